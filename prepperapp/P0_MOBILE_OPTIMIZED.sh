@@ -35,14 +35,20 @@ echo "  - Basic index options (no positions/frequencies)"
 echo "  - No indexed title field"
 echo "  - No stored summary field"
 echo "  - Single segment for mobile performance"
+echo "  - Deterministic output, so updates can ship as deltas"
+echo "  - lz4 docstore in small blocks, for fast article fetches"
 echo ""
 
 cd "${CONTENT_SCRIPTS}"
 ./tantivy-indexer-mobile \
     --index "${DATA_DIR}/indexes/tantivy-p0-mobile" \
     --input "${DATA_DIR}/processed-p0/articles-p0.jsonl" \
-    --threads 2 \
+    --threads "${INDEXER_THREADS:-$(nproc 2>/dev/null || echo 2)}" \
     --heap-size 300 \
+    --pipeline \
+    --deterministic \
+    --compressor lz4 \
+    --docstore-blocksize 8192 \
     --finalize
 
 echo ""
@@ -184,6 +184,16 @@ EOF
 # Create version file
 echo "${PACKAGE_NAME}" > "$PACKAGE_PATH/metadata/VERSION"
 
+# Build an update delta against the previously shipped package, if given.
+# Both indexes must come from deterministic builds
+if [ -n "${PREVIOUS_PACKAGE:-}" ]; then
+    echo -e "${YELLOW}Building index delta from ${PREVIOUS_PACKAGE}...${NC}"
+    "${SCRIPT_DIR}/content/scripts/tantivy-delta" \
+        --base "${PREVIOUS_PACKAGE}/index" \
+        --target "$PACKAGE_PATH/index" \
+        --output "$PACKAGE_PATH/delta"
+fi
+
 # Create deployment checksums
 echo -e "${YELLOW}Creating checksums...${NC}"
 cd "$PACKAGE_PATH"
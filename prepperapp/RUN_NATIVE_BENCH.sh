@@ -0,0 +1,88 @@
+#!/bin/bash
+#
+# RUN_NATIVE_BENCH.sh - Native search benchmark on an Android device
+#
+# Builds tantivy_bench for the device ABI, pushes it with
+# libtantivy_mobile.so, an index and the query corpora over adb, and pulls
+# the JSON report back. With a baseline report, fails if any path's p95
+# latency or allocations per query grew by more than the tolerance.
+#
+# Usage: RUN_NATIVE_BENCH.sh INDEX_DIR [OUT.json] [BASELINE.json]
+# Env:   ANDROID_NDK (required), ABI (arm64-v8a), ITERATIONS (20),
+#        TOLERANCE (0.10)
+#
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m' # No Color
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+CPP_DIR="${SCRIPT_DIR}/android/app/src/main/cpp"
+BUILD_DIR="${SCRIPT_DIR}/android/app/build/tantivy_bench"
+DEVICE_DIR="/data/local/tmp/tantivy_bench"
+
+INDEX_DIR="$1"
+OUT="${2:-${SCRIPT_DIR}/native_bench.json}"
+BASELINE="$3"
+ABI="${ABI:-arm64-v8a}"
+ITERATIONS="${ITERATIONS:-20}"
+TOLERANCE="${TOLERANCE:-0.10}"
+
+if [ -z "${INDEX_DIR}" ] || [ ! -d "${INDEX_DIR}" ]; then
+    echo "Usage: $0 INDEX_DIR [OUT.json] [BASELINE.json]"
+    exit 1
+fi
+if [ -z "${ANDROID_NDK}" ]; then
+    echo -e "${RED}Error: set ANDROID_NDK to the NDK root${NC}"
+    exit 1
+fi
+
+echo -e "${BLUE}=== Building tantivy_bench (${ABI}) ===${NC}"
+cmake -S "${CPP_DIR}" -B "${BUILD_DIR}" \
+    -DCMAKE_TOOLCHAIN_FILE="${ANDROID_NDK}/build/cmake/android.toolchain.cmake" \
+    -DANDROID_ABI="${ABI}" \
+    -DANDROID_PLATFORM=android-26 \
+    -DCMAKE_BUILD_TYPE=Release \
+    -DTANTIVY_BUILD_BENCH=ON > /dev/null
+cmake --build "${BUILD_DIR}" --target tantivy_bench
+
+echo -e "${BLUE}=== Pushing to ${DEVICE_DIR} ===${NC}"
+adb shell "rm -rf ${DEVICE_DIR} && mkdir -p ${DEVICE_DIR}"
+adb push "${BUILD_DIR}/tantivy_bench" "${DEVICE_DIR}/" > /dev/null
+adb push "${SCRIPT_DIR}/android/app/src/main/jniLibs/${ABI}/libtantivy_mobile.so" "${DEVICE_DIR}/" > /dev/null
+adb push "${CPP_DIR}/bench/safety_queries.txt" "${CPP_DIR}/bench/typeahead_trace.txt" "${DEVICE_DIR}/" > /dev/null
+adb push "${INDEX_DIR}" "${DEVICE_DIR}/index" > /dev/null
+
+echo -e "${BLUE}=== Running ===${NC}"
+adb shell "cd ${DEVICE_DIR} && LD_LIBRARY_PATH=. ./tantivy_bench \
+    --index index \
+    --corpus safety=safety_queries.txt \
+    --corpus typeahead=typeahead_trace.txt \
+    --iterations ${ITERATIONS} \
+    --json report.json"
+adb pull "${DEVICE_DIR}/report.json" "${OUT}" > /dev/null
+echo -e "${GREEN}✓ Report written to ${OUT}${NC}"
+
+if [ -n "${BASELINE}" ]; then
+    echo -e "${BLUE}=== Comparing with ${BASELINE} (tolerance ${TOLERANCE}) ===${NC}"
+    python3 - "${BASELINE}" "${OUT}" "${TOLERANCE}" <<'EOF'
+import json, sys
+
+baseline, current, tolerance = json.load(open(sys.argv[1])), json.load(open(sys.argv[2])), float(sys.argv[3])
+before = {(r["path"], r["corpus"]): r for r in baseline["results"]}
+regressions = []
+for r in current["results"]:
+    old = before.get((r["path"], r["corpus"]))
+    if old is None:
+        continue
+    for metric in ("p95_us", "allocs_per_query"):
+        if old[metric] > 0 and r[metric] > old[metric] * (1 + tolerance):
+            regressions.append(f'{r["path"]}/{r["corpus"]} {metric}: {old[metric]} -> {r[metric]}')
+for line in regressions:
+    print("REGRESSION " + line)
+sys.exit(1 if regressions else 0)
+EOF
+    echo -e "${GREEN}✓ No regressions${NC}"
+fi
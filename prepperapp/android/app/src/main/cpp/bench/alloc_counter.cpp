@@ -0,0 +1,187 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <malloc.h>
+
+// The executable's definitions win over libc's for every library in the
+// process, including libtantivy_mobile.so. Each forwards to the next
+// definition, resolved on first use.
+
+namespace {
+
+using MallocFn = void *(*)(size_t);
+using CallocFn = void *(*)(size_t, size_t);
+using ReallocFn = void *(*)(void *, size_t);
+using FreeFn = void (*)(void *);
+using PosixMemalignFn = int (*)(void **, size_t, size_t);
+using MemalignFn = void *(*)(size_t, size_t);
+
+struct RealAllocator {
+    MallocFn malloc;
+    CallocFn calloc;
+    ReallocFn realloc;
+    FreeFn free;
+    PosixMemalignFn posixMemalign;
+    MemalignFn memalign;
+    MemalignFn alignedAlloc;
+};
+
+RealAllocator gReal = {};
+std::atomic<bool> gResolving{false};
+
+std::atomic<uint64_t> gAllocations{0};
+std::atomic<uint64_t> gBytes{0};
+
+// dlsym may calloc before calloc itself is resolved; those few blocks come
+// from here and are never freed
+alignas(16) char gBootstrap[4096];
+size_t gBootstrapUsed = 0;
+
+void *bootstrapAlloc(size_t size) {
+    size = (size + 15) & ~static_cast<size_t>(15);
+    if (gBootstrapUsed + size > sizeof(gBootstrap)) {
+        return nullptr;
+    }
+    void *block = gBootstrap + gBootstrapUsed;
+    gBootstrapUsed += size;
+    return block;
+}
+
+bool isBootstrap(void *ptr) {
+    char *p = static_cast<char *>(ptr);
+    return p >= gBootstrap && p < gBootstrap + sizeof(gBootstrap);
+}
+
+void resolve() {
+    if (gReal.free != nullptr) {
+        return;
+    }
+    gResolving = true;
+    gReal.malloc = reinterpret_cast<MallocFn>(dlsym(RTLD_NEXT, "malloc"));
+    gReal.calloc = reinterpret_cast<CallocFn>(dlsym(RTLD_NEXT, "calloc"));
+    gReal.realloc = reinterpret_cast<ReallocFn>(dlsym(RTLD_NEXT, "realloc"));
+    gReal.posixMemalign = reinterpret_cast<PosixMemalignFn>(dlsym(RTLD_NEXT, "posix_memalign"));
+    gReal.memalign = reinterpret_cast<MemalignFn>(dlsym(RTLD_NEXT, "memalign"));
+    gReal.alignedAlloc = reinterpret_cast<MemalignFn>(dlsym(RTLD_NEXT, "aligned_alloc"));
+    gReal.free = reinterpret_cast<FreeFn>(dlsym(RTLD_NEXT, "free"));
+    gResolving = false;
+}
+
+void count(void *block, size_t size) {
+    if (block != nullptr) {
+        gAllocations.fetch_add(1, std::memory_order_relaxed);
+        gBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+size_t statusKb(const char *field) {
+    FILE *status = fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    size_t fieldLength = strlen(field);
+    char line[256];
+    size_t kb = 0;
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':') {
+            kb = strtoul(line + fieldLength + 1, nullptr, 10);
+            break;
+        }
+    }
+    fclose(status);
+    return kb;
+}
+
+} // namespace
+
+extern "C" {
+
+void *malloc(size_t size) {
+    if (gResolving) {
+        return bootstrapAlloc(size);
+    }
+    resolve();
+    void *block = gReal.malloc(size);
+    count(block, size);
+    return block;
+}
+
+void *calloc(size_t count_, size_t size) {
+    if (gResolving) {
+        // The bootstrap buffer is zero-initialized and never reused
+        return bootstrapAlloc(count_ * size);
+    }
+    resolve();
+    void *block = gReal.calloc(count_, size);
+    count(block, count_ * size);
+    return block;
+}
+
+void *realloc(void *ptr, size_t size) {
+    resolve();
+    if (isBootstrap(ptr)) {
+        void *block = gReal.malloc(size);
+        if (block != nullptr) {
+            size_t available = sizeof(gBootstrap) - static_cast<size_t>(static_cast<char *>(ptr) - gBootstrap);
+            memcpy(block, ptr, size < available ? size : available);
+        }
+        count(block, size);
+        return block;
+    }
+    void *block = gReal.realloc(ptr, size);
+    count(block, size);
+    return block;
+}
+
+void free(void *ptr) {
+    if (ptr == nullptr || isBootstrap(ptr)) {
+        return;
+    }
+    resolve();
+    gReal.free(ptr);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+    resolve();
+    int result = gReal.posixMemalign(out, alignment, size);
+    if (result == 0) {
+        count(*out, size);
+    }
+    return result;
+}
+
+void *memalign(size_t alignment, size_t size) {
+    resolve();
+    void *block = gReal.memalign(alignment, size);
+    count(block, size);
+    return block;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    resolve();
+    void *block = gReal.alignedAlloc != nullptr ? gReal.alignedAlloc(alignment, size) : gReal.memalign(alignment, size);
+    count(block, size);
+    return block;
+}
+
+} // extern "C"
+
+namespace alloc_counter {
+
+Snapshot snapshot() {
+    return {gAllocations.load(std::memory_order_relaxed), gBytes.load(std::memory_order_relaxed)};
+}
+
+size_t residentKb() {
+    return statusKb("VmRSS");
+}
+
+size_t peakResidentKb() {
+    return statusKb("VmHWM");
+}
+
+} // namespace alloc_counter
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation counts for the benchmark. alloc_counter.cpp interposes
+// malloc and friends for the whole process, Rust's system allocator
+// included, so a query's allocations on the search threads count too.
+namespace alloc_counter {
+
+struct Snapshot {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+// Allocations since the process started
+Snapshot snapshot();
+
+// Resident and peak resident set size in KiB, from /proc/self/status
+size_t residentKb();
+size_t peakResidentKb();
+
+} // namespace alloc_counter
@@ -0,0 +1,428 @@
+// tantivy_bench - end-to-end latency of the native search entry points
+//
+// Replays query corpora against the C API the app ships and reports, per
+// path and corpus, p50/p95/p99 latency, heap allocations per query and
+// RSS. Results go to stdout as JSON (or to --json FILE) for regression
+// gates; a readable table goes to stderr. See RUN_NATIVE_BENCH.sh for
+// running it on a device over adb.
+//
+// Paths:
+//   legacy  tantivy_search, the single-index struct API
+//   json    search, the single-index JSON API in ffi.rs
+//   multi   multi_manager_search, JSON config and results
+//   binary  multi_manager_search_binary, what nativeSearchBinary calls
+//
+// The JNI layer itself needs a VM and is not replayed here; its copying
+// shows up in SearchTiming.marshal_ns on device.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/utsname.h>
+
+#include "tantivy_mobile.h"
+#include "alloc_counter.h"
+
+namespace {
+
+constexpr size_t kPackedBufferBytes = 256 * 1024;
+
+struct Corpus {
+    std::string name;
+    std::vector<std::string> queries;
+};
+
+struct Module {
+    std::string name;
+    std::string path;
+};
+
+struct Options {
+    std::string index;
+    std::vector<Module> modules;
+    std::vector<Corpus> corpora;
+    std::vector<std::string> paths = {"legacy", "json", "multi", "binary"};
+    int iterations = 20;
+    int warmup = 2;
+    uint32_t limit = 20;
+    bool cache = false;
+    std::string jsonOut;
+};
+
+struct Result {
+    std::string path;
+    std::string corpus;
+    size_t queries;
+    size_t failures;
+    double p50Us;
+    double p95Us;
+    double p99Us;
+    double meanUs;
+    double allocsPerQuery;
+    double allocBytesPerQuery;
+    size_t rssKb;
+    size_t peakRssKb;
+};
+
+// One search; false on failure
+using SearchFn = bool (*)(void *context, const char *query);
+
+struct LegacyContext {
+    void *index;
+    size_t limit;
+};
+
+struct JsonContext {
+    SearchService *service;
+};
+
+struct MultiContext {
+    MultiSearchManager *manager;
+    MultiSearchOptions options;
+    std::string configJson;
+    std::vector<uint8_t> buffer;
+};
+
+bool legacySearch(void *context, const char *query) {
+    auto *legacy = static_cast<LegacyContext *>(context);
+    SearchResults *results = tantivy_search(legacy->index, query, legacy->limit);
+    if (results == nullptr) {
+        return false;
+    }
+    tantivy_free_search_results(results);
+    return true;
+}
+
+bool jsonSearch(void *context, const char *query) {
+    const char *json = search(static_cast<JsonContext *>(context)->service, query);
+    if (json == nullptr) {
+        return false;
+    }
+    free_string(const_cast<char *>(json));
+    return true;
+}
+
+bool multiSearch(void *context, const char *query) {
+    auto *multi = static_cast<MultiContext *>(context);
+    const char *json = multi_manager_search(multi->manager, query, multi->configJson.c_str());
+    if (json == nullptr) {
+        return false;
+    }
+    free_rust_string(const_cast<char *>(json));
+    return true;
+}
+
+bool binarySearch(void *context, const char *query) {
+    auto *multi = static_cast<MultiContext *>(context);
+    return multi_manager_search_binary(
+        multi->manager, query, &multi->options, multi->buffer.data(), multi->buffer.size()) >= 0;
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size()) + 0.5);
+    rank = std::min(std::max(rank, static_cast<size_t>(1)), sorted.size());
+    return sorted[rank - 1];
+}
+
+Result run(const Options &options, const std::string &path, const Corpus &corpus, SearchFn fn, void *context) {
+    for (int i = 0; i < options.warmup; i++) {
+        for (const std::string &query : corpus.queries) {
+            fn(context, query.c_str());
+        }
+    }
+
+    std::vector<double> samples;
+    samples.reserve(corpus.queries.size() * static_cast<size_t>(options.iterations));
+    size_t failures = 0;
+    alloc_counter::Snapshot before = alloc_counter::snapshot();
+    for (int i = 0; i < options.iterations; i++) {
+        for (const std::string &query : corpus.queries) {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = fn(context, query.c_str());
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            samples.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+            if (!ok) {
+                failures++;
+            }
+        }
+    }
+    alloc_counter::Snapshot after = alloc_counter::snapshot();
+    // The samples vector was reserved up front, so the loop's own
+    // bookkeeping does not allocate
+
+    Result result = {};
+    result.path = path;
+    result.corpus = corpus.name;
+    result.queries = samples.size();
+    result.failures = failures;
+    double count = samples.empty() ? 1.0 : static_cast<double>(samples.size());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.meanUs = sum / count;
+    std::sort(samples.begin(), samples.end());
+    result.p50Us = percentile(samples, 50);
+    result.p95Us = percentile(samples, 95);
+    result.p99Us = percentile(samples, 99);
+    result.allocsPerQuery = static_cast<double>(after.allocations - before.allocations) / count;
+    result.allocBytesPerQuery = static_cast<double>(after.bytes - before.bytes) / count;
+    result.rssKb = alloc_counter::residentKb();
+    result.peakRssKb = alloc_counter::peakResidentKb();
+    return result;
+}
+
+bool loadCorpus(const std::string &spec, Corpus &corpus) {
+    // NAME=FILE, or FILE named after its basename
+    size_t eq = spec.find('=');
+    std::string file = eq == std::string::npos ? spec : spec.substr(eq + 1);
+    if (eq != std::string::npos) {
+        corpus.name = spec.substr(0, eq);
+    } else {
+        size_t slash = file.find_last_of('/');
+        corpus.name = file.substr(slash == std::string::npos ? 0 : slash + 1);
+        corpus.name = corpus.name.substr(0, corpus.name.find('.'));
+    }
+
+    FILE *in = fopen(file.c_str(), "r");
+    if (in == nullptr) {
+        fprintf(stderr, "Cannot read corpus %s\n", file.c_str());
+        return false;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), in) != nullptr) {
+        // Trailing spaces are kept: a type-ahead trace has them mid-word
+        size_t length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        if (length == 0 || line[0] == '#') {
+            continue;
+        }
+        corpus.queries.emplace_back(line);
+    }
+    fclose(in);
+    return !corpus.queries.empty();
+}
+
+std::string jsonEscape(const std::string &value) {
+    std::string out;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void writeJson(FILE *out, const Options &options, const std::vector<Result> &results) {
+    struct utsname system = {};
+    uname(&system);
+    fprintf(out, "{\n  \"machine\": \"%s\",\n  \"kernel\": \"%s\",\n", jsonEscape(system.machine).c_str(),
+            jsonEscape(system.release).c_str());
+    fprintf(out, "  \"iterations\": %d,\n  \"warmup\": %d,\n  \"limit\": %u,\n  \"cache\": %s,\n",
+            options.iterations, options.warmup, options.limit, options.cache ? "true" : "false");
+    fprintf(out, "  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(out,
+                "%s\n    {\"path\": \"%s\", \"corpus\": \"%s\", \"queries\": %zu, \"failures\": %zu, "
+                "\"p50_us\": %.1f, \"p95_us\": %.1f, \"p99_us\": %.1f, \"mean_us\": %.1f, "
+                "\"allocs_per_query\": %.1f, \"alloc_bytes_per_query\": %.0f, \"rss_kb\": %zu, \"peak_rss_kb\": %zu}",
+                i == 0 ? "" : ",", r.path.c_str(), jsonEscape(r.corpus).c_str(), r.queries, r.failures, r.p50Us,
+                r.p95Us, r.p99Us, r.meanUs, r.allocsPerQuery, r.allocBytesPerQuery, r.rssKb, r.peakRssKb);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void printTable(const std::vector<Result> &results) {
+    fprintf(stderr, "%-8s %-16s %7s %9s %9s %9s %9s %8s %9s\n", "path", "corpus", "queries", "p50 us", "p95 us",
+            "p99 us", "allocs/q", "fails", "rss KiB");
+    for (const Result &r : results) {
+        fprintf(stderr, "%-8s %-16s %7zu %9.1f %9.1f %9.1f %9.1f %8zu %9zu\n", r.path.c_str(), r.corpus.c_str(),
+                r.queries, r.p50Us, r.p95Us, r.p99Us, r.allocsPerQuery, r.failures, r.rssKb);
+    }
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: tantivy_bench --index DIR --corpus [NAME=]FILE... [options]\n"
+            "  --index DIR          index for the legacy and json paths, and the\n"
+            "                       multi-module paths when no --module is given\n"
+            "  --module NAME=DIR    module for the multi and binary paths (repeatable)\n"
+            "  --corpus [NAME=]FILE query file, one query per line (repeatable)\n"
+            "  --paths LIST         comma-separated: legacy,json,multi,binary (default all)\n"
+            "  --iterations N       timed passes over each corpus (default 20)\n"
+            "  --warmup N           untimed passes first (default 2)\n"
+            "  --limit N            results per query (default 20)\n"
+            "  --cache              keep the result caches on; repeats become cache hits\n"
+            "  --json FILE          write the JSON report to FILE instead of stdout\n");
+}
+
+bool parseArgs(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char *v = nullptr;
+        if (arg == "--cache") {
+            options.cache = true;
+            continue;
+        }
+        if ((v = value()) == nullptr) {
+            return false;
+        }
+        if (arg == "--index") {
+            options.index = v;
+        } else if (arg == "--module") {
+            std::string spec = v;
+            size_t eq = spec.find('=');
+            if (eq == std::string::npos) {
+                return false;
+            }
+            options.modules.push_back({spec.substr(0, eq), spec.substr(eq + 1)});
+        } else if (arg == "--corpus") {
+            Corpus corpus;
+            if (!loadCorpus(v, corpus)) {
+                return false;
+            }
+            options.corpora.push_back(corpus);
+        } else if (arg == "--paths") {
+            options.paths.clear();
+            std::string list = v;
+            size_t start = 0;
+            while (start <= list.size()) {
+                size_t comma = list.find(',', start);
+                if (comma == std::string::npos) {
+                    comma = list.size();
+                }
+                options.paths.push_back(list.substr(start, comma - start));
+                start = comma + 1;
+            }
+        } else if (arg == "--iterations") {
+            options.iterations = std::max(1, atoi(v));
+        } else if (arg == "--warmup") {
+            options.warmup = std::max(0, atoi(v));
+        } else if (arg == "--limit") {
+            options.limit = static_cast<uint32_t>(std::max(1, atoi(v)));
+        } else if (arg == "--json") {
+            options.jsonOut = v;
+        } else {
+            return false;
+        }
+    }
+    if (options.index.empty() && options.modules.empty()) {
+        return false;
+    }
+    if (options.modules.empty()) {
+        options.modules.push_back({"index", options.index});
+    }
+    return !options.corpora.empty();
+}
+
+bool wants(const Options &options, const char *path) {
+    return std::find(options.paths.begin(), options.paths.end(), path) != options.paths.end();
+}
+
+void runAll(const Options &options, const char *path, SearchFn fn, void *context, std::vector<Result> &results) {
+    for (const Corpus &corpus : options.corpora) {
+        results.push_back(run(options, path, corpus, fn, context));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<Result> results;
+    bool needsIndex = wants(options, "legacy") || wants(options, "json");
+    if (needsIndex && options.index.empty()) {
+        fprintf(stderr, "The legacy and json paths need --index\n");
+        return 2;
+    }
+
+    if (wants(options, "legacy")) {
+        LegacyContext legacy = {};
+        legacy.limit = options.limit;
+        if ((legacy.index = tantivy_open_index(options.index.c_str())) == nullptr) {
+            fprintf(stderr, "Skipping legacy: cannot open %s\n", options.index.c_str());
+        } else {
+            if (!options.cache) {
+                tantivy_set_cache_capacity(legacy.index, 0);
+            }
+            runAll(options, "legacy", legacySearch, &legacy, results);
+            tantivy_free_index(legacy.index);
+        }
+    }
+
+    if (wants(options, "json")) {
+        JsonContext json = {init_searcher(options.index.c_str())};
+        if (json.service == nullptr) {
+            fprintf(stderr, "Skipping json: cannot open %s\n", options.index.c_str());
+        } else {
+            runAll(options, "json", jsonSearch, &json, results);
+            destroy_searcher(json.service);
+        }
+    }
+
+    if (wants(options, "multi") || wants(options, "binary")) {
+        MultiContext multi = {};
+        multi.manager = init_multi_manager();
+        multi.options = multi_search_options_default();
+        multi.options.limit = options.limit;
+        multi.configJson = "{\"limit\":" + std::to_string(options.limit) + "}";
+        multi.buffer.resize(kPackedBufferBytes);
+        size_t loaded = 0;
+        for (const Module &module : options.modules) {
+            if (multi.manager != nullptr &&
+                multi_manager_load_index(multi.manager, module.name.c_str(), module.path.c_str()) == 0) {
+                loaded++;
+            } else {
+                fprintf(stderr, "Cannot load module %s from %s\n", module.name.c_str(), module.path.c_str());
+            }
+        }
+        if (loaded == 0) {
+            fprintf(stderr, "Skipping multi and binary: no module loaded\n");
+        } else {
+            if (!options.cache) {
+                multi_manager_set_cache_capacity(multi.manager, 0);
+            }
+            if (wants(options, "multi")) {
+                runAll(options, "multi", multiSearch, &multi, results);
+            }
+            if (wants(options, "binary")) {
+                runAll(options, "binary", binarySearch, &multi, results);
+            }
+        }
+        destroy_multi_manager(multi.manager);
+    }
+
+    printTable(results);
+    FILE *out = stdout;
+    if (!options.jsonOut.empty() && (out = fopen(options.jsonOut.c_str(), "w")) == nullptr) {
+        fprintf(stderr, "Cannot write %s\n", options.jsonOut.c_str());
+        return 1;
+    }
+    writeJson(out, options, results);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return results.empty() ? 1 : 0;
+}
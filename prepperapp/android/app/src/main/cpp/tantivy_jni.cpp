@@ -1,14 +1,402 @@
 #include <jni.h>
+#include <chrono>
 #include <string>
 #include <android/log.h>
+#include <android/trace.h>
 #include "include/tantivy_mobile.h"
 
 #define LOG_TAG "TantivyJNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+static_assert(sizeof(PackedResultsHeader) == TANTIVY_PACKED_HEADER_SIZE, "packed header layout");
+static_assert(sizeof(PackedResultRow) == TANTIVY_PACKED_ROW_SIZE, "packed row layout");
+static_assert(sizeof(SearchHit) == 16, "search hit layout");
+
+namespace {
+
+// Class and method IDs resolved once in JNI_OnLoad. The classes are held as
+// global refs so the method IDs stay valid for the lifetime of the library.
+struct JniCache {
+    JavaVM *vm;
+    jclass searchResultClass;
+    jclass searchResultsClass;
+    jclass indexStatsClass;
+    jclass searchServiceClass;
+    jmethodID searchResultConstructor;
+    jmethodID searchResultsConstructor;
+    jmethodID indexStatsConstructor;
+    jmethodID onAsyncSearchComplete;
+    jmethodID onTieredSearchBatch;
+};
+
+JniCache gJni = {};
+
+jclass findGlobalClass(JNIEnv *env, const char *name) {
+    jclass localClass = env->FindClass(name);
+    if (localClass == nullptr) {
+        LOGE("Failed to find class %s", name);
+        return nullptr;
+    }
+    jclass globalClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+    env->DeleteLocalRef(localClass);
+    return globalClass;
+}
+
+void releaseJniCache(JNIEnv *env) {
+    if (gJni.searchResultClass != nullptr) {
+        env->DeleteGlobalRef(gJni.searchResultClass);
+    }
+    if (gJni.searchResultsClass != nullptr) {
+        env->DeleteGlobalRef(gJni.searchResultsClass);
+    }
+    if (gJni.indexStatsClass != nullptr) {
+        env->DeleteGlobalRef(gJni.indexStatsClass);
+    }
+    if (gJni.searchServiceClass != nullptr) {
+        env->DeleteGlobalRef(gJni.searchServiceClass);
+    }
+    gJni = {};
+}
+
+bool initJniCache(JNIEnv *env) {
+    gJni.searchResultClass = findGlobalClass(env, "com/prepperapp/TantivyBridge$SearchResultNative");
+    gJni.searchResultsClass = findGlobalClass(env, "com/prepperapp/TantivyBridge$SearchResultsNative");
+    gJni.indexStatsClass = findGlobalClass(env, "com/prepperapp/TantivyBridge$IndexStats");
+    // Resolved here: FindClass on a native search thread would only see
+    // system classes
+    gJni.searchServiceClass = findGlobalClass(env, "com/prepperapp/SearchService");
+    if (gJni.searchResultClass == nullptr || gJni.searchResultsClass == nullptr ||
+        gJni.indexStatsClass == nullptr || gJni.searchServiceClass == nullptr) {
+        return false;
+    }
+
+    gJni.searchResultConstructor = env->GetMethodID(
+        gJni.searchResultClass,
+        "<init>",
+        "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;IF)V"
+    );
+    gJni.searchResultsConstructor = env->GetMethodID(
+        gJni.searchResultsClass,
+        "<init>",
+        "([Lcom/prepperapp/TantivyBridge$SearchResultNative;J)V"
+    );
+    gJni.indexStatsConstructor = env->GetMethodID(gJni.indexStatsClass, "<init>", "(JJIJJJJJJ[J)V");
+    gJni.onAsyncSearchComplete = env->GetStaticMethodID(gJni.searchServiceClass, "onAsyncSearchComplete", "(JI[B)V");
+    gJni.onTieredSearchBatch = env->GetStaticMethodID(gJni.searchServiceClass, "onTieredSearchBatch", "(JI[BZ)V");
+
+    return gJni.searchResultConstructor != nullptr &&
+           gJni.searchResultsConstructor != nullptr &&
+           gJni.indexStatsConstructor != nullptr &&
+           gJni.onAsyncSearchComplete != nullptr &&
+           gJni.onTieredSearchBatch != nullptr;
+}
+
+// One result arena per calling thread, reused by every nativeSearch on that
+// thread so result strings don't churn through malloc/free per query.
+constexpr size_t kArenaInitialBytes = 16 * 1024;
+
+struct ThreadArena {
+    SearchResultArena *arena = nullptr;
+
+    ~ThreadArena() {
+        if (arena != nullptr) {
+            tantivy_arena_free(arena);
+        }
+    }
+
+    SearchResultArena *get() {
+        if (arena == nullptr) {
+            arena = tantivy_arena_create(kArenaInitialBytes);
+        }
+        return arena;
+    }
+};
+
+thread_local ThreadArena tThreadArena;
+
+// Modified UTF-8 view of a jstring, released on scope exit. A null jstring
+// yields a null pointer so optional arguments can be passed straight through.
+class ScopedUtfChars {
+public:
+    ScopedUtfChars(JNIEnv *env, jstring value)
+        : env_(env), value_(value),
+          chars_(value != nullptr ? env->GetStringUTFChars(value, nullptr) : nullptr) {}
+
+    ~ScopedUtfChars() {
+        if (chars_ != nullptr) {
+            env_->ReleaseStringUTFChars(value_, chars_);
+        }
+    }
+
+    ScopedUtfChars(const ScopedUtfChars &) = delete;
+    ScopedUtfChars &operator=(const ScopedUtfChars &) = delete;
+
+    const char *get() const { return chars_; }
+
+private:
+    JNIEnv *env_;
+    jstring value_;
+    const char *chars_;
+};
+
+// TantivyBridge.IndexStats from the native struct, or null on failure
+jobject toIndexStats(JNIEnv *env, const IndexStats &stats) {
+    jlongArray histogram = env->NewLongArray(TANTIVY_LATENCY_BUCKETS);
+    if (histogram == nullptr) {
+        return nullptr;
+    }
+    jlong buckets[TANTIVY_LATENCY_BUCKETS];
+    for (int i = 0; i < TANTIVY_LATENCY_BUCKETS; i++) {
+        buckets[i] = static_cast<jlong>(stats.latency_histogram[i]);
+    }
+    env->SetLongArrayRegion(histogram, 0, TANTIVY_LATENCY_BUCKETS, buckets);
+
+    jobject result = env->NewObject(
+        gJni.indexStatsClass,
+        gJni.indexStatsConstructor,
+        static_cast<jlong>(stats.num_docs),
+        static_cast<jlong>(stats.index_size_bytes),
+        static_cast<jint>(stats.segment_count),
+        static_cast<jlong>(stats.mapped_bytes),
+        static_cast<jlong>(stats.resident_bytes),
+        static_cast<jlong>(stats.heap_bytes),
+        static_cast<jlong>(stats.docstore_cache_bytes),
+        static_cast<jlong>(stats.query_count),
+        static_cast<jlong>(stats.query_time_ns),
+        histogram
+    );
+    env->DeleteLocalRef(histogram);
+    return result;
+}
+
+MultiSearchManager *toManager(jlong managerPtr) {
+    return reinterpret_cast<MultiSearchManager*>(managerPtr);
+}
+
+// An on-device writer and the module it feeds. The callback runs on the
+// writer thread and only reloads the module, so it never attaches to the VM.
+struct WriterBinding {
+    MultiSearchManager *manager;
+    std::string module;
+    OnDeviceWriter *writer;
+};
+
+void reloadWrittenModule(int32_t status, uint32_t /* segmentCount */, void *userData) {
+    auto *binding = static_cast<WriterBinding*>(userData);
+    if (status != TANTIVY_SUCCESS) {
+        LOGE("Writer for %s failed (%d)", binding->module.c_str(), status);
+        return;
+    }
+    multi_manager_reload_index(binding->manager, binding->module.c_str());
+}
+
+const OnDeviceWriter *toWriter(jlong writerPtr) {
+    auto *binding = reinterpret_cast<WriterBinding*>(writerPtr);
+    return binding != nullptr ? binding->writer : nullptr;
+}
+
+// Binary options from SearchService's slot mask and weights, indexed by slot
+MultiSearchOptions toOptions(JNIEnv *env, jint limit, jint moduleMask, jfloatArray moduleWeights) {
+    MultiSearchOptions options = multi_search_options_default();
+    options.limit = static_cast<uint32_t>(limit);
+    options.module_mask = static_cast<uint32_t>(moduleMask);
+    if (moduleWeights != nullptr) {
+        jsize count = env->GetArrayLength(moduleWeights);
+        if (count > MULTI_SEARCH_MAX_MODULES) {
+            count = MULTI_SEARCH_MAX_MODULES;
+        }
+        env->GetFloatArrayRegion(moduleWeights, 0, count, options.module_weights);
+    }
+    return options;
+}
+
+// Tier budgets passed to multi_manager_search_tiered; the last one repeats
+// for any further tiers, so more are never needed
+constexpr jsize kMaxTierDeadlines = 8;
+
+// SearchTiming flattened for SearchService.SearchTiming: the seven phases,
+// cache_hit, module_count, searched_mask, pending_mask, then
+// module_collect_ns by slot
+constexpr jsize kTimingFields = 11;
+constexpr jsize kTimingLongs = kTimingFields + MULTI_SEARCH_MAX_MODULES;
+
+void copyTiming(JNIEnv *env, const SearchTiming &timing, jlongArray out) {
+    if (env->GetArrayLength(out) < kTimingLongs) {
+        return;
+    }
+    jlong values[kTimingLongs] = {
+        static_cast<jlong>(timing.total_ns),
+        static_cast<jlong>(timing.parse_ns),
+        static_cast<jlong>(timing.collect_ns),
+        static_cast<jlong>(timing.merge_ns),
+        static_cast<jlong>(timing.fetch_ns),
+        static_cast<jlong>(timing.serialize_ns),
+        static_cast<jlong>(timing.marshal_ns),
+        static_cast<jlong>(timing.cache_hit),
+        static_cast<jlong>(timing.module_count),
+        static_cast<jlong>(timing.searched_mask),
+        static_cast<jlong>(timing.pending_mask),
+    };
+    for (jsize slot = 0; slot < MULTI_SEARCH_MAX_MODULES; slot++) {
+        values[kTimingFields + slot] = static_cast<jlong>(timing.module_collect_ns[slot]);
+    }
+    env->SetLongArrayRegion(out, 0, kTimingLongs, values);
+}
+
+uint64_t nanosSince(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+// Ends an ATrace section when it goes out of scope
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char *name) { ATrace_beginSection(name); }
+    ~ScopedTrace() { ATrace_endSection(); }
+    ScopedTrace(const ScopedTrace &) = delete;
+    ScopedTrace &operator=(const ScopedTrace &) = delete;
+};
+
+// The native threads behind multi_manager_search_async live as long as
+// their manager, so each is attached to the VM on its first callback and
+// detached when it exits, not once per search.
+struct ThreadAttachment {
+    JNIEnv *env = nullptr;
+
+    ~ThreadAttachment() {
+        if (env != nullptr && gJni.vm != nullptr) {
+            gJni.vm->DetachCurrentThread();
+        }
+    }
+
+    JNIEnv *get() {
+        if (env == nullptr && gJni.vm != nullptr) {
+            // Daemon, so a search in flight never holds up VM shutdown
+            JavaVMAttachArgs args = {JNI_VERSION_1_6, "tantivy-async", nullptr};
+            if (gJni.vm->AttachCurrentThreadAsDaemon(&env, &args) != JNI_OK) {
+                env = nullptr;
+            }
+        }
+        return env;
+    }
+};
+
+thread_local ThreadAttachment tAttachment;
+
+// Copies a callback's packed results, which are only valid during the
+// call, into a Java array. Null when there are none; a failed allocation
+// turns `status` into TANTIVY_ERROR_SEARCH_FAILED.
+jbyteArray copyPacked(JNIEnv *env, int32_t &status, const uint8_t *packed, size_t packedLen) {
+    if (status < 0 || packed == nullptr) {
+        return nullptr;
+    }
+    jbyteArray data = env->NewByteArray(static_cast<jsize>(packedLen));
+    if (data == nullptr) {
+        env->ExceptionClear();
+        status = TANTIVY_ERROR_SEARCH_FAILED;
+        return nullptr;
+    }
+    env->SetByteArrayRegion(data, 0, static_cast<jsize>(packedLen), reinterpret_cast<const jbyte*>(packed));
+    return data;
+}
+
+void clearCallbackException(JNIEnv *env, const char *method) {
+    if (env->ExceptionCheck()) {
+        LOGE("SearchService.%s threw", method);
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+// MultiSearchCallback: hands the packed results to
+// SearchService.onAsyncSearchComplete. user_data is the Kotlin-side token,
+// registered before the search was queued so no completion is missed.
+void onAsyncSearchComplete(uint64_t /* requestId */, int32_t status, const uint8_t *packed,
+                           size_t packedLen, void *userData) {
+    JNIEnv *env = tAttachment.get();
+    if (env == nullptr) {
+        LOGE("Failed to attach search thread; async search result dropped");
+        return;
+    }
+
+    jbyteArray data = copyPacked(env, status, packed, packedLen);
+    env->CallStaticVoidMethod(
+        gJni.searchServiceClass,
+        gJni.onAsyncSearchComplete,
+        static_cast<jlong>(reinterpret_cast<intptr_t>(userData)),
+        static_cast<jint>(status),
+        data
+    );
+    clearCallbackException(env, "onAsyncSearchComplete");
+    if (data != nullptr) {
+        env->DeleteLocalRef(data);
+    }
+}
+
+// TieredSearchCallback: hands each batch, then the final result, to
+// SearchService.onTieredSearchBatch under the same kind of token
+void onTieredSearchBatch(uint64_t /* requestId */, int32_t status, const uint8_t *packed,
+                         size_t packedLen, int32_t isFinal, void *userData) {
+    JNIEnv *env = tAttachment.get();
+    if (env == nullptr) {
+        LOGE("Failed to attach search thread; tiered search batch dropped");
+        return;
+    }
+
+    jbyteArray data = copyPacked(env, status, packed, packedLen);
+    env->CallStaticVoidMethod(
+        gJni.searchServiceClass,
+        gJni.onTieredSearchBatch,
+        static_cast<jlong>(reinterpret_cast<intptr_t>(userData)),
+        static_cast<jint>(status),
+        data,
+        static_cast<jboolean>(isFinal != 0)
+    );
+    clearCallbackException(env, "onTieredSearchBatch");
+    if (data != nullptr) {
+        env->DeleteLocalRef(data);
+    }
+}
+
+} // namespace
+
 extern "C" {
 
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM *vm, void * /* reserved */) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+
+    // The bridge is compiled against tantivy_mobile.h; refuse a library
+    // built from a different ABI rather than misreading its structs
+    uint32_t abiVersion = tantivy_abi_version();
+    if (abiVersion != TANTIVY_ABI_VERSION) {
+        LOGE("libtantivy_mobile ABI %u does not match header ABI %u", abiVersion, TANTIVY_ABI_VERSION);
+        return JNI_ERR;
+    }
+
+    if (!initJniCache(env)) {
+        LOGE("Failed to resolve JNI class and method IDs");
+        releaseJniCache(env);
+        return JNI_ERR;
+    }
+    gJni.vm = vm;
+
+    return JNI_VERSION_1_6;
+}
+
+JNIEXPORT void JNICALL
+JNI_OnUnload(JavaVM *vm, void * /* reserved */) {
+    JNIEnv *env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return;
+    }
+    releaseJniCache(env);
+}
+
 JNIEXPORT void JNICALL
 Java_com_prepperapp_TantivyBridge_nativeInitLogging(JNIEnv *env, jobject /* this */) {
     tantivy_init_logging();
@@ -82,6 +470,50 @@ Java_com_prepperapp_TantivyBridge_nativeAddDocument(
     return result;
 }
 
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_TantivyBridge_nativeAddDocumentsBatch(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong indexPtr,
+    jobject batch
+) {
+    // The batch is already UTF-8 and length-prefixed, so the whole buffer is
+    // handed to Rust without any per-document string conversion.
+    void *address = env->GetDirectBufferAddress(batch);
+    jlong capacity = env->GetDirectBufferCapacity(batch);
+    if (address == nullptr || capacity <= 0) {
+        LOGE("nativeAddDocumentsBatch requires a direct ByteBuffer");
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    
+    void *index = reinterpret_cast<void*>(indexPtr);
+    int32_t added = tantivy_add_documents_batch(
+        index,
+        static_cast<const uint8_t*>(address),
+        static_cast<size_t>(capacity)
+    );
+    if (added < 0) {
+        LOGE("Failed to add document batch (%d)", added);
+    }
+    return added;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_TantivyBridge_nativeSetCommitThresholds(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong indexPtr,
+    jint maxDocs,
+    jlong maxBytes
+) {
+    void *index = reinterpret_cast<void*>(indexPtr);
+    return tantivy_set_commit_thresholds(
+        index,
+        static_cast<size_t>(maxDocs),
+        static_cast<size_t>(maxBytes)
+    );
+}
+
 JNIEXPORT jint JNICALL
 Java_com_prepperapp_TantivyBridge_nativeCommit(JNIEnv *env, jobject /* this */, jlong indexPtr) {
     void *index = reinterpret_cast<void*>(indexPtr);
@@ -99,34 +531,24 @@ Java_com_prepperapp_TantivyBridge_nativeSearch(
     void *index = reinterpret_cast<void*>(indexPtr);
     const char *nativeQuery = env->GetStringUTFChars(query, nullptr);
     
-    SearchResults *results = tantivy_search(index, nativeQuery, limit);
+    // Results live in this thread's arena until its next search
+    const SearchResults *results = tantivy_search_arena(index, tThreadArena.get(), nativeQuery, limit);
     env->ReleaseStringUTFChars(query, nativeQuery);
     
     if (results == nullptr) {
         return nullptr;
     }
     
-    // Get class references
-    jclass searchResultClass = env->FindClass("com/prepperapp/TantivyBridge$SearchResultNative");
-    jclass searchResultsClass = env->FindClass("com/prepperapp/TantivyBridge$SearchResultsNative");
-    
     // Create result array
     jobjectArray resultArray = env->NewObjectArray(
         results->count,
-        searchResultClass,
+        gJni.searchResultClass,
         nullptr
     );
     
-    // Create SearchResultNative constructor
-    jmethodID resultConstructor = env->GetMethodID(
-        searchResultClass,
-        "<init>",
-        "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;IF)V"
-    );
-    
     // Fill array with results
     for (size_t i = 0; i < results->count; i++) {
-        SearchResult &result = results->results[i];
+        const SearchResult &result = results->results[i];
         
         jstring jId = env->NewStringUTF(result.id);
         jstring jTitle = env->NewStringUTF(result.title);
@@ -134,8 +556,8 @@ Java_com_prepperapp_TantivyBridge_nativeSearch(
         jstring jSummary = env->NewStringUTF(result.summary);
         
         jobject jResult = env->NewObject(
-            searchResultClass,
-            resultConstructor,
+            gJni.searchResultClass,
+            gJni.searchResultConstructor,
             jId, jTitle, jCategory, jSummary,
             static_cast<jint>(result.priority),
             result.score
@@ -152,28 +574,154 @@ Java_com_prepperapp_TantivyBridge_nativeSearch(
     }
     
     // Create SearchResultsNative
-    jmethodID resultsConstructor = env->GetMethodID(
-        searchResultsClass,
-        "<init>",
-        "([Lcom/prepperapp/TantivyBridge$SearchResultNative;J)V"
-    );
-    
     jobject jResults = env->NewObject(
-        searchResultsClass,
-        resultsConstructor,
+        gJni.searchResultsClass,
+        gJni.searchResultsConstructor,
         resultArray,
         static_cast<jlong>(results->search_time_ms)
     );
     
-    // Free native results
-    tantivy_free_search_results(results);
-    
     return jResults;
 }
 
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_TantivyBridge_nativeSearchPacked(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring query,
+    jint limit,
+    jobject buffer
+) {
+    // Results are written straight into the caller's direct ByteBuffer,
+    // so no Java objects are created per hit.
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || capacity <= 0) {
+        LOGE("nativeSearchPacked requires a direct ByteBuffer");
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    
+    void *index = reinterpret_cast<void*>(indexPtr);
+    const char *nativeQuery = env->GetStringUTFChars(query, nullptr);
+    
+    int32_t count = tantivy_search_packed(
+        index,
+        nativeQuery,
+        static_cast<size_t>(limit),
+        static_cast<uint8_t*>(address),
+        static_cast<size_t>(capacity)
+    );
+    env->ReleaseStringUTFChars(query, nativeQuery);
+    
+    return count;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_TantivyBridge_nativeSearchHits(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong indexPtr,
+    jstring query,
+    jint limit
+) {
+    // Phase one only ranks; stored fields are loaded by nativeHydrate
+    if (limit <= 0) return 0;
+    
+    ScopedUtfChars nativeQuery(env, query);
+    if (nativeQuery.get() == nullptr) return 0;
+    
+    SearchHits *hits = tantivy_search_hits(
+        reinterpret_cast<void*>(indexPtr),
+        nativeQuery.get(),
+        static_cast<size_t>(limit)
+    );
+    return reinterpret_cast<jlong>(hits);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_TantivyBridge_nativeHitsCount(JNIEnv *env, jobject /* this */, jlong hitsPtr) {
+    return static_cast<jint>(tantivy_hits_count(reinterpret_cast<const SearchHits*>(hitsPtr)));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_TantivyBridge_nativeHydrate(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong hitsPtr,
+    jint start,
+    jint count,
+    jobject buffer
+) {
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || capacity <= 0 || start < 0 || count < 0) {
+        LOGE("nativeHydrate requires a direct ByteBuffer and a valid range");
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    
+    return tantivy_hits_hydrate(
+        reinterpret_cast<const SearchHits*>(hitsPtr),
+        static_cast<size_t>(start),
+        static_cast<size_t>(count),
+        static_cast<uint8_t*>(address),
+        static_cast<size_t>(capacity)
+    );
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_TantivyBridge_nativeFreeHits(JNIEnv *env, jobject /* this */, jlong hitsPtr) {
+    tantivy_hits_free(reinterpret_cast<SearchHits*>(hitsPtr));
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_TantivyBridge_nativeCreateSearchSession(JNIEnv *env, jobject /* this */, jlong indexPtr) {
+    return reinterpret_cast<jlong>(tantivy_incremental_create(reinterpret_cast<void*>(indexPtr)));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_TantivyBridge_nativeSearchIncremental(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong sessionPtr,
+    jstring query,
+    jint limit,
+    jobject buffer
+) {
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || capacity <= 0 || limit < 0) {
+        LOGE("nativeSearchIncremental requires a direct ByteBuffer");
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    
+    ScopedUtfChars nativeQuery(env, query);
+    if (nativeQuery.get() == nullptr) return TANTIVY_ERROR_INVALID_PARAM;
+    
+    // Blocks only until an older keystroke on this session notices it is
+    // stale; that call then returns TANTIVY_ERROR_CANCELLED
+    return tantivy_search_incremental(
+        reinterpret_cast<const SearchSession*>(sessionPtr),
+        nativeQuery.get(),
+        static_cast<size_t>(limit),
+        static_cast<uint8_t*>(address),
+        static_cast<size_t>(capacity)
+    );
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_TantivyBridge_nativeCancelIncremental(JNIEnv *env, jobject /* this */, jlong sessionPtr) {
+    tantivy_incremental_cancel(reinterpret_cast<const SearchSession*>(sessionPtr));
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_TantivyBridge_nativeFreeSearchSession(JNIEnv *env, jobject /* this */, jlong sessionPtr) {
+    tantivy_incremental_free(reinterpret_cast<SearchSession*>(sessionPtr));
+}
+
 JNIEXPORT void JNICALL
 Java_com_prepperapp_TantivyBridge_nativeFreeSearchResults(JNIEnv *env, jobject /* this */, jlong resultsPtr) {
-    // Not needed - we free immediately after converting to Java objects
+    // Not needed - results live in the per-thread arena and are reused
 }
 
 JNIEXPORT void JNICALL
@@ -186,16 +734,531 @@ JNIEXPORT jobject JNICALL
 Java_com_prepperapp_TantivyBridge_nativeGetIndexStats(JNIEnv *env, jobject /* this */, jlong indexPtr) {
     void *index = reinterpret_cast<void*>(indexPtr);
     IndexStats stats = tantivy_get_index_stats(index);
+    return toIndexStats(env, stats);
+}
+
+// MARK: - MultiSearchManager (com.prepperapp.SearchService)
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeInitMultiManager(
+    JNIEnv *env,
+    jobject /* this */,
+    jint searchThreads,
+    jint asyncThreads,
+    jint backgroundSearchThreads,
+    jint coreClass,
+    jint threadPriority
+) {
+    // Non-positive counts take the native defaults
+    MultiManagerOptions options = multi_manager_options_default();
+    if (searchThreads > 0) options.search_threads = static_cast<uint32_t>(searchThreads);
+    if (asyncThreads > 0) options.async_threads = static_cast<uint32_t>(asyncThreads);
+    if (backgroundSearchThreads > 0) options.background_search_threads = static_cast<uint32_t>(backgroundSearchThreads);
+    options.core_class = coreClass;
+    options.thread_priority = threadPriority;
+    
+    MultiSearchManager *manager = init_multi_manager_with_options(&options);
+    if (manager == nullptr) {
+        LOGE("Failed to create multi-search manager");
+        return 0;
+    }
+    return reinterpret_cast<jlong>(manager);
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_SearchService_nativeDestroyMultiManager(JNIEnv *env, jobject /* this */, jlong managerPtr) {
+    destroy_multi_manager(toManager(managerPtr));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeLoadIndex(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring name,
+    jstring path,
+    jlong docstoreCacheBytes
+) {
+    ScopedUtfChars nativeName(env, name);
+    ScopedUtfChars nativePath(env, path);
+    int32_t result = multi_manager_load_index_with_cache(
+        toManager(managerPtr),
+        nativeName.get(),
+        nativePath.get(),
+        static_cast<uint64_t>(docstoreCacheBytes < 0 ? 0 : docstoreCacheBytes)
+    );
+    if (result != 0) {
+        LOGE("Failed to load module %s", nativeName.get() != nullptr ? nativeName.get() : "(null)");
+    }
+    return result;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeUnloadIndex(JNIEnv *env, jobject /* this */, jlong managerPtr, jstring name) {
+    ScopedUtfChars nativeName(env, name);
+    return multi_manager_unload_index(toManager(managerPtr), nativeName.get());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeReloadIndex(JNIEnv *env, jobject /* this */, jlong managerPtr, jstring name) {
+    ScopedUtfChars nativeName(env, name);
+    return multi_manager_reload_index(toManager(managerPtr), nativeName.get());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeRegisterIndex(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring name,
+    jstring path,
+    jint tier,
+    jlong docstoreCacheBytes
+) {
+    ScopedUtfChars nativeName(env, name);
+    ScopedUtfChars nativePath(env, path);
+    return multi_manager_register_index(
+        toManager(managerPtr),
+        nativeName.get(),
+        nativePath.get(),
+        static_cast<uint32_t>(tier < 0 ? 0 : tier),
+        static_cast<uint64_t>(docstoreCacheBytes < 0 ? 0 : docstoreCacheBytes)
+    );
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeModuleState(JNIEnv *env, jobject /* this */, jlong managerPtr, jstring name) {
+    ScopedUtfChars nativeName(env, name);
+    return multi_manager_module_state(toManager(managerPtr), nativeName.get());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeSetOpenModuleLimit(JNIEnv *env, jobject /* this */, jlong managerPtr, jint count) {
+    if (count < 0) {
+        return -1;
+    }
+    return multi_manager_set_open_module_limit(toManager(managerPtr), static_cast<uint32_t>(count));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeSearchBinary(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring query,
+    jint limit,
+    jint moduleMask,
+    jfloatArray moduleWeights,
+    jobject buffer,
+    jlongArray timing
+) {
+    // Same packed layout as TantivyBridge.nativeSearchPacked, with the
+    // module slot filled in. A non-null `timing` receives the phases of
+    // this search, with the JNI copying in marshal_ns.
+    ScopedTrace trace("tantivy.jni.search");
+    auto start = std::chrono::steady_clock::now();
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || capacity <= 0) {
+        LOGE("nativeSearchBinary requires a direct ByteBuffer");
+        return -1;
+    }
     
-    jclass statsClass = env->FindClass("com/prepperapp/TantivyBridge$IndexStats");
-    jmethodID constructor = env->GetMethodID(statsClass, "<init>", "(JJ)V");
+    // Options live on the stack; weights are copied straight out of the
+    // Java array, indexed by module slot
+    MultiSearchOptions options = toOptions(env, limit, moduleMask, moduleWeights);
     
-    return env->NewObject(
-        statsClass,
-        constructor,
-        static_cast<jlong>(stats.num_docs),
-        static_cast<jlong>(stats.index_size_bytes)
+    ScopedUtfChars nativeQuery(env, query);
+    SearchTiming nativeTiming = {};
+    int32_t count = multi_manager_search_binary_timed(
+        toManager(managerPtr),
+        nativeQuery.get(),
+        &options,
+        static_cast<uint8_t*>(address),
+        static_cast<size_t>(capacity),
+        timing != nullptr ? &nativeTiming : nullptr
     );
+    if (timing != nullptr) {
+        // Everything outside the library call is marshalling: buffer and
+        // array access and the query's UTF conversion
+        uint64_t total = nanosSince(start);
+        nativeTiming.marshal_ns = total > nativeTiming.total_ns ? total - nativeTiming.total_ns : 0;
+        nativeTiming.total_ns = total;
+        copyTiming(env, nativeTiming, timing);
+    }
+    return count;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeSearchFiltered(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring query,
+    jint limit,
+    jint moduleMask,
+    jfloatArray moduleWeights,
+    jstring category,
+    jint priorityMin,
+    jint priorityMax,
+    jobject buffer
+) {
+    // nativeSearchBinary with a category (null for any) and an inclusive
+    // priority range, where a negative priorityMax leaves it unbounded. An
+    // empty query browses the matching articles by priority.
+    ScopedTrace trace("tantivy.jni.search");
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || capacity <= 0) {
+        LOGE("nativeSearchFiltered requires a direct ByteBuffer");
+        return -1;
+    }
+
+    MultiSearchOptions options = toOptions(env, limit, moduleMask, moduleWeights);
+    ScopedUtfChars nativeQuery(env, query);
+    ScopedUtfChars nativeCategory(env, category);
+    SearchFilter filter = {};
+    filter.category = nativeCategory.get();
+    filter.priority_min = priorityMin > 0 ? static_cast<uint32_t>(priorityMin) : 0;
+    filter.priority_max = priorityMax >= 0 ? static_cast<uint32_t>(priorityMax) : UINT32_MAX;
+    return multi_manager_search_filtered(
+        toManager(managerPtr),
+        nativeQuery.get(),
+        &options,
+        &filter,
+        static_cast<uint8_t*>(address),
+        static_cast<size_t>(capacity)
+    );
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeSearchAsync(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring query,
+    jint limit,
+    jint moduleMask,
+    jfloatArray moduleWeights,
+    jlong token
+) {
+    // Returns at once; the results arrive on a native search thread through
+    // SearchService.onAsyncSearchComplete(token, ...)
+    MultiSearchOptions options = toOptions(env, limit, moduleMask, moduleWeights);
+    ScopedUtfChars nativeQuery(env, query);
+    uint64_t requestId = multi_manager_search_async(
+        toManager(managerPtr),
+        nativeQuery.get(),
+        &options,
+        onAsyncSearchComplete,
+        reinterpret_cast<void*>(static_cast<intptr_t>(token))
+    );
+    return static_cast<jlong>(requestId);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeSearchTiered(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring query,
+    jint limit,
+    jint moduleMask,
+    jfloatArray moduleWeights,
+    jintArray tierDeadlinesMs,
+    jlong token
+) {
+    // Returns at once; batches arrive on a native search thread through
+    // SearchService.onTieredSearchBatch(token, ...)
+    MultiSearchOptions options = toOptions(env, limit, moduleMask, moduleWeights);
+    ScopedUtfChars nativeQuery(env, query);
+
+    jint deadlines[kMaxTierDeadlines] = {};
+    uint32_t budgets[kMaxTierDeadlines] = {};
+    jsize deadlineCount = 0;
+    if (tierDeadlinesMs != nullptr) {
+        deadlineCount = env->GetArrayLength(tierDeadlinesMs);
+        if (deadlineCount > kMaxTierDeadlines) {
+            deadlineCount = kMaxTierDeadlines;
+        }
+        env->GetIntArrayRegion(tierDeadlinesMs, 0, deadlineCount, deadlines);
+    }
+    // A negative budget means none (0), not a wrapped-around u32
+    for (jsize i = 0; i < deadlineCount; i++) {
+        budgets[i] = deadlines[i] > 0 ? static_cast<uint32_t>(deadlines[i]) : 0;
+    }
+    uint64_t requestId = multi_manager_search_tiered(
+        toManager(managerPtr),
+        nativeQuery.get(),
+        &options,
+        budgets,
+        static_cast<size_t>(deadlineCount),
+        onTieredSearchBatch,
+        reinterpret_cast<void*>(static_cast<intptr_t>(token))
+    );
+    return static_cast<jlong>(requestId);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeCancelSearch(JNIEnv *env, jobject /* this */, jlong managerPtr, jlong requestId) {
+    return multi_manager_cancel_search(toManager(managerPtr), static_cast<uint64_t>(requestId));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeModuleSlot(JNIEnv *env, jobject /* this */, jlong managerPtr, jstring name) {
+    ScopedUtfChars nativeName(env, name);
+    return multi_manager_module_slot(toManager(managerPtr), nativeName.get());
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_prepperapp_SearchService_nativeGetStats(JNIEnv *env, jobject /* this */, jlong managerPtr) {
+    const char *statsJson = multi_manager_get_stats(toManager(managerPtr));
+    if (statsJson == nullptr) {
+        return nullptr;
+    }
+    
+    jstring result = env->NewStringUTF(statsJson);
+    free_rust_string(const_cast<char*>(statsJson));
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_prepperapp_SearchService_nativeGetDocument(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring module,
+    jstring docId
+) {
+    ScopedUtfChars nativeModule(env, module);
+    ScopedUtfChars nativeDocId(env, docId);
+    const char *documentJson = multi_manager_get_document(toManager(managerPtr), nativeModule.get(), nativeDocId.get());
+    if (documentJson == nullptr) {
+        return nullptr;
+    }
+
+    jstring result = env->NewStringUTF(documentJson);
+    free_rust_string(const_cast<char*>(documentJson));
+    return result;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeOpenDocumentStream(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring module,
+    jstring docId
+) {
+    ScopedUtfChars nativeModule(env, module);
+    ScopedUtfChars nativeDocId(env, docId);
+    DocumentStream *stream =
+        multi_manager_open_document_stream(toManager(managerPtr), nativeModule.get(), nativeDocId.get());
+    return reinterpret_cast<jlong>(stream);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeDocumentStreamLength(JNIEnv *env, jobject /* this */, jlong streamPtr) {
+    return document_stream_length(reinterpret_cast<const DocumentStream*>(streamPtr));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeReadDocumentStream(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong streamPtr,
+    jobject buffer,
+    jint maxBytes
+) {
+    // The chunk lands straight in the caller's direct ByteBuffer; Kotlin
+    // decodes it from there without an intermediate byte[] or jstring
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (address == nullptr || capacity <= 0 || maxBytes <= 0) {
+        LOGE("nativeReadDocumentStream requires a direct ByteBuffer");
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    return document_stream_read(
+        reinterpret_cast<DocumentStream*>(streamPtr),
+        static_cast<uint8_t*>(address),
+        static_cast<size_t>(capacity < maxBytes ? capacity : maxBytes)
+    );
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_SearchService_nativeFreeDocumentStream(JNIEnv *env, jobject /* this */, jlong streamPtr) {
+    document_stream_free(reinterpret_cast<DocumentStream*>(streamPtr));
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_prepperapp_SearchService_nativeGetModuleStats(JNIEnv *env, jobject /* this */, jlong managerPtr, jstring name) {
+    // Binary, unlike nativeGetStats, so it can be sampled on a timer
+    ScopedUtfChars nativeName(env, name);
+    IndexStats stats = {};
+    if (multi_manager_module_stats(toManager(managerPtr), nativeName.get(), &stats) != 0) {
+        return nullptr;
+    }
+    return toIndexStats(env, stats);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_prepperapp_SearchService_nativeGetCacheStats(JNIEnv *env, jobject /* this */, jlong managerPtr) {
+    const char *statsJson = multi_manager_cache_stats(toManager(managerPtr));
+    if (statsJson == nullptr) {
+        return nullptr;
+    }
+
+    jstring result = env->NewStringUTF(statsJson);
+    free_rust_string(const_cast<char*>(statsJson));
+    return result;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeSetMemoryBudget(JNIEnv *env, jobject /* this */, jlong managerPtr, jlong bytes) {
+    if (bytes < 0) {
+        return -1;
+    }
+    return multi_manager_set_memory_budget(toManager(managerPtr), static_cast<size_t>(bytes));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeTrimMemory(JNIEnv *env, jobject /* this */, jlong managerPtr, jint level) {
+    return multi_manager_trim_memory(toManager(managerPtr), level);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeSetBackgroundIndexing(JNIEnv *env, jobject /* this */, jlong managerPtr, jboolean active) {
+    return multi_manager_set_background_indexing(toManager(managerPtr), active ? 1 : 0);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeStartWarmup(JNIEnv *env, jobject /* this */, jlong managerPtr, jstring manifestJson) {
+    ScopedUtfChars nativeManifest(env, manifestJson);
+    return reinterpret_cast<jlong>(multi_manager_start_warmup(toManager(managerPtr), nativeManifest.get()));
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_SearchService_nativeCancelWarmup(JNIEnv *env, jobject /* this */, jlong warmupPtr) {
+    warmup_cancel(reinterpret_cast<const WarmupHandle*>(warmupPtr));
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_SearchService_nativeFreeWarmup(JNIEnv *env, jobject /* this */, jlong warmupPtr) {
+    warmup_free(reinterpret_cast<WarmupHandle*>(warmupPtr));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeSetCacheCapacity(JNIEnv *env, jobject /* this */, jlong managerPtr, jlong bytes) {
+    if (bytes < 0) {
+        return -1;
+    }
+    return multi_manager_set_cache_capacity(toManager(managerPtr), static_cast<size_t>(bytes));
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_prepperapp_SearchService_nativeOpenWriter(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong managerPtr,
+    jstring name,
+    jstring path,
+    jlong heapBytes,
+    jint commitDelayMs
+) {
+    ScopedUtfChars nativeName(env, name);
+    ScopedUtfChars nativePath(env, path);
+    if (managerPtr == 0 || nativeName.get() == nullptr || nativePath.get() == nullptr) {
+        return 0;
+    }
+
+    WriterOptions options = tantivy_writer_options_default();
+    options.heap_bytes = heapBytes > 0 ? static_cast<uint64_t>(heapBytes) : 0;
+    options.commit_delay_ms = commitDelayMs > 0 ? static_cast<uint32_t>(commitDelayMs) : 0;
+
+    auto *binding = new WriterBinding{toManager(managerPtr), nativeName.get(), nullptr};
+    binding->writer = tantivy_writer_open(nativePath.get(), &options, reloadWrittenModule, binding);
+    if (binding->writer == nullptr) {
+        LOGE("Failed to open writer for %s", nativeName.get());
+        delete binding;
+        return 0;
+    }
+    return reinterpret_cast<jlong>(binding);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeWriterAddDocument(
+    JNIEnv *env,
+    jobject /* this */,
+    jlong writerPtr,
+    jstring id,
+    jstring title,
+    jstring category,
+    jint priority,
+    jstring summary,
+    jstring content
+) {
+    ScopedUtfChars nativeId(env, id);
+    ScopedUtfChars nativeTitle(env, title);
+    ScopedUtfChars nativeCategory(env, category);
+    ScopedUtfChars nativeSummary(env, summary);
+    ScopedUtfChars nativeContent(env, content);
+    return tantivy_writer_add_document(
+        toWriter(writerPtr),
+        nativeId.get(),
+        nativeTitle.get(),
+        nativeCategory.get(),
+        static_cast<uint64_t>(priority),
+        nativeSummary.get(),
+        nativeContent.get()
+    );
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeWriterAddDocumentsBatch(JNIEnv *env, jobject /* this */, jlong writerPtr, jobject batch) {
+    void *address = env->GetDirectBufferAddress(batch);
+    jlong capacity = env->GetDirectBufferCapacity(batch);
+    if (address == nullptr || capacity <= 0) {
+        LOGE("nativeWriterAddDocumentsBatch requires a direct ByteBuffer");
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    return tantivy_writer_add_documents_batch(
+        toWriter(writerPtr),
+        static_cast<const uint8_t*>(address),
+        static_cast<size_t>(capacity)
+    );
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeWriterDeleteDocument(JNIEnv *env, jobject /* this */, jlong writerPtr, jstring id) {
+    ScopedUtfChars nativeId(env, id);
+    return tantivy_writer_delete_document(toWriter(writerPtr), nativeId.get());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeWriterCommit(JNIEnv *env, jobject /* this */, jlong writerPtr) {
+    return tantivy_writer_commit(toWriter(writerPtr));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeWriterSetMerging(JNIEnv *env, jobject /* this */, jlong writerPtr, jboolean allowed) {
+    return tantivy_writer_set_merging(toWriter(writerPtr), allowed ? 1 : 0);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_prepperapp_SearchService_nativeWriterSegmentCount(JNIEnv *env, jobject /* this */, jlong writerPtr) {
+    return tantivy_writer_segment_count(toWriter(writerPtr));
+}
+
+JNIEXPORT void JNICALL
+Java_com_prepperapp_SearchService_nativeCloseWriter(JNIEnv *env, jobject /* this */, jlong writerPtr) {
+    auto *binding = reinterpret_cast<WriterBinding*>(writerPtr);
+    if (binding == nullptr) {
+        return;
+    }
+    // Joins the writer thread, so the callback cannot run after the delete
+    tantivy_writer_close(binding->writer);
+    delete binding;
 }
 
-} // extern "C"
\ No newline at end of file
+} // extern "C"
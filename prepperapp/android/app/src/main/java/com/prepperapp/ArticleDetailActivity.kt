@@ -6,7 +6,9 @@ import android.view.MenuItem
 import androidx.appcompat.app.AlertDialog
 import androidx.appcompat.app.AppCompatActivity
 import androidx.core.view.WindowCompat
+import androidx.lifecycle.lifecycleScope
 import com.prepperapp.databinding.ActivityArticleDetailBinding
+import kotlinx.coroutines.launch
 
 class ArticleDetailActivity : AppCompatActivity() {
     
@@ -45,9 +47,31 @@ class ArticleDetailActivity : AppCompatActivity() {
     }
     
     private fun loadArticle() {
-        // TODO: Load from ZIM file using articleId
-        // For now, show mock content
+        val id = articleId
+        if (id == null) {
+            showPlaceholderContent()
+            return
+        }
         
+        // Append the body as it streams in, so the first screen of a long
+        // manual shows before the rest has been read
+        lifecycleScope.launch {
+            var streamed = false
+            SearchService.documentChunks(id).collect { chunk ->
+                if (!streamed) {
+                    binding.contentText.text = ""
+                    streamed = true
+                }
+                binding.contentText.append(chunk)
+            }
+            if (!streamed) {
+                showPlaceholderContent()
+            }
+        }
+    }
+    
+    // Shown until articles without a stored body are read from their ZIM file
+    private fun showPlaceholderContent() {
         val content = """
 IMMEDIATE ACTION REQUIRED
 
@@ -0,0 +1,93 @@
+package com.prepperapp
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.CharBuffer
+import java.nio.charset.CharsetEncoder
+import java.nio.charset.CodingErrorAction
+
+/**
+ * Encodes documents into the length-prefixed batch layout read by
+ * `tantivy_add_documents_batch` (see `tantivy_mobile.h`). Strings are encoded
+ * to UTF-8 straight into a reused direct buffer, so a whole content module
+ * crosses JNI in a handful of calls instead of one call per document.
+ */
+class DocumentBatch(capacityBytes: Int = DEFAULT_CAPACITY_BYTES) {
+
+    private var buffer: ByteBuffer = allocate(capacityBytes)
+    private val encoder: CharsetEncoder = Charsets.UTF_8.newEncoder()
+        .onMalformedInput(CodingErrorAction.REPLACE)
+        .onUnmappableCharacter(CodingErrorAction.REPLACE)
+
+    var count = 0
+        private set
+
+    val sizeBytes: Int get() = buffer.position()
+
+    init {
+        clear()
+    }
+
+    fun clear() {
+        buffer.clear()
+        buffer.putInt(MAGIC)
+        buffer.putInt(0)
+        count = 0
+    }
+
+    /**
+     * Appends a document. Returns false when the batch is full; send it and
+     * [clear] before retrying. A document larger than an empty batch grows it.
+     */
+    fun add(document: TantivyBridge.IndexDocument): Boolean {
+        val start = buffer.position()
+        if (tryPut(document)) {
+            count++
+            buffer.putInt(OFFSET_COUNT, count)
+            return true
+        }
+
+        buffer.position(start)
+        if (count > 0) return false
+
+        val grown = allocate(buffer.capacity() * 2)
+        grown.put(buffer.duplicate().apply { flip() })
+        buffer = grown
+        return add(document)
+    }
+
+    internal fun buffer(): ByteBuffer = buffer
+
+    private fun tryPut(document: TantivyBridge.IndexDocument): Boolean {
+        if (buffer.remaining() < 4) return false
+        buffer.putInt(document.priority)
+        return putString(document.id) &&
+            putString(document.title) &&
+            putString(document.category) &&
+            putString(document.summary) &&
+            putString(document.content)
+    }
+
+    private fun putString(value: String): Boolean {
+        if (buffer.remaining() < 4) return false
+        val lengthAt = buffer.position()
+        buffer.position(lengthAt + 4)
+
+        encoder.reset()
+        if (encoder.encode(CharBuffer.wrap(value), buffer, true).isOverflow) return false
+        if (encoder.flush(buffer).isOverflow) return false
+
+        buffer.putInt(lengthAt, buffer.position() - lengthAt - 4)
+        return true
+    }
+
+    companion object {
+        const val MAGIC = 0x31424454 // "TDB1"
+        const val DEFAULT_CAPACITY_BYTES = 1024 * 1024
+
+        private const val OFFSET_COUNT = 4
+
+        private fun allocate(capacity: Int): ByteBuffer =
+            ByteBuffer.allocateDirect(capacity).order(ByteOrder.LITTLE_ENDIAN)
+    }
+}
@@ -0,0 +1,50 @@
+package com.prepperapp
+
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.withContext
+import java.io.Closeable
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+
+/**
+ * Search-as-you-type over one index. Each keystroke that extends the previous
+ * query narrows its native candidate set instead of searching cold, and a call
+ * overtaken by a newer keystroke returns null instead of results.
+ */
+class IncrementalSearch internal constructor(private var sessionPtr: Long) : Closeable {
+
+    private val packedBuffers = PackedBufferPool()
+
+    // Searches share the session; close waits for them to drain
+    private val lifecycle = ReentrantReadWriteLock()
+
+    /**
+     * Results for [query], or null when superseded by a newer call or on
+     * error. Valid until the second-next call, as with [PackedBufferPool].
+     */
+    suspend fun search(query: String, limit: Int = 20): PackedSearchResults? = withContext(Dispatchers.IO) {
+        lifecycle.read {
+            val session = sessionPtr
+            if (session == 0L) return@withContext null
+            packedBuffers.search { buffer -> TantivyBridge.nativeSearchIncremental(session, query, limit, buffer) }
+        }
+    }
+
+    /** Abandons the in-flight query, e.g. when the search box is cleared */
+    fun cancel() {
+        lifecycle.read {
+            if (sessionPtr != 0L) TantivyBridge.nativeCancelIncremental(sessionPtr)
+        }
+    }
+
+    override fun close() {
+        cancel()
+        lifecycle.write {
+            if (sessionPtr != 0L) {
+                TantivyBridge.nativeFreeSearchSession(sessionPtr)
+                sessionPtr = 0L
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+package com.prepperapp
+
+import android.util.Log
+import kotlinx.serialization.Serializable
+import kotlinx.serialization.json.Json
+import java.io.File
+import java.io.FileOutputStream
+import java.io.RandomAccessFile
+import java.security.MessageDigest
+
+/** delta.json written by tantivy-delta */
+@Serializable
+data class IndexDelta(
+    val format: Int,
+    val base_meta_sha256: String,
+    val target_meta_sha256: String,
+    val files: List<IndexDeltaFile>,
+    val remove: List<String>,
+    val data_size: Long,
+    val data_sha256: String
+)
+
+@Serializable
+data class IndexDeltaFile(
+    val name: String,
+    val size: Long,
+    val sha256: String,
+    val ops: List<IndexDeltaOp>
+)
+
+/** A byte range of an installed file ("copy") or of delta.bin ("data") */
+@Serializable
+data class IndexDeltaOp(
+    val op: String,
+    val file: String? = null,
+    val offset: Long,
+    val len: Long
+)
+
+/**
+ * Updates a module index in place from a tantivy-delta (delta.json +
+ * delta.bin). New files are written beside the installed ones and
+ * checksummed, and meta.json is renamed in last, so an interrupted apply
+ * leaves the installed version searchable. Reload the module afterwards.
+ */
+object IndexDeltaApplier {
+    private const val TAG = "IndexDeltaApplier"
+
+    // Must match DELTA_FORMAT_VERSION in tantivy-indexer's delta.rs
+    private const val SUPPORTED_FORMAT = 1
+    private const val COPY_BUFFER_BYTES = 1 shl 20
+
+    private val json = Json { ignoreUnknownKeys = true }
+
+    private class DeltaException(message: String) : Exception(message)
+
+    /** Returns false, leaving the installed version intact, if the delta does not apply */
+    fun apply(manifest: File, data: File, indexDir: File): Boolean {
+        val staged = mutableListOf<Pair<File, File>>()
+        return try {
+            val delta = json.decodeFromString<IndexDelta>(manifest.readText())
+            if (delta.format != SUPPORTED_FORMAT) {
+                throw DeltaException("unsupported delta format ${delta.format}")
+            }
+
+            // A delta only rebuilds the exact version it was made from
+            val installed = sha256(File(indexDir, "meta.json"))
+            if (installed == delta.target_meta_sha256) return true // Already applied
+            if (installed != delta.base_meta_sha256) {
+                throw DeltaException("delta does not match the installed version")
+            }
+            if (data.length() != delta.data_size || sha256(data) != delta.data_sha256) {
+                throw DeltaException("delta.bin is corrupted")
+            }
+
+            // Stage every file before touching the installed version
+            RandomAccessFile(data, "r").use { payload ->
+                for (file in delta.files) {
+                    val part = File(indexDir, file.name + ".part")
+                    staged += part to File(indexDir, file.name)
+                    writeFile(file, indexDir, payload, part)
+                }
+            }
+
+            // Files are listed with meta.json last, which publishes the new version
+            for ((part, target) in staged) {
+                if (!part.renameTo(target)) {
+                    throw DeltaException("could not move ${part.name} into place")
+                }
+            }
+            staged.clear()
+
+            // Open searchers keep their mappings of removed files until reloaded
+            delta.remove.forEach { File(indexDir, it).delete() }
+            true
+        } catch (e: Exception) {
+            Log.e(TAG, "Failed to apply index delta to ${indexDir.path}", e)
+            staged.forEach { (part, _) -> part.delete() }
+            false
+        }
+    }
+
+    private fun writeFile(file: IndexDeltaFile, indexDir: File, payload: RandomAccessFile, destination: File) {
+        val digest = MessageDigest.getInstance("SHA-256")
+        val buffer = ByteArray(COPY_BUFFER_BYTES)
+        var written = 0L
+
+        FileOutputStream(destination).use { output ->
+            fun copyRange(input: RandomAccessFile, offset: Long, len: Long) {
+                if (offset < 0 || len < 0 || offset + len > input.length()) {
+                    throw DeltaException("range outside its source in ${file.name}")
+                }
+                input.seek(offset)
+                var remaining = len
+                while (remaining > 0) {
+                    val n = input.read(buffer, 0, minOf(remaining, buffer.size.toLong()).toInt())
+                    if (n < 0) throw DeltaException("unexpected end of input in ${file.name}")
+                    digest.update(buffer, 0, n)
+                    output.write(buffer, 0, n)
+                    remaining -= n
+                    written += n
+                }
+            }
+
+            for (op in file.ops) {
+                when (op.op) {
+                    "data" -> copyRange(payload, op.offset, op.len)
+                    "copy" -> {
+                        val source = File(indexDir, op.file ?: throw DeltaException("copy without a file"))
+                        RandomAccessFile(source, "r").use { copyRange(it, op.offset, op.len) }
+                    }
+                    else -> throw DeltaException("unknown op ${op.op}")
+                }
+            }
+            output.fd.sync()
+        }
+
+        if (written != file.size || hex(digest.digest()) != file.sha256) {
+            throw DeltaException("${file.name} does not match its checksum")
+        }
+    }
+
+    private fun sha256(file: File): String {
+        val digest = MessageDigest.getInstance("SHA-256")
+        file.inputStream().use { input ->
+            val buffer = ByteArray(COPY_BUFFER_BYTES)
+            while (true) {
+                val n = input.read(buffer)
+                if (n < 0) break
+                digest.update(buffer, 0, n)
+            }
+        }
+        return hex(digest.digest())
+    }
+
+    private fun hex(bytes: ByteArray): String = bytes.joinToString("") { "%02x".format(it) }
+}
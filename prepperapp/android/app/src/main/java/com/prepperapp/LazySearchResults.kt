@@ -0,0 +1,71 @@
+package com.prepperapp
+
+import java.io.Closeable
+import java.nio.ByteBuffer
+
+/**
+ * Two-phase search results. The native search only ranks hits; stored fields
+ * are hydrated a page at a time when a row is first bound, so the time to the
+ * first result no longer grows with the search limit.
+ *
+ * Holds native memory until [close]d. [SearchResultAdapter] closes the
+ * results it was given when they are replaced.
+ */
+class LazySearchResults internal constructor(private var hitsPtr: Long) : SearchResultRows, Closeable {
+
+    override val size: Int = TantivyBridge.nativeHitsCount(hitsPtr)
+
+    private var buffer: ByteBuffer = ByteBuffer.allocateDirect(PAGE_BYTES)
+    private var page: PackedSearchResults? = null
+    private var pageStart = 0
+
+    override fun title(row: Int): String = pageFor(row).title(row - pageStart)
+    override fun category(row: Int): String = pageFor(row).category(row - pageStart)
+    override fun summary(row: Int): String = pageFor(row).summary(row - pageStart)
+    override fun priority(row: Int): Int = pageFor(row).priority(row - pageStart)
+    fun id(row: Int): String = pageFor(row).id(row - pageStart)
+    fun score(row: Int): Float = pageFor(row).score(row - pageStart)
+
+    override fun toSearchResult(row: Int): SearchResult = pageFor(row).toSearchResult(row - pageStart)
+
+    @Synchronized
+    override fun close() {
+        if (hitsPtr != 0L) {
+            TantivyBridge.nativeFreeHits(hitsPtr)
+            hitsPtr = 0L
+            page = null
+        }
+    }
+
+    /** The hydrated page containing [row], loading it on first access */
+    @Synchronized
+    private fun pageFor(row: Int): PackedSearchResults {
+        if (row < 0 || row >= size) throw IndexOutOfBoundsException("row $row of $size")
+        check(hitsPtr != 0L) { "LazySearchResults used after close" }
+
+        page?.let { current ->
+            if (row >= pageStart && row < pageStart + current.size) return current
+        }
+
+        while (true) {
+            val count = TantivyBridge.nativeHydrate(hitsPtr, row, PAGE_ROWS, buffer)
+            if (count < 0) throw IllegalStateException("hydrate failed: $count")
+
+            val hydrated = PackedSearchResults(buffer)
+            if (hydrated.size > 0 || buffer.capacity() >= MAX_PAGE_BYTES) {
+                check(hydrated.size > 0) { "row $row does not fit in $MAX_PAGE_BYTES bytes" }
+                pageStart = row
+                page = hydrated
+                return hydrated
+            }
+            // A single row did not fit; rows can carry long summaries
+            buffer = ByteBuffer.allocateDirect(buffer.capacity() * 2)
+        }
+    }
+
+    companion object {
+        const val PAGE_ROWS = 16
+        const val PAGE_BYTES = 32 * 1024
+        const val MAX_PAGE_BYTES = 1024 * 1024
+    }
+}
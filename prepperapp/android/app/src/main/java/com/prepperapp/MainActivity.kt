@@ -48,6 +48,11 @@ class MainActivity : AppCompatActivity() {
         initializeTantivy()
     }
     
+    override fun onTrimMemory(level: Int) {
+        super.onTrimMemory(level)
+        SearchService.onTrimMemory(level)
+    }
+    
     private fun setupUI() {
         // Configure toolbar
         setSupportActionBar(binding.toolbar)
@@ -0,0 +1,131 @@
+package com.prepperapp
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/** Rows a result list can bind without materializing a [SearchResult] per hit */
+interface SearchResultRows {
+    val size: Int
+    fun title(row: Int): String
+    fun category(row: Int): String
+    fun summary(row: Int): String
+    fun priority(row: Int): Int
+    fun toSearchResult(row: Int): SearchResult
+}
+
+/**
+ * Read-only view over the packed result layout written by `tantivy_search_packed`
+ * (see `tantivy_mobile.h`). Strings are decoded on access, so rows the adapter
+ * never binds never allocate.
+ *
+ * The view is only valid until its buffer is reused by a later search.
+ */
+class PackedSearchResults internal constructor(buffer: ByteBuffer) : SearchResultRows {
+
+    private val buffer: ByteBuffer = buffer.duplicate().order(ByteOrder.LITTLE_ENDIAN)
+    private val poolOffset: Int = this.buffer.getInt(OFFSET_POOL)
+
+    override val size: Int = if (this.buffer.getInt(OFFSET_MAGIC) == MAGIC) this.buffer.getInt(OFFSET_COUNT) else 0
+    val totalHits: Int = this.buffer.getInt(OFFSET_TOTAL_HITS)
+    val searchTimeMs: Long = this.buffer.getLong(OFFSET_SEARCH_TIME)
+
+    /** True when the buffer was too small to hold every hit */
+    val isTruncated: Boolean get() = size < totalHits
+
+    fun id(row: Int): String = string(row, SLOT_ID)
+    override fun title(row: Int): String = string(row, SLOT_TITLE)
+    override fun category(row: Int): String = string(row, SLOT_CATEGORY)
+    override fun summary(row: Int): String = string(row, SLOT_SUMMARY)
+    fun module(row: Int): String = string(row, SLOT_MODULE)
+    override fun priority(row: Int): Int = buffer.getInt(rowOffset(row) + OFFSET_PRIORITY)
+    fun score(row: Int): Float = buffer.getFloat(rowOffset(row) + OFFSET_SCORE)
+
+    override fun toSearchResult(row: Int) = SearchResult(
+        id = id(row),
+        title = title(row),
+        category = category(row),
+        summary = summary(row),
+        priority = priority(row),
+        score = score(row)
+    )
+
+    private fun rowOffset(row: Int): Int {
+        if (row < 0 || row >= size) throw IndexOutOfBoundsException("row $row of $size")
+        return HEADER_SIZE + row * ROW_SIZE
+    }
+
+    private fun string(row: Int, slot: Int): String {
+        val at = rowOffset(row) + slot * STRING_SLOT_SIZE
+        val length = buffer.getInt(at + 4)
+        if (length == 0) return ""
+
+        val start = poolOffset + buffer.getInt(at)
+        val view = buffer.duplicate()
+        view.limit(start + length)
+        view.position(start)
+        return Charsets.UTF_8.decode(view).toString()
+    }
+
+    companion object {
+        const val MAGIC = 0x31525054 // "TPR1"
+        const val HEADER_SIZE = 24
+        const val ROW_SIZE = 48
+
+        private const val OFFSET_MAGIC = 0
+        private const val OFFSET_COUNT = 4
+        private const val OFFSET_TOTAL_HITS = 8
+        private const val OFFSET_POOL = 12
+        private const val OFFSET_SEARCH_TIME = 16
+
+        private const val STRING_SLOT_SIZE = 8
+        private const val SLOT_ID = 0
+        private const val SLOT_TITLE = 1
+        private const val SLOT_CATEGORY = 2
+        private const val SLOT_SUMMARY = 3
+        private const val SLOT_MODULE = 4
+        private const val OFFSET_PRIORITY = 40
+        private const val OFFSET_SCORE = 44
+    }
+}
+
+/**
+ * Two direct buffers handed out alternately, so the results an adapter is
+ * still binding are not overwritten by the next keystroke's search.
+ */
+internal class PackedBufferPool(initialBytes: Int = INITIAL_BYTES) {
+
+    private val buffers = arrayOf(
+        ByteBuffer.allocateDirect(initialBytes),
+        ByteBuffer.allocateDirect(initialBytes)
+    )
+    private var next = 0
+
+    /**
+     * Runs [search] against the next buffer. [search] returns the native row
+     * count or a negative error code, in which case null is returned.
+     */
+    fun search(search: (ByteBuffer) -> Int): PackedSearchResults? {
+        val slot = take()
+        val buffer = buffers[slot]
+        if (search(buffer) < 0) return null
+
+        val results = PackedSearchResults(buffer)
+        if (results.isTruncated && buffer.capacity() < MAX_BYTES) {
+            // Grow for the next query that lands in this slot
+            buffers[slot] = ByteBuffer.allocateDirect(buffer.capacity() * 2)
+        }
+        return results
+    }
+
+    @Synchronized
+    private fun take(): Int {
+        val slot = next
+        next = slot xor 1
+        return slot
+    }
+
+    companion object {
+        const val INITIAL_BYTES = 64 * 1024
+        const val MAX_BYTES = 1024 * 1024
+    }
+}
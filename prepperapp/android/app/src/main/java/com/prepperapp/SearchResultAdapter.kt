@@ -21,6 +21,31 @@ class SearchResultAdapter(
     private val onItemClick: (SearchResult) -> Unit
 ) : ListAdapter<SearchResult, SearchResultAdapter.ViewHolder>(SearchResultDiffCallback()) {
     
+    // Set when results come from native rows (packed or lazily hydrated);
+    // rows are decoded only when bound instead of materializing every
+    // SearchResult up front.
+    private var packedResults: SearchResultRows? = null
+    
+    /** Shows native rows. [LazySearchResults] are closed once replaced. */
+    fun submitPacked(results: SearchResultRows) {
+        super.submitList(null)
+        replaceRows(results)
+        notifyDataSetChanged()
+    }
+    
+    override fun submitList(list: List<SearchResult>?) {
+        replaceRows(null)
+        super.submitList(list)
+    }
+    
+    private fun replaceRows(results: SearchResultRows?) {
+        val previous = packedResults
+        packedResults = results
+        if (previous !== results) (previous as? LazySearchResults)?.close()
+    }
+    
+    override fun getItemCount(): Int = packedResults?.size ?: super.getItemCount()
+    
     override fun onCreateViewHolder(parent: ViewGroup, viewType: Int): ViewHolder {
         val binding = ItemSearchResultBinding.inflate(
             LayoutInflater.from(parent.context), parent, false
@@ -29,7 +54,12 @@ class SearchResultAdapter(
     }
     
     override fun onBindViewHolder(holder: ViewHolder, position: Int) {
-        holder.bind(getItem(position))
+        val packed = packedResults
+        if (packed != null) {
+            holder.bind(packed, position)
+        } else {
+            holder.bind(getItem(position))
+        }
     }
     
     class ViewHolder(
@@ -41,20 +71,35 @@ class SearchResultAdapter(
             binding.titleText.text = result.title
             binding.categoryText.text = result.category.uppercase()
             binding.summaryText.text = result.summary
+            bindPriority(result.priority)
             
+            // Click listener
+            binding.root.setOnClickListener {
+                onItemClick(result)
+            }
+        }
+        
+        fun bind(results: SearchResultRows, row: Int) {
+            binding.titleText.text = results.title(row)
+            binding.categoryText.text = results.category(row).uppercase()
+            binding.summaryText.text = results.summary(row)
+            bindPriority(results.priority(row))
+            
+            // Only materialize the full result when it is actually opened
+            binding.root.setOnClickListener {
+                onItemClick(results.toSearchResult(row))
+            }
+        }
+        
+        private fun bindPriority(priority: Int) {
             // Set priority indicator color
-            val priorityColor = when (result.priority) {
+            val priorityColor = when (priority) {
                 5 -> Color.parseColor("#FF3838") // Red
                 4 -> Color.parseColor("#FF9500") // Orange  
                 3 -> Color.parseColor("#FFEB3B") // Yellow
                 else -> Color.parseColor("#4D4D4D") // Gray
             }
             binding.priorityIndicator.setBackgroundColor(priorityColor)
-            
-            // Click listener
-            binding.root.setOnClickListener {
-                onItemClick(result)
-            }
         }
     }
     
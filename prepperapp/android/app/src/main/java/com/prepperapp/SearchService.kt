@@ -1,16 +1,32 @@
 package com.prepperapp
 
+import android.content.ComponentCallbacks2
 import android.content.Context
 import android.util.Log
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.channels.SendChannel
+import kotlinx.coroutines.channels.awaitClose
+import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.asStateFlow
+import kotlinx.coroutines.flow.callbackFlow
+import kotlinx.coroutines.flow.conflate
+import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.flowOn
 import kotlinx.coroutines.withContext
 import kotlinx.serialization.Serializable
 import kotlinx.serialization.json.Json
-import kotlinx.serialization.encodeToString
 import java.io.File
 import java.io.FileOutputStream
+import java.nio.ByteBuffer
+import java.nio.charset.StandardCharsets
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicLong
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
 
 // MARK: - Models
 
@@ -32,12 +48,122 @@ data class SearchConfig(
     val module_filter: List<String>? = null
 )
 
+/**
+ * Category and priority filter for [SearchService.searchFiltered]. A null
+ * [category] matches any; a null [priorityMax] leaves the range open.
+ */
+data class ArticleFilter(
+    val category: String? = null,
+    val priorityMin: Int = 0,
+    val priorityMax: Int? = null
+)
+
+/**
+ * Native search threads. Counts of 0 take the native defaults (4 search
+ * threads capped at the core count, 2 async, 1 while indexing).
+ */
+data class SearchThreadConfig(
+    val searchThreads: Int = 0,
+    val asyncThreads: Int = 0,
+    val backgroundSearchThreads: Int = 0,
+    val cores: Cores = Cores.ANY,
+    /** Nice value for every search thread; positive values yield to the UI */
+    val threadPriority: Int = 0
+) {
+    /** Must match TANTIVY_CORES_* in tantivy_mobile.h */
+    enum class Cores(val native: Int) { ANY(0), EFFICIENCY(1), PERFORMANCE(2) }
+}
+
+/**
+ * Native phases of one search in nanoseconds, filled in by [SearchService.search]
+ * or [SearchService.searchPacked] when passed. Mirrors `SearchTiming` in
+ * tantivy_mobile.h; [marshalNanos] is the JNI copying around the search.
+ * Reusable: each search overwrites every field.
+ */
+class SearchTiming {
+    // Layout written by copyTiming in tantivy_jni.cpp
+    internal val raw = LongArray(FIELDS + MAX_MODULES)
+    
+    val totalNanos get() = raw[0]
+    val parseNanos get() = raw[1]
+    /** Wall time of the parallel per-module collection */
+    val collectNanos get() = raw[2]
+    val mergeNanos get() = raw[3]
+    /** Stored fields and snippets, not included in [mergeNanos] */
+    val fetchNanos get() = raw[4]
+    val serializeNanos get() = raw[5]
+    val marshalNanos get() = raw[6]
+    /** Answered from the result cache; parse through fetch are 0 */
+    val cacheHit get() = raw[7] != 0L
+    val moduleCount get() = raw[8].toInt()
+    /** Native slots searched */
+    val searchedMask get() = raw[9].toInt()
+    /** Native slots selected but skipped because their module is not open yet */
+    val pendingMask get() = raw[10].toInt()
+    /** Some selected modules were not searched; search again once they are ready */
+    val isPartial get() = pendingMask != 0
+    
+    /** Collect time of the module in native [slot] */
+    fun moduleCollectNanos(slot: Int): Long = if (slot in 0 until MAX_MODULES) raw[FIELDS + slot] else 0L
+    
+    override fun toString() =
+        "total=${totalNanos / 1000}us parse=${parseNanos / 1000}us collect=${collectNanos / 1000}us " +
+            "merge=${mergeNanos / 1000}us fetch=${fetchNanos / 1000}us serialize=${serializeNanos / 1000}us " +
+            "marshal=${marshalNanos / 1000}us cacheHit=$cacheHit modules=$moduleCount partial=$isPartial"
+    
+    private companion object {
+        const val FIELDS = 11
+        // Must match MULTI_SEARCH_MAX_MODULES in tantivy_mobile.h
+        const val MAX_MODULES = 32
+    }
+}
+
+/**
+ * Results of [SearchService.searchTiered] so far: the top hits over every
+ * tier searched, replacing the previous batch. [isFinal] on the last one.
+ */
+class TieredSearchResults(val results: PackedSearchResults, val isFinal: Boolean)
+
+/** Open state of a module, mirroring TANTIVY_MODULE_* in tantivy_mobile.h */
+enum class ModuleState {
+    /** Registered and waiting for the native loader thread */
+    PENDING,
+    /** Open and searched */
+    READY,
+    /** Registered, closed under memory pressure; reopens when searched by name */
+    UNLOADED,
+    /** Registered, but the index could not be opened */
+    FAILED;
+    
+    internal companion object {
+        fun fromNative(state: Int): ModuleState? = values().getOrNull(state)
+    }
+}
+
 /** Module statistics */
 @Serializable
 data class ModuleStats(
     val name: String,
     val num_docs: Long,
-    val estimated_size_bytes: Long
+    /** Segment file bytes */
+    val estimated_size_bytes: Long,
+    val mapped_bytes: Long = 0,
+    val resident_bytes: Long = 0,
+    val heap_bytes: Long = 0,
+    val docstore_cache_bytes: Long = 0,
+    val segment_count: Int = 0,
+    val query_count: Long = 0,
+    val query_time_ns: Long = 0,
+    val latency_histogram: List<Long> = emptyList()
+)
+
+@Serializable
+data class CacheStats(
+    val hits: Long,
+    val misses: Long,
+    val entries: Int,
+    val bytes: Long,
+    val capacity_bytes: Long
 )
 
 // MARK: - SearchService
@@ -47,10 +173,40 @@ data class ModuleStats(
  */
 object SearchService {
     private const val TAG = "SearchService"
-    private const val LIBRARY_NAME = "tantivy_mobile"
+    private const val LIBRARY_NAME = "tantivy_jni"
+    
+    // Must match MULTI_SEARCH_MAX_MODULES in tantivy_mobile.h
+    private const val MAX_ADDRESSABLE_MODULES = 32
+    
+    private const val MANIFEST_ASSET = "content/content_manifest.json"
+    
+    // Must match TANTIVY_TRIM_* in tantivy_mobile.h
+    private const val TRIM_MODERATE = 1
+    private const val TRIM_CRITICAL = 2
+    
+    // Docstore block cache of the core (Tier-1 medical) module, whose
+    // articles are re-opened the most
+    private const val CORE_DOCSTORE_CACHE_BYTES = 4L * 1024 * 1024
+    
+    // Article body chunks: a small first one so the first screen shows at
+    // once, then larger ones to keep the JNI calls few
+    private const val FIRST_CHUNK_BYTES = 4 * 1024
+    private const val CHUNK_BYTES = 64 * 1024
+    
+    // Tiered search budgets: the core tier, in which the emergency answer
+    // must arrive, then each lower tier
+    private val DEFAULT_TIER_DEADLINES_MS = intArrayOf(50, 2000)
     
     private var managerPtr: Long = 0L
-    private val loadedModules = mutableSetOf<String>()
+    // Concurrent: loads, unloads and writers update it from IO coroutines
+    private val loadedModules: MutableSet<String> = ConcurrentHashMap.newKeySet()
+    
+    // Native slot of each loaded module, used to build the binary search options.
+    // Concurrent: native searches no longer serialize, so reads race loads.
+    private val moduleSlots = ConcurrentHashMap<String, Int>()
+    
+    // Running startup warmup, 0 if none. Guarded by the SearchService lock.
+    private var warmupPtr: Long = 0L
     
     // Observable state
     private val _isReady = MutableStateFlow(false)
@@ -62,20 +218,130 @@ object SearchService {
         encodeDefaults = true
     }
     
-    // FFI function declarations
-    private external fun init_multi_manager(): Long
-    private external fun destroy_multi_manager(managerPtr: Long)
-    private external fun multi_manager_load_index(managerPtr: Long, name: String, path: String): Int
-    private external fun multi_manager_unload_index(managerPtr: Long, name: String): Int
-    private external fun multi_manager_reload_index(managerPtr: Long, name: String): Int
-    private external fun multi_manager_search(managerPtr: Long, query: String, configJson: String?): String?
-    private external fun multi_manager_get_stats(managerPtr: Long): String?
-    private external fun free_rust_string(ptr: Long)
+    // Packed result buffers reused across keystrokes
+    private val packedBuffers = PackedBufferPool()
+    
+    // Async searches awaiting their native callback, by token. The token is
+    // registered before the search is queued, since the callback can run
+    // before nativeSearchAsync returns the native request id.
+    private val asyncSearches = ConcurrentHashMap<Long, CompletableDeferred<PackedSearchResults?>>()
+    private val nextAsyncToken = AtomicLong(1)
+    
+    // Native request id of the newest searchAsync, cancelled when superseded
+    private val latestAsyncRequest = AtomicLong(0)
+    
+    // Tiered searches awaiting their batches, by token like asyncSearches
+    private val tieredSearches = ConcurrentHashMap<Long, SendChannel<TieredSearchResults>>()
+    
+    // Open on-device writers by module name. Calls on a writer hold the read
+    // lock and closing one takes the write lock, so a handle is never freed
+    // while a native call is using it.
+    private val writers = HashMap<String, Long>()
+    private val writerLock = ReentrantReadWriteLock()
+    
+    // JNI entry points in tantivy_jni.cpp, wrapping the multi_manager_* C API
+    private external fun nativeInitMultiManager(
+        searchThreads: Int,
+        asyncThreads: Int,
+        backgroundSearchThreads: Int,
+        coreClass: Int,
+        threadPriority: Int
+    ): Long
+    private external fun nativeDestroyMultiManager(managerPtr: Long)
+    private external fun nativeLoadIndex(managerPtr: Long, name: String, path: String, docstoreCacheBytes: Long): Int
+    private external fun nativeUnloadIndex(managerPtr: Long, name: String): Int
+    private external fun nativeReloadIndex(managerPtr: Long, name: String): Int
+    private external fun nativeRegisterIndex(
+        managerPtr: Long,
+        name: String,
+        path: String,
+        tier: Int,
+        docstoreCacheBytes: Long
+    ): Int
+    private external fun nativeModuleState(managerPtr: Long, name: String): Int
+    private external fun nativeSetOpenModuleLimit(managerPtr: Long, count: Int): Int
+    private external fun nativeSearchBinary(
+        managerPtr: Long,
+        query: String,
+        limit: Int,
+        moduleMask: Int,
+        moduleWeights: FloatArray?,
+        buffer: ByteBuffer,
+        timing: LongArray?
+    ): Int
+    private external fun nativeSearchFiltered(
+        managerPtr: Long,
+        query: String,
+        limit: Int,
+        moduleMask: Int,
+        moduleWeights: FloatArray?,
+        category: String?,
+        priorityMin: Int,
+        priorityMax: Int,
+        buffer: ByteBuffer
+    ): Int
+    private external fun nativeSearchAsync(
+        managerPtr: Long,
+        query: String,
+        limit: Int,
+        moduleMask: Int,
+        moduleWeights: FloatArray?,
+        token: Long
+    ): Long
+    private external fun nativeSearchTiered(
+        managerPtr: Long,
+        query: String,
+        limit: Int,
+        moduleMask: Int,
+        moduleWeights: FloatArray?,
+        tierDeadlinesMs: IntArray?,
+        token: Long
+    ): Long
+    private external fun nativeCancelSearch(managerPtr: Long, requestId: Long): Int
+    private external fun nativeModuleSlot(managerPtr: Long, name: String): Int
+    private external fun nativeGetDocument(managerPtr: Long, module: String?, docId: String): String?
+    private external fun nativeOpenDocumentStream(managerPtr: Long, module: String?, docId: String): Long
+    private external fun nativeDocumentStreamLength(streamPtr: Long): Long
+    private external fun nativeReadDocumentStream(streamPtr: Long, buffer: ByteBuffer, maxBytes: Int): Int
+    private external fun nativeFreeDocumentStream(streamPtr: Long)
+    private external fun nativeGetStats(managerPtr: Long): String?
+    private external fun nativeGetModuleStats(managerPtr: Long, name: String): TantivyBridge.IndexStats?
+    private external fun nativeGetCacheStats(managerPtr: Long): String?
+    private external fun nativeSetCacheCapacity(managerPtr: Long, bytes: Long): Int
+    private external fun nativeSetMemoryBudget(managerPtr: Long, bytes: Long): Int
+    private external fun nativeTrimMemory(managerPtr: Long, level: Int): Int
+    private external fun nativeSetBackgroundIndexing(managerPtr: Long, active: Boolean): Int
+    private external fun nativeStartWarmup(managerPtr: Long, manifestJson: String): Long
+    private external fun nativeCancelWarmup(warmupPtr: Long)
+    private external fun nativeFreeWarmup(warmupPtr: Long)
+    private external fun nativeOpenWriter(
+        managerPtr: Long,
+        name: String,
+        path: String,
+        heapBytes: Long,
+        commitDelayMs: Int
+    ): Long
+    private external fun nativeWriterAddDocument(
+        writerPtr: Long,
+        id: String,
+        title: String,
+        category: String,
+        priority: Int,
+        summary: String,
+        content: String
+    ): Int
+    private external fun nativeWriterAddDocumentsBatch(writerPtr: Long, batch: ByteBuffer): Int
+    private external fun nativeWriterDeleteDocument(writerPtr: Long, id: String): Int
+    private external fun nativeWriterCommit(writerPtr: Long): Int
+    private external fun nativeWriterSetMerging(writerPtr: Long, allowed: Boolean): Int
+    private external fun nativeWriterSegmentCount(writerPtr: Long): Int
+    private external fun nativeCloseWriter(writerPtr: Long)
     
     init {
         try {
+            // tantivy_jni links against libtantivy_mobile.so
             System.loadLibrary(LIBRARY_NAME)
-            managerPtr = init_multi_manager()
+            managerPtr = createManager(SearchThreadConfig())
             
             if (managerPtr != 0L) {
                 Log.d(TAG, "Multi-search manager initialized successfully")
@@ -87,14 +353,48 @@ object SearchService {
         }
     }
     
+    private fun createManager(config: SearchThreadConfig): Long = nativeInitMultiManager(
+        config.searchThreads,
+        config.asyncThreads,
+        config.backgroundSearchThreads,
+        config.cores.native,
+        config.threadPriority
+    )
+    
+    /**
+     * Replaces the native search threads. Call before loading any module,
+     * e.g. from Application.onCreate; returns false once modules are loaded.
+     */
+    @Synchronized
+    fun configureThreads(config: SearchThreadConfig): Boolean {
+        // Open writers reload through the current manager
+        if (managerPtr == 0L || moduleSlots.isNotEmpty() || hasWriters()) return false
+        val replacement = createManager(config)
+        if (replacement == 0L) {
+            Log.e(TAG, "Failed to start search threads for $config")
+            return false
+        }
+        cancelWarmup()
+        nativeDestroyMultiManager(managerPtr)
+        managerPtr = replacement
+        return true
+    }
+    
     /**
-     * Clean up resources when no longer needed
+     * Clean up resources when no longer needed. Synchronized with
+     * configureThreads and openWriter, so no writer outlives the manager.
      */
+    @Synchronized
     fun close() {
+        cancelWarmup()
+        // Writers reload through the manager, so they go first
+        closeAllWriters()
         if (managerPtr != 0L) {
-            destroy_multi_manager(managerPtr)
+            // Cancels pending async searches and waits for their callbacks
+            nativeDestroyMultiManager(managerPtr)
             managerPtr = 0L
             loadedModules.clear()
+            moduleSlots.clear()
             _isReady.value = false
         }
     }
@@ -111,10 +411,11 @@ object SearchService {
         // Check if index already exists
         if (coreIndexDir.exists() && coreIndexDir.isDirectory) {
             // Load existing index
-            val loaded = loadIndex("core", coreIndexDir.absolutePath)
+            val loaded = loadIndex("core", coreIndexDir.absolutePath, CORE_DOCSTORE_CACHE_BYTES)
             if (loaded) {
                 _isReady.value = true
                 Log.d(TAG, "Core index loaded from disk")
+                prewarmSearch(context)
             }
             return@withContext
         }
@@ -125,10 +426,11 @@ object SearchService {
             copyAssetFolder(context.assets, "core_index", coreIndexDir.absolutePath)
             
             // Load the index
-            val loaded = loadIndex("core", coreIndexDir.absolutePath)
+            val loaded = loadIndex("core", coreIndexDir.absolutePath, CORE_DOCSTORE_CACHE_BYTES)
             if (loaded) {
                 _isReady.value = true
                 Log.d(TAG, "Core index copied and loaded successfully")
+                prewarmSearch(context)
             }
         } catch (e: Exception) {
             Log.e(TAG, "Error preparing core index", e)
@@ -166,14 +468,21 @@ object SearchService {
     }
     
     /**
-     * Loads an index module
+     * Loads an index module. [docstoreCacheBytes] sizes its cache of
+     * decompressed docstore blocks, worth raising for modules whose results
+     * and articles are re-read often; 0 keeps the native default.
      */
-    suspend fun loadIndex(name: String, path: String): Boolean = withContext(Dispatchers.IO) {
-        if (managerPtr == 0L) return@withContext false
+    suspend fun loadIndex(name: String, path: String, docstoreCacheBytes: Long = 0): Boolean = withContext(Dispatchers.IO) {
+        loadIndexBlocking(name, path, docstoreCacheBytes)
+    }
+    
+    private fun loadIndexBlocking(name: String, path: String, docstoreCacheBytes: Long): Boolean {
+        if (managerPtr == 0L) return false
         
-        val result = multi_manager_load_index(managerPtr, name, path)
-        if (result == 0) {
+        val result = nativeLoadIndex(managerPtr, name, path, docstoreCacheBytes)
+        return if (result == 0) {
             loadedModules.add(name)
+            moduleSlots[name] = nativeModuleSlot(managerPtr, name)
             Log.d(TAG, "Loaded module '$name' from $path")
             true
         } else {
@@ -182,15 +491,48 @@ object SearchService {
         }
     }
     
+    /**
+     * Registers a module to be opened on the native loader thread and
+     * returns at once, so startup does not grow with installed content.
+     * Modules open one at a time, lowest [tier] first. Until a module is
+     * open, searches skip it and report it in [SearchTiming.pendingMask];
+     * see [pendingModules]. [docstoreCacheBytes] is as in [loadIndex].
+     */
+    fun registerModule(name: String, path: String, tier: Int = 1, docstoreCacheBytes: Long = 0): Boolean {
+        if (managerPtr == 0L) return false
+        
+        if (nativeRegisterIndex(managerPtr, name, path, tier, docstoreCacheBytes) != 0) {
+            Log.e(TAG, "Failed to register module '$name'")
+            return false
+        }
+        // Assigned at once, so searches can select the module before it opens
+        moduleSlots[name] = nativeModuleSlot(managerPtr, name)
+        Log.d(TAG, "Registered module '$name' (tier $tier) from $path")
+        return true
+    }
+    
+    /** Open state of a loaded or registered module, null if unknown */
+    fun moduleState(name: String): ModuleState? =
+        if (managerPtr == 0L) null else ModuleState.fromNative(nativeModuleState(managerPtr, name))
+    
+    /**
+     * Keeps at most [count] registered modules open, closing the least
+     * recently searched first; 0 removes the limit. Loaded modules do not
+     * count.
+     */
+    fun setOpenModuleLimit(count: Int): Boolean =
+        managerPtr != 0L && nativeSetOpenModuleLimit(managerPtr, count) == 0
+    
     /**
      * Unloads a module
      */
     suspend fun unloadModule(name: String): Boolean = withContext(Dispatchers.IO) {
         if (managerPtr == 0L) return@withContext false
         
-        val result = multi_manager_unload_index(managerPtr, name)
+        val result = nativeUnloadIndex(managerPtr, name)
         if (result == 0) {
             loadedModules.remove(name)
+            moduleSlots.remove(name)
             true
         } else {
             false
@@ -203,39 +545,407 @@ object SearchService {
     suspend fun reloadModule(name: String): Boolean = withContext(Dispatchers.IO) {
         if (managerPtr == 0L) return@withContext false
         
-        multi_manager_reload_index(managerPtr, name) == 0
+        nativeReloadIndex(managerPtr, name) == 0
+    }
+    
+    /**
+     * Applies a downloaded index delta to a loaded module's directory and
+     * reloads it, so the update costs only the changed chunks. On failure
+     * the installed version stays in use; fall back to a full download.
+     */
+    suspend fun applyIndexDelta(name: String, indexDir: File, manifest: File, data: File): Boolean =
+        withContext(Dispatchers.IO) {
+            // Checksumming competes with search for cores
+            val applied = withBackgroundIndexing { IndexDeltaApplier.apply(manifest, data, indexDir) }
+            applied && reloadModule(name)
+        }
+    
+    /**
+     * Runs [block] with searches limited to the background search threads,
+     * so indexing or update work and type-ahead together stay off the
+     * cores the UI needs.
+     */
+    fun <T> withBackgroundIndexing(block: () -> T): T {
+        val ptr = managerPtr
+        if (ptr != 0L) nativeSetBackgroundIndexing(ptr, true)
+        try {
+            return block()
+        } finally {
+            if (ptr != 0L) nativeSetBackgroundIndexing(ptr, false)
+        }
+    }
+    
+    // MARK: - On-Device Writer
+    
+    /**
+     * Opens a background writer for user notes or downloaded articles in
+     * [path], creating the index if there is none, and loads it as module
+     * [name]. Adds return once queued, but wait while the native queue of
+     * 1024 commands is full, e.g. during a merge, so they run on
+     * [Dispatchers.IO]. The writer commits after [commitDelayMs] without new
+     * documents, and every commit reloads the module, so searches see the
+     * change without waiting on the writer.
+     * [heapBytes] of 0 keeps the native 16 MB indexing budget.
+     */
+    suspend fun openWriter(
+        name: String,
+        path: String,
+        heapBytes: Long = 0,
+        commitDelayMs: Int = 0
+    ): Boolean = withContext(Dispatchers.IO) {
+        // Holds the lock configureThreads takes, so the manager the writer
+        // reloads is not replaced while it opens
+        synchronized(this@SearchService) {
+            if (managerPtr == 0L) return@withContext false
+            if (writerLock.read { name in writers }) return@withContext true
+            
+            val writerPtr = nativeOpenWriter(managerPtr, name, path, heapBytes, commitDelayMs)
+            if (writerPtr == 0L) {
+                Log.e(TAG, "Failed to open writer for '$name' at $path")
+                return@withContext false
+            }
+            // The writer creates the index, so the module can load only now
+            if (name !in loadedModules && !loadIndexBlocking(name, path, 0)) {
+                nativeCloseWriter(writerPtr)
+                return@withContext false
+            }
+            writerLock.write { writers[name] = writerPtr }
+            true
+        }
+    }
+    
+    /**
+     * Queues a note or article for [module]'s writer. A document with the
+     * same [id] is replaced.
+     */
+    suspend fun addDocument(
+        module: String,
+        id: String,
+        title: String,
+        content: String,
+        summary: String = "",
+        category: String = "notes",
+        priority: Int = 0
+    ): Boolean = withContext(Dispatchers.IO) {
+        withWriter(module, false) { writerPtr ->
+            nativeWriterAddDocument(writerPtr, id, title, category, priority, summary, content) == 0
+        }
+    }
+    
+    /**
+     * Queues a batch encoded by [DocumentBatch] in a direct
+     * buffer. Returns the number of documents queued, or -1.
+     */
+    suspend fun addDocumentsBatch(module: String, batch: ByteBuffer): Int = withContext(Dispatchers.IO) {
+        withWriter(module, -1) { nativeWriterAddDocumentsBatch(it, batch).coerceAtLeast(-1) }
+    }
+    
+    /** Queues the deletion of [id] from [module] */
+    suspend fun deleteDocument(module: String, id: String): Boolean = withContext(Dispatchers.IO) {
+        withWriter(module, false) { nativeWriterDeleteDocument(it, id) == 0 }
+    }
+    
+    /** Asks [module]'s writer to commit now instead of after the delay */
+    suspend fun commitWriter(module: String): Boolean = withContext(Dispatchers.IO) {
+        withWriter(module, false) { nativeWriterCommit(it) == 0 }
+    }
+    
+    /**
+     * Allows or stops segment merges on every open writer. Merges are off
+     * until allowed; call this from a charging or device-idle listener,
+     * since merging rewrites segments and drains the battery.
+     */
+    suspend fun setWriterMergingAllowed(allowed: Boolean) = withContext(Dispatchers.IO) {
+        writerLock.read { writers.values.forEach { nativeWriterSetMerging(it, allowed) } }
     }
     
+    /** Committed segments of [module]'s writer, -1 if it has none */
+    fun writerSegmentCount(module: String): Int =
+        withWriter(module, -1) { nativeWriterSegmentCount(it) }
+    
+    /**
+     * Commits what is pending and closes [module]'s writer. The module
+     * stays loaded.
+     */
+    suspend fun closeWriter(module: String): Boolean = withContext(Dispatchers.IO) {
+        writerLock.write {
+            val writerPtr = writers.remove(module) ?: return@withContext false
+            nativeCloseWriter(writerPtr)
+        }
+        true
+    }
+    
+    private fun closeAllWriters() {
+        writerLock.write {
+            writers.values.forEach { nativeCloseWriter(it) }
+            writers.clear()
+        }
+    }
+    
+    private fun hasWriters(): Boolean = writerLock.read { writers.isNotEmpty() }
+    
+    // Runs [block] with [module]'s writer handle, kept open until it returns
+    private inline fun <T> withWriter(module: String, missing: T, block: (Long) -> T): T =
+        writerLock.read { writers[module]?.let(block) ?: missing }
+    
     // MARK: - Search
     
     /**
-     * The primary search function
+     * The primary search function. A [timing] receives the native phases.
      */
     suspend fun search(
         query: String, 
-        config: SearchConfig = SearchConfig()
+        config: SearchConfig = SearchConfig(),
+        timing: SearchTiming? = null
     ): List<SearchResult> = withContext(Dispatchers.IO) {
-        if (managerPtr == 0L) return@withContext emptyList()
+        val packed = searchPacked(query, config, timing) ?: return@withContext emptyList()
+        (0 until packed.size).map { row ->
+            SearchResult(
+                doc_id = packed.id(row),
+                title = packed.title(row),
+                summary = packed.summary(row),
+                score = packed.score(row),
+                module = packed.module(row)
+            )
+        }
+    }
+    
+    /**
+     * Search returning the packed native buffer; strings are decoded only
+     * for rows that are read. Valid until the second-next search. A
+     * [timing] receives the native phases; each is also a systrace section.
+     */
+    suspend fun searchPacked(
+        query: String,
+        config: SearchConfig = SearchConfig(),
+        timing: SearchTiming? = null
+    ): PackedSearchResults? = withContext(Dispatchers.IO) {
+        if (managerPtr == 0L) return@withContext null
+        val options = nativeOptions(config) ?: return@withContext null
+        
+        packedBuffers.search { buffer ->
+            nativeSearchBinary(
+                managerPtr, query, config.limit, options.moduleMask, options.moduleWeights, buffer, timing?.raw
+            )
+        }
+    }
+    
+    /**
+     * [searchPacked] returning only articles that pass [filter]. The filter
+     * is applied natively while collecting, so a narrow category does not
+     * cost a full search. Modules are [SearchConfig.module_filter].
+     */
+    suspend fun searchFiltered(
+        query: String,
+        filter: ArticleFilter,
+        config: SearchConfig = SearchConfig()
+    ): PackedSearchResults? = withContext(Dispatchers.IO) {
+        if (managerPtr == 0L) return@withContext null
+        val options = nativeOptions(config) ?: return@withContext null
+        
+        packedBuffers.search { buffer ->
+            nativeSearchFiltered(
+                managerPtr, query, config.limit, options.moduleMask, options.moduleWeights,
+                filter.category, filter.priorityMin, filter.priorityMax ?: -1, buffer
+            )
+        }
+    }
+    
+    /**
+     * Articles passing [filter] with no query, most critical first, e.g. a
+     * category screen. Nothing is scored, so rows have a score of 0.
+     */
+    suspend fun browse(
+        filter: ArticleFilter = ArticleFilter(),
+        config: SearchConfig = SearchConfig()
+    ): PackedSearchResults? = searchFiltered("", filter, config)
+    
+    /** Modules a search with [timing] skipped because they were not open yet */
+    fun pendingModules(timing: SearchTiming): Set<String> = moduleSlots.filterValues { slot ->
+        slot in 0 until MAX_ADDRESSABLE_MODULES && (timing.pendingMask and (1 shl slot)) != 0
+    }.keys
+    
+    /** Per-module collect times of [timing] by module name */
+    fun moduleCollectNanos(timing: SearchTiming): Map<String, Long> =
+        moduleSlots.mapValues { (_, slot) -> timing.moduleCollectNanos(slot) }
+    
+    /**
+     * Type-ahead search on the native search threads. No caller thread
+     * blocks while it runs, and starting one cancels the previous call's
+     * native search, so only the latest keystroke uses CPU. Cancelling the
+     * calling coroutine cancels the native search too.
+     *
+     * Returns null when superseded, cancelled or on error. The results own
+     * their buffer and stay valid.
+     */
+    suspend fun searchAsync(
+        query: String,
+        config: SearchConfig = SearchConfig()
+    ): PackedSearchResults? {
+        if (managerPtr == 0L) return null
+        val options = nativeOptions(config) ?: return null
+        
+        val token = nextAsyncToken.getAndIncrement()
+        val completion = CompletableDeferred<PackedSearchResults?>()
+        asyncSearches[token] = completion
+        val requestId = nativeSearchAsync(
+            managerPtr, query, config.limit, options.moduleMask, options.moduleWeights, token
+        )
+        if (requestId == 0L) {
+            asyncSearches.remove(token)
+            return null
+        }
+        
+        val superseded = latestAsyncRequest.getAndSet(requestId)
+        if (superseded != 0L) nativeCancelSearch(managerPtr, superseded)
+        
+        return try {
+            completion.await()
+        } catch (e: CancellationException) {
+            // The callback still arrives and drops the token
+            nativeCancelSearch(managerPtr, requestId)
+            throw e
+        } finally {
+            latestAsyncRequest.compareAndSet(requestId, 0L)
+        }
+    }
+    
+    /** Called by tantivy_jni.cpp on a native search thread */
+    @JvmStatic
+    @Suppress("unused")
+    private fun onAsyncSearchComplete(token: Long, status: Int, packed: ByteArray?) {
+        val completion = asyncSearches.remove(token) ?: return
+        val results = if (status >= 0 && packed != null) PackedSearchResults(ByteBuffer.wrap(packed)) else null
+        completion.complete(results)
+    }
+    
+    /**
+     * Search answering from the core modules first: the selected modules are
+     * searched one tier at a time, lowest first (directly loaded modules,
+     * then registered ones by tier), and each tier emits the merged top
+     * hits so far, so the core answer shows without waiting for large
+     * reference modules. [tierDeadlinesMs] budgets each tier in order, the
+     * last repeating; a tier out of budget contributes what it found.
+     *
+     * Batches are conflated: a slow collector only sees the newest. The
+     * flow ends after the final batch, or empty on error; cancelling
+     * collection cancels the native search.
+     */
+    fun searchTiered(
+        query: String,
+        config: SearchConfig = SearchConfig(),
+        tierDeadlinesMs: IntArray = DEFAULT_TIER_DEADLINES_MS
+    ): Flow<TieredSearchResults> = callbackFlow {
+        val ptr = managerPtr
+        val options = if (ptr != 0L) nativeOptions(config) else null
+        if (options == null) {
+            close()
+            return@callbackFlow
+        }
+        
+        val token = nextAsyncToken.getAndIncrement()
+        tieredSearches[token] = channel
+        val requestId = nativeSearchTiered(
+            ptr, query, config.limit, options.moduleMask, options.moduleWeights, tierDeadlinesMs, token
+        )
+        if (requestId == 0L) {
+            tieredSearches.remove(token)
+            close()
+            return@callbackFlow
+        }
+        // A no-op once the final batch has arrived
+        awaitClose { nativeCancelSearch(ptr, requestId) }
+    }.conflate()
+    
+    /** Called by tantivy_jni.cpp on a native search thread */
+    @JvmStatic
+    @Suppress("unused")
+    private fun onTieredSearchBatch(token: Long, status: Int, packed: ByteArray?, isFinal: Boolean) {
+        val channel = (if (isFinal) tieredSearches.remove(token) else tieredSearches[token]) ?: return
+        if (status >= 0 && packed != null) {
+            channel.trySend(TieredSearchResults(PackedSearchResults(ByteBuffer.wrap(packed)), isFinal))
+        }
+        if (isFinal) channel.close()
+    }
+    
+    /** Module filter and weights of [config] as native slots */
+    private class NativeOptions(val moduleMask: Int, val moduleWeights: FloatArray?)
+    
+    /**
+     * Translates module names into native slots: a filter becomes a bitmask
+     * and weights an array indexed by slot, so no JSON is built. Returns
+     * null when a filter names no loaded module, since a zero mask would
+     * mean "all modules".
+     */
+    private fun nativeOptions(config: SearchConfig): NativeOptions? {
+        var moduleMask = 0
+        config.module_filter?.let { filter ->
+            for (name in filter) {
+                val slot = moduleSlots[name] ?: continue
+                if (slot in 0 until MAX_ADDRESSABLE_MODULES) moduleMask = moduleMask or (1 shl slot)
+            }
+            if (moduleMask == 0) return null
+        }
+        val moduleWeights = config.weights?.let { weights ->
+            FloatArray(MAX_ADDRESSABLE_MODULES) { 1.0f }.also { array ->
+                for ((name, weight) in weights) {
+                    val slot = moduleSlots[name] ?: continue
+                    if (slot in 0 until MAX_ADDRESSABLE_MODULES) array[slot] = weight
+                }
+            }
+        }
+        return NativeOptions(moduleMask, moduleWeights)
+    }
+    
+    // MARK: - Documents
+    
+    /**
+     * Stored fields of the article with id [docId], from [module] or from
+     * the first loaded module that has it. Modules built with an id table
+     * resolve it without a query. Null if no module has the article.
+     */
+    suspend fun getDocument(docId: String, module: String? = null): Map<String, String>? = withContext(Dispatchers.IO) {
+        if (managerPtr == 0L) return@withContext null
         
         try {
-            // Serialize config to JSON
-            val configJson = json.encodeToString(config)
-            
-            // Perform search
-            val resultJson = multi_manager_search(managerPtr, query, configJson)
-                ?: return@withContext emptyList()
-            
-            // Note: JNI automatically handles string memory management
-            // No need to call free_rust_string for JNI strings
-            
-            // Decode results
-            json.decodeFromString<List<SearchResult>>(resultJson)
+            val documentJson = nativeGetDocument(managerPtr, module, docId)
+                ?: return@withContext null
+            json.decodeFromString<Map<String, String>>(documentJson)
         } catch (e: Exception) {
-            Log.e(TAG, "Search error", e)
-            emptyList()
+            Log.e(TAG, "Document error", e)
+            null
         }
     }
     
+    /**
+     * The stored body of article [docId] in chunks, for rendering long
+     * manuals progressively. Each chunk ends on a character boundary. The
+     * flow is empty if no module has the article or its index stores no
+     * body; cancelling collection releases the native stream.
+     */
+    fun documentChunks(docId: String, module: String? = null): Flow<String> = flow {
+        val ptr = managerPtr
+        if (ptr == 0L) return@flow
+        val stream = nativeOpenDocumentStream(ptr, module, docId)
+        if (stream == 0L) return@flow
+        
+        try {
+            val length = nativeDocumentStreamLength(stream)
+            val buffer = ByteBuffer.allocateDirect(length.coerceIn(1L, CHUNK_BYTES.toLong()).toInt().coerceAtLeast(4))
+            var maxBytes = FIRST_CHUNK_BYTES
+            while (true) {
+                val read = nativeReadDocumentStream(stream, buffer, maxBytes)
+                if (read <= 0) break
+                buffer.limit(read)
+                emit(StandardCharsets.UTF_8.decode(buffer).toString())
+                buffer.clear()
+                maxBytes = CHUNK_BYTES
+            }
+        } finally {
+            nativeFreeDocumentStream(stream)
+        }
+    }.flowOn(Dispatchers.IO)
+    
     // MARK: - Statistics
     
     /**
@@ -245,7 +955,7 @@ object SearchService {
         if (managerPtr == 0L) return@withContext emptyList()
         
         try {
-            val resultJson = multi_manager_get_stats(managerPtr)
+            val resultJson = nativeGetStats(managerPtr)
                 ?: return@withContext emptyList()
             
             json.decodeFromString<List<ModuleStats>>(resultJson)
@@ -255,21 +965,105 @@ object SearchService {
         }
     }
     
+    /**
+     * Footprint and query counters of one loaded module, without JSON, for
+     * periodic sampling, e.g. to choose modules to unload on small devices.
+     * Null if the module is not loaded.
+     */
+    fun getModuleFootprint(name: String): TantivyBridge.IndexStats? {
+        val ptr = managerPtr
+        if (ptr == 0L) return null
+        return nativeGetModuleStats(ptr, name)
+    }
+    
+    /**
+     * Gets result cache counters, or null if unavailable
+     */
+    suspend fun getCacheStats(): CacheStats? = withContext(Dispatchers.IO) {
+        if (managerPtr == 0L) return@withContext null
+        
+        try {
+            nativeGetCacheStats(managerPtr)?.let { json.decodeFromString<CacheStats>(it) }
+        } catch (e: Exception) {
+            Log.e(TAG, "Cache stats error", e)
+            null
+        }
+    }
+    
+    /**
+     * Caps the native result cache at [bytes]; 0 disables it.
+     * Loading, unloading or reloading a module clears the cache.
+     */
+    fun setCacheCapacity(bytes: Long): Boolean =
+        managerPtr != 0L && nativeSetCacheCapacity(managerPtr, bytes) == 0
+    
+    // MARK: - Memory
+    
+    /**
+     * Caps the index pages kept in RAM across all modules; 0 removes the cap.
+     * The least recently searched modules are paged out first.
+     */
+    fun setMemoryBudget(bytes: Long): Boolean =
+        managerPtr != 0L && nativeSetMemoryBudget(managerPtr, bytes) == 0
+    
+    /**
+     * Forwards [ComponentCallbacks2.onTrimMemory]. Searches keep working;
+     * dropped index pages are read back from storage when needed.
+     */
+    fun onTrimMemory(level: Int) {
+        if (managerPtr == 0L) return
+        val nativeLevel = when {
+            level >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE -> TRIM_CRITICAL
+            level == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> TRIM_CRITICAL
+            level >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND -> TRIM_MODERATE
+            level >= ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> TRIM_MODERATE
+            else -> return
+        }
+        nativeTrimMemory(managerPtr, nativeLevel)
+    }
+    
     // MARK: - Helpers
     
     /**
-     * Pre-warm the search engine with a dummy query
+     * Pre-warm the search engine with the bundled manifest's emergency queries.
+     * Runs natively in the background and returns immediately.
      */
-    suspend fun prewarmSearch() = withContext(Dispatchers.IO) {
+    fun prewarmSearch(context: Context) {
         try {
-            val config = SearchConfig(limit = 1)
-            search("the", config)
-            Log.d(TAG, "Pre-warm completed")
+            val manifestJson = context.assets.open(MANIFEST_ASSET).bufferedReader().use { it.readText() }
+            if (startWarmup(manifestJson)) {
+                Log.d(TAG, "Pre-warm started")
+            }
         } catch (e: Exception) {
             Log.e(TAG, "Pre-warm failed", e)
         }
     }
     
+    /**
+     * Starts warming the loaded modules with a content manifest's warmup
+     * queries on a native background thread, replacing any running warmup.
+     * User searches are never blocked by it.
+     */
+    @Synchronized
+    fun startWarmup(manifestJson: String): Boolean {
+        if (managerPtr == 0L) return false
+        cancelWarmup()
+        warmupPtr = nativeStartWarmup(managerPtr, manifestJson)
+        return warmupPtr != 0L
+    }
+    
+    /**
+     * Stops the running warmup, if any, after its in-flight query
+     */
+    @Synchronized
+    fun cancelWarmup() {
+        if (warmupPtr != 0L) {
+            nativeCancelWarmup(warmupPtr)
+            nativeFreeWarmup(warmupPtr)
+            warmupPtr = 0L
+        }
+    }
+    
     /**
      * Get loaded module names
      */
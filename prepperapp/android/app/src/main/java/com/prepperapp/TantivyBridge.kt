@@ -2,9 +2,15 @@ package com.prepperapp
 
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
+import java.nio.ByteBuffer
 
 object TantivyBridge {
     
+    init {
+        // JNI_OnLoad in tantivy_jni caches the class/method IDs used below
+        System.loadLibrary("tantivy_jni")
+    }
+    
     // Native method declarations
     external fun nativeInitLogging()
     external fun nativeCreateIndex(path: String): Long
@@ -18,12 +24,28 @@ object TantivyBridge {
         summary: String,
         content: String
     ): Int
+    external fun nativeAddDocumentsBatch(indexPtr: Long, batch: ByteBuffer): Int
+    external fun nativeSetCommitThresholds(indexPtr: Long, maxDocs: Int, maxBytes: Long): Int
     external fun nativeCommit(indexPtr: Long): Int
     external fun nativeSearch(
         indexPtr: Long,
         query: String,
         limit: Int
     ): SearchResultsNative?
+    external fun nativeSearchPacked(
+        indexPtr: Long,
+        query: String,
+        limit: Int,
+        buffer: ByteBuffer
+    ): Int
+    external fun nativeSearchHits(indexPtr: Long, query: String, limit: Int): Long
+    external fun nativeHitsCount(hitsPtr: Long): Int
+    external fun nativeHydrate(hitsPtr: Long, start: Int, count: Int, buffer: ByteBuffer): Int
+    external fun nativeFreeHits(hitsPtr: Long)
+    external fun nativeCreateSearchSession(indexPtr: Long): Long
+    external fun nativeSearchIncremental(sessionPtr: Long, query: String, limit: Int, buffer: ByteBuffer): Int
+    external fun nativeCancelIncremental(sessionPtr: Long)
+    external fun nativeFreeSearchSession(sessionPtr: Long)
     external fun nativeFreeSearchResults(resultsPtr: Long)
     external fun nativeFreeIndex(indexPtr: Long)
     external fun nativeGetIndexStats(indexPtr: Long): IndexStats
@@ -43,14 +65,46 @@ object TantivyBridge {
         val score: Float
     )
     
-    data class IndexStats(
-        val numDocs: Long,
-        val indexSizeBytes: Long
+    data class IndexDocument(
+        val id: String,
+        val title: String,
+        val category: String,
+        val priority: Int,
+        val summary: String,
+        val content: String
     )
     
+    /**
+     * Footprint and query counters of an index, see `IndexStats` in
+     * tantivy_mobile.h. Resident bytes need an index opened mmap-advised.
+     */
+    class IndexStats(
+        val numDocs: Long,
+        val indexSizeBytes: Long,
+        val segmentCount: Int,
+        val mappedBytes: Long,
+        val residentBytes: Long,
+        /** Docstore cache, plus a single index's result cache */
+        val heapBytes: Long,
+        val docstoreCacheBytes: Long,
+        val queryCount: Long,
+        val queryTimeNanos: Long,
+        /** Search counts per [LATENCY_BUCKET_BOUNDS_MS] bucket, then slower */
+        val latencyHistogram: LongArray
+    ) {
+        val meanQueryNanos: Long get() = if (queryCount > 0) queryTimeNanos / queryCount else 0L
+        
+        companion object {
+            // Must match the buckets of IndexStats.latency_histogram
+            val LATENCY_BUCKET_BOUNDS_MS = doubleArrayOf(0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 25.0, 50.0, 100.0, 250.0)
+        }
+    }
+    
     // High-level Kotlin API
     class Index(private val indexPtr: Long) {
         
+        private val packedBuffers = PackedBufferPool()
+        
         suspend fun addDocument(
             id: String,
             title: String,
@@ -63,6 +117,31 @@ object TantivyBridge {
             result == 0
         }
         
+        /**
+         * Add many documents through [DocumentBatch], one JNI call per batch.
+         * The native writer auto-commits at its thresholds; the tail is
+         * committed before returning.
+         */
+        suspend fun addDocuments(documents: List<IndexDocument>): Boolean = withContext(Dispatchers.IO) {
+            val batch = DocumentBatch()
+            for (document in documents) {
+                if (batch.add(document)) continue
+                
+                if (nativeAddDocumentsBatch(indexPtr, batch.buffer()) < 0) return@withContext false
+                batch.clear()
+                batch.add(document)
+            }
+            if (batch.count > 0 && nativeAddDocumentsBatch(indexPtr, batch.buffer()) < 0) {
+                return@withContext false
+            }
+            nativeCommit(indexPtr) == 0
+        }
+        
+        /** Auto-commit after this many documents or text bytes (0 disables) */
+        fun setCommitThresholds(maxDocs: Int, maxBytes: Long): Boolean {
+            return nativeSetCommitThresholds(indexPtr, maxDocs, maxBytes) == 0
+        }
+        
         suspend fun commit(): Boolean = withContext(Dispatchers.IO) {
             val result = nativeCommit(indexPtr)
             result == 0
@@ -82,6 +161,29 @@ object TantivyBridge {
             } ?: emptyList()
         }
         
+        /**
+         * Search without creating Java objects per hit. Strings are decoded
+         * lazily from the returned view. Valid until the second-next call.
+         */
+        suspend fun searchPacked(query: String, limit: Int = 10): PackedSearchResults? = withContext(Dispatchers.IO) {
+            packedBuffers.search { buffer -> nativeSearchPacked(indexPtr, query, limit, buffer) }
+        }
+        
+        /**
+         * Two-phase search: ranks up to [limit] hits now and loads stored
+         * fields only for rows that get bound. Close the result when done.
+         */
+        suspend fun searchLazy(query: String, limit: Int = 50): LazySearchResults? = withContext(Dispatchers.IO) {
+            val hitsPtr = nativeSearchHits(indexPtr, query, limit)
+            if (hitsPtr != 0L) LazySearchResults(hitsPtr) else null
+        }
+        
+        /** Search-as-you-type session; close it before closing this index */
+        fun openIncrementalSearch(): IncrementalSearch? {
+            val sessionPtr = nativeCreateSearchSession(indexPtr)
+            return if (sessionPtr != 0L) IncrementalSearch(sessionPtr) else null
+        }
+        
         suspend fun getStats(): IndexStats = withContext(Dispatchers.IO) {
             nativeGetIndexStats(indexPtr)
         }
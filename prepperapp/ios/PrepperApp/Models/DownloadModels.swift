@@ -165,6 +165,35 @@ struct ContentModule: Codable {
     }
 }
 
+// MARK: - Index Deltas
+
+/// delta.json written by tantivy-delta. Rebuilds a module index from the
+/// installed version plus the bytes in delta.bin.
+struct IndexDelta: Codable {
+    let format: Int
+    let base_meta_sha256: String
+    let target_meta_sha256: String
+    let files: [IndexDeltaFile]
+    let remove: [String]
+    let data_size: Int64
+    let data_sha256: String
+}
+
+struct IndexDeltaFile: Codable {
+    let name: String
+    let size: Int64
+    let sha256: String
+    let ops: [IndexDeltaOp]
+}
+
+/// A byte range of an installed file ("copy") or of delta.bin ("data")
+struct IndexDeltaOp: Codable {
+    let op: String
+    let file: String?
+    let offset: Int64
+    let len: Int64
+}
+
 // MARK: - Download Errors
 
 enum DownloadError: LocalizedError {
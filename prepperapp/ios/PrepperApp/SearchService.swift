@@ -1,4 +1,8 @@
 import Foundation
+import os
+#if canImport(UIKit)
+import UIKit
+#endif
 
 // MARK: - Models
 
@@ -32,11 +36,96 @@ struct SearchConfig: Codable {
     }
 }
 
+/// Category and priority filter for `searchFiltered` and `browse`. A nil
+/// `category` matches any; a nil `priorityMax` leaves the range open.
+struct ArticleFilter {
+    var category: String? = nil
+    var priorityMin: UInt32 = 0
+    var priorityMax: UInt32? = nil
+}
+
+/// Native search threads. Counts of 0 take the native defaults (4 search
+/// threads capped at the core count, 2 async, 1 while indexing).
+struct SearchThreadConfig {
+    /// Must match TANTIVY_CORES_* in tantivy_mobile.h; mapped to QoS classes
+    enum Cores: Int32 {
+        case any = 0
+        case efficiency = 1
+        case performance = 2
+    }
+    
+    var searchThreads = 0
+    var asyncThreads = 0
+    var backgroundSearchThreads = 0
+    var cores = Cores.any
+}
+
 /// Module statistics
 struct ModuleStats: Codable {
     let name: String
     let num_docs: UInt64
     let estimated_size_bytes: UInt64
+    let resident_bytes: UInt64?
+    let mapped_bytes: UInt64?
+    let heap_bytes: UInt64?
+    let docstore_cache_bytes: UInt64?
+    let segment_count: UInt32?
+    let query_count: UInt64?
+    let query_time_ns: UInt64?
+    let latency_histogram: [UInt64]?
+}
+
+struct CacheStats: Codable {
+    let hits: UInt64
+    let misses: UInt64
+    let entries: Int
+    let bytes: Int
+    let capacity_bytes: Int
+}
+
+/// Native phases of one search in nanoseconds, from `SearchTiming` in
+/// tantivy_mobile.h. `marshalNanos` is the Swift side: building options
+/// and decoding the packed buffer.
+struct QueryTiming {
+    var totalNanos: UInt64 = 0
+    var parseNanos: UInt64 = 0
+    /// Wall time of the parallel per-module collection
+    var collectNanos: UInt64 = 0
+    var mergeNanos: UInt64 = 0
+    /// Stored fields and snippets, not included in `mergeNanos`
+    var fetchNanos: UInt64 = 0
+    var serializeNanos: UInt64 = 0
+    var marshalNanos: UInt64 = 0
+    /// Answered from the result cache; parse through fetch are 0
+    var cacheHit = false
+    var moduleCount = 0
+    /// Collect time per searched module
+    var moduleCollectNanos = [String: UInt64]()
+    /// Selected modules skipped because they were not open yet; search
+    /// again once they are ready for complete results
+    var pendingModules = Set<String>()
+    var isPartial: Bool { !pendingModules.isEmpty }
+    
+    init() {}
+    
+    fileprivate init(_ native: SearchTiming, moduleSlots: [String: Int]) {
+        totalNanos = native.total_ns
+        parseNanos = native.parse_ns
+        collectNanos = native.collect_ns
+        mergeNanos = native.merge_ns
+        fetchNanos = native.fetch_ns
+        serializeNanos = native.serialize_ns
+        marshalNanos = native.marshal_ns
+        cacheHit = native.cache_hit != 0
+        moduleCount = Int(native.module_count)
+        let perSlot = withUnsafeBytes(of: native.module_collect_ns) { Array($0.bindMemory(to: UInt64.self)) }
+        for (name, slot) in moduleSlots where perSlot.indices.contains(slot) && perSlot[slot] > 0 {
+            moduleCollectNanos[name] = perSlot[slot]
+        }
+        for (name, slot) in moduleSlots where perSlot.indices.contains(slot) && native.pending_mask & (UInt32(1) << UInt32(slot)) != 0 {
+            pendingModules.insert(name)
+        }
+    }
 }
 
 // MARK: - Errors
@@ -61,6 +150,68 @@ enum SearchError: LocalizedError {
     }
 }
 
+// MARK: - Async Search
+
+/// Completion of one multi_manager_search_async call. Retained for the
+/// native side until its callback runs.
+private final class AsyncSearchContext {
+    let continuation: CheckedContinuation<[SearchResult]?, Never>
+    
+    init(continuation: CheckedContinuation<[SearchResult]?, Never>) {
+        self.continuation = continuation
+    }
+}
+
+/// Native request id of one searchAsync call, guarded by the service's asyncLock
+private final class AsyncSearchRequest {
+    var id: UInt64 = 0
+    var cancelled = false
+}
+
+/// Runs on a native search thread. The packed buffer is only valid during
+/// the call, so it is decoded here.
+private let asyncSearchCallback: MultiSearchCallback = { _, status, packed, length, userData in
+    guard let userData = userData else { return }
+    let context = Unmanaged<AsyncSearchContext>.fromOpaque(userData).takeRetainedValue()
+    guard status >= 0, let packed = packed else {
+        context.continuation.resume(returning: nil)
+        return
+    }
+    context.continuation.resume(returning: SearchService.decodePacked(UnsafeRawBufferPointer(start: packed, count: length)))
+}
+
+/// Results of `searchTiered` so far: the top hits over every tier searched,
+/// replacing the previous batch. `isFinal` on the last one.
+struct TieredSearchResults {
+    let results: [SearchResult]
+    let isFinal: Bool
+}
+
+/// Batches of one multi_manager_search_tiered call. Retained for the native
+/// side until its final callback runs.
+private final class TieredSearchContext {
+    let continuation: AsyncStream<TieredSearchResults>.Continuation
+    
+    init(continuation: AsyncStream<TieredSearchResults>.Continuation) {
+        self.continuation = continuation
+    }
+}
+
+/// Runs on a native search thread for every batch; the final one releases
+/// the context and ends the stream.
+private let tieredSearchCallback: TieredSearchCallback = { _, status, packed, length, isFinal, userData in
+    guard let userData = userData else { return }
+    let unmanaged = Unmanaged<TieredSearchContext>.fromOpaque(userData)
+    let context = isFinal != 0 ? unmanaged.takeRetainedValue() : unmanaged.takeUnretainedValue()
+    if status >= 0, let packed = packed {
+        let results = SearchService.decodePacked(UnsafeRawBufferPointer(start: packed, count: length))
+        context.continuation.yield(TieredSearchResults(results: results, isFinal: isFinal != 0))
+    }
+    if isFinal != 0 {
+        context.continuation.finish()
+    }
+}
+
 // MARK: - SearchService
 
 /// Singleton service for managing search functionality
@@ -70,13 +221,49 @@ final class SearchService {
     private var managerPtr: OpaquePointer?
     private let backgroundQueue = DispatchQueue(label: "com.prepperapp.searchservice", qos: .userInitiated)
     
+    /// Signposts for searches, shown under Points of Interest in Instruments
+    private static let signpostLog = OSLog(subsystem: "com.prepperapp", category: .pointsOfInterest)
+    
+    /// Docstore block cache of the core (Tier-1 medical) module, whose
+    /// articles are re-opened the most
+    private static let coreDocstoreCacheBytes: UInt64 = 4 * 1024 * 1024
+    
+    /// Article body chunks: a small first one so the first screen shows at
+    /// once, then larger ones to keep the native calls few
+    private static let firstChunkBytes = 4 * 1024
+    private static let chunkBytes = 64 * 1024
+    
     /// Track loaded modules
     private var loadedModules = Set<String>()
     
+    /// Native slot of each loaded module, used to build MultiSearchOptions
+    private var moduleSlots = [String: Int]()
+    
+    /// Result buffer reused across searches (all searches run on backgroundQueue)
+    private var resultBuffer = [UInt8](repeating: 0, count: 64 * 1024)
+    
+    /// Newest searchAsync, cancelled when superseded; guarded by asyncLock
+    private var latestAsyncRequest: AsyncSearchRequest?
+    private let asyncLock = NSLock()
+    
+    /// Running startup warmup, guarded by warmupLock
+    private var warmupHandle: OpaquePointer?
+    private let warmupLock = NSLock()
+    
+    private var memoryWarningObserver: NSObjectProtocol?
+    
     /// Is the search service ready
     @Published private(set) var isReady = false
     
     private init() {
+        // A library built from a different tantivy_mobile.h would misread
+        // every struct we pass it, so leave the service unready instead
+        let abiVersion = tantivy_abi_version()
+        guard abiVersion == UInt32(TANTIVY_ABI_VERSION) else {
+            print("SearchService: libtantivy_mobile ABI \(abiVersion) does not match header ABI \(TANTIVY_ABI_VERSION)")
+            return
+        }
+        
         // Initialize the Rust multi-search manager
         self.managerPtr = init_multi_manager()
         
@@ -85,14 +272,54 @@ final class SearchService {
         } else {
             print("SearchService: Failed to initialize multi-search manager")
         }
+        
+        #if canImport(UIKit)
+        memoryWarningObserver = NotificationCenter.default.addObserver(
+            forName: UIApplication.didReceiveMemoryWarningNotification,
+            object: nil,
+            queue: nil
+        ) { [weak self] _ in
+            self?.trimMemory(critical: true)
+        }
+        #endif
     }
     
     deinit {
+        if let observer = memoryWarningObserver {
+            NotificationCenter.default.removeObserver(observer)
+        }
+        cancelWarmup()
         if let ptr = managerPtr {
             destroy_multi_manager(ptr)
         }
     }
     
+    /// Replaces the native search threads. Call before loading any module,
+    /// e.g. at launch; returns false once modules are loaded.
+    @discardableResult
+    func configureThreads(_ config: SearchThreadConfig) -> Bool {
+        backgroundQueue.sync { () -> Bool in
+            guard let ptr = managerPtr, moduleSlots.isEmpty else { return false }
+            
+            var options = multi_manager_options_default()
+            if config.searchThreads > 0 { options.search_threads = UInt32(config.searchThreads) }
+            if config.asyncThreads > 0 { options.async_threads = UInt32(config.asyncThreads) }
+            if config.backgroundSearchThreads > 0 {
+                options.background_search_threads = UInt32(config.backgroundSearchThreads)
+            }
+            options.core_class = config.cores.rawValue
+            guard let replacement = init_multi_manager_with_options(&options) else {
+                print("SearchService: Failed to start search threads")
+                return false
+            }
+            
+            cancelWarmup()
+            destroy_multi_manager(ptr)
+            managerPtr = replacement
+            return true
+        }
+    }
+    
     // MARK: - Index Management
     
     /// Prepares the core index on first launch
@@ -109,10 +336,11 @@ final class SearchService {
         // Check if index already exists
         if fileManager.fileExists(atPath: coreIndexPath.path) {
             // Load existing index
-            let loaded = await loadIndex(name: "core", path: coreIndexPath.path)
+            let loaded = await loadIndex(name: "core", path: coreIndexPath.path, docstoreCacheBytes: Self.coreDocstoreCacheBytes)
             if loaded {
                 isReady = true
                 print("SearchService: Core index loaded from disk")
+                prewarmSearch()
             }
             return
         }
@@ -138,10 +366,11 @@ final class SearchService {
             }
             
             // Load the index
-            let loaded = await loadIndex(name: "core", path: coreIndexPath.path)
+            let loaded = await loadIndex(name: "core", path: coreIndexPath.path, docstoreCacheBytes: Self.coreDocstoreCacheBytes)
             if loaded {
                 isReady = true
                 print("SearchService: Core index copied and loaded successfully")
+                prewarmSearch()
             }
         } catch {
             print("SearchService: Error preparing core index: \(error)")
@@ -149,8 +378,10 @@ final class SearchService {
         }
     }
     
-    /// Loads an index module into the manager
-    func loadIndex(name: String, path: String) async -> Bool {
+    /// Loads an index module into the manager. `docstoreCacheBytes` sizes
+    /// its cache of decompressed docstore blocks, worth raising for modules
+    /// whose results and articles are re-read often; 0 keeps the default.
+    func loadIndex(name: String, path: String, docstoreCacheBytes: UInt64 = 0) async -> Bool {
         await withCheckedContinuation { continuation in
             backgroundQueue.async { [weak self] in
                 guard let self = self, let ptr = self.managerPtr else {
@@ -158,9 +389,10 @@ final class SearchService {
                     return
                 }
                 
-                let result = multi_manager_load_index(ptr, name, path)
+                let result = multi_manager_load_index_with_cache(ptr, name, path, docstoreCacheBytes)
                 if result == 0 {
                     self.loadedModules.insert(name)
+                    self.moduleSlots[name] = Int(multi_manager_module_slot(ptr, name))
                     print("SearchService: Loaded module '\(name)' from \(path)")
                     continuation.resume(returning: true)
                 } else {
@@ -171,6 +403,45 @@ final class SearchService {
         }
     }
     
+    /// Registers a module to be opened on the native loader thread and
+    /// returns at once, so startup does not grow with installed content.
+    /// Modules open one at a time, lowest `tier` first. Until a module is
+    /// open, searches skip it and list it in `QueryTiming.pendingModules`.
+    func registerModule(name: String, path: String, tier: UInt32 = 1, docstoreCacheBytes: UInt64 = 0) async -> Bool {
+        await withCheckedContinuation { continuation in
+            backgroundQueue.async { [weak self] in
+                guard let self = self, let ptr = self.managerPtr else {
+                    continuation.resume(returning: false)
+                    return
+                }
+                
+                guard multi_manager_register_index(ptr, name, path, tier, docstoreCacheBytes) == 0 else {
+                    print("SearchService: Failed to register module '\(name)'")
+                    continuation.resume(returning: false)
+                    return
+                }
+                // Assigned at once, so searches can select the module before it opens
+                self.moduleSlots[name] = Int(multi_manager_module_slot(ptr, name))
+                continuation.resume(returning: true)
+            }
+        }
+    }
+    
+    /// `TANTIVY_MODULE_*` state of a loaded or registered module, nil if unknown
+    func moduleState(name: String) -> Int32? {
+        guard let ptr = managerPtr else { return nil }
+        let state = multi_manager_module_state(ptr, name)
+        return state < 0 ? nil : state
+    }
+    
+    /// Keeps at most `count` registered modules open, closing the least
+    /// recently searched first; 0 removes the limit.
+    @discardableResult
+    func setOpenModuleLimit(_ count: UInt32) -> Bool {
+        guard let ptr = managerPtr else { return false }
+        return multi_manager_set_open_module_limit(ptr, count) == 0
+    }
+    
     /// Unloads a module
     func unloadModule(name: String) async -> Bool {
         await withCheckedContinuation { continuation in
@@ -183,6 +454,7 @@ final class SearchService {
                 let result = multi_manager_unload_index(ptr, name)
                 if result == 0 {
                     self.loadedModules.remove(name)
+                    self.moduleSlots.removeValue(forKey: name)
                     continuation.resume(returning: true)
                 } else {
                     continuation.resume(returning: false)
@@ -206,10 +478,272 @@ final class SearchService {
         }
     }
     
+    /// Applies a downloaded index delta to a loaded module's directory and
+    /// reloads it, so the update costs only the changed chunks. On failure
+    /// the installed version stays in use; fall back to a full download.
+    func applyIndexDelta(
+        name: String,
+        indexDirectory: URL,
+        manifestURL: URL,
+        dataURL: URL
+    ) async -> Bool {
+        // Off the search queue: searches keep using the installed version,
+        // on the background search threads while checksumming takes cores
+        let ptr = managerPtr
+        let applied: Result<Void, ValidationError> = await withCheckedContinuation { continuation in
+            DispatchQueue.global(qos: .utility).async {
+                if let ptr = ptr { multi_manager_set_background_indexing(ptr, 1) }
+                defer { if let ptr = ptr { multi_manager_set_background_indexing(ptr, 0) } }
+                continuation.resume(returning: ChunkValidator.applyIndexDelta(
+                    manifestAt: manifestURL,
+                    dataAt: dataURL,
+                    to: indexDirectory
+                ))
+            }
+        }
+        if case .failure(let error) = applied {
+            print("SearchService: Index delta for \(name) failed: \(error.localizedDescription)")
+            return false
+        }
+        return await reloadModule(name: name)
+    }
+    
     // MARK: - Search
     
-    /// The primary search function
+    /// The primary search function. Options and results cross the FFI
+    /// boundary as plain structs and a packed buffer, with no JSON.
     func search(query: String, config: SearchConfig = SearchConfig()) async throws -> [SearchResult] {
+        try await searchTimed(query: query, config: config).results
+    }
+    
+    /// `search` returning where the time went. Every search is also a
+    /// points-of-interest signpost, with its phases as an event, so
+    /// Instruments shows it next to the app's own work.
+    func searchTimed(
+        query: String,
+        config: SearchConfig = SearchConfig()
+    ) async throws -> (results: [SearchResult], timing: QueryTiming) {
+        guard let ptr = managerPtr else { 
+            throw SearchError.managerNotInitialized 
+        }
+        
+        return try await withCheckedThrowingContinuation { continuation in
+            backgroundQueue.async { [weak self] in
+                guard let self = self else {
+                    continuation.resume(returning: ([], QueryTiming()))
+                    return
+                }
+                
+                let signpostID = OSSignpostID(log: SearchService.signpostLog)
+                os_signpost(.begin, log: SearchService.signpostLog, name: "Search", signpostID: signpostID)
+                defer { os_signpost(.end, log: SearchService.signpostLog, name: "Search", signpostID: signpostID) }
+                let start = DispatchTime.now().uptimeNanoseconds
+                
+                guard var options = self.makeOptions(config) else {
+                    // None of the requested modules is loaded
+                    continuation.resume(returning: ([], QueryTiming()))
+                    return
+                }
+                
+                var native = SearchTiming()
+                let written = self.resultBuffer.withUnsafeMutableBytes { raw in
+                    multi_manager_search_binary_timed(ptr, query, &options,
+                                                      raw.baseAddress?.assumingMemoryBound(to: UInt8.self),
+                                                      raw.count, &native)
+                }
+                guard written >= 0 else {
+                    continuation.resume(throwing: SearchError.searchFailed)
+                    return
+                }
+                
+                let results = self.resultBuffer.withUnsafeBytes { SearchService.decodePacked($0) }
+                if results.count < Int(self.packedTotalHits()) && self.resultBuffer.count < 1024 * 1024 {
+                    // Grow for the next query
+                    self.resultBuffer = [UInt8](repeating: 0, count: self.resultBuffer.count * 2)
+                }
+                
+                // Everything outside the library call is marshalling
+                let total = DispatchTime.now().uptimeNanoseconds - start
+                native.marshal_ns = total > native.total_ns ? total - native.total_ns : 0
+                native.total_ns = total
+                let timing = QueryTiming(native, moduleSlots: self.moduleSlots)
+                os_signpost(.event, log: SearchService.signpostLog, name: "Search Phases", signpostID: signpostID,
+                            "parse %llu collect %llu merge %llu fetch %llu serialize %llu marshal %llu ns, cache hit %d",
+                            timing.parseNanos, timing.collectNanos, timing.mergeNanos, timing.fetchNanos,
+                            timing.serializeNanos, timing.marshalNanos, timing.cacheHit ? 1 : 0)
+                continuation.resume(returning: (results, timing))
+            }
+        }
+    }
+    
+    /// `search` returning only articles that pass `filter`, applied natively
+    /// while collecting. Modules are `config.module_filter`.
+    func searchFiltered(
+        query: String,
+        filter: ArticleFilter,
+        config: SearchConfig = SearchConfig()
+    ) async throws -> [SearchResult] {
+        guard let ptr = managerPtr else {
+            throw SearchError.managerNotInitialized
+        }
+        
+        return try await withCheckedThrowingContinuation { continuation in
+            backgroundQueue.async { [weak self] in
+                guard let self = self, var options = self.makeOptions(config) else {
+                    continuation.resume(returning: [])
+                    return
+                }
+                
+                func run(_ category: UnsafePointer<CChar>?) -> Int32 {
+                    var native = SearchFilter(category: category,
+                                              priority_min: filter.priorityMin,
+                                              priority_max: filter.priorityMax ?? UInt32.max)
+                    return self.resultBuffer.withUnsafeMutableBytes { raw in
+                        multi_manager_search_filtered(ptr, query, &options, &native,
+                                                      raw.baseAddress?.assumingMemoryBound(to: UInt8.self),
+                                                      raw.count)
+                    }
+                }
+                let written = filter.category.map { $0.withCString(run) } ?? run(nil)
+                guard written >= 0 else {
+                    continuation.resume(throwing: SearchError.searchFailed)
+                    return
+                }
+                continuation.resume(returning: self.resultBuffer.withUnsafeBytes { SearchService.decodePacked($0) })
+            }
+        }
+    }
+    
+    /// Articles passing `filter` with no query, most critical first, e.g. a
+    /// category screen. Nothing is scored, so results have a score of 0.
+    func browse(filter: ArticleFilter = ArticleFilter(), config: SearchConfig = SearchConfig()) async throws -> [SearchResult] {
+        try await searchFiltered(query: "", filter: filter, config: config)
+    }
+    
+    /// Type-ahead search on the native search threads. No thread waits while
+    /// it runs, and starting one cancels the previous call's native search,
+    /// so only the latest keystroke uses CPU. Cancelling the calling task
+    /// cancels the native search too.
+    ///
+    /// Returns nil when superseded, cancelled or on error.
+    func searchAsync(query: String, config: SearchConfig = SearchConfig()) async -> [SearchResult]? {
+        guard let ptr = managerPtr else { return nil }
+        let request = AsyncSearchRequest()
+        
+        return await withTaskCancellationHandler {
+            await withCheckedContinuation { (continuation: CheckedContinuation<[SearchResult]?, Never>) in
+                // moduleSlots is only touched on backgroundQueue; queuing the
+                // native search there takes microseconds
+                backgroundQueue.async { [weak self] in
+                    guard let self = self, var options = self.makeOptions(config) else {
+                        continuation.resume(returning: nil)
+                        return
+                    }
+                    
+                    let context = Unmanaged.passRetained(AsyncSearchContext(continuation: continuation))
+                    let id = multi_manager_search_async(ptr, query, &options, asyncSearchCallback, context.toOpaque())
+                    guard id != 0 else {
+                        context.release()
+                        continuation.resume(returning: nil)
+                        return
+                    }
+                    
+                    self.asyncLock.lock()
+                    request.id = id
+                    let superseded = self.latestAsyncRequest
+                    self.latestAsyncRequest = request
+                    let cancelNow = request.cancelled
+                    self.asyncLock.unlock()
+                    
+                    if let superseded = superseded, superseded.id != 0 {
+                        multi_manager_cancel_search(ptr, superseded.id)
+                    }
+                    if cancelNow {
+                        multi_manager_cancel_search(ptr, id)
+                    }
+                }
+            }
+        } onCancel: {
+            asyncLock.lock()
+            request.cancelled = true
+            let id = request.id
+            asyncLock.unlock()
+            if id != 0 {
+                multi_manager_cancel_search(ptr, id)
+            }
+        }
+    }
+    
+    /// Tiered search budgets in ms: the core tier, in which the emergency
+    /// answer must arrive, then each lower tier
+    static let defaultTierDeadlinesMs: [UInt32] = [50, 2000]
+    
+    /// Search answering from the core modules first: the selected modules
+    /// are searched one tier at a time, lowest first (directly loaded
+    /// modules, then registered ones by tier), and each tier yields the
+    /// merged top hits so far, so the core answer shows without waiting for
+    /// large reference modules. `tierDeadlinesMs` budgets each tier in
+    /// order, the last repeating; a tier out of budget contributes what it
+    /// found.
+    ///
+    /// Only the newest batch is buffered. The stream ends after the final
+    /// batch, or empty on error; ending iteration cancels the native search.
+    func searchTiered(
+        query: String,
+        config: SearchConfig = SearchConfig(),
+        tierDeadlinesMs: [UInt32] = SearchService.defaultTierDeadlinesMs
+    ) -> AsyncStream<TieredSearchResults> {
+        AsyncStream(bufferingPolicy: .bufferingNewest(1)) { continuation in
+            guard let ptr = managerPtr else {
+                continuation.finish()
+                return
+            }
+            let request = AsyncSearchRequest()
+            
+            // Also runs after the final batch, when cancelling is a no-op
+            continuation.onTermination = { [weak self] _ in
+                guard let self = self else { return }
+                self.asyncLock.lock()
+                request.cancelled = true
+                let id = request.id
+                self.asyncLock.unlock()
+                if id != 0 {
+                    multi_manager_cancel_search(ptr, id)
+                }
+            }
+            
+            backgroundQueue.async { [weak self] in
+                guard let self = self, var options = self.makeOptions(config) else {
+                    continuation.finish()
+                    return
+                }
+                
+                let context = Unmanaged.passRetained(TieredSearchContext(continuation: continuation))
+                let id = tierDeadlinesMs.withUnsafeBufferPointer { deadlines in
+                    multi_manager_search_tiered(
+                        ptr, query, &options, deadlines.baseAddress, deadlines.count,
+                        tieredSearchCallback, context.toOpaque()
+                    )
+                }
+                guard id != 0 else {
+                    context.release()
+                    continuation.finish()
+                    return
+                }
+                
+                self.asyncLock.lock()
+                request.id = id
+                let cancelNow = request.cancelled
+                self.asyncLock.unlock()
+                if cancelNow {
+                    multi_manager_cancel_search(ptr, id)
+                }
+            }
+        }
+    }
+    
+    /// JSON variant of `search`, kept for debugging
+    func searchJSON(query: String, config: SearchConfig = SearchConfig()) async throws -> [SearchResult] {
         guard let ptr = managerPtr else { 
             throw SearchError.managerNotInitialized 
         }
@@ -285,16 +819,213 @@ final class SearchService {
         }
     }
     
+    /// Gets result cache counters, or nil if unavailable
+    /// Stored fields of the article with id `docId`, from `module` or from
+    /// the first loaded module that has it. Modules built with an id table
+    /// resolve it without a query. Nil if no module has the article.
+    func getDocument(docId: String, module: String? = nil) async -> [String: String]? {
+        guard let ptr = managerPtr else { return nil }
+        
+        return await withCheckedContinuation { continuation in
+            backgroundQueue.async {
+                guard let resultPtr = multi_manager_get_document(ptr, module, docId) else {
+                    continuation.resume(returning: nil)
+                    return
+                }
+                
+                let jsonString = String(cString: resultPtr)
+                free_rust_string(UnsafeMutablePointer(mutating: resultPtr))
+                let document = jsonString.data(using: .utf8).flatMap {
+                    try? JSONDecoder().decode([String: String].self, from: $0)
+                }
+                continuation.resume(returning: document)
+            }
+        }
+    }
+    
+    /// The stored body of article `docId` in chunks, for rendering long
+    /// manuals progressively. Each chunk ends on a character boundary. The
+    /// stream is empty if no module has the article or its index stores no
+    /// body; it stops reading once the consumer goes away.
+    func documentChunks(docId: String, module: String? = nil) -> AsyncStream<String> {
+        AsyncStream { continuation in
+            backgroundQueue.async { [weak self] in
+                guard let ptr = self?.managerPtr,
+                      let stream = multi_manager_open_document_stream(ptr, module, docId) else {
+                    continuation.finish()
+                    return
+                }
+                defer { document_stream_free(stream) }
+                
+                var buffer = [UInt8](repeating: 0, count: Self.chunkBytes)
+                var maxBytes = Self.firstChunkBytes
+                while true {
+                    let read = buffer.withUnsafeMutableBufferPointer {
+                        document_stream_read(stream, $0.baseAddress, maxBytes)
+                    }
+                    if read <= 0 { break }
+                    let chunk = String(decoding: buffer[0..<Int(read)], as: UTF8.self)
+                    if case .terminated = continuation.yield(chunk) { break }
+                    maxBytes = Self.chunkBytes
+                }
+                continuation.finish()
+            }
+        }
+    }
+    
+    /// Footprint and query counters of one loaded module, or nil if it
+    /// isn't loaded
+    func moduleFootprint(name: String) async -> TantivyBridge.IndexStats? {
+        guard let ptr = managerPtr else { return nil }
+        
+        return await withCheckedContinuation { continuation in
+            backgroundQueue.async {
+                var stats = IndexStats()
+                guard multi_manager_module_stats(ptr, name, &stats) == 0 else {
+                    continuation.resume(returning: nil)
+                    return
+                }
+                continuation.resume(returning: TantivyBridge.IndexStats(stats))
+            }
+        }
+    }
+    
+    func getCacheStats() -> CacheStats? {
+        guard let ptr = managerPtr, let resultPtr = multi_manager_cache_stats(ptr) else {
+            return nil
+        }
+        
+        let jsonString = String(cString: resultPtr)
+        free_rust_string(resultPtr)
+        return jsonString.data(using: .utf8).flatMap { try? JSONDecoder().decode(CacheStats.self, from: $0) }
+    }
+    
+    /// Caps the native result cache at `bytes`; 0 disables it.
+    /// Loading, unloading or reloading a module clears the cache.
+    @discardableResult
+    func setCacheCapacity(_ bytes: Int) -> Bool {
+        guard let ptr = managerPtr else { return false }
+        return multi_manager_set_cache_capacity(ptr, max(bytes, 0)) == 0
+    }
+    
+    // MARK: - Binary Encoding
+    
+    /// Translates module names into slots. Returns nil when a filter names
+    /// no loaded module, since an empty mask would mean "all modules".
+    private func makeOptions(_ config: SearchConfig) -> MultiSearchOptions? {
+        var options = multi_search_options_default()
+        options.limit = UInt32(clamping: config.limit)
+        
+        if let filter = config.module_filter {
+            for name in filter {
+                if let slot = moduleSlots[name], (0..<Int(MULTI_SEARCH_MAX_MODULES)).contains(slot) {
+                    options.module_mask |= UInt32(1) << UInt32(slot)
+                }
+            }
+            if options.module_mask == 0 { return nil }
+        }
+        
+        if let weights = config.weights {
+            withUnsafeMutableBytes(of: &options.module_weights) { raw in
+                let slots = raw.bindMemory(to: Float.self)
+                for (name, weight) in weights {
+                    if let slot = moduleSlots[name], slot >= 0, slot < slots.count {
+                        slots[slot] = weight
+                    }
+                }
+            }
+        }
+        return options
+    }
+    
+    private func packedTotalHits() -> UInt32 {
+        resultBuffer.withUnsafeBytes { $0.load(as: PackedResultsHeader.self).total_hits }
+    }
+    
+    /// Decodes the packed layout described in tantivy_mobile.h
+    fileprivate static func decodePacked(_ raw: UnsafeRawBufferPointer) -> [SearchResult] {
+        guard raw.count >= MemoryLayout<PackedResultsHeader>.size else { return [] }
+        let header = raw.load(as: PackedResultsHeader.self)
+        guard header.magic == TANTIVY_PACKED_MAGIC else { return [] }
+        
+        let pool = Int(header.pool_offset)
+        func string(_ packed: PackedString) -> String {
+            let start = pool + Int(packed.offset)
+            return String(decoding: raw[start..<start + Int(packed.length)], as: UTF8.self)
+        }
+        
+        var results = [SearchResult]()
+        results.reserveCapacity(Int(header.count))
+        for row in 0..<Int(header.count) {
+            let offset = MemoryLayout<PackedResultsHeader>.size + row * MemoryLayout<PackedResultRow>.size
+            let packed = raw.load(fromByteOffset: offset, as: PackedResultRow.self)
+            results.append(SearchResult(doc_id: string(packed.id),
+                                        title: string(packed.title),
+                                        summary: string(packed.summary),
+                                        score: packed.score,
+                                        module: string(packed.module)))
+        }
+        return results
+    }
+    
+    // MARK: - Memory
+    
+    /// Caps the index pages kept in RAM across all modules; 0 removes the
+    /// cap. The least recently searched modules are paged out first.
+    @discardableResult
+    func setMemoryBudget(_ bytes: Int) -> Bool {
+        guard let ptr = managerPtr else { return false }
+        return multi_manager_set_memory_budget(ptr, max(bytes, 0)) == 0
+    }
+    
+    /// Drops resident index pages; `critical` also clears the result cache.
+    /// Searches keep working and read pages back from storage when needed.
+    func trimMemory(critical: Bool) {
+        guard let ptr = managerPtr else { return }
+        multi_manager_trim_memory(ptr, critical ? TANTIVY_TRIM_CRITICAL : TANTIVY_TRIM_MODERATE)
+    }
+    
     // MARK: - Helpers
     
-    /// Pre-warm the search engine with a dummy query
-    func prewarmSearch() async {
-        do {
-            let config = SearchConfig(limit: 1)
-            _ = try await search(query: "the", config: config)
-            print("SearchService: Pre-warm completed")
-        } catch {
-            print("SearchService: Pre-warm failed: \(error)")
+    /// Pre-warm the search engine with the bundled manifest's emergency
+    /// queries. Runs natively in the background and returns immediately.
+    func prewarmSearch() {
+        guard let url = Bundle.main.url(forResource: "content_manifest", withExtension: "json", subdirectory: "Content"),
+              let manifestJSON = try? String(contentsOf: url, encoding: .utf8) else {
+            print("SearchService: Pre-warm skipped, no bundled manifest")
+            return
+        }
+        if startWarmup(manifestJSON: manifestJSON) {
+            print("SearchService: Pre-warm started")
+        }
+    }
+    
+    /// Starts warming the loaded modules with a content manifest's warmup
+    /// queries on a native background thread, replacing any running warmup.
+    /// User searches are never blocked by it.
+    @discardableResult
+    func startWarmup(manifestJSON: String) -> Bool {
+        guard let ptr = managerPtr else { return false }
+        
+        warmupLock.lock()
+        defer { warmupLock.unlock() }
+        stopWarmupLocked()
+        warmupHandle = multi_manager_start_warmup(ptr, manifestJSON)
+        return warmupHandle != nil
+    }
+    
+    /// Stops the running warmup, if any, after its in-flight query
+    func cancelWarmup() {
+        warmupLock.lock()
+        defer { warmupLock.unlock() }
+        stopWarmupLocked()
+    }
+    
+    private func stopWarmupLocked() {
+        if let handle = warmupHandle {
+            warmup_cancel(handle)
+            warmup_free(handle)
+            warmupHandle = nil
         }
     }
 }
\ No newline at end of file
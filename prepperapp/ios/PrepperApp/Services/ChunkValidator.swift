@@ -101,6 +101,152 @@ class ChunkValidator {
         }
     }
     
+    // MARK: - Index Deltas
+    
+    // Must match DELTA_FORMAT_VERSION in tantivy-indexer's delta.rs
+    private static let supportedDeltaFormat = 1
+    private static let copySliceBytes = 1 << 20
+    
+    /// Updates a module index in place from a downloaded tantivy-delta
+    /// (delta.json + delta.bin). New files are written beside the installed
+    /// ones and checksummed, and meta.json is swapped in last, so an
+    /// interrupted apply leaves the installed version searchable. Reload the
+    /// module afterwards.
+    static func applyIndexDelta(
+        manifestAt manifestURL: URL,
+        dataAt dataURL: URL,
+        to indexDirectory: URL,
+        progress: ((Float) -> Void)? = nil
+    ) -> Result<Void, ValidationError> {
+        let delta: IndexDelta
+        do {
+            delta = try JSONDecoder().decode(IndexDelta.self, from: Data(contentsOf: manifestURL))
+        } catch {
+            return .failure(.invalidDelta(error.localizedDescription))
+        }
+        guard delta.format == supportedDeltaFormat else {
+            return .failure(.invalidDelta("Unsupported delta format \(delta.format)"))
+        }
+        
+        // A delta only rebuilds the exact version it was made from
+        let metaURL = indexDirectory.appendingPathComponent("meta.json")
+        guard let installedMeta = try? Data(contentsOf: metaURL) else {
+            return .failure(.deltaBaseMismatch)
+        }
+        let installedChecksum = calculateChecksum(for: installedMeta)
+        if installedChecksum == delta.target_meta_sha256 {
+            return .success(()) // Already applied
+        }
+        guard installedChecksum == delta.base_meta_sha256 else {
+            return .failure(.deltaBaseMismatch)
+        }
+        
+        let payload: Data
+        do {
+            payload = try Data(contentsOf: dataURL, options: .alwaysMapped)
+        } catch {
+            return .failure(.fileReadError(error))
+        }
+        guard Int64(payload.count) == delta.data_size else {
+            return .failure(.fileSizeMismatch(expected: delta.data_size, actual: Int64(payload.count)))
+        }
+        let payloadChecksum = calculateChecksum(for: payload)
+        guard payloadChecksum == delta.data_sha256 else {
+            return .failure(.checksumMismatch(expected: delta.data_sha256, actual: payloadChecksum))
+        }
+        
+        // Stage every file before touching the installed version
+        var staged: [(part: URL, final: URL)] = []
+        for (index, file) in delta.files.enumerated() {
+            let finalURL = indexDirectory.appendingPathComponent(file.name)
+            let partURL = indexDirectory.appendingPathComponent(file.name + ".part")
+            if case .failure(let error) = writeDeltaFile(file, in: indexDirectory, payload: payload, to: partURL) {
+                staged.forEach { try? FileManager.default.removeItem(at: $0.part) }
+                try? FileManager.default.removeItem(at: partURL)
+                return .failure(error)
+            }
+            staged.append((partURL, finalURL))
+            progress?(Float(index + 1) / Float(delta.files.count))
+        }
+        
+        // Files are listed with meta.json last, which publishes the new version
+        do {
+            for file in staged {
+                if FileManager.default.fileExists(atPath: file.final.path) {
+                    _ = try FileManager.default.replaceItemAt(file.final, withItemAt: file.part)
+                } else {
+                    try FileManager.default.moveItem(at: file.part, to: file.final)
+                }
+            }
+        } catch {
+            return .failure(.assemblyFailed(error))
+        }
+        
+        // Open searchers keep their mappings of removed files until reloaded
+        for name in delta.remove {
+            try? FileManager.default.removeItem(at: indexDirectory.appendingPathComponent(name))
+        }
+        return .success(())
+    }
+    
+    private static func writeDeltaFile(
+        _ file: IndexDeltaFile,
+        in indexDirectory: URL,
+        payload: Data,
+        to destination: URL
+    ) -> Result<Void, ValidationError> {
+        FileManager.default.createFile(atPath: destination.path, contents: nil)
+        guard let output = FileHandle(forWritingAtPath: destination.path) else {
+            return .failure(.fileCreationFailed)
+        }
+        defer { output.closeFile() }
+        
+        var hasher = SHA256()
+        var written: Int64 = 0
+        let emit = { (bytes: Data) in
+            hasher.update(data: bytes)
+            output.write(bytes)
+            written += Int64(bytes.count)
+        }
+        
+        for op in file.ops {
+            switch op.op {
+            case "data":
+                guard op.offset >= 0, op.len >= 0, op.offset + op.len <= Int64(payload.count) else {
+                    return .failure(.invalidDelta("Data range outside delta.bin in \(file.name)"))
+                }
+                emit(payload.subdata(in: Int(op.offset)..<Int(op.offset + op.len)))
+            case "copy":
+                guard let source = op.file,
+                      let input = FileHandle(forReadingAtPath: indexDirectory.appendingPathComponent(source).path) else {
+                    return .failure(.invalidDelta("Missing installed file for \(file.name)"))
+                }
+                defer { input.closeFile() }
+                input.seek(toFileOffset: UInt64(op.offset))
+                var remaining = op.len
+                while remaining > 0 {
+                    let slice = input.readData(ofLength: Int(min(remaining, Int64(copySliceBytes))))
+                    if slice.isEmpty {
+                        return .failure(.invalidDelta("Copy past the end of \(source)"))
+                    }
+                    emit(slice)
+                    remaining -= Int64(slice.count)
+                }
+            default:
+                return .failure(.invalidDelta("Unknown op \(op.op)"))
+            }
+        }
+        
+        guard written == file.size else {
+            return .failure(.fileSizeMismatch(expected: file.size, actual: written))
+        }
+        let checksum = hasher.finalize().compactMap { String(format: "%02x", $0) }.joined()
+        guard checksum == file.sha256 else {
+            return .failure(.checksumMismatch(expected: file.sha256, actual: checksum))
+        }
+        return .success(())
+    }
+    
     // MARK: - Content Verification
     
     static func verifyContentIntegrity(
@@ -196,6 +342,8 @@ enum ValidationError: LocalizedError {
     case invalidDatabase
     case databaseCorrupted(String)
     case invalidFileFormat(String)
+    case invalidDelta(String)
+    case deltaBaseMismatch
     
     var errorDescription: String? {
         switch self {
@@ -221,6 +369,10 @@ enum ValidationError: LocalizedError {
             return "Database corruption detected: \(message)"
         case .invalidFileFormat(let message):
             return "Invalid file format: \(message)"
+        case .invalidDelta(let message):
+            return "Invalid index update: \(message)"
+        case .deltaBaseMismatch:
+            return "Index update does not match the installed version"
         }
     }
 }
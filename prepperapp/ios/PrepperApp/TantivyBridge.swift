@@ -1,5 +1,8 @@
 import Foundation
 
+// The C struct, which TantivyBridge.IndexStats shadows inside the class
+typealias NativeIndexStats = IndexStats
+
 // MARK: - TantivyBridge
 /// Swift wrapper for Tantivy search engine
 final class TantivyBridge {
@@ -42,6 +45,41 @@ final class TantivyBridge {
     struct IndexStats {
         let documentCount: Int64
         let indexSizeBytes: Int64
+        var segmentCount: Int = 0
+        var mappedBytes: Int64 = 0
+        // 0 unless the index was opened with TANTIVY_OPEN_MMAP_ADVISED
+        var residentBytes: Int64 = 0
+        var heapBytes: Int64 = 0
+        var docstoreCacheBytes: Int64 = 0
+        var queryCount: UInt64 = 0
+        var queryTimeNanos: UInt64 = 0
+        // Search counts by latency: < 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50,
+        // 100, 250 ms, and slower
+        var latencyHistogram: [UInt64] = []
+        
+        var meanQueryNanos: UInt64 {
+            queryCount == 0 ? 0 : queryTimeNanos / queryCount
+        }
+        
+        init(documentCount: Int64, indexSizeBytes: Int64) {
+            self.documentCount = documentCount
+            self.indexSizeBytes = indexSizeBytes
+        }
+        
+        init(_ stats: NativeIndexStats) {
+            documentCount = Int64(stats.num_docs)
+            indexSizeBytes = Int64(stats.index_size_bytes)
+            segmentCount = Int(stats.segment_count)
+            mappedBytes = Int64(stats.mapped_bytes)
+            residentBytes = Int64(stats.resident_bytes)
+            heapBytes = Int64(stats.heap_bytes)
+            docstoreCacheBytes = Int64(stats.docstore_cache_bytes)
+            queryCount = stats.query_count
+            queryTimeNanos = stats.query_time_ns
+            latencyHistogram = withUnsafeBytes(of: stats.latency_histogram) {
+                Array($0.bindMemory(to: UInt64.self))
+            }
+        }
         
         var formattedSize: String {
             let formatter = ByteCountFormatter()
@@ -192,14 +230,19 @@ final class TantivyBridge {
                 
                 let stats = tantivy_get_index_stats(self.indexPointer)
                 
-                continuation.resume(returning: IndexStats(
-                    documentCount: Int64(stats.num_docs),
-                    indexSizeBytes: Int64(stats.index_size_bytes)
-                ))
+                continuation.resume(returning: IndexStats(stats))
             }
         }
     }
     
+    /// Start a search-as-you-type session over this index
+    func makeIncrementalSearch() -> IncrementalSearch? {
+        guard let session = tantivy_incremental_create(indexPointer) else {
+            return nil
+        }
+        return IncrementalSearch(index: self, session: session)
+    }
+    
     // MARK: - Batch Operations
     
     /// Add multiple documents in a batch
@@ -218,6 +261,82 @@ final class TantivyBridge {
     }
 }
 
+// MARK: - Incremental Search
+/// Search-as-you-type session. Each keystroke that extends the previous query
+/// narrows the native candidate set instead of searching cold.
+final class IncrementalSearch {
+    
+    // Keeps the index alive for as long as the session
+    private let index: TantivyBridge
+    private let session: OpaquePointer
+    private let queue = DispatchQueue(label: "com.prepperapp.tantivy.incremental", qos: .userInitiated)
+    private var buffer = [UInt8](repeating: 0, count: 64 * 1024)
+    
+    fileprivate init(index: TantivyBridge, session: OpaquePointer) {
+        self.index = index
+        self.session = session
+    }
+    
+    deinit {
+        tantivy_incremental_free(session)
+    }
+    
+    /// Results for `query`, or nil when a newer keystroke superseded it
+    func search(query: String, limit: Int = 20) async throws -> [TantivyBridge.SearchResult]? {
+        // Stop the query in flight now rather than after it reaches the queue
+        tantivy_incremental_cancel(session)
+        
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                let count = self.buffer.withUnsafeMutableBytes { raw in
+                    tantivy_search_incremental(self.session, query, limit,
+                                               raw.baseAddress?.assumingMemoryBound(to: UInt8.self),
+                                               raw.count)
+                }
+                if count == TANTIVY_ERROR_CANCELLED {
+                    continuation.resume(returning: nil)
+                } else if count < 0 {
+                    continuation.resume(throwing: TantivyBridge.TantivyError.searchFailed)
+                } else {
+                    continuation.resume(returning: self.decodePacked())
+                }
+            }
+        }
+    }
+    
+    /// Abandon the query in flight, e.g. when the search field is cleared
+    func cancel() {
+        tantivy_incremental_cancel(session)
+    }
+    
+    /// Decodes the packed layout described in tantivy_mobile.h
+    private func decodePacked() -> [TantivyBridge.SearchResult] {
+        buffer.withUnsafeBytes { raw -> [TantivyBridge.SearchResult] in
+            let header = raw.load(as: PackedResultsHeader.self)
+            guard header.magic == TANTIVY_PACKED_MAGIC else { return [] }
+            
+            let pool = Int(header.pool_offset)
+            func string(_ packed: PackedString) -> String {
+                let start = pool + Int(packed.offset)
+                return String(decoding: raw[start..<start + Int(packed.length)], as: UTF8.self)
+            }
+            
+            return (0..<Int(header.count)).map { row in
+                let offset = MemoryLayout<PackedResultsHeader>.size + row * MemoryLayout<PackedResultRow>.size
+                let packed = raw.load(fromByteOffset: offset, as: PackedResultRow.self)
+                return TantivyBridge.SearchResult(
+                    id: string(packed.id),
+                    title: string(packed.title),
+                    category: string(packed.category),
+                    summary: string(packed.summary),
+                    priority: Int(packed.priority),
+                    score: packed.score
+                )
+            }
+        }
+    }
+}
+
 // MARK: - Index Manager
 /// Manages multiple Tantivy indexes (core + modules)
 final class TantivyIndexManager {
@@ -278,22 +397,37 @@ final class TantivyIndexManager {
     
     /// Get combined statistics
     func getStats() async -> TantivyBridge.IndexStats {
-        var totalDocs: Int64 = 0
-        var totalSize: Int64 = 0
-        
+        var indexes: [TantivyBridge] = Array(moduleIndexes.values)
         if let core = coreIndex {
-            let stats = await core.getStats()
-            totalDocs += stats.documentCount
-            totalSize += stats.indexSizeBytes
+            indexes.insert(core, at: 0)
         }
         
-        for (_, moduleIndex) in moduleIndexes {
-            let stats = await moduleIndex.getStats()
-            totalDocs += stats.documentCount
-            totalSize += stats.indexSizeBytes
+        var all: [TantivyBridge.IndexStats] = []
+        for index in indexes {
+            all.append(await index.getStats())
         }
         
-        return TantivyBridge.IndexStats(documentCount: totalDocs, indexSizeBytes: totalSize)
+        var combined = TantivyBridge.IndexStats(
+            documentCount: all.reduce(0) { $0 + $1.documentCount },
+            indexSizeBytes: all.reduce(0) { $0 + $1.indexSizeBytes }
+        )
+        for stats in all {
+            combined.segmentCount += stats.segmentCount
+            combined.mappedBytes += stats.mappedBytes
+            combined.residentBytes += stats.residentBytes
+            combined.heapBytes += stats.heapBytes
+            combined.docstoreCacheBytes += stats.docstoreCacheBytes
+            combined.queryCount += stats.queryCount
+            combined.queryTimeNanos += stats.queryTimeNanos
+            if combined.latencyHistogram.isEmpty {
+                combined.latencyHistogram = stats.latencyHistogram
+            } else {
+                for (bucket, count) in stats.latencyHistogram.enumerated() where bucket < combined.latencyHistogram.count {
+                    combined.latencyHistogram[bucket] += count
+                }
+            }
+        }
+        return combined
     }
     
     // MARK: - Private Methods
@@ -2,12 +2,13 @@ import Foundation
 
 // MARK: - Tantivy C Bridge
 
-// C function declarations
+// C function declarations, matching the single-index JSON API in
+// rust/tantivy-mobile/tantivy_mobile.h
 @_silgen_name("init_searcher")
-func tantivy_init_searcher(_ path: UnsafePointer<CChar>) -> UnsafeMutablePointer<CChar>?
+func tantivy_init_searcher(_ path: UnsafePointer<CChar>) -> OpaquePointer?
 
-@_silgen_name("search")
-func tantivy_search(_ searcher_ptr: UnsafeRawPointer,
+@_silgen_name("search_with_offset")
+func tantivy_search(_ searcher_ptr: OpaquePointer,
                    _ query: UnsafePointer<CChar>,
                    _ limit: UInt32,
                    _ offset: UInt32) -> UnsafeMutablePointer<CChar>?
@@ -15,13 +16,13 @@ func tantivy_search(_ searcher_ptr: UnsafeRawPointer,
 @_silgen_name("free_string")
 func tantivy_free_string(_ str: UnsafeMutablePointer<CChar>)
 
-@_silgen_name("close_searcher")
-func tantivy_close_searcher(_ searcher_ptr: UnsafeMutableRawPointer)
+@_silgen_name("destroy_searcher")
+func tantivy_destroy_searcher(_ searcher_ptr: OpaquePointer)
 
 // MARK: - TantivyBridge
 
 class TantivyBridge {
-    private var searcherPointer: UnsafeMutableRawPointer?
+    private var searcherPointer: OpaquePointer?
     private let queue = DispatchQueue(label: "com.prepperapp.tantivy", qos: .userInitiated)
     
     init() {}
@@ -40,31 +41,13 @@ class TantivyBridge {
                     return
                 }
                 
-                // Call C function
-                guard let resultPtr = tantivy_init_searcher(indexPath) else {
+                guard let searcher = tantivy_init_searcher(indexPath) else {
                     continuation.resume(throwing: PrepperAppError.searchFailed("Failed to initialize searcher"))
                     return
                 }
                 
-                // Parse JSON response
-                let resultString = String(cString: resultPtr)
-                tantivy_free_string(resultPtr)
-                
-                do {
-                    let data = resultString.data(using: .utf8)!
-                    let response = try JSONDecoder().decode(InitResponse.self, from: data)
-                    
-                    if let success = response.success {
-                        self.searcherPointer = UnsafeMutableRawPointer(bitPattern: success.searcherPtr)
-                        continuation.resume()
-                    } else if let error = response.error {
-                        continuation.resume(throwing: PrepperAppError.searchFailed(error))
-                    } else {
-                        continuation.resume(throwing: PrepperAppError.searchFailed("Invalid response"))
-                    }
-                } catch {
-                    continuation.resume(throwing: PrepperAppError.searchFailed("Failed to parse response: \(error)"))
-                }
+                self.searcherPointer = searcher
+                continuation.resume()
             }
         }
     }
@@ -88,23 +71,16 @@ class TantivyBridge {
                 
                 do {
                     let data = resultString.data(using: .utf8)!
-                    let response = try JSONDecoder().decode(SearchResponse.self, from: data)
-                    
-                    if let success = response.success {
-                        let results = success.map { item in
-                            TantivySearchResult(
-                                docId: item.doc_id,
-                                score: item.score,
-                                title: item.title,
-                                snippet: item.snippet
-                            )
-                        }
-                        continuation.resume(returning: results)
-                    } else if let error = response.error {
-                        continuation.resume(throwing: PrepperAppError.searchFailed(error))
-                    } else {
-                        continuation.resume(returning: [])
+                    let items = try JSONDecoder().decode([SearchItem].self, from: data)
+                    let results = items.map { item in
+                        TantivySearchResult(
+                            docId: item.doc_id,
+                            score: item.score,
+                            title: item.title,
+                            snippet: item.summary
+                        )
                     }
+                    continuation.resume(returning: results)
                 } catch {
                     continuation.resume(throwing: PrepperAppError.searchFailed("Failed to parse response: \(error)"))
                 }
@@ -115,7 +91,7 @@ class TantivyBridge {
     func close() {
         if let searcher = searcherPointer {
             queue.sync {
-                tantivy_close_searcher(searcher)
+                tantivy_destroy_searcher(searcher)
                 searcherPointer = nil
             }
         }
@@ -123,28 +99,11 @@ class TantivyBridge {
     
     // MARK: - Private Types
     
-    private struct InitResponse: Codable {
-        struct Success: Codable {
-            let searcherPtr: Int
-            
-            private enum CodingKeys: String, CodingKey {
-                case searcherPtr = "searcher_ptr"
-            }
-        }
-        
-        let success: Success?
-        let error: String?
-    }
-    
-    private struct SearchResponse: Codable {
-        struct SearchItem: Codable {
-            let doc_id: String
-            let score: Float
-            let title: String
-            let snippet: String?
-        }
-        
-        let success: [SearchItem]?
-        let error: String?
+    /// One element of the JSON array returned by search_with_offset
+    private struct SearchItem: Codable {
+        let doc_id: String
+        let score: Float
+        let title: String
+        let summary: String?
     }
 }
\ No newline at end of file
@@ -0,0 +1,310 @@
+// delta.rs - Chunk-level deltas between two builds of a module index
+//
+// Files are cut into content-defined chunks (a gear rolling hash picks the
+// boundaries), so inserting documents only disturbs the chunks around the
+// change instead of shifting every fixed-size block after it. A delta is two
+// files:
+//   delta.json - for each new or changed file, the ops that rebuild it:
+//                copy a byte range from a file of the installed version, or
+//                take a range of delta.bin
+//   delta.bin  - the bytes no installed file already has
+// Files of the installed version that are not mentioned stay as they are;
+// `remove` lists the ones the new version no longer uses. Changed files are
+// listed segment files first, then .managed.json, then meta.json, so a client
+// that writes them in order and swaps meta.json last never exposes a
+// half-applied index to the reader.
+
+use anyhow::{bail, Result};
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+use std::collections::HashMap;
+use std::fs;
+use std::ops::Range;
+use std::path::Path;
+
+pub const DELTA_FORMAT_VERSION: u32 = 1;
+
+pub const MIN_CHUNK: usize = 16 * 1024;
+pub const MAX_CHUNK: usize = 256 * 1024;
+// 16 bits of the hash must be zero: a 64 KiB average past MIN_CHUNK
+const CUT_MASK: u64 = 0xffff << 48;
+
+#[derive(Serialize, Deserialize, Debug, Clone, PartialEq)]
+#[serde(tag = "op", rename_all = "snake_case")]
+pub enum Op {
+    /// Bytes `offset..offset + len` of an installed file
+    Copy { file: String, offset: u64, len: u64 },
+    /// Bytes `offset..offset + len` of delta.bin
+    Data { offset: u64, len: u64 },
+}
+
+#[derive(Serialize, Deserialize, Debug)]
+pub struct FileDelta {
+    pub name: String,
+    pub size: u64,
+    pub sha256: String,
+    pub ops: Vec<Op>,
+}
+
+#[derive(Serialize, Deserialize, Debug)]
+pub struct DeltaManifest {
+    pub format: u32,
+    /// SHA-256 of the meta.json the delta applies to
+    pub base_meta_sha256: String,
+    pub target_meta_sha256: String,
+    pub files: Vec<FileDelta>,
+    pub remove: Vec<String>,
+    pub data_size: u64,
+    pub data_sha256: String,
+}
+
+fn hex(bytes: &[u8]) -> String {
+    bytes.iter().map(|b| format!("{:02x}", b)).collect()
+}
+
+pub fn sha256_hex(bytes: &[u8]) -> String {
+    hex(&Sha256::digest(bytes))
+}
+
+// Fixed pseudo-random gear table (splitmix64), so boundaries never change
+// between tool versions
+fn gear_table() -> [u64; 256] {
+    let mut table = [0u64; 256];
+    let mut state: u64 = 0x5072_6570_7065_7221;
+    for entry in table.iter_mut() {
+        state = state.wrapping_add(0x9e37_79b9_7f4a_7c15);
+        let mut z = state;
+        z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+        *entry = z ^ (z >> 31);
+    }
+    table
+}
+
+/// Content-defined chunk ranges covering `data`.
+pub fn chunks(data: &[u8]) -> Vec<Range<usize>> {
+    let gear = gear_table();
+    let mut ranges = Vec::with_capacity(data.len() / (64 * 1024) + 1);
+    let mut start = 0;
+    while start < data.len() {
+        let end = (start + MAX_CHUNK).min(data.len());
+        let mut cut = end;
+        let mut hash = 0u64;
+        for i in (start + MIN_CHUNK).min(end)..end {
+            hash = (hash << 1).wrapping_add(gear[data[i] as usize]);
+            if hash & CUT_MASK == 0 {
+                cut = i + 1;
+                break;
+            }
+        }
+        ranges.push(start..cut);
+        start = cut;
+    }
+    ranges
+}
+
+// Lock files are created empty by whichever process opens a writer
+fn is_packaged(name: &str) -> bool {
+    !name.starts_with(".tantivy-") && !name.ends_with(".lock")
+}
+
+fn read_index(dir: &Path) -> Result<Vec<(String, Vec<u8>)>> {
+    let mut files = Vec::new();
+    for entry in fs::read_dir(dir)? {
+        let entry = entry?;
+        if !entry.file_type()?.is_file() {
+            continue;
+        }
+        if let Ok(name) = entry.file_name().into_string() {
+            if is_packaged(&name) {
+                let bytes = fs::read(entry.path())?;
+                files.push((name, bytes));
+            }
+        }
+    }
+    // Segment files, then .managed.json, then meta.json
+    files.sort_by_key(|(name, _)| (name == "meta.json", name == ".managed.json", name.clone()));
+    Ok(files)
+}
+
+// Appends an op, extending the previous one when the ranges are contiguous
+fn push_op(ops: &mut Vec<Op>, op: Op) {
+    match (ops.last_mut(), &op) {
+        (Some(Op::Copy { file, offset, len }), Op::Copy { file: f, offset: o, len: l })
+            if file == f && *offset + *len == *o =>
+        {
+            *len += l;
+        }
+        (Some(Op::Data { offset, len }), Op::Data { offset: o, len: l }) if *offset + *len == *o => {
+            *len += l;
+        }
+        _ => ops.push(op),
+    }
+}
+
+/// Builds the delta that turns the index in `base_dir` into the one in
+/// `target_dir`. Returns the manifest and the contents of delta.bin.
+pub fn build(base_dir: &Path, target_dir: &Path) -> Result<(DeltaManifest, Vec<u8>)> {
+    let base = read_index(base_dir)?;
+    let target = read_index(target_dir)?;
+    let meta_sha = |files: &[(String, Vec<u8>)]| -> Result<String> {
+        match files.iter().find(|(name, _)| name == "meta.json") {
+            Some((_, bytes)) => Ok(sha256_hex(bytes)),
+            None => bail!("no meta.json; not an index directory"),
+        }
+    };
+    let base_meta_sha256 = meta_sha(&base)?;
+    let target_meta_sha256 = meta_sha(&target)?;
+
+    // Every chunk of the installed version, by content hash
+    let mut known: HashMap<[u8; 32], (usize, Range<usize>)> = HashMap::new();
+    for (file_idx, (_, bytes)) in base.iter().enumerate() {
+        for range in chunks(bytes) {
+            let digest: [u8; 32] = Sha256::digest(&bytes[range.clone()]).into();
+            known.entry(digest).or_insert((file_idx, range));
+        }
+    }
+    let base_by_name: HashMap<&str, &[u8]> =
+        base.iter().map(|(name, bytes)| (name.as_str(), bytes.as_slice())).collect();
+
+    let mut data = Vec::new();
+    let mut files = Vec::new();
+    for (name, bytes) in &target {
+        if base_by_name.get(name.as_str()) == Some(&bytes.as_slice()) {
+            continue; // Unchanged; segment files are named by content
+        }
+        let mut ops = Vec::new();
+        for range in chunks(bytes) {
+            let chunk = &bytes[range.clone()];
+            let digest: [u8; 32] = Sha256::digest(chunk).into();
+            match known.get(&digest) {
+                Some((file_idx, source)) => push_op(
+                    &mut ops,
+                    Op::Copy { file: base[*file_idx].0.clone(), offset: source.start as u64, len: chunk.len() as u64 },
+                ),
+                None => {
+                    push_op(&mut ops, Op::Data { offset: data.len() as u64, len: chunk.len() as u64 });
+                    data.extend_from_slice(chunk);
+                }
+            }
+        }
+        files.push(FileDelta { name: name.clone(), size: bytes.len() as u64, sha256: sha256_hex(bytes), ops });
+    }
+
+    let target_names: Vec<&str> = target.iter().map(|(name, _)| name.as_str()).collect();
+    let remove = base.iter().map(|(name, _)| name.clone()).filter(|name| !target_names.contains(&name.as_str())).collect();
+
+    let manifest = DeltaManifest {
+        format: DELTA_FORMAT_VERSION,
+        base_meta_sha256,
+        target_meta_sha256,
+        files,
+        remove,
+        data_size: data.len() as u64,
+        data_sha256: sha256_hex(&data),
+    };
+    Ok((manifest, data))
+}
+
+/// Rebuilds `name` from the installed files and delta.bin. Mirrors what the
+/// mobile clients do, for checking a delta before it ships.
+pub fn apply_file(base_dir: &Path, file: &FileDelta, data: &[u8]) -> Result<Vec<u8>> {
+    let mut out = Vec::with_capacity(file.size as usize);
+    let mut sources: HashMap<&str, Vec<u8>> = HashMap::new();
+    for op in &file.ops {
+        match op {
+            Op::Copy { file: source, offset, len } => {
+                if !sources.contains_key(source.as_str()) {
+                    sources.insert(source, fs::read(base_dir.join(source))?);
+                }
+                let bytes = &sources[source.as_str()];
+                match bytes.get(*offset as usize..(*offset + *len) as usize) {
+                    Some(range) => out.extend_from_slice(range),
+                    None => bail!("copy past the end of {}", source),
+                }
+            }
+            Op::Data { offset, len } => match data.get(*offset as usize..(*offset + *len) as usize) {
+                Some(range) => out.extend_from_slice(range),
+                None => bail!("data range past the end of delta.bin"),
+            },
+        }
+    }
+    if out.len() as u64 != file.size || sha256_hex(&out) != file.sha256 {
+        bail!("{} does not match its checksum after applying", file.name);
+    }
+    Ok(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    // Deterministic filler that does not repeat within a test file
+    fn noise(len: usize, seed: u64) -> Vec<u8> {
+        let mut state = seed;
+        (0..len)
+            .map(|_| {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                state as u8
+            })
+            .collect()
+    }
+
+    #[test]
+    fn test_chunks_cover_input_within_bounds() {
+        let data = noise(2_000_000, 7);
+        let ranges = chunks(&data);
+        assert_eq!(ranges.first().unwrap().start, 0);
+        assert_eq!(ranges.last().unwrap().end, data.len());
+        for pair in ranges.windows(2) {
+            assert_eq!(pair[0].end, pair[1].start);
+        }
+        for range in &ranges[..ranges.len() - 1] {
+            assert!(range.len() >= MIN_CHUNK && range.len() <= MAX_CHUNK);
+        }
+        assert!(chunks(&[]).is_empty());
+    }
+
+    #[test]
+    fn test_chunks_resync_after_insert() {
+        let original = noise(1_500_000, 11);
+        let mut edited = original[..300_000].to_vec();
+        edited.extend_from_slice(b"a newly inserted article");
+        edited.extend_from_slice(&original[300_000..]);
+
+        let before: Vec<&[u8]> = chunks(&original).into_iter().map(|r| &original[r]).collect();
+        let after: Vec<&[u8]> = chunks(&edited).into_iter().map(|r| &edited[r]).collect();
+        let shared = after.iter().filter(|chunk| before.contains(chunk)).count();
+        // Only the chunks around the insertion differ
+        assert!(shared + 3 >= after.len(), "{} of {} chunks shared", shared, after.len());
+    }
+
+    #[test]
+    fn test_build_and_apply_roundtrip() {
+        let root = std::env::temp_dir().join(format!("tantivy-delta-test-{}", std::process::id()));
+        let (base, target) = (root.join("base"), root.join("target"));
+        fs::create_dir_all(&base).unwrap();
+        fs::create_dir_all(&target).unwrap();
+
+        let store = noise(600_000, 3);
+        let mut grown = store.clone();
+        grown.extend_from_slice(&noise(50_000, 5));
+        fs::write(base.join("aaaa.store"), &store).unwrap();
+        fs::write(base.join("meta.json"), b"{\"v\":1}").unwrap();
+        fs::write(target.join("bbbb.store"), &grown).unwrap();
+        fs::write(target.join("meta.json"), b"{\"v\":2}").unwrap();
+        fs::write(target.join(".tantivy-writer.lock"), b"").unwrap();
+
+        let (manifest, data) = build(&base, &target).unwrap();
+        assert_eq!(manifest.remove, vec!["aaaa.store".to_string()]);
+        assert_eq!(manifest.files.last().unwrap().name, "meta.json");
+        assert!(data.len() < grown.len() / 4, "delta carries {} bytes", data.len());
+        for file in &manifest.files {
+            let rebuilt = apply_file(&base, file, &data).unwrap();
+            assert_eq!(rebuilt, fs::read(target.join(&file.name)).unwrap());
+        }
+        fs::remove_dir_all(&root).unwrap();
+    }
+}
@@ -0,0 +1,151 @@
+// deterministic.rs - Byte-stable index builds for delta updates
+//
+// Two builds of the same JSONL must produce identical files, or every content
+// update ships the whole module again. tantivy leaves two things to chance:
+// segment ids are random UUIDs, and a merge concatenates segments in the
+// order it is handed them. A deterministic build therefore indexes with one
+// writer thread and no background merges, commits at fixed document counts
+// so each commit yields exactly one segment, merges in commit order, and
+// finally renames the single segment after a hash of its own contents.
+
+use anyhow::{anyhow, bail, Context, Result};
+use sha2::{Digest, Sha256};
+use std::fs;
+use std::path::Path;
+use tantivy::{IndexWriter, SegmentId};
+
+/// Segment ids in the order their documents were added.
+#[derive(Default)]
+pub struct SegmentOrder {
+    ids: Vec<SegmentId>,
+}
+
+impl SegmentOrder {
+    /// Commits and records the segment the commit produced. Fails if the
+    /// writer flushed more than one, since their relative order is lost.
+    pub fn commit(&mut self, writer: &mut IndexWriter) -> Result<()> {
+        writer.commit()?;
+        let new: Vec<SegmentId> = writer
+            .index()
+            .searchable_segment_metas()?
+            .iter()
+            .map(|meta| meta.id())
+            .filter(|id| !self.ids.contains(id))
+            .collect();
+        if new.len() > 1 {
+            bail!(
+                "{} segments were flushed between two commits; raise --heap-size or lower --commit-every",
+                new.len()
+            );
+        }
+        self.ids.extend(new);
+        Ok(())
+    }
+
+    pub fn ids(&self) -> &[SegmentId] {
+        &self.ids
+    }
+}
+
+/// Renames the index's only segment after the SHA-256 of its files and
+/// rewrites meta.json and .managed.json to match. Returns the new id, or
+/// None for an index without segments (empty or fully filtered input),
+/// which is already stable.
+pub fn canonicalize(index_dir: &Path) -> Result<Option<String>> {
+    let meta_path = index_dir.join("meta.json");
+    let mut meta: serde_json::Value = serde_json::from_slice(&fs::read(&meta_path)?)?;
+    let segments = meta["segments"]
+        .as_array_mut()
+        .ok_or_else(|| anyhow!("meta.json has no segment list"))?;
+    if segments.is_empty() {
+        return Ok(None);
+    }
+    if segments.len() != 1 {
+        bail!("deterministic packaging needs a single segment, found {}", segments.len());
+    }
+    let old_id = segments[0]["segment_id"]
+        .as_str()
+        .ok_or_else(|| anyhow!("meta.json segment has no id"))?
+        .to_string();
+    // Files are named with the id's 32 hex digits, meta.json uses the dashed form
+    let old_prefix = old_id.replace('-', "");
+
+    let mut files: Vec<String> = fs::read_dir(index_dir)?
+        .filter_map(|entry| entry.ok())
+        .filter_map(|entry| entry.file_name().into_string().ok())
+        .filter(|name| name.starts_with(&old_prefix))
+        .collect();
+    files.sort();
+
+    let mut hasher = Sha256::new();
+    for name in &files {
+        let bytes = fs::read(index_dir.join(name)).with_context(|| format!("reading {}", name))?;
+        hasher.update(&name[old_prefix.len()..]);
+        hasher.update((bytes.len() as u64).to_le_bytes());
+        hasher.update(&bytes);
+    }
+    let digest = hasher.finalize();
+    let new_prefix: String = digest[..16].iter().map(|b| format!("{:02x}", b)).collect();
+    let new_id = format!(
+        "{}-{}-{}-{}-{}",
+        &new_prefix[0..8],
+        &new_prefix[8..12],
+        &new_prefix[12..16],
+        &new_prefix[16..20],
+        &new_prefix[20..32]
+    );
+
+    for name in &files {
+        let renamed = format!("{}{}", new_prefix, &name[old_prefix.len()..]);
+        fs::rename(index_dir.join(name), index_dir.join(renamed))?;
+    }
+
+    segments[0]["segment_id"] = serde_json::Value::String(new_id.clone());
+    fs::write(&meta_path, serde_json::to_string_pretty(&meta)? + "\n")?;
+
+    // The files tantivy owns and may garbage collect
+    let managed_path = index_dir.join(".managed.json");
+    if managed_path.exists() {
+        let listed: Vec<String> = serde_json::from_slice(&fs::read(&managed_path)?)?;
+        let mut managed: Vec<String> = listed
+            .into_iter()
+            .filter_map(|name| match name.strip_prefix(&old_prefix) {
+                Some(ext) => Some(format!("{}{}", new_prefix, ext)),
+                // Entries of merged-away segments carry random ids
+                None => index_dir.join(&name).exists().then_some(name),
+            })
+            .collect();
+        managed.sort();
+        managed.dedup();
+        fs::write(&managed_path, serde_json::to_string(&managed)?)?;
+    }
+
+    Ok(Some(new_id))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tantivy::schema::{Schema, TEXT};
+    use tantivy::Index;
+
+    #[test]
+    fn test_canonicalize_without_segments() {
+        let dir = std::env::temp_dir().join(format!("deterministic-empty-{}", std::process::id()));
+        let _ = fs::remove_dir_all(&dir);
+        fs::create_dir_all(&dir).unwrap();
+        let mut builder = Schema::builder();
+        builder.add_text_field("title", TEXT);
+        let index = Index::create_in_dir(&dir, builder.build()).unwrap();
+        let mut writer: IndexWriter = index.writer_with_num_threads(1, 15_000_000).unwrap();
+        let mut order = SegmentOrder::default();
+        order.commit(&mut writer).unwrap();
+        drop(writer);
+        assert!(order.ids().is_empty());
+
+        let meta = fs::read(dir.join("meta.json")).unwrap();
+        assert_eq!(canonicalize(&dir).unwrap(), None);
+        assert_eq!(fs::read(dir.join("meta.json")).unwrap(), meta);
+        let _ = fs::remove_dir_all(&dir);
+    }
+}
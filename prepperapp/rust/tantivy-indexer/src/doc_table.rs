@@ -0,0 +1,103 @@
+// doc_table.rs - Article id to DocAddress side table
+//
+// Opening an article by id with a term query walks the term dictionary and
+// the id's posting list in every segment. The indexer writes this table
+// beside the segments instead, and tantivy-mobile maps it and binary-searches
+// it, so an article open is one lookup and one docstore read. Layout (must
+// match tantivy-mobile's doc_table.rs), little-endian:
+//   [b"PDAT"][u32 version][u32 segment_count][u32 entry_count]
+//   [segment_count x 32-byte segment id, hex as in segment file names]
+//   [entry_count x (u64 id_hash, u32 segment, u32 doc)]
+// Entries are sorted, so ids whose hashes collide sit next to each other and
+// the reader tells them apart by the stored id. `segment` indexes the
+// table's segment list, not the searcher's.
+
+use anyhow::Result;
+use std::fs;
+use std::path::Path;
+use tantivy::schema::{Field, Value};
+use tantivy::{Index, ReloadPolicy, TantivyDocument};
+
+pub const DOC_TABLE_FILE: &str = "doc_addresses.bin";
+pub const DOC_TABLE_MAGIC: &[u8; 4] = b"PDAT";
+pub const DOC_TABLE_VERSION: u32 = 1;
+
+// Blocks cached while walking a segment's docstore in order
+const STORE_CACHE_BLOCKS: usize = 8;
+
+/// FNV-1a of the id's UTF-8 bytes.
+pub fn id_hash(id: &str) -> u64 {
+    id.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, byte| (hash ^ byte as u64).wrapping_mul(0x0100_0000_01b3))
+}
+
+/// Writes the table for the committed segments of `index` to `index_dir`.
+/// Call after the last commit, merge and rename. Returns the entry count.
+pub fn write(index: &Index, index_dir: &Path, id_field: Field) -> Result<usize> {
+    let reader = index.reader_builder().reload_policy(ReloadPolicy::Manual).try_into()?;
+    let searcher = reader.searcher();
+
+    let mut segments = Vec::new();
+    let mut entries: Vec<(u64, u32, u32)> = Vec::new();
+    for (ord, segment) in searcher.segment_readers().iter().enumerate() {
+        segments.push(segment.segment_id().uuid_string());
+        let store = segment.get_store_reader(STORE_CACHE_BLOCKS)?;
+        for doc in segment.doc_ids_alive() {
+            let stored: TantivyDocument = store.get(doc)?;
+            if let Some(id) = stored.get_first(id_field).and_then(|v| v.as_str()) {
+                entries.push((id_hash(id), ord as u32, doc));
+            }
+        }
+    }
+    entries.sort_unstable();
+
+    let bytes = encode(&segments, &entries);
+    // Written beside and renamed in, so a reader never maps half a table
+    let tmp = index_dir.join(format!("{}.tmp", DOC_TABLE_FILE));
+    fs::write(&tmp, bytes)?;
+    fs::rename(&tmp, index_dir.join(DOC_TABLE_FILE))?;
+    Ok(entries.len())
+}
+
+fn encode(segments: &[String], entries: &[(u64, u32, u32)]) -> Vec<u8> {
+    let mut out = Vec::with_capacity(16 + segments.len() * 32 + entries.len() * 16);
+    out.extend_from_slice(DOC_TABLE_MAGIC);
+    out.extend_from_slice(&DOC_TABLE_VERSION.to_le_bytes());
+    out.extend_from_slice(&(segments.len() as u32).to_le_bytes());
+    out.extend_from_slice(&(entries.len() as u32).to_le_bytes());
+    for segment in segments {
+        out.extend_from_slice(segment.as_bytes());
+    }
+    for &(hash, segment, doc) in entries {
+        out.extend_from_slice(&hash.to_le_bytes());
+        out.extend_from_slice(&segment.to_le_bytes());
+        out.extend_from_slice(&doc.to_le_bytes());
+    }
+    out
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_id_hash() {
+        // FNV-1a reference values
+        assert_eq!(id_hash(""), 0xcbf2_9ce4_8422_2325);
+        assert_eq!(id_hash("a"), 0xaf63_dc4c_8601_ec8c);
+        assert_eq!(id_hash("foobar"), 0x8594_4171_f739_67e8);
+    }
+
+    #[test]
+    fn test_encode_layout() {
+        let segment = "0123456789abcdef0123456789abcdef".to_string();
+        let bytes = encode(&[segment.clone()], &[(7, 0, 3)]);
+        assert_eq!(&bytes[..4], DOC_TABLE_MAGIC);
+        assert_eq!(u32::from_le_bytes(bytes[4..8].try_into().unwrap()), DOC_TABLE_VERSION);
+        assert_eq!(u32::from_le_bytes(bytes[8..12].try_into().unwrap()), 1);
+        assert_eq!(u32::from_le_bytes(bytes[12..16].try_into().unwrap()), 1);
+        assert_eq!(&bytes[16..48], segment.as_bytes());
+        assert_eq!(u64::from_le_bytes(bytes[48..56].try_into().unwrap()), 7);
+        assert_eq!(u32::from_le_bytes(bytes[60..64].try_into().unwrap()), 3);
+        assert_eq!(bytes.len(), 64);
+    }
+}
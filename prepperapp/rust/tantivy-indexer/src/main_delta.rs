@@ -0,0 +1,55 @@
+use anyhow::Result;
+use clap::Parser;
+use std::path::PathBuf;
+
+mod delta;
+
+/// Builds a chunk-level delta between two deterministic builds of a module
+/// index (see tantivy-indexer-mobile --deterministic).
+#[derive(Parser, Debug)]
+#[command(author, version, about, long_about = None)]
+struct Args {
+    /// Index directory of the version installed on devices
+    #[arg(short, long)]
+    base: PathBuf,
+
+    /// Index directory of the new version
+    #[arg(short, long)]
+    target: PathBuf,
+
+    /// Output directory for delta.json and delta.bin
+    #[arg(short, long)]
+    output: PathBuf,
+}
+
+fn main() -> Result<()> {
+    let args = Args::parse();
+
+    println!("Building index delta...");
+    println!("Base: {}", args.base.display());
+    println!("Target: {}", args.target.display());
+
+    let start = std::time::Instant::now();
+    let (manifest, data) = delta::build(&args.base, &args.target)?;
+
+    // Replay every file against the base before anything ships
+    for file in &manifest.files {
+        delta::apply_file(&args.base, file, &data)?;
+    }
+
+    std::fs::create_dir_all(&args.output)?;
+    std::fs::write(args.output.join("delta.bin"), &data)?;
+    std::fs::write(args.output.join("delta.json"), serde_json::to_string_pretty(&manifest)?)?;
+
+    let target_bytes: u64 = manifest.files.iter().map(|f| f.size).sum();
+    let copied_bytes = target_bytes - manifest.data_size;
+    println!("\n=== Delta Statistics ===");
+    println!("Changed files: {}", manifest.files.len());
+    println!("Removed files: {}", manifest.remove.len());
+    println!("Changed bytes: {:.2} MB", target_bytes as f64 / (1024.0 * 1024.0));
+    println!("Reused from installed version: {:.2} MB", copied_bytes as f64 / (1024.0 * 1024.0));
+    println!("Download size: {:.2} MB", manifest.data_size as f64 / (1024.0 * 1024.0));
+    println!("Built and verified in {:.2}s", start.elapsed().as_secs_f32());
+
+    Ok(())
+}
@@ -1,13 +1,21 @@
 use anyhow::Result;
-use clap::Parser;
+use clap::{Parser, ValueEnum};
 use serde::{Deserialize, Serialize};
 use std::fs::File;
 use std::io::{BufRead, BufReader};
 use std::path::PathBuf;
 use tantivy::collector::Count;
+use tantivy::indexer::NoMergePolicy;
 use tantivy::query::AllQuery;
 use tantivy::schema::*;
-use tantivy::{doc, Index, IndexWriter, ReloadPolicy};
+use tantivy::store::{Compressor, ZstdCompressor};
+use tantivy::tokenizer::TextAnalyzer;
+use tantivy::{doc, Index, IndexSettings, IndexWriter, ReloadPolicy, TantivyDocument};
+
+mod deterministic;
+mod doc_table;
+mod mobile_pipeline;
+mod snippet;
 
 #[derive(Parser, Debug)]
 #[command(author, version, about, long_about = None)]
@@ -31,6 +39,79 @@ struct Args {
     /// Finalize the index after adding documents (merge to single segment)
     #[arg(short, long)]
     finalize: bool,
+
+    /// Pipelined build: parallel JSON parsing feeding a multi-threaded writer
+    #[arg(short, long)]
+    pipeline: bool,
+
+    /// Lines per batch passed between pipeline stages
+    #[arg(long, default_value = "1000")]
+    batch_size: usize,
+
+    /// Batches buffered between pipeline stages
+    #[arg(long, default_value = "8")]
+    queue_depth: usize,
+
+    /// Byte-identical output for identical input, for delta updates.
+    /// Uses one writer thread and implies --finalize
+    #[arg(short, long)]
+    deterministic: bool,
+
+    /// Documents per commit in a deterministic build. Each commit must fit
+    /// in the writer heap
+    #[arg(long, default_value = "50000")]
+    commit_every: u64,
+
+    /// Docstore compression. lz4 decompresses fastest; zstd makes smaller
+    /// reference modules at more CPU per fetched block
+    #[arg(long, value_enum, default_value = "lz4")]
+    compressor: DocstoreCompressor,
+
+    /// zstd compression level (1-22), with --compressor zstd
+    #[arg(long, default_value = "3")]
+    zstd_level: i32,
+
+    /// Uncompressed bytes per docstore block. Every stored-field fetch
+    /// decompresses a whole block: smaller blocks fetch faster, larger ones
+    /// compress better
+    #[arg(long, default_value = "16384")]
+    docstore_blocksize: usize,
+
+    /// Store each article's text in a `body` field, for modules whose
+    /// articles are opened from the index rather than a ZIM file. Pair with
+    /// --compressor zstd for large modules
+    #[arg(long)]
+    store_body: bool,
+}
+
+#[derive(Clone, Copy, Debug, ValueEnum)]
+enum DocstoreCompressor {
+    None,
+    Lz4,
+    Zstd,
+}
+
+impl Args {
+    fn index_settings(&self) -> Result<IndexSettings> {
+        if self.docstore_blocksize == 0 {
+            anyhow::bail!("--docstore-blocksize must be positive");
+        }
+        let docstore_compression = match self.compressor {
+            DocstoreCompressor::None => Compressor::None,
+            DocstoreCompressor::Lz4 => Compressor::Lz4,
+            DocstoreCompressor::Zstd => {
+                if !(1..=22).contains(&self.zstd_level) {
+                    anyhow::bail!("--zstd-level must be between 1 and 22");
+                }
+                Compressor::Zstd(ZstdCompressor { compression_level: Some(self.zstd_level) })
+            }
+        };
+        Ok(IndexSettings {
+            docstore_compression,
+            docstore_blocksize: self.docstore_blocksize,
+            ..IndexSettings::default()
+        })
+    }
 }
 
 #[derive(Debug, Deserialize, Serialize)]
@@ -41,6 +122,57 @@ struct Article {
     content: String,
     priority: u32,
     keywords: Vec<String>,
+    // Absent in older exports
+    #[serde(default)]
+    category: String,
+}
+
+// Field handles of the mobile schema
+struct MobileFields {
+    id: Field,
+    title: Field,
+    content: Field,
+    priority: Field,
+    module: Field,
+    category: Field,
+    snippet: Field,
+    // Stored, unindexed article text, with --store-body
+    body: Option<Field>,
+}
+
+impl MobileFields {
+    /// `tokenizer` is the content field's, for the snippet's token spans.
+    fn build(&self, article: Article, tokenizer: &mut TextAnalyzer) -> TantivyDocument {
+        let snippet_source = if article.summary.trim().is_empty() { &article.content } else { &article.summary };
+        let snippet = snippet::encode(&snippet::cut(snippet_source), tokenizer);
+
+        // For mobile, combine title and summary into content for searching
+        let mut searchable_content = String::with_capacity(
+            article.title.len() + article.summary.len() + article.content.len() + 2,
+        );
+        searchable_content.push_str(&article.title);
+        searchable_content.push(' ');
+        searchable_content.push_str(&article.summary);
+        searchable_content.push(' ');
+        searchable_content.push_str(&article.content);
+
+        // Create minimal document
+        let mut document = doc!(
+            self.id => article.id,
+            self.title => article.title,
+            self.content => searchable_content,
+            self.priority => article.priority as u64,
+            self.module => "core",
+            self.snippet => snippet
+        );
+        if !article.category.is_empty() {
+            document.add_text(self.category, &article.category);
+        }
+        if let Some(body) = self.body {
+            document.add_text(body, article.content);
+        }
+        document
+    }
 }
 
 fn main() -> Result<()> {
@@ -57,6 +189,12 @@ fn main() -> Result<()> {
     println!("Index: {}", args.index.display());
     println!("Threads: {}", args.threads);
     println!("Heap size: {}MB", args.heap_size);
+    println!("Mode: {}", if args.pipeline { "pipelined" } else { "serial" });
+    if args.deterministic {
+        println!("Deterministic: commit every {} documents", args.commit_every);
+    }
+    let settings = args.index_settings()?;
+    println!("Docstore: {:?}, {} byte blocks", settings.docstore_compression, settings.docstore_blocksize);
 
     // 1. Define MOBILE-OPTIMIZED schema
     let mut schema_builder = Schema::builder();
@@ -87,16 +225,59 @@ fn main() -> Result<()> {
     // Module field - which content module this belongs to
     let module_field = schema_builder.add_text_field("module", STRING | STORED);
     
+    // Category field - an exact-match term, so the app can filter and browse
+    // by category from its postings
+    let category_field = schema_builder.add_text_field("category", STRING | STORED);
+    
+    // Snippet field - a short pre-tokenized excerpt in a fast column, so result
+    // lists are built without reading article text from the docstore
+    let snippet_field = schema_builder.add_bytes_field(snippet::SNIPPET_FIELD, FAST);
+    
+    // Body field - stored ONLY, read back in chunks by the app's document
+    // streams; left out unless asked for, as it dominates the docstore
+    let body_field = args.store_body.then(|| schema_builder.add_text_field("body", STORED));
+    
     let schema = schema_builder.build();
+    let fields = MobileFields {
+        id: id_field,
+        title: title_field,
+        content: content_field,
+        priority: priority_field,
+        module: module_field,
+        category: category_field,
+        snippet: snippet_field,
+        body: body_field,
+    };
 
     // 2. Create the index (always fresh for mobile optimization)
     println!("Creating mobile-optimized index...");
     std::fs::create_dir_all(&args.index)?;
-    let index = Index::create_in_dir(&args.index, schema.clone())?;
+    let index = Index::builder()
+        .schema(schema.clone())
+        .settings(settings)
+        .create_in_dir(&args.index)?;
+    let mut tokenizer = index
+        .tokenizers()
+        .get("default")
+        .ok_or_else(|| anyhow::anyhow!("default tokenizer not registered"))?;
 
     // 3. Create an index writer with smaller heap for mobile
     let heap_size_bytes = args.heap_size * 1_000_000;
-    let mut index_writer: IndexWriter = index.writer_with_num_threads(1, heap_size_bytes)?;
+    let writer_threads = if args.pipeline && !args.deterministic {
+        mobile_pipeline::writer_threads(args.threads, heap_size_bytes)
+    } else {
+        1
+    };
+    println!("Writer threads: {}", writer_threads);
+    let mut index_writer: IndexWriter = index.writer_with_num_threads(writer_threads, heap_size_bytes)?;
+    // Deterministic builds merge once, in commit order, when finalizing
+    let mut segment_order = deterministic::SegmentOrder::default();
+    let commit_every = if args.deterministic {
+        index_writer.set_merge_policy(Box::new(NoMergePolicy));
+        args.commit_every.max(1)
+    } else {
+        0
+    };
 
     // 4. Read the JSONL file and add documents
     let file = File::open(&args.input)?;
@@ -105,49 +286,51 @@ fn main() -> Result<()> {
     let mut doc_count = 0;
     let mut error_count = 0;
 
-    for (line_num, line) in reader.lines().enumerate() {
-        match line {
-            Ok(line_content) => {
-                match serde_json::from_str::<Article>(&line_content) {
-                    Ok(article) => {
-                        // For mobile, combine title and summary into content for searching
-                        let searchable_content = format!(
-                            "{} {} {}", 
-                            article.title, 
-                            article.summary, 
-                            article.content
-                        );
-                        
-                        // Create minimal document
-                        let doc = doc!(
-                            id_field => article.id.clone(),
-                            title_field => article.title,
-                            content_field => searchable_content,
-                            priority_field => article.priority as u64,
-                            module_field => "core"
-                        );
-
-                        // Add the document
-                        index_writer.add_document(doc)?;
-                        doc_count += 1;
-
-                        if doc_count % 100 == 0 {
-                            print!("Processed {} documents...", doc_count);
-                            // Flush to ensure progress is visible
-                            use std::io::Write;
-                            std::io::stdout().flush()?;
-                            print!("\r"); // Return to start of line for next update
+    if args.pipeline {
+        let report = mobile_pipeline::run(
+            reader,
+            &fields,
+            &tokenizer,
+            &mut index_writer,
+            args.batch_size,
+            args.queue_depth,
+            commit_every,
+            |writer| segment_order.commit(writer),
+        )?;
+        doc_count = report.index.items;
+        error_count = report.errors;
+        report.print();
+    } else {
+        for (line_num, line) in reader.lines().enumerate() {
+            match line {
+                Ok(line_content) => {
+                    match serde_json::from_str::<Article>(&line_content) {
+                        Ok(article) => {
+                            // Add the document
+                            index_writer.add_document(fields.build(article, &mut tokenizer))?;
+                            doc_count += 1;
+                            if commit_every > 0 && doc_count % commit_every == 0 {
+                                segment_order.commit(&mut index_writer)?;
+                            }
+
+                            if doc_count % 100 == 0 {
+                                print!("Processed {} documents...", doc_count);
+                                // Flush to ensure progress is visible
+                                use std::io::Write;
+                                std::io::stdout().flush()?;
+                                print!("\r"); // Return to start of line for next update
+                            }
+                        }
+                        Err(e) => {
+                            eprintln!("Error parsing JSON on line {}: {}", line_num + 1, e);
+                            error_count += 1;
                         }
-                    }
-                    Err(e) => {
-                        eprintln!("Error parsing JSON on line {}: {}", line_num + 1, e);
-                        error_count += 1;
                     }
                 }
-            }
-            Err(e) => {
-                eprintln!("Error reading line {}: {}", line_num + 1, e);
-                error_count += 1;
+                Err(e) => {
+                    eprintln!("Error reading line {}: {}", line_num + 1, e);
+                    error_count += 1;
+                }
             }
         }
     }
@@ -158,16 +341,24 @@ fn main() -> Result<()> {
     // 5. Commit the documents
     println!("Committing to index (this may take a moment)...");
     let start = std::time::Instant::now();
-    index_writer.commit()?;
+    if args.deterministic {
+        segment_order.commit(&mut index_writer)?;
+    } else {
+        index_writer.commit()?;
+    }
     println!("Commit completed in {:.2}s", start.elapsed().as_secs_f32());
+    // Releases the directory lock for the merge writer
+    drop(index_writer);
 
     // 6. Finalize the index if requested
-    if args.finalize {
+    if args.finalize || args.deterministic {
         println!("\nFinalizing index: merging segments...");
         let start = std::time::Instant::now();
         
         // Force merge to a single segment for optimal mobile performance
-        let segment_ids: Vec<_> = {
+        let segment_ids: Vec<_> = if args.deterministic {
+            segment_order.ids().to_vec()
+        } else {
             let index_reader = index.reader()?;
             let searcher = index_reader.searcher();
             searcher.segment_readers()
@@ -181,6 +372,7 @@ fn main() -> Result<()> {
         if segment_ids.len() > 1 {
             // Create a new writer for merging
             let mut merge_writer: IndexWriter = index.writer_with_num_threads(1, heap_size_bytes)?;
+            merge_writer.set_merge_policy(Box::new(NoMergePolicy));
             
             // Merge all segments
             let merge_future = merge_writer.merge(&segment_ids);
@@ -196,11 +388,22 @@ fn main() -> Result<()> {
         } else {
             println!("✓ Index already has single segment.");
         }
+
+        if args.deterministic {
+            match deterministic::canonicalize(&args.index)? {
+                Some(segment_id) => println!("✓ Segment renamed by content: {}", segment_id),
+                None => println!("✓ Index has no segments, nothing to rename."),
+            }
+        }
         
         println!("Finalization completed in {:.2}s", start.elapsed().as_secs_f32());
     }
 
-    // 7. Report final statistics
+    // 7. Write the id table, after the segments have their final names
+    let table_entries = doc_table::write(&index, &args.index, id_field)?;
+    println!("✓ Id table: {} entries in {}", table_entries, doc_table::DOC_TABLE_FILE);
+
+    // 8. Report final statistics
     let index_reader = index.reader_builder()
         .reload_policy(ReloadPolicy::Manual)
         .try_into()?;
@@ -229,7 +432,11 @@ fn main() -> Result<()> {
     println!("\nMobile optimizations applied:");
     println!("- Basic index options (no positions/frequencies)");
     println!("- No indexed title field (search via content)");
-    println!("- No stored summary field");
+    println!("- No stored summary field (snippets in a fast column)");
+    println!("- Id to document address table for article opens");
+    if args.store_body {
+        println!("- Article bodies stored for streaming");
+    }
     println!("- Single segment (if finalized)");
 
     println!("\nIndexing completed successfully!");
@@ -0,0 +1,231 @@
+// mobile_pipeline.rs - Pipelined JSONL -> index build for tantivy-indexer-mobile
+//
+// Three stages joined by bounded channels, so no stage can run ahead and
+// buffer the whole corpus in memory:
+//   read  - one thread reads lines into batches
+//   parse - each batch is parsed into documents in parallel on the rayon pool
+//   index - documents are handed to a multi-threaded IndexWriter
+// Batches stay in input order, so with a single writer thread the index is
+// the same as a serial build's. Each stage times only its own work (not the
+// time spent waiting on its neighbours), so the report shows which stage
+// bounds the build.
+
+use crate::{Article, MobileFields};
+use anyhow::{anyhow, Result};
+use rayon::prelude::*;
+use std::io::{BufRead, Write};
+use std::sync::mpsc::sync_channel;
+use std::time::{Duration, Instant};
+use tantivy::tokenizer::TextAnalyzer;
+use tantivy::{IndexWriter, TantivyDocument};
+
+// tantivy rejects writers with less heap than this per indexing thread
+const MIN_HEAP_PER_THREAD: usize = 15_000_000;
+// The thread cap tantivy itself applies in Index::writer
+const MAX_WRITER_THREADS: usize = 8;
+
+/// Indexing threads to request for `heap_bytes` of writer heap.
+pub fn writer_threads(requested: usize, heap_bytes: usize) -> usize {
+    requested
+        .min(MAX_WRITER_THREADS)
+        .min(heap_bytes / MIN_HEAP_PER_THREAD)
+        .max(1)
+}
+
+#[derive(Default)]
+pub struct StageStats {
+    pub items: u64,
+    pub bytes: u64,
+    pub busy: Duration,
+}
+
+impl StageStats {
+    fn print(&self, stage: &str, unit: &str) {
+        let secs = self.busy.as_secs_f64().max(1e-9);
+        println!(
+            "  {:<6} {:>9} {:<5} {:>8.2}s busy {:>10.0} {}/s {:>8.1} MB/s",
+            stage,
+            self.items,
+            unit,
+            self.busy.as_secs_f64(),
+            self.items as f64 / secs,
+            unit,
+            self.bytes as f64 / secs / 1_000_000.0
+        );
+    }
+}
+
+pub struct PipelineReport {
+    pub read: StageStats,
+    pub parse: StageStats,
+    pub index: StageStats,
+    pub errors: usize,
+    pub wall: Duration,
+}
+
+impl PipelineReport {
+    pub fn print(&self) {
+        println!("\n=== Pipeline Throughput ===");
+        self.read.print("read", "lines");
+        self.parse.print("parse", "docs");
+        self.index.print("index", "docs");
+        let wall = self.wall.as_secs_f64().max(1e-9);
+        println!(
+            "  wall   {:>8.2}s {:>10.0} docs/s end to end",
+            self.wall.as_secs_f64(),
+            self.index.items as f64 / wall
+        );
+    }
+}
+
+struct LineBatch {
+    first_line: usize,
+    lines: Vec<String>,
+}
+
+struct DocBatch {
+    docs: Vec<TantivyDocument>,
+    json_bytes: u64,
+}
+
+/// Reads JSONL from `input` and adds every article to `writer`. When
+/// `commit_every` is non-zero, `commit` runs after each multiple of that many
+/// documents; the final commit is left to the caller. Unparseable lines are
+/// reported and counted, as in the serial builder; a read, indexing or
+/// commit error stops the pipeline.
+pub fn run(
+    input: impl BufRead + Send,
+    fields: &MobileFields,
+    tokenizer: &TextAnalyzer,
+    writer: &mut IndexWriter,
+    batch_size: usize,
+    queue_depth: usize,
+    commit_every: u64,
+    mut commit: impl FnMut(&mut IndexWriter) -> Result<()>,
+) -> Result<PipelineReport> {
+    let batch_size = batch_size.max(1);
+    let start = Instant::now();
+    let (line_tx, line_rx) = sync_channel::<LineBatch>(queue_depth);
+    let (doc_tx, doc_rx) = sync_channel::<DocBatch>(queue_depth);
+
+    std::thread::scope(|scope| {
+        let reader = scope.spawn(move || -> std::io::Result<StageStats> {
+            let mut stats = StageStats::default();
+            let mut batch = LineBatch { first_line: 1, lines: Vec::with_capacity(batch_size) };
+            let mut busy_since = Instant::now();
+            for line in input.lines() {
+                let line = line?;
+                stats.items += 1;
+                stats.bytes += line.len() as u64 + 1;
+                batch.lines.push(line);
+                if batch.lines.len() == batch_size {
+                    stats.busy += busy_since.elapsed();
+                    let next_line = batch.first_line + batch.lines.len();
+                    let full = std::mem::replace(
+                        &mut batch,
+                        LineBatch { first_line: next_line, lines: Vec::with_capacity(batch_size) },
+                    );
+                    if line_tx.send(full).is_err() {
+                        return Ok(stats); // Indexing stopped
+                    }
+                    busy_since = Instant::now();
+                }
+            }
+            stats.busy += busy_since.elapsed();
+            if !batch.lines.is_empty() {
+                let _ = line_tx.send(batch);
+            }
+            Ok(stats)
+        });
+
+        let parser = scope.spawn(move || {
+            let mut stats = StageStats::default();
+            let mut errors = 0;
+            for batch in line_rx {
+                let busy_since = Instant::now();
+                let json_bytes: u64 = batch.lines.iter().map(|l| l.len() as u64 + 1).sum();
+                let parsed: Vec<Result<TantivyDocument, String>> = batch
+                    .lines
+                    .par_iter()
+                    .enumerate()
+                    // One tokenizer per rayon job, for the snippet token spans
+                    .map_init(
+                        || tokenizer.clone(),
+                        |tokenizer, (i, line)| {
+                            serde_json::from_str::<Article>(line)
+                                .map(|article| fields.build(article, tokenizer))
+                                .map_err(|e| format!("Error parsing JSON on line {}: {}", batch.first_line + i, e))
+                        },
+                    )
+                    .collect();
+
+                let mut docs = Vec::with_capacity(parsed.len());
+                for result in parsed {
+                    match result {
+                        Ok(doc) => docs.push(doc),
+                        Err(message) => {
+                            eprintln!("{}", message);
+                            errors += 1;
+                        }
+                    }
+                }
+                stats.items += docs.len() as u64;
+                stats.bytes += json_bytes;
+                stats.busy += busy_since.elapsed();
+                if doc_tx.send(DocBatch { docs, json_bytes }).is_err() {
+                    break; // Indexing stopped
+                }
+            }
+            (stats, errors)
+        });
+
+        // Index on this thread; add_document blocks while the writer's
+        // own threads are saturated, which is the backpressure we want
+        let mut index = StageStats::default();
+        let mut failure: Option<anyhow::Error> = None;
+        for batch in doc_rx {
+            let busy_since = Instant::now();
+            for doc in batch.docs {
+                if let Err(e) = writer.add_document(doc) {
+                    failure = Some(e.into());
+                    break;
+                }
+                index.items += 1;
+                if commit_every > 0 && index.items % commit_every == 0 {
+                    if let Err(e) = commit(writer) {
+                        failure = Some(e);
+                        break;
+                    }
+                }
+            }
+            index.bytes += batch.json_bytes;
+            index.busy += busy_since.elapsed();
+            if failure.is_some() {
+                break; // Dropping the receiver stops the upstream stages
+            }
+
+            print!("\rIndexed {} documents...", index.items);
+            let _ = std::io::stdout().flush();
+        }
+
+        let read = reader.join().map_err(|_| anyhow!("reader thread panicked"))??;
+        let (parse, errors) = parser.join().map_err(|_| anyhow!("parser thread panicked"))?;
+        if let Some(e) = failure {
+            return Err(e);
+        }
+        Ok(PipelineReport { read, parse, index, errors, wall: start.elapsed() })
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_writer_threads() {
+        assert_eq!(writer_threads(32, 100_000_000), 6);
+        assert_eq!(writer_threads(32, 1_000_000_000), MAX_WRITER_THREADS);
+        assert_eq!(writer_threads(0, 100_000_000), 1);
+        assert_eq!(writer_threads(4, 1_000_000), 1);
+    }
+}
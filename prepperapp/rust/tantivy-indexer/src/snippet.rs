@@ -0,0 +1,92 @@
+// snippet.rs - Compact pre-tokenized result snippets
+//
+// Result lists show a line or two under each title. Rather than storing the
+// article text and truncating it at query time, the indexer cuts a short
+// snippet once and writes it to a fast bytes column, which search reads
+// without decompressing any docstore block. Each value is (must match
+// tantivy-mobile's snippet.rs):
+//   [u8 version][u16 text_len][text][u16 token_count][token_count x (u16 start, u16 end)]
+// little-endian, with the byte span of every token the index's default
+// tokenizer finds in the text, so query terms can be highlighted natively
+// without re-tokenizing.
+
+use tantivy::tokenizer::TextAnalyzer;
+
+pub const SNIPPET_FIELD: &str = "snippet";
+pub const SNIPPET_FORMAT_VERSION: u8 = 1;
+// Two lines on a phone; the cut backs up to a word boundary
+pub const SNIPPET_MAX_BYTES: usize = 200;
+
+/// The leading text of `source`, cut at a word boundary within
+/// SNIPPET_MAX_BYTES, with an ellipsis when anything was dropped.
+pub fn cut(source: &str) -> String {
+    let source = source.trim();
+    if source.len() <= SNIPPET_MAX_BYTES {
+        return source.split_whitespace().collect::<Vec<_>>().join(" ");
+    }
+    let mut end = SNIPPET_MAX_BYTES;
+    while !source.is_char_boundary(end) {
+        end -= 1;
+    }
+    if let Some(space) = source[..end].rfind(char::is_whitespace) {
+        if space > SNIPPET_MAX_BYTES / 2 {
+            end = space;
+        }
+    }
+    let mut snippet = source[..end].split_whitespace().collect::<Vec<_>>().join(" ");
+    snippet.push('…');
+    snippet
+}
+
+/// Encodes `text` with the token spans `tokenizer` finds in it.
+pub fn encode(text: &str, tokenizer: &mut TextAnalyzer) -> Vec<u8> {
+    // Offsets are u16; cut() keeps text far below that
+    let text = &text[..text.len().min(u16::MAX as usize)];
+    let mut spans = Vec::new();
+    let mut stream = tokenizer.token_stream(text);
+    stream.process(&mut |token| {
+        if token.offset_to <= text.len() {
+            spans.push((token.offset_from as u16, token.offset_to as u16));
+        }
+    });
+
+    let mut out = Vec::with_capacity(5 + text.len() + spans.len() * 4);
+    out.push(SNIPPET_FORMAT_VERSION);
+    out.extend_from_slice(&(text.len() as u16).to_le_bytes());
+    out.extend_from_slice(text.as_bytes());
+    out.extend_from_slice(&(spans.len() as u16).to_le_bytes());
+    for (start, end) in spans {
+        out.extend_from_slice(&start.to_le_bytes());
+        out.extend_from_slice(&end.to_le_bytes());
+    }
+    out
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tantivy::tokenizer::{LowerCaser, SimpleTokenizer};
+
+    #[test]
+    fn test_cut() {
+        assert_eq!(cut("  Apply   pressure. "), "Apply pressure.");
+        let long = "word ".repeat(100);
+        let snippet = cut(&long);
+        assert!(snippet.len() <= SNIPPET_MAX_BYTES + '…'.len_utf8());
+        assert!(snippet.ends_with("word…"));
+        // Never splits a multi-byte character
+        assert!(cut(&"é".repeat(150)).ends_with('…'));
+    }
+
+    #[test]
+    fn test_encode_layout() {
+        let mut tokenizer = TextAnalyzer::builder(SimpleTokenizer::default()).filter(LowerCaser).build();
+        let bytes = encode("Stop bleeding", &mut tokenizer);
+        assert_eq!(bytes[0], SNIPPET_FORMAT_VERSION);
+        assert_eq!(u16::from_le_bytes([bytes[1], bytes[2]]), 13);
+        assert_eq!(&bytes[3..16], b"Stop bleeding");
+        assert_eq!(u16::from_le_bytes([bytes[16], bytes[17]]), 2);
+        // Second token spans 5..13
+        assert_eq!(&bytes[22..26], &[5, 0, 13, 0]);
+    }
+}
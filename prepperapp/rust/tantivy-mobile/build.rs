@@ -1,27 +1,26 @@
 use std::env;
 use std::path::PathBuf;
 
+// Generates tantivy_mobile.h into OUT_DIR, never into the source tree, so a
+// build can be diffed against the checked-in header without rewriting it.
+// scripts/generate-header.sh regenerates the checked-in copy.
 fn main() {
-    let crate_dir = env::var("CARGO_MANIFEST_DIR").unwrap();
-    let output_file = target_dir()
-        .join("tantivy_mobile.h")
-        .display()
-        .to_string();
+    let crate_dir = PathBuf::from(env::var("CARGO_MANIFEST_DIR").unwrap());
+    let out_file = PathBuf::from(env::var("OUT_DIR").unwrap()).join("tantivy_mobile.h");
 
-    cbindgen::Builder::new()
-        .with_crate(crate_dir)
-        .with_language(cbindgen::Language::C)
-        .generate()
-        .expect("Unable to generate bindings")
-        .write_to_file(&output_file);
+    // A header problem must not fail the library build
+    let generated = cbindgen::Config::from_file(crate_dir.join("cbindgen.toml"))
+        .map_err(|e| e.to_string())
+        .and_then(|config| {
+            cbindgen::Builder::new().with_crate(&crate_dir).with_config(config).generate().map_err(|e| e.to_string())
+        });
+    match generated {
+        Ok(bindings) => {
+            bindings.write_to_file(&out_file);
+        }
+        Err(e) => println!("cargo:warning=tantivy_mobile.h not generated: {}", e),
+    }
 
-    println!("cargo:rerun-if-changed=src/lib.rs");
+    println!("cargo:rerun-if-changed=src");
+    println!("cargo:rerun-if-changed=cbindgen.toml");
 }
-
-fn target_dir() -> PathBuf {
-    if let Ok(target) = env::var("CARGO_TARGET_DIR") {
-        PathBuf::from(target)
-    } else {
-        PathBuf::from(env::var("CARGO_MANIFEST_DIR").unwrap()).join("target")
-    }
-}
\ No newline at end of file
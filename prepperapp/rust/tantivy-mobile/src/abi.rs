@@ -0,0 +1,35 @@
+// abi.rs - Version and error codes of the C ABI
+//
+// tantivy_mobile.h is generated from this crate by cbindgen
+// (scripts/generate-header.sh, cbindgen.toml) and is the only C surface:
+// the JNI bridge, the Swift bridging header and the native benchmark all
+// compile against it. Bump TANTIVY_ABI_VERSION whenever an exported
+// signature or #[repr(C)] layout changes incompatibly; bridges compare it
+// with tantivy_abi_version() when the library loads, so a stale library is
+// refused instead of misread.
+
+pub const TANTIVY_ABI_VERSION: u32 = 2;
+
+// Error codes returned by the i32 entry points
+pub const TANTIVY_SUCCESS: i32 = 0;
+pub const TANTIVY_ERROR_INVALID_PARAM: i32 = -1;
+pub const TANTIVY_ERROR_INDEX_CREATION: i32 = -2;
+pub const TANTIVY_ERROR_SEARCH_FAILED: i32 = -3;
+pub const TANTIVY_ERROR_INDEXING_FAILED: i32 = -4;
+pub const TANTIVY_ERROR_CANCELLED: i32 = -5;
+
+/// TANTIVY_ABI_VERSION of the loaded library.
+#[no_mangle]
+pub extern "C" fn tantivy_abi_version() -> u32 {
+    TANTIVY_ABI_VERSION
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_abi_version() {
+        assert_eq!(tantivy_abi_version(), TANTIVY_ABI_VERSION);
+    }
+}
@@ -0,0 +1,392 @@
+// async_search.rs - Cancellable searches on dedicated native threads
+//
+// Type-ahead starts a search per keystroke, and a blocking call ties up a
+// caller thread until tantivy returns even when the query was superseded
+// long ago. Async searches are queued to a small pool of long-lived native
+// threads instead and report through a C callback. Cancelling one sets a
+// flag the collector checks for every document its scorer visits (see
+// priority.rs), so a stale query stops at the next one and the next
+// keystroke gets the CPU. The threads live as long as their manager, so a
+// JNI bridge attaches each to the VM only once.
+//
+// A tiered search reports more than once: each batch it emits while
+// running goes to its callback as it is ready, followed by the final
+// result, so the core modules can answer before the large ones finish.
+
+use std::collections::{HashMap, VecDeque};
+use std::ffi::c_void;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+
+use crate::abi::TANTIVY_ERROR_CANCELLED;
+use crate::thread_pool::ThreadHints;
+
+/// Completion callback: `status` is the number of packed rows, or a negative
+/// error code with no buffer. `packed` is only valid during the call.
+pub type MultiSearchCallback =
+    extern "C" fn(request_id: u64, status: i32, packed: *const u8, packed_len: usize, user_data: *mut c_void);
+
+/// Tiered search callback: runs once per batch with `is_final` 0, then
+/// exactly once with `is_final` 1. `status` and `packed` are as for
+/// MultiSearchCallback.
+pub type TieredSearchCallback = extern "C" fn(
+    request_id: u64,
+    status: i32,
+    packed: *const u8,
+    packed_len: usize,
+    is_final: i32,
+    user_data: *mut c_void,
+);
+
+// Hands a batch (status, packed buffer) to the callback before the final one
+pub(crate) type EmitBatch<'a> = &'a dyn Fn(i32, &[u8]);
+
+// Returns the status and packed buffer; checks the flag to stop early
+type SearchJob = Box<dyn FnOnce(&Arc<AtomicBool>, EmitBatch) -> (i32, Vec<u8>) + Send>;
+
+#[derive(Clone, Copy)]
+enum Callback {
+    Once(MultiSearchCallback),
+    Tiered(TieredSearchCallback),
+}
+
+// The caller's context, handed back untouched on the search thread
+struct UserData(*mut c_void);
+
+unsafe impl Send for UserData {}
+
+struct Request {
+    id: u64,
+    cancelled: Arc<AtomicBool>,
+    search: SearchJob,
+    callback: Callback,
+    user_data: UserData,
+}
+
+#[derive(Default)]
+struct Queue {
+    requests: VecDeque<Request>,
+    shutdown: bool,
+}
+
+#[derive(Default)]
+struct Shared {
+    queue: Mutex<Queue>,
+    ready: Condvar,
+    // Requests whose callback has not started, by id
+    pending: Mutex<HashMap<u64, Arc<AtomicBool>>>,
+    next_id: AtomicU64,
+}
+
+impl Shared {
+    fn worker(&self) {
+        loop {
+            let request = {
+                let mut queue = match self.queue.lock() {
+                    Ok(q) => q,
+                    Err(_) => return,
+                };
+                loop {
+                    // Drains what is queued even when shutting down, so every
+                    // request gets its callback
+                    if let Some(request) = queue.requests.pop_front() {
+                        break request;
+                    }
+                    if queue.shutdown {
+                        return;
+                    }
+                    queue = match self.ready.wait(queue) {
+                        Ok(q) => q,
+                        Err(_) => return,
+                    };
+                }
+            };
+            self.run(request);
+        }
+    }
+
+    fn run(&self, request: Request) {
+        let (id, callback, user_data) = (request.id, request.callback, request.user_data.0);
+        let cancelled = &request.cancelled;
+        // Batches of a cancelled search are dropped, but the flag is read
+        // without the pending lock, so one already being delivered can still
+        // arrive after cancel() returns. Holding the lock across the callback
+        // would block cancels and deadlock one made from inside a callback.
+        // Only the final call is guaranteed to report the cancel.
+        let emit = |status: i32, packed: &[u8]| {
+            if let Callback::Tiered(callback) = callback {
+                if !cancelled.load(Ordering::Relaxed) {
+                    let data = if packed.is_empty() { std::ptr::null() } else { packed.as_ptr() };
+                    callback(id, status, data, packed.len(), 0, user_data);
+                }
+            }
+        };
+        let (mut status, mut packed) = if cancelled.load(Ordering::Relaxed) {
+            (TANTIVY_ERROR_CANCELLED, Vec::new())
+        } else {
+            (request.search)(cancelled, &emit)
+        };
+
+        // Under the lock cancel() takes, so a cancel that returned 0 always
+        // sees its callback report TANTIVY_ERROR_CANCELLED
+        if let Ok(mut pending) = self.pending.lock() {
+            pending.remove(&request.id);
+            if request.cancelled.load(Ordering::Relaxed) {
+                status = TANTIVY_ERROR_CANCELLED;
+            }
+        }
+        if status < 0 {
+            packed.clear();
+        }
+
+        let data = if packed.is_empty() { std::ptr::null() } else { packed.as_ptr() };
+        match callback {
+            Callback::Once(callback) => callback(id, status, data, packed.len(), user_data),
+            Callback::Tiered(callback) => callback(id, status, data, packed.len(), 1, user_data),
+        }
+    }
+}
+
+/// Queue and threads for one manager's async searches. The searches
+/// themselves still fan out over the manager's search pool.
+pub(crate) struct AsyncSearches {
+    shared: Arc<Shared>,
+    threads: usize,
+    hints: ThreadHints,
+    // Started on the first search
+    workers: Mutex<Vec<JoinHandle<()>>>,
+}
+
+impl AsyncSearches {
+    pub fn new(threads: usize, hints: ThreadHints) -> Self {
+        AsyncSearches { shared: Arc::default(), threads: threads.max(1), hints, workers: Mutex::new(Vec::new()) }
+    }
+
+    /// Queues `search`, returning its request id, or 0 if the search threads
+    /// could not be started. `callback` runs exactly once for every id
+    /// returned, on a search thread.
+    pub fn submit<F>(&self, search: F, callback: MultiSearchCallback, user_data: *mut c_void) -> u64
+    where
+        F: FnOnce(&Arc<AtomicBool>) -> (i32, Vec<u8>) + Send + 'static,
+    {
+        let search = move |cancelled: &Arc<AtomicBool>, _: EmitBatch| search(cancelled);
+        self.queue(Box::new(search), Callback::Once(callback), user_data)
+    }
+
+    /// Like `submit`, but `search` may also emit batches, each delivered to
+    /// `callback` before the final result.
+    pub fn submit_tiered<F>(&self, search: F, callback: TieredSearchCallback, user_data: *mut c_void) -> u64
+    where
+        F: FnOnce(&Arc<AtomicBool>, EmitBatch) -> (i32, Vec<u8>) + Send + 'static,
+    {
+        self.queue(Box::new(search), Callback::Tiered(callback), user_data)
+    }
+
+    fn queue(&self, search: SearchJob, callback: Callback, user_data: *mut c_void) -> u64 {
+        if !self.start_workers() {
+            return 0;
+        }
+
+        // Ids start at 1; 0 reports failure
+        let id = self.shared.next_id.fetch_add(1, Ordering::Relaxed) + 1;
+        let cancelled = Arc::new(AtomicBool::new(false));
+        match self.shared.pending.lock() {
+            Ok(mut pending) => pending.insert(id, cancelled.clone()),
+            Err(_) => return 0,
+        };
+
+        let request = Request { id, cancelled, search, callback, user_data: UserData(user_data) };
+        match self.shared.queue.lock() {
+            Ok(mut queue) => queue.requests.push_back(request),
+            Err(_) => return 0,
+        }
+        self.shared.ready.notify_one();
+        id
+    }
+
+    /// Flags a request as cancelled. It stops at its next check and its
+    /// callback reports TANTIVY_ERROR_CANCELLED. False if the callback has
+    /// already started or the id is unknown.
+    pub fn cancel(&self, id: u64) -> bool {
+        match self.shared.pending.lock() {
+            Ok(pending) => pending.get(&id).map_or(false, |flag| {
+                flag.store(true, Ordering::Relaxed);
+                true
+            }),
+            Err(_) => false,
+        }
+    }
+
+    fn start_workers(&self) -> bool {
+        let mut workers = match self.workers.lock() {
+            Ok(w) => w,
+            Err(_) => return false,
+        };
+        while workers.len() < self.threads {
+            let shared = self.shared.clone();
+            let hints = self.hints;
+            let spawned = std::thread::Builder::new()
+                .name(format!("tantivy-async-{}", workers.len()))
+                .spawn(move || {
+                    hints.apply();
+                    shared.worker()
+                });
+            match spawned {
+                Ok(handle) => workers.push(handle),
+                // One thread is enough to make progress
+                Err(_) => return !workers.is_empty(),
+            }
+        }
+        true
+    }
+}
+
+impl Drop for AsyncSearches {
+    /// Cancels everything queued or running and waits for the callbacks.
+    /// Must not run on a search thread, i.e. from inside a callback.
+    fn drop(&mut self) {
+        if let Ok(pending) = self.shared.pending.lock() {
+            pending.values().for_each(|flag| flag.store(true, Ordering::Relaxed));
+        }
+        if let Ok(mut queue) = self.shared.queue.lock() {
+            queue.shutdown = true;
+        }
+        self.shared.ready.notify_all();
+        if let Ok(workers) = self.workers.get_mut() {
+            for worker in workers.drain(..) {
+                let _ = worker.join();
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::mpsc;
+
+    // The callbacks' user_data: (id, status, bytes) per completion
+    type Deliveries = Mutex<mpsc::Sender<(u64, i32, Vec<u8>)>>;
+
+    extern "C" fn record(id: u64, status: i32, packed: *const u8, len: usize, user_data: *mut c_void) {
+        let sender = unsafe { &*(user_data as *const Deliveries) };
+        let bytes = if packed.is_null() { Vec::new() } else { unsafe { std::slice::from_raw_parts(packed, len) }.to_vec() };
+        let _ = sender.lock().unwrap().send((id, status, bytes));
+    }
+
+    #[test]
+    fn test_completes_and_cancels() {
+        let (tx, rx) = mpsc::channel();
+        let sender: *mut Deliveries = Box::into_raw(Box::new(Mutex::new(tx)));
+        let searches = AsyncSearches::new(2, ThreadHints::default());
+
+        let done = searches.submit(|_| (1, vec![7, 8]), record, sender as *mut c_void);
+        assert_eq!(rx.recv().unwrap(), (done, 1, vec![7, 8]));
+        assert!(!searches.cancel(done)); // Already delivered
+
+        // Spins until cancelled, like a collector checking its flag
+        let (started_tx, started_rx) = mpsc::channel();
+        let slow = searches.submit(
+            move |cancelled| {
+                started_tx.send(()).unwrap();
+                while !cancelled.load(Ordering::Relaxed) {
+                    std::thread::yield_now();
+                }
+                (3, vec![1])
+            },
+            record,
+            sender as *mut c_void,
+        );
+        started_rx.recv().unwrap();
+        assert!(searches.cancel(slow));
+        assert_eq!(rx.recv().unwrap(), (slow, TANTIVY_ERROR_CANCELLED, vec![]));
+        assert!(!searches.cancel(0));
+
+        drop(searches);
+        drop(unsafe { Box::from_raw(sender) });
+    }
+
+    // (id, status, rows, is_final) per call
+    type Batches = Mutex<mpsc::Sender<(u64, i32, Vec<u8>, i32)>>;
+
+    extern "C" fn record_batch(id: u64, status: i32, packed: *const u8, len: usize, is_final: i32, user_data: *mut c_void) {
+        let sender = unsafe { &*(user_data as *const Batches) };
+        let bytes = if packed.is_null() { Vec::new() } else { unsafe { std::slice::from_raw_parts(packed, len) }.to_vec() };
+        let _ = sender.lock().unwrap().send((id, status, bytes, is_final));
+    }
+
+    #[test]
+    fn test_tiered_batches_then_final() {
+        let (tx, rx) = mpsc::channel();
+        let sender: *mut Batches = Box::into_raw(Box::new(Mutex::new(tx)));
+        let searches = AsyncSearches::new(1, ThreadHints::default());
+
+        let id = searches.submit_tiered(
+            |_, emit| {
+                emit(1, &[1]);
+                emit(2, &[1, 2]);
+                (3, vec![1, 2, 3])
+            },
+            record_batch,
+            sender as *mut c_void,
+        );
+        assert_eq!(rx.recv().unwrap(), (id, 1, vec![1], 0));
+        assert_eq!(rx.recv().unwrap(), (id, 2, vec![1, 2], 0));
+        assert_eq!(rx.recv().unwrap(), (id, 3, vec![1, 2, 3], 1));
+
+        // Cancelled between batches: later batches are dropped and the final
+        // call reports the cancel
+        let (started_tx, started_rx) = mpsc::channel();
+        let (resume_tx, resume_rx) = mpsc::channel::<()>();
+        let cancelled = searches.submit_tiered(
+            move |_, emit| {
+                emit(1, &[1]);
+                started_tx.send(()).unwrap();
+                let _ = resume_rx.recv();
+                emit(2, &[1, 2]);
+                (2, vec![1, 2])
+            },
+            record_batch,
+            sender as *mut c_void,
+        );
+        started_rx.recv().unwrap();
+        assert!(searches.cancel(cancelled));
+        resume_tx.send(()).unwrap();
+        assert_eq!(rx.recv().unwrap(), (cancelled, 1, vec![1], 0));
+        assert_eq!(rx.recv().unwrap(), (cancelled, TANTIVY_ERROR_CANCELLED, vec![], 1));
+
+        drop(searches);
+        drop(unsafe { Box::from_raw(sender) });
+    }
+
+    #[test]
+    fn test_drop_delivers_every_callback() {
+        let (tx, rx) = mpsc::channel();
+        let sender: *mut Deliveries = Box::into_raw(Box::new(Mutex::new(tx)));
+        let searches = AsyncSearches::new(2, ThreadHints::default());
+        let ids: Vec<u64> = (0..8)
+            .map(|_| {
+                searches.submit(
+                    |cancelled| {
+                        while !cancelled.load(Ordering::Relaxed) {
+                            std::thread::yield_now();
+                        }
+                        (0, Vec::new())
+                    },
+                    record,
+                    sender as *mut c_void,
+                )
+            })
+            .collect();
+        drop(searches);
+
+        let mut delivered: Vec<u64> = rx.try_iter().map(|(id, status, _)| {
+            assert_eq!(status, TANTIVY_ERROR_CANCELLED);
+            id
+        }).collect();
+        delivered.sort_unstable();
+        assert_eq!(delivered, ids);
+        drop(unsafe { Box::from_raw(sender) });
+    }
+}
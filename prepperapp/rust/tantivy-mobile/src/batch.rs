@@ -0,0 +1,132 @@
+// batch.rs - Length-prefixed document batches for bulk ingestion
+//
+// Layout (little-endian, see tantivy_mobile.h):
+//   header  [magic u32][doc_count u32]
+//   docs    doc_count x [priority u32][id][title][category][summary][content]
+// where every string is [len u32][UTF-8 bytes]. Strings are borrowed from
+// the batch buffer, so decoding allocates nothing.
+
+pub const BATCH_MAGIC: u32 = 0x3142_4454; // "TDB1"
+pub const BATCH_HEADER_SIZE: usize = 8;
+
+pub(crate) struct BatchDocument<'a> {
+    pub id: &'a str,
+    pub title: &'a str,
+    pub category: &'a str,
+    pub summary: &'a str,
+    pub content: &'a str,
+    pub priority: u64,
+}
+
+impl BatchDocument<'_> {
+    /// Text bytes carried by this document, used for commit thresholds.
+    pub fn byte_len(&self) -> usize {
+        self.id.len() + self.title.len() + self.category.len() + self.summary.len() + self.content.len()
+    }
+}
+
+/// A batch whose header or a document inside it is truncated or not UTF-8.
+#[derive(Debug, PartialEq)]
+pub(crate) struct MalformedBatch;
+
+pub(crate) struct BatchReader<'a> {
+    data: &'a [u8],
+    at: usize,
+    remaining: u32,
+}
+
+impl<'a> BatchReader<'a> {
+    pub fn new(data: &'a [u8]) -> Result<Self, MalformedBatch> {
+        let mut reader = BatchReader { data, at: 0, remaining: 0 };
+        if reader.read_u32()? != BATCH_MAGIC {
+            return Err(MalformedBatch);
+        }
+        reader.remaining = reader.read_u32()?;
+        Ok(reader)
+    }
+
+    /// Documents not yet decoded.
+    pub fn remaining(&self) -> usize {
+        self.remaining as usize
+    }
+
+    fn read_u32(&mut self) -> Result<u32, MalformedBatch> {
+        let bytes = self.data.get(self.at..self.at + 4).ok_or(MalformedBatch)?;
+        self.at += 4;
+        Ok(u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]))
+    }
+
+    fn read_str(&mut self) -> Result<&'a str, MalformedBatch> {
+        let len = self.read_u32()? as usize;
+        let end = self.at.checked_add(len).ok_or(MalformedBatch)?;
+        let bytes = self.data.get(self.at..end).ok_or(MalformedBatch)?;
+        self.at = end;
+        std::str::from_utf8(bytes).map_err(|_| MalformedBatch)
+    }
+
+    fn read_document(&mut self) -> Result<BatchDocument<'a>, MalformedBatch> {
+        let priority = self.read_u32()? as u64;
+        Ok(BatchDocument {
+            id: self.read_str()?,
+            title: self.read_str()?,
+            category: self.read_str()?,
+            summary: self.read_str()?,
+            content: self.read_str()?,
+            priority,
+        })
+    }
+}
+
+impl<'a> Iterator for BatchReader<'a> {
+    type Item = Result<BatchDocument<'a>, MalformedBatch>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.remaining == 0 {
+            return None;
+        }
+        let doc = self.read_document();
+        // Stop after the first malformed document
+        self.remaining = if doc.is_ok() { self.remaining - 1 } else { 0 };
+        Some(doc)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn encode(docs: &[(&str, &str, u32)]) -> Vec<u8> {
+        let mut out = Vec::new();
+        out.extend_from_slice(&BATCH_MAGIC.to_le_bytes());
+        out.extend_from_slice(&(docs.len() as u32).to_le_bytes());
+        for (id, title, priority) in docs {
+            out.extend_from_slice(&priority.to_le_bytes());
+            for s in [*id, *title, "medical", "", "body text"] {
+                out.extend_from_slice(&(s.len() as u32).to_le_bytes());
+                out.extend_from_slice(s.as_bytes());
+            }
+        }
+        out
+    }
+
+    #[test]
+    fn test_decodes_documents() {
+        let data = encode(&[("med-001", "Tourniquet", 0), ("med-002", "Hypothermia", 1)]);
+        let docs: Vec<_> = BatchReader::new(&data).unwrap().collect::<Result<_, _>>().unwrap();
+        assert_eq!(docs.len(), 2);
+        assert_eq!(docs[1].title, "Hypothermia");
+        assert_eq!(docs[1].priority, 1);
+        assert_eq!(docs[0].byte_len(), "med-001Tourniquetmedicalbody text".len());
+    }
+
+    #[test]
+    fn test_rejects_malformed_batches() {
+        assert!(BatchReader::new(&[0u8; 4]).is_err());
+
+        let mut data = encode(&[("med-001", "Tourniquet", 0)]);
+        data.truncate(data.len() - 3);
+        let mut reader = BatchReader::new(&data).unwrap();
+        assert_eq!(reader.next().unwrap().err(), Some(MalformedBatch));
+        assert!(reader.next().is_none());
+    }
+}
@@ -0,0 +1,246 @@
+// cache.rs - Bounded LRU cache for ranked search results
+//
+// Keys are the normalized query, the module scope it ran against, the
+// limit and, for filtered searches, the filter. Entries are charged by an
+// estimated byte cost and evicted least recently used first once the cap is
+// exceeded. Invalidation bumps an epoch; a search that started before the
+// bump cannot insert its (possibly stale) results afterwards.
+
+use std::collections::{BTreeMap, HashMap};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+
+pub const DEFAULT_RESULT_CACHE_BYTES: usize = 2 * 1024 * 1024;
+
+// Bookkeeping charged per entry on top of the caller's value cost
+const ENTRY_OVERHEAD_BYTES: usize = 96;
+
+/// Trims and collapses whitespace so trivially different spellings of a
+/// query share an entry. Case is kept: the query parser treats operators and
+/// field names case-sensitively ("a AND b" is not "a and b").
+pub(crate) fn normalize_query(query: &str) -> String {
+    let mut normalized = String::with_capacity(query.len());
+    for word in query.split_whitespace() {
+        if !normalized.is_empty() {
+            normalized.push(' ');
+        }
+        normalized.push_str(word);
+    }
+    normalized
+}
+
+#[derive(Clone, Debug, Hash, PartialEq, Eq)]
+pub(crate) struct CacheKey {
+    query: String,
+    // (module slot, weight bits) for every module searched, sorted by slot
+    scope: Vec<(u32, u32)>,
+    limit: usize,
+    // Filter::cache_key of a filtered search; None for an unfiltered one
+    filter: Option<String>,
+}
+
+impl CacheKey {
+    pub fn new(query: &str, mut scope: Vec<(u32, u32)>, limit: usize) -> Self {
+        scope.sort_unstable();
+        CacheKey { query: normalize_query(query), scope, limit, filter: None }
+    }
+
+    /// The key of the same search run through the filtered API.
+    pub fn filtered(mut self, filter: Option<String>) -> Self {
+        self.filter = filter;
+        self
+    }
+
+    fn cost(&self) -> usize {
+        self.query.len() + self.scope.len() * 8 + self.filter.as_ref().map_or(0, String::len) + ENTRY_OVERHEAD_BYTES
+    }
+}
+
+#[derive(serde::Serialize, Debug, PartialEq)]
+pub(crate) struct CacheStats {
+    pub hits: u64,
+    pub misses: u64,
+    pub entries: usize,
+    pub bytes: usize,
+    pub capacity_bytes: usize,
+}
+
+struct Entry<V> {
+    value: Arc<V>,
+    cost: usize,
+    tick: u64,
+}
+
+struct LruState<V> {
+    entries: HashMap<CacheKey, Entry<V>>,
+    // Last-use tick -> key, oldest first
+    order: BTreeMap<u64, CacheKey>,
+    tick: u64,
+    bytes: usize,
+    capacity: usize,
+    epoch: u64,
+}
+
+impl<V> LruState<V> {
+    fn evict_to(&mut self, capacity: usize) {
+        while self.bytes > capacity {
+            let (_, key) = match self.order.pop_first() {
+                Some(oldest) => oldest,
+                None => break,
+            };
+            if let Some(entry) = self.entries.remove(&key) {
+                self.bytes -= entry.cost;
+            }
+        }
+    }
+}
+
+pub(crate) struct ResultCache<V> {
+    state: Mutex<LruState<V>>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+}
+
+impl<V> ResultCache<V> {
+    pub fn new(capacity: usize) -> Self {
+        ResultCache {
+            state: Mutex::new(LruState {
+                entries: HashMap::new(),
+                order: BTreeMap::new(),
+                tick: 0,
+                bytes: 0,
+                capacity,
+                epoch: 0,
+            }),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+        }
+    }
+
+    /// Looks up and refreshes an entry, counting the hit or miss.
+    pub fn get(&self, key: &CacheKey) -> Option<Arc<V>> {
+        let found = self.state.lock().ok().and_then(|mut state| {
+            state.tick += 1;
+            let tick = state.tick;
+            let entry = state.entries.get_mut(key)?;
+            let previous = std::mem::replace(&mut entry.tick, tick);
+            let value = entry.value.clone();
+            state.order.remove(&previous);
+            state.order.insert(tick, key.clone());
+            Some(value)
+        });
+        let counter = if found.is_some() { &self.hits } else { &self.misses };
+        counter.fetch_add(1, Ordering::Relaxed);
+        found
+    }
+
+    /// Epoch to pass to `insert`; read it before looking at the index.
+    pub fn epoch(&self) -> u64 {
+        self.state.lock().map_or(u64::MAX, |state| state.epoch)
+    }
+
+    /// Stores results computed under `epoch`. Dropped if the cache was
+    /// invalidated since, or if the entry alone exceeds the cap.
+    pub fn insert(&self, key: CacheKey, value: Arc<V>, value_cost: usize, epoch: u64) {
+        let mut state = match self.state.lock() {
+            Ok(s) => s,
+            Err(_) => return,
+        };
+        let cost = key.cost() + value_cost;
+        if state.epoch != epoch || cost > state.capacity {
+            return;
+        }
+
+        state.tick += 1;
+        let tick = state.tick;
+        if let Some(old) = state.entries.insert(key.clone(), Entry { value, cost, tick }) {
+            state.order.remove(&old.tick);
+            state.bytes -= old.cost;
+        }
+        state.order.insert(tick, key);
+        state.bytes += cost;
+        let capacity = state.capacity;
+        state.evict_to(capacity);
+    }
+
+    /// Drops every entry and fences off searches already in flight.
+    pub fn invalidate(&self) {
+        if let Ok(mut state) = self.state.lock() {
+            state.entries.clear();
+            state.order.clear();
+            state.bytes = 0;
+            state.epoch += 1;
+        }
+    }
+
+    /// Sets the memory cap in bytes; 0 disables caching.
+    pub fn set_capacity(&self, capacity: usize) {
+        if let Ok(mut state) = self.state.lock() {
+            state.capacity = capacity;
+            state.evict_to(capacity);
+        }
+    }
+
+    pub fn stats(&self) -> CacheStats {
+        let (entries, bytes, capacity_bytes) = self
+            .state
+            .lock()
+            .map_or((0, 0, 0), |state| (state.entries.len(), state.bytes, state.capacity));
+        CacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            entries,
+            bytes,
+            capacity_bytes,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn key(query: &str) -> CacheKey {
+        CacheKey::new(query, vec![(1, 0), (0, 0)], 20)
+    }
+
+    #[test]
+    fn test_normalize_query() {
+        assert_eq!(normalize_query("  Tourniquet   Application "), "Tourniquet Application");
+        assert_eq!(key(" burn ").query, key("burn").query);
+        assert_ne!(key("a AND b"), key("a and b"));
+        assert_ne!(key("Title:x"), key("title:x"));
+        assert_ne!(key("burn"), key("burn").filtered(Some(String::new())));
+    }
+
+    #[test]
+    fn test_hits_and_eviction() {
+        // Room for three entries: key (query + scope + overhead) plus 80 bytes
+        let cache = ResultCache::new(3 * (ENTRY_OVERHEAD_BYTES + 108));
+        for query in ["bleeding", "tourniquet", "hypothermia"] {
+            cache.insert(key(query), Arc::new(query.to_string()), 80, cache.epoch());
+        }
+        // Refresh "bleeding" so "tourniquet" is now the oldest
+        assert!(cache.get(&key(" bleeding ")).is_some());
+        cache.insert(key("splint"), Arc::new(String::new()), 80, cache.epoch());
+
+        assert!(cache.get(&key("tourniquet")).is_none());
+        assert!(cache.get(&key("bleeding")).is_some());
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses, stats.entries), (2, 1, 3));
+        assert!(stats.bytes <= stats.capacity_bytes);
+    }
+
+    #[test]
+    fn test_invalidate_fences_stale_inserts() {
+        let cache = ResultCache::new(DEFAULT_RESULT_CACHE_BYTES);
+        let epoch = cache.epoch();
+        cache.invalidate();
+        cache.insert(key("burn"), Arc::new(()), 0, epoch);
+        assert!(cache.get(&key("burn")).is_none());
+
+        cache.set_capacity(0);
+        cache.insert(key("burn"), Arc::new(()), 0, cache.epoch());
+        assert_eq!(cache.stats().entries, 0);
+    }
+}
@@ -0,0 +1,159 @@
+// doc_stream.rs - Article bodies read in chunks into caller buffers
+//
+// get_document returns every stored field as one JSON string, so a
+// multi-megabyte manual is escaped, copied across the FFI and copied again
+// into the platform's string type before anything can be shown. A
+// DocumentStream holds just the body of one article and hands it out in
+// chunks the caller sizes: the first screen of text can be laid out while
+// the rest is still being read. Chunks end on UTF-8 character boundaries,
+// so each one decodes on its own.
+
+use crate::multi_search::MultiSearchManager;
+use std::ffi::{c_char, CStr};
+
+// The opaque stream handle. It owns a copy of the body, so it stays valid
+// across reloads and unloads of the module it was opened on. Not for
+// concurrent use: reads advance a shared position.
+pub struct DocumentStream {
+    body: String,
+    position: usize,
+}
+
+impl DocumentStream {
+    pub(crate) fn new(body: String) -> Self {
+        DocumentStream { body, position: 0 }
+    }
+
+    /// Copies the next chunk into `buf`, cut back to a character boundary.
+    /// Returns the bytes written, 0 at the end, or None if not even the
+    /// next character fits.
+    fn read(&mut self, buf: &mut [u8]) -> Option<usize> {
+        let rest = &self.body[self.position..];
+        if rest.is_empty() {
+            return Some(0);
+        }
+        let mut len = rest.len().min(buf.len());
+        while !rest.is_char_boundary(len) {
+            len -= 1;
+        }
+        if len == 0 {
+            return None;
+        }
+        buf[..len].copy_from_slice(&rest.as_bytes()[..len]);
+        self.position += len;
+        Some(len)
+    }
+}
+
+/// Opens the body of article `doc_id` for chunked reading, from module
+/// `module_name` or, when it is null, the first loaded module that has the
+/// article. The body is the document's stored `body` text, or `content`
+/// when the schema stores that instead.
+///
+/// # Safety
+/// `doc_id_ptr` and a non-null `module_name_ptr` must be valid,
+/// null-terminated C strings. The stream must be freed with
+/// `document_stream_free`. Returns null if no module has the article or
+/// its index stores no body.
+#[no_mangle]
+pub extern "C" fn multi_manager_open_document_stream(
+    manager_ptr: *const MultiSearchManager,
+    module_name_ptr: *const c_char,
+    doc_id_ptr: *const c_char,
+) -> *mut DocumentStream {
+    if manager_ptr.is_null() || doc_id_ptr.is_null() {
+        return std::ptr::null_mut();
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let doc_id = match unsafe { CStr::from_ptr(doc_id_ptr) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let module_name = if module_name_ptr.is_null() {
+        None
+    } else {
+        match unsafe { CStr::from_ptr(module_name_ptr) }.to_str() {
+            Ok(s) => Some(s),
+            Err(_) => return std::ptr::null_mut(),
+        }
+    };
+
+    match manager.document_body(module_name, doc_id) {
+        Some(body) => Box::into_raw(Box::new(DocumentStream::new(body))),
+        None => std::ptr::null_mut(),
+    }
+}
+
+/// Total body length in bytes, to size a buffer or a progress bar; -1 for a
+/// null stream.
+#[no_mangle]
+pub extern "C" fn document_stream_length(stream_ptr: *const DocumentStream) -> i64 {
+    if stream_ptr.is_null() {
+        return -1;
+    }
+    unsafe { &*stream_ptr }.body.len() as i64
+}
+
+/// Copies up to `capacity` bytes of UTF-8 into `buf`, ending on a character
+/// boundary. Returns the bytes written, 0 once the body is exhausted, or
+/// TANTIVY_ERROR_INVALID_PARAM for null arguments or a buffer too small
+/// for the next character (under 4 bytes).
+#[no_mangle]
+pub extern "C" fn document_stream_read(stream_ptr: *mut DocumentStream, buf: *mut u8, capacity: usize) -> i32 {
+    if stream_ptr.is_null() || buf.is_null() {
+        return -1;
+    }
+    let stream = unsafe { &mut *stream_ptr };
+    // Results are i32 byte counts
+    let capacity = capacity.min(i32::MAX as usize);
+    let buf = unsafe { std::slice::from_raw_parts_mut(buf, capacity) };
+    stream.read(buf).map_or(-1, |n| n as i32)
+}
+
+/// Frees a stream; null is ignored.
+#[no_mangle]
+pub extern "C" fn document_stream_free(stream_ptr: *mut DocumentStream) {
+    if !stream_ptr.is_null() {
+        let _ = unsafe { Box::from_raw(stream_ptr) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_read_chunks_on_char_boundaries() {
+        // "é" is 2 bytes and "🩹" is 4
+        let body = "ab é 🩹 end".to_string();
+        let mut stream = DocumentStream::new(body.clone());
+        let mut buf = [0u8; 4];
+        let mut out = Vec::new();
+        loop {
+            let n = stream.read(&mut buf).unwrap();
+            if n == 0 {
+                break;
+            }
+            assert!(std::str::from_utf8(&buf[..n]).is_ok());
+            out.extend_from_slice(&buf[..n]);
+        }
+        assert_eq!(String::from_utf8(out).unwrap(), body);
+    }
+
+    #[test]
+    fn test_read_buffer_too_small() {
+        let mut stream = DocumentStream::new("🩹".to_string());
+        assert_eq!(stream.read(&mut [0u8; 3]), None);
+        assert_eq!(stream.read(&mut [0u8; 4]), Some(4));
+        assert_eq!(stream.read(&mut [0u8; 4]), Some(0));
+    }
+
+    #[test]
+    fn test_null_safety() {
+        assert!(multi_manager_open_document_stream(std::ptr::null(), std::ptr::null(), std::ptr::null()).is_null());
+        assert_eq!(document_stream_length(std::ptr::null()), -1);
+        assert_eq!(document_stream_read(std::ptr::null_mut(), std::ptr::null_mut(), 0), -1);
+        document_stream_free(std::ptr::null_mut());
+    }
+}
@@ -0,0 +1,194 @@
+// doc_table.rs - Article id to DocAddress lookups from the indexer's table
+//
+// tantivy-indexer-mobile writes doc_addresses.bin beside the segments. It is
+// opened through the index directory, so it is memory-mapped like the
+// segment files, and looked up by binary search instead of a term query.
+// Layout (must match tantivy-indexer's doc_table.rs), little-endian:
+//   [b"PDAT"][u32 version][u32 segment_count][u32 entry_count]
+//   [segment_count x 32-byte segment id, hex as in segment file names]
+//   [entry_count x (u64 id_hash, u32 segment, u32 doc)], sorted
+// A table only covers the segments it was built for; hits are checked
+// against the stored id, so a stale or colliding entry falls through to the
+// term query instead of opening the wrong article.
+
+use std::path::Path;
+use tantivy::directory::OwnedBytes;
+use tantivy::{DocAddress, Directory, Searcher};
+
+pub(crate) const DOC_TABLE_FILE: &str = "doc_addresses.bin";
+const DOC_TABLE_MAGIC: &[u8; 4] = b"PDAT";
+const DOC_TABLE_VERSION: u32 = 1;
+
+const HEADER_SIZE: usize = 16;
+const SEGMENT_ID_SIZE: usize = 32;
+const ENTRY_SIZE: usize = 16;
+
+/// FNV-1a of the id's UTF-8 bytes.
+pub(crate) fn id_hash(id: &str) -> u64 {
+    id.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, byte| (hash ^ byte as u64).wrapping_mul(0x0100_0000_01b3))
+}
+
+/// The table of one searcher generation.
+pub(crate) struct DocTable {
+    bytes: OwnedBytes,
+    entries_start: usize,
+    entry_count: usize,
+    // The searcher's ordinal of each table segment, None where the
+    // generation no longer has it
+    segment_ords: Vec<Option<u32>>,
+    generation: u64,
+}
+
+impl DocTable {
+    /// The table for `searcher`'s generation; None when the index has none,
+    /// it is malformed or a newer version, or none of its segments is live.
+    pub fn open(searcher: &Searcher) -> Option<DocTable> {
+        let file = searcher.index().directory().open_read(Path::new(DOC_TABLE_FILE)).ok()?;
+        let bytes = file.read_bytes().ok()?;
+        let (segment_ids, entries_start, entry_count) = parse(bytes.as_slice())?;
+
+        let live: Vec<String> = searcher.segment_readers().iter().map(|r| r.segment_id().uuid_string()).collect();
+        let segment_ords: Vec<Option<u32>> = segment_ids
+            .chunks_exact(SEGMENT_ID_SIZE)
+            .map(|id| live.iter().position(|l| l.as_bytes() == id).map(|ord| ord as u32))
+            .collect();
+        if segment_ords.iter().all(Option::is_none) {
+            return None;
+        }
+
+        Some(DocTable {
+            bytes,
+            entries_start,
+            entry_count,
+            segment_ords,
+            generation: searcher.generation().generation_id(),
+        })
+    }
+
+    /// Whether this table was opened for `searcher`'s generation.
+    pub fn matches(&self, searcher: &Searcher) -> bool {
+        self.generation == searcher.generation().generation_id()
+    }
+
+    /// Addresses of the documents whose id hashes like `id`, in live
+    /// segments. Usually one; the caller checks the stored id.
+    pub fn candidates<'a>(&'a self, id: &str) -> impl Iterator<Item = DocAddress> + 'a {
+        let hash = id_hash(id);
+        // First entry whose hash is not below `hash`
+        let (mut lo, mut hi) = (0, self.entry_count);
+        while lo < hi {
+            let mid = lo + (hi - lo) / 2;
+            if self.entry(mid).0 < hash {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        (lo..self.entry_count)
+            .map(move |i| self.entry(i))
+            .take_while(move |&(entry_hash, _, _)| entry_hash == hash)
+            .filter_map(move |(_, segment, doc)| {
+                let ord = (*self.segment_ords.get(segment as usize)?)?;
+                Some(DocAddress::new(ord, doc))
+            })
+    }
+
+    fn entry(&self, i: usize) -> (u64, u32, u32) {
+        let at = self.entries_start + i * ENTRY_SIZE;
+        let entry = &self.bytes.as_slice()[at..at + ENTRY_SIZE];
+        (
+            u64::from_le_bytes(entry[0..8].try_into().unwrap()),
+            u32::from_le_bytes(entry[8..12].try_into().unwrap()),
+            u32::from_le_bytes(entry[12..16].try_into().unwrap()),
+        )
+    }
+}
+
+// Segment id bytes, entries offset and entry count of a well-formed table
+fn parse(bytes: &[u8]) -> Option<(&[u8], usize, usize)> {
+    let word = |at: usize| Some(u32::from_le_bytes(bytes.get(at..at + 4)?.try_into().ok()?) as usize);
+    if bytes.get(..4)? != DOC_TABLE_MAGIC || word(4)? != DOC_TABLE_VERSION as usize {
+        return None;
+    }
+    let segment_count = word(8)?;
+    let entry_count = word(12)?;
+    let entries_start = HEADER_SIZE.checked_add(segment_count.checked_mul(SEGMENT_ID_SIZE)?)?;
+    let end = entries_start.checked_add(entry_count.checked_mul(ENTRY_SIZE)?)?;
+    if bytes.len() != end {
+        return None;
+    }
+    Some((&bytes[HEADER_SIZE..entries_start], entries_start, entry_count))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn table(segments: &[&str], entries: &[(u64, u32, u32)]) -> Vec<u8> {
+        let mut out = Vec::new();
+        out.extend_from_slice(DOC_TABLE_MAGIC);
+        out.extend_from_slice(&DOC_TABLE_VERSION.to_le_bytes());
+        out.extend_from_slice(&(segments.len() as u32).to_le_bytes());
+        out.extend_from_slice(&(entries.len() as u32).to_le_bytes());
+        for segment in segments {
+            out.extend_from_slice(segment.as_bytes());
+        }
+        for &(hash, segment, doc) in entries {
+            out.extend_from_slice(&hash.to_le_bytes());
+            out.extend_from_slice(&segment.to_le_bytes());
+            out.extend_from_slice(&doc.to_le_bytes());
+        }
+        out
+    }
+
+    #[test]
+    fn test_id_hash_matches_indexer() {
+        assert_eq!(id_hash("a"), 0xaf63_dc4c_8601_ec8c);
+        assert_eq!(id_hash("foobar"), 0x8594_4171_f739_67e8);
+    }
+
+    #[test]
+    fn test_parse() {
+        let segment = "0123456789abcdef0123456789abcdef";
+        let bytes = table(&[segment], &[(1, 0, 0), (2, 0, 1)]);
+        let (ids, start, count) = parse(&bytes).unwrap();
+        assert_eq!(ids, segment.as_bytes());
+        assert_eq!(start, HEADER_SIZE + SEGMENT_ID_SIZE);
+        assert_eq!(count, 2);
+
+        assert!(parse(&bytes[..bytes.len() - 1]).is_none());
+        let mut newer = bytes.clone();
+        newer[4] = 2;
+        assert!(parse(&newer).is_none());
+        assert!(parse(b"PDAT").is_none());
+    }
+
+    #[test]
+    fn test_candidates() {
+        use tantivy::schema::{Schema, STORED, STRING};
+        use tantivy::{doc, Index};
+
+        let mut builder = Schema::builder();
+        let id = builder.add_text_field("id", STRING | STORED);
+        let index = Index::create_in_ram(builder.build());
+        let mut writer: tantivy::IndexWriter = index.writer(15_000_000).unwrap();
+        writer.add_document(doc!(id => "a")).unwrap();
+        writer.add_document(doc!(id => "b")).unwrap();
+        writer.commit().unwrap();
+        let searcher = index.reader().unwrap().searcher();
+        let segment = searcher.segment_readers()[0].segment_id().uuid_string();
+
+        // "b" shares its hash with a document of a segment that is gone
+        let gone = "ffffffffffffffffffffffffffffffff";
+        let mut entries = vec![(id_hash("a"), 1, 0), (id_hash("b"), 1, 1), (id_hash("b"), 0, 7)];
+        entries.sort_unstable();
+        let bytes = table(&[gone, &segment], &entries);
+        index.directory().atomic_write(Path::new(DOC_TABLE_FILE), &bytes).unwrap();
+
+        let table = DocTable::open(&searcher).unwrap();
+        assert!(table.matches(&searcher));
+        assert_eq!(table.candidates("a").collect::<Vec<_>>(), vec![DocAddress::new(0, 0)]);
+        assert_eq!(table.candidates("b").collect::<Vec<_>>(), vec![DocAddress::new(0, 1)]);
+        assert_eq!(table.candidates("c").count(), 0);
+    }
+}
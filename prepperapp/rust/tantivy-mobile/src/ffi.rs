@@ -1,9 +1,17 @@
 // ffi.rs - FFI interface for mobile integration
 
+use crate::doc_table::DocTable;
+use crate::filter::FilterCache;
+use crate::mmap_advice::{AdvisedDirectory, PageOut};
+use crate::snippet::{summary_or_snippet, SnippetReader, SNIPPET_FIELD};
+use crate::stats::{IndexStats, QueryStats};
+use arc_swap::{ArcSwap, ArcSwapOption};
 use std::ffi::{c_char, CStr, CString};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
 use tantivy::collector::TopDocs;
 use tantivy::query::QueryParser;
-use tantivy::{schema::{Schema, Value}, Index, IndexReader, TantivyDocument};
+use tantivy::{schema::{Field, FieldType, Schema, Value}, DocAddress, Index, IndexReader, Searcher, TantivyDocument};
 
 // This struct is our opaque handle. The native side only knows it as a pointer.
 // No #[repr(C)] is needed because we aren't accessing its fields from the C side.
@@ -11,6 +19,187 @@ pub struct SearchService {
     pub(crate) reader: IndexReader,
     pub(crate) schema: Schema,
     pub(crate) query_parser: QueryParser,
+    pub(crate) fields: SearchFields,
+    // Searcher for the current generation, replaced wholesale on reload.
+    // Queries load it without taking a lock and keep the old generation
+    // alive until they finish.
+    searcher: ArcSwap<Searcher>,
+    // The indexer's id table for the current generation, if it has one
+    doc_table: ArcSwapOption<DocTable>,
+    // Category and priority filter sets of recent filtered searches
+    pub(crate) filters: FilterCache,
+    // Set when opened with TANTIVY_OPEN_MMAP_ADVISED
+    directory: Option<AdvisedDirectory>,
+    // Tick of the last search, for picking cold modules to page out
+    last_used: AtomicU64,
+    // Segment file bytes of the current generation, measured on reload
+    index_bytes: AtomicU64,
+    pub(crate) queries: QueryStats,
+}
+
+// Text fields a query runs against, where the schema indexes them
+const QUERY_FIELDS: [&str; 4] = ["title", "summary", "body", "content"];
+
+// Index open modes for init_searcher_with_mode
+pub const TANTIVY_OPEN_DEFAULT: u32 = 0;
+// Memory-mapped with per-file madvise hints and resident-page accounting
+pub const TANTIVY_OPEN_MMAP_ADVISED: u32 = 1;
+
+// Monotonic clock shared by every service's last_used
+static USE_CLOCK: AtomicU64 = AtomicU64::new(1);
+
+impl SearchService {
+    /// Snapshot of the current generation.
+    pub(crate) fn searcher(&self) -> Arc<Searcher> {
+        self.searcher.load_full()
+    }
+
+    /// Reloads the reader and publishes the new generation.
+    pub(crate) fn reload(&self) -> tantivy::Result<()> {
+        self.reader.reload()?;
+        let searcher = self.reader.searcher();
+        self.index_bytes.store(index_bytes(&searcher), Ordering::Relaxed);
+        self.doc_table.store(DocTable::open(&searcher).map(Arc::new));
+        self.searcher.store(Arc::new(searcher));
+        if let Some(directory) = &self.directory {
+            directory.forget_missing();
+        }
+        Ok(())
+    }
+
+    /// The stored document with article id `id`, from the id table when the
+    /// generation has one and it covers the id, else by a term query.
+    pub(crate) fn find_document(&self, searcher: &Searcher, id: &str) -> Option<TantivyDocument> {
+        let id_field = self.fields.id?;
+        if let Some(table) = self.doc_table.load().as_deref().filter(|t| t.matches(searcher)) {
+            for address in table.candidates(id) {
+                let segment = searcher.segment_reader(address.segment_ord);
+                if segment.is_deleted(address.doc_id) {
+                    continue;
+                }
+                if let Ok(doc) = searcher.doc::<TantivyDocument>(address) {
+                    if SearchFields::text(&doc, Some(id_field)) == id {
+                        return Some(doc);
+                    }
+                }
+            }
+        }
+
+        let query = tantivy::query::TermQuery::new(
+            tantivy::Term::from_field_text(id_field, id),
+            tantivy::schema::IndexRecordOption::Basic,
+        );
+        let (_, address): (f32, DocAddress) = *searcher.search(&query, &TopDocs::with_limit(1)).ok()?.first()?;
+        searcher.doc::<TantivyDocument>(address).ok()
+    }
+
+    /// Marks the service as just searched.
+    pub(crate) fn touch(&self) {
+        self.last_used.store(USE_CLOCK.fetch_add(1, Ordering::Relaxed), Ordering::Relaxed);
+    }
+
+    pub(crate) fn last_used(&self) -> u64 {
+        self.last_used.load(Ordering::Relaxed)
+    }
+
+    /// Index bytes in RAM; 0 unless opened with TANTIVY_OPEN_MMAP_ADVISED.
+    pub(crate) fn resident_bytes(&self) -> usize {
+        self.directory.as_ref().map_or(0, |d| d.resident_bytes())
+    }
+
+    /// Footprint of the current generation and the query counters.
+    pub(crate) fn stats(&self) -> IndexStats {
+        let mut stats = IndexStats::empty();
+        searcher_footprint(&self.searcher(), &mut stats);
+        stats.index_size_bytes = self.index_bytes.load(Ordering::Relaxed);
+        // MmapDirectory maps every file it opens
+        stats.mapped_bytes = self.directory.as_ref().map_or(stats.index_size_bytes, |d| d.mapped_bytes() as u64);
+        stats.resident_bytes = self.resident_bytes() as u64;
+        stats.heap_bytes = stats.docstore_cache_bytes + self.filters.bytes() as u64;
+        self.queries.fill(&mut stats);
+        stats
+    }
+
+    /// Drops resident index pages. A no-op unless opened advised.
+    pub(crate) fn page_out(&self, scope: PageOut) {
+        if let Some(directory) = &self.directory {
+            directory.page_out(scope);
+        }
+    }
+}
+
+/// Bytes of a generation's segment files.
+pub(crate) fn index_bytes(searcher: &Searcher) -> u64 {
+    searcher.space_usage().map_or(0, |usage| usage.total().get_bytes())
+}
+
+/// Docstore cache capacity in blocks for a byte budget.
+fn docstore_cache_blocks(bytes: u64, index: &Index) -> usize {
+    let block_size = index.settings().docstore_blocksize.max(1) as u64;
+    (bytes / block_size).clamp(1, usize::MAX as u64) as usize
+}
+
+/// Document, segment and docstore cache figures of a generation. Cached
+/// blocks are counted at the docstore block size, which bounds their
+/// decompressed size.
+pub(crate) fn searcher_footprint(searcher: &Searcher, stats: &mut IndexStats) {
+    stats.num_docs = searcher.num_docs();
+    stats.segment_count = searcher.segment_readers().len() as u32;
+    let block_size = searcher.index().settings().docstore_blocksize as u64;
+    stats.docstore_cache_bytes = searcher.doc_store_cache_stats().num_entries as u64 * block_size;
+}
+
+// Field handles read back from hits, resolved once when an index is opened.
+// Fields missing from a schema read as empty strings.
+pub(crate) struct SearchFields {
+    pub id: Option<Field>,
+    pub title: Option<Field>,
+    pub category: Option<Field>,
+    pub summary: Option<Field>,
+    // Stored article text, streamed by doc_stream.rs
+    pub body: Option<Field>,
+    pub priority: Option<Field>,
+    // The indexer's fast bytes snippet column, read when no summary is stored
+    pub snippet: Option<Field>,
+}
+
+impl SearchFields {
+    pub fn resolve(schema: &Schema) -> Self {
+        SearchFields {
+            id: schema.get_field("id").ok(),
+            title: schema.get_field("title").ok(),
+            category: schema.get_field("category").ok(),
+            summary: schema.get_field("summary").ok(),
+            body: ["body", "content"].iter().filter_map(|name| schema.get_field(name).ok()).find(|&f| {
+                let entry = schema.get_field_entry(f);
+                matches!(entry.field_type(), FieldType::Str(_)) && entry.is_stored()
+            }),
+            priority: schema.get_field("priority").ok(),
+            snippet: schema.get_field(SNIPPET_FIELD).ok().filter(|&f| {
+                let entry = schema.get_field_entry(f);
+                matches!(entry.field_type(), FieldType::Bytes(_)) && entry.is_fast()
+            }),
+        }
+    }
+
+    /// Snippet reader for one results list from `searcher`.
+    pub fn snippets<'a>(&self, searcher: &'a Searcher) -> SnippetReader<'a> {
+        SnippetReader::new(searcher, self.snippet.is_some())
+    }
+
+    pub fn text(doc: &TantivyDocument, field: Option<Field>) -> &str {
+        field
+            .and_then(|f| doc.get_first(f))
+            .and_then(|v| v.as_str())
+            .unwrap_or("")
+    }
+
+    pub fn priority(&self, doc: &TantivyDocument) -> u64 {
+        self.priority
+            .and_then(|f| doc.get_first(f))
+            .and_then(|v| v.as_u64())
+            .unwrap_or(0)
+    }
 }
 
 // A struct to define the format of our search results.
@@ -31,7 +220,25 @@ struct SearchResultItem {
 /// Returns null on failure (e.g., index not found, invalid path).
 #[no_mangle]
 pub extern "C" fn init_searcher(index_path_ptr: *const c_char) -> *mut SearchService {
-    if index_path_ptr.is_null() {
+    init_searcher_with_mode(index_path_ptr, TANTIVY_OPEN_DEFAULT)
+}
+
+/// Like `init_searcher`, choosing how index files are opened. With
+/// `TANTIVY_OPEN_MMAP_ADVISED`, term dictionaries and fast fields are
+/// prefetched, the docstore is marked random access, and resident pages can
+/// be measured and dropped under memory pressure.
+/// Returns null on failure or an unknown mode.
+#[no_mangle]
+pub extern "C" fn init_searcher_with_mode(index_path_ptr: *const c_char, mode: u32) -> *mut SearchService {
+    open_searcher(index_path_ptr, mode, 0)
+}
+
+/// Opens a searcher whose docstore block cache holds up to
+/// `docstore_cache_bytes` of decompressed blocks, rounded down to whole
+/// blocks of the index's block size (at least one); 0 keeps tantivy's
+/// default of 100 blocks.
+pub(crate) fn open_searcher(index_path_ptr: *const c_char, mode: u32, docstore_cache_bytes: u64) -> *mut SearchService {
+    if index_path_ptr.is_null() || mode > TANTIVY_OPEN_MMAP_ADVISED {
         return std::ptr::null_mut();
     }
     
@@ -40,17 +247,50 @@ pub extern "C" fn init_searcher(index_path_ptr: *const c_char) -> *mut SearchSer
         let path_cstr = unsafe { CStr::from_ptr(index_path_ptr) };
         let index_path = path_cstr.to_str()?;
 
-        let index = Index::open_in_dir(index_path)?;
+        let (index, directory) = if mode == TANTIVY_OPEN_MMAP_ADVISED {
+            let directory = AdvisedDirectory::open(index_path)?;
+            (Index::open(directory.clone())?, Some(directory))
+        } else {
+            (Index::open_in_dir(index_path)?, None)
+        };
         let schema = index.schema();
-        let reader = index.reader_builder().reload_policy(tantivy::ReloadPolicy::Manual).try_into()?;
+        let mut reader_builder = index.reader_builder().reload_policy(tantivy::ReloadPolicy::Manual);
+        if docstore_cache_bytes > 0 {
+            reader_builder = reader_builder
+                .doc_store_cache_num_blocks(docstore_cache_blocks(docstore_cache_bytes, &index));
+        }
+        let reader = reader_builder.try_into()?;
 
-        // Define which fields are used for searching.
-        let title_field = schema.get_field("title").map_err(|_| "title field not found")?;
-        let body_field = schema.get_field("body").map_err(|_| "body field not found")?;
-        let summary_field = schema.get_field("summary").map_err(|_| "summary field not found")?;
-        let query_parser = QueryParser::for_index(&index, vec![title_field, summary_field, body_field]);
+        // Search whichever text fields this schema indexes; the mobile
+        // schema indexes only `content`
+        let query_fields: Vec<Field> = QUERY_FIELDS
+            .iter()
+            .filter_map(|name| schema.get_field(name).ok())
+            .filter(|&f| schema.get_field_entry(f).is_indexed())
+            .collect();
+        if query_fields.is_empty() {
+            return Err("no indexed text field to search".into());
+        }
+        let query_parser = QueryParser::for_index(&index, query_fields);
 
-        let service = SearchService { reader, schema, query_parser };
+        let fields = SearchFields::resolve(&schema);
+        let searcher = reader.searcher();
+        let index_bytes = AtomicU64::new(index_bytes(&searcher));
+        let doc_table = ArcSwapOption::from(DocTable::open(&searcher).map(Arc::new));
+        let searcher = ArcSwap::from_pointee(searcher);
+        let service = SearchService {
+            reader,
+            schema,
+            query_parser,
+            fields,
+            searcher,
+            doc_table,
+            filters: FilterCache::default(),
+            directory,
+            last_used: AtomicU64::new(0),
+            index_bytes,
+            queries: QueryStats::default(),
+        };
         let service_box = Box::new(service);
         Ok(Box::into_raw(service_box))
     });
@@ -83,6 +323,21 @@ pub extern "C" fn destroy_searcher(service_ptr: *mut SearchService) {
 /// Returns null on failure.
 #[no_mangle]
 pub extern "C" fn search(service_ptr: *const SearchService, query_ptr: *const c_char) -> *const c_char {
+    search_with_offset(service_ptr, query_ptr, 20, 0)
+}
+
+/// `search` returning `limit` results after skipping the best `offset`,
+/// for paging through a results list.
+///
+/// # Safety
+/// As for `search`.
+#[no_mangle]
+pub extern "C" fn search_with_offset(
+    service_ptr: *const SearchService,
+    query_ptr: *const c_char,
+    limit: u32,
+    offset: u32,
+) -> *const c_char {
     if service_ptr.is_null() || query_ptr.is_null() {
         return std::ptr::null();
     }
@@ -95,29 +350,36 @@ pub extern "C" fn search(service_ptr: *const SearchService, query_ptr: *const c_
         Err(_) => return std::ptr::null(),
     };
 
-    let searcher = service.reader.searcher();
+    let start = std::time::Instant::now();
+    let searcher = service.searcher();
     let query = match service.query_parser.parse_query(query_str) {
         Ok(q) => q,
         Err(_) => return std::ptr::null(), // Invalid query syntax
     };
 
-    let top_docs = match searcher.search(&query, &TopDocs::with_limit(20)) {
-        Ok(td) => td,
-        Err(_) => return std::ptr::null(),
+    // TopDocs rejects a limit of 0
+    let top_docs = if limit == 0 {
+        Vec::new()
+    } else {
+        let collector = TopDocs::with_limit(limit as usize).and_offset(offset as usize);
+        match searcher.search(&query, &collector) {
+            Ok(td) => td,
+            Err(_) => return std::ptr::null(),
+        }
     };
 
     let mut results: Vec<SearchResultItem> = Vec::new();
+    let mut snippets = service.fields.snippets(&searcher);
     for (score, doc_address) in top_docs {
         if let Ok(doc) = searcher.doc::<TantivyDocument>(doc_address) {
-            let title = doc.get_first(service.schema.get_field("title").unwrap())
-                .and_then(|v| v.as_str()).unwrap_or("").to_string();
-            let doc_id = doc.get_first(service.schema.get_field("id").unwrap())
-                .and_then(|v| v.as_str()).unwrap_or("").to_string();
-            let summary = doc.get_first(service.schema.get_field("summary").unwrap())
-                .and_then(|v| v.as_str()).unwrap_or("").to_string();
+            let title = SearchFields::text(&doc, service.fields.title).to_string();
+            let doc_id = SearchFields::text(&doc, service.fields.id).to_string();
+            let stored = SearchFields::text(&doc, service.fields.summary);
+            let summary = summary_or_snippet(stored, &mut snippets, doc_address).to_string();
             results.push(SearchResultItem { doc_id, title, summary, score });
         }
     }
+    service.queries.record(start.elapsed());
 
     let json_string = match serde_json::to_string(&results) {
         Ok(s) => s,
@@ -148,47 +410,25 @@ pub extern "C" fn get_document(service_ptr: *const SearchService, doc_id_ptr: *c
         Err(_) => return std::ptr::null(),
     };
 
-    // Create a query for the specific document ID
-    let id_field = match service.schema.get_field("id") {
-        Ok(f) => f,
-        Err(_) => return std::ptr::null(),
-    };
-
-    let searcher = service.reader.searcher();
-    let query = tantivy::query::TermQuery::new(
-        tantivy::Term::from_field_text(id_field, doc_id),
-        tantivy::schema::IndexRecordOption::WithFreqsAndPositions,
-    );
-
-    let top_docs = match searcher.search(&query, &TopDocs::with_limit(1)) {
-        Ok(td) => td,
-        Err(_) => return std::ptr::null(),
-    };
-
-    if let Some((_, doc_address)) = top_docs.first() {
-        if let Ok(doc) = searcher.doc::<TantivyDocument>(*doc_address) {
-            // Create a full document result with all fields
-            let mut doc_map = std::collections::HashMap::new();
-            
-            // Get all fields from schema and extract their values
-            for (field, field_entry) in service.schema.fields() {
-                let field_name = field_entry.name();
-                if let Some(field_value) = doc.get_first(field) {
-                    if let Some(text_value) = field_value.as_str() {
-                        doc_map.insert(field_name.to_string(), text_value.to_string());
-                    }
-                }
-            }
+    let searcher = service.searcher();
+    match service.find_document(&searcher, doc_id) {
+        Some(doc) => document_json(&service.schema, &doc),
+        None => std::ptr::null(),
+    }
+}
 
-            match serde_json::to_string(&doc_map) {
-                Ok(s) => CString::new(s).map_or(std::ptr::null(), |s| s.into_raw()),
-                Err(_) => std::ptr::null(),
-            }
-        } else {
-            std::ptr::null()
+/// Every stored text field of `doc` as a JSON object; null on failure.
+pub(crate) fn document_json(schema: &Schema, doc: &TantivyDocument) -> *const c_char {
+    let mut doc_map = std::collections::HashMap::new();
+    for (field, field_entry) in schema.fields() {
+        if let Some(text_value) = doc.get_first(field).and_then(|v| v.as_str()) {
+            doc_map.insert(field_entry.name().to_string(), text_value.to_string());
         }
-    } else {
-        std::ptr::null()
+    }
+
+    match serde_json::to_string(&doc_map) {
+        Ok(s) => CString::new(s).map_or(std::ptr::null(), |s| s.into_raw()),
+        Err(_) => std::ptr::null(),
     }
 }
 
@@ -199,8 +439,8 @@ pub extern "C" fn trigger_index_reload(service_ptr: *mut SearchService) -> i32 {
     if service_ptr.is_null() {
         return -1;
     }
-    let service = unsafe { &mut *service_ptr };
-    match service.reader.reload() {
+    let service = unsafe { &*service_ptr };
+    match service.reload() {
         Ok(_) => 0,
         Err(_) => -1,
     }
@@ -224,7 +464,10 @@ mod tests {
     #[test]
     fn test_null_safety() {
         assert!(init_searcher(std::ptr::null()).is_null());
+        assert!(init_searcher_with_mode(std::ptr::null(), TANTIVY_OPEN_MMAP_ADVISED).is_null());
         assert!(search(std::ptr::null(), std::ptr::null()).is_null());
+        assert!(search_with_offset(std::ptr::null(), std::ptr::null(), 20, 40).is_null());
+        assert!(get_document(std::ptr::null(), std::ptr::null()).is_null());
         assert_eq!(trigger_index_reload(std::ptr::null_mut()), -1);
         
         // Should not crash
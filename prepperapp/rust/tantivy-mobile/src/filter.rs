@@ -0,0 +1,357 @@
+// filter.rs - Filter-first searches and browse listings
+//
+// Category and priority filters become a set of matching documents per
+// segment, built once per index generation from the category term's
+// postings and a range scan of the priority fast column, and cached on the
+// service. A filtered search checks each scored document against its
+// segment's set while collecting and skips segments with no match at all;
+// a filtered browse (empty query) walks the sets directly, ranked by
+// priority, without a query or any BM25 scoring. Module filters stay with
+// MultiSearchOptions.module_mask.
+
+use crate::ffi::SearchFields;
+use std::collections::BinaryHeap;
+use std::ffi::{c_char, CStr};
+use std::ops::RangeInclusive;
+use std::sync::{Arc, Mutex};
+use tantivy::schema::IndexRecordOption;
+use tantivy::{DocAddress, DocId, DocSet, Searcher, SegmentReader, Term, TERMINATED};
+
+/// Filter of a filtered search, passed by pointer from native code.
+#[repr(C)]
+pub struct SearchFilter {
+    // Exact category to match, or null for any. Indexes without an indexed
+    // `category` field match nothing when it is set.
+    pub category: *const c_char,
+    // Inclusive priority range; 0 and UINT32_MAX leave it unbounded.
+    // Documents without a priority only pass an unbounded range.
+    pub priority_min: u32,
+    pub priority_max: u32,
+}
+
+// Filter sets kept per service, most recently used last
+const FILTER_CACHE_ENTRIES: usize = 8;
+
+#[derive(Clone, Debug, PartialEq, Eq, Hash)]
+pub(crate) struct Filter {
+    pub category: Option<String>,
+    pub priority: RangeInclusive<u64>,
+}
+
+impl Filter {
+    pub const NONE: Filter = Filter { category: None, priority: 0..=u64::MAX };
+
+    /// The filter `ptr` describes; NONE for null, None for a category that
+    /// is not UTF-8.
+    pub fn from_raw(ptr: *const SearchFilter) -> Option<Filter> {
+        if ptr.is_null() {
+            return Some(Filter::NONE);
+        }
+        let raw = unsafe { &*ptr };
+        let category = if raw.category.is_null() {
+            None
+        } else {
+            Some(unsafe { CStr::from_ptr(raw.category) }.to_str().ok()?.to_string())
+        };
+        let max = if raw.priority_max == u32::MAX { u64::MAX } else { raw.priority_max as u64 };
+        Some(Filter { category, priority: raw.priority_min as u64..=max })
+    }
+
+    pub fn is_none(&self) -> bool {
+        self == &Filter::NONE
+    }
+
+    fn bounds_priority(&self) -> bool {
+        self.priority != (0..=u64::MAX)
+    }
+
+    /// Distinguishes filtered entries in the result cache; empty for NONE.
+    pub fn cache_key(&self) -> String {
+        if self.is_none() {
+            return String::new();
+        }
+        format!(
+            "{}\u{0}{}-{}",
+            self.category.as_deref().unwrap_or(""),
+            self.priority.start(),
+            self.priority.end()
+        )
+    }
+}
+
+// Fixed-size bitset over a segment's doc ids
+pub(crate) struct DocBits {
+    words: Vec<u64>,
+}
+
+impl DocBits {
+    fn with_max_doc(max_doc: DocId) -> Self {
+        DocBits { words: vec![0; (max_doc as usize + 63) / 64] }
+    }
+
+    fn insert(&mut self, doc: DocId) {
+        if let Some(word) = self.words.get_mut(doc as usize / 64) {
+            *word |= 1 << (doc % 64);
+        }
+    }
+
+    pub fn contains(&self, doc: DocId) -> bool {
+        self.words.get(doc as usize / 64).map_or(false, |word| word & (1 << (doc % 64)) != 0)
+    }
+
+    fn is_empty(&self) -> bool {
+        self.words.iter().all(|&word| word == 0)
+    }
+
+    fn iter(&self) -> impl Iterator<Item = DocId> + '_ {
+        self.words.iter().enumerate().flat_map(|(i, &word)| {
+            let mut rest = word;
+            std::iter::from_fn(move || {
+                if rest == 0 {
+                    return None;
+                }
+                let bit = rest.trailing_zeros();
+                rest &= rest - 1;
+                Some(i as DocId * 64 + bit)
+            })
+        })
+    }
+
+    fn bytes(&self) -> usize {
+        self.words.len() * 8
+    }
+}
+
+/// Documents of one segment that pass a filter, deleted ones included.
+pub(crate) enum SegmentSet {
+    All,
+    Docs(DocBits),
+}
+
+impl SegmentSet {
+    pub fn contains(&self, doc: DocId) -> bool {
+        match self {
+            SegmentSet::All => true,
+            SegmentSet::Docs(bits) => bits.contains(doc),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        matches!(self, SegmentSet::Docs(bits) if bits.is_empty())
+    }
+}
+
+/// A filter's sets for every segment of one generation.
+pub(crate) struct FilterSets {
+    filter: Filter,
+    generation: u64,
+    segments: Vec<SegmentSet>,
+}
+
+impl FilterSets {
+    fn build(searcher: &Searcher, fields: &SearchFields, filter: &Filter) -> tantivy::Result<FilterSets> {
+        let segments = searcher
+            .segment_readers()
+            .iter()
+            .map(|reader| segment_set(reader, fields, filter))
+            .collect::<tantivy::Result<_>>()?;
+        Ok(FilterSets { filter: filter.clone(), generation: searcher.generation().generation_id(), segments })
+    }
+
+    pub fn segment(&self, segment_ord: u32) -> &SegmentSet {
+        self.segments.get(segment_ord as usize).unwrap_or(&SegmentSet::All)
+    }
+
+    /// Heap bytes of the sets.
+    pub fn bytes(&self) -> usize {
+        self.segments
+            .iter()
+            .map(|set| match set {
+                SegmentSet::All => 0,
+                SegmentSet::Docs(bits) => bits.bytes(),
+            })
+            .sum()
+    }
+}
+
+fn segment_set(reader: &SegmentReader, fields: &SearchFields, filter: &Filter) -> tantivy::Result<SegmentSet> {
+    let max_doc = reader.max_doc();
+    let mut set = None;
+
+    if let Some(category) = &filter.category {
+        let mut docs = DocBits::with_max_doc(max_doc);
+        if let Some(field) = fields.category {
+            let term = Term::from_field_text(field, category);
+            if let Some(mut postings) = reader.inverted_index(field)?.read_postings(&term, IndexRecordOption::Basic)? {
+                let mut doc = postings.doc();
+                while doc != TERMINATED {
+                    docs.insert(doc);
+                    doc = postings.advance();
+                }
+            }
+        }
+        set = Some(docs);
+    }
+
+    if filter.bounds_priority() {
+        let mut docs = DocBits::with_max_doc(max_doc);
+        if let Ok(column) = reader.fast_fields().u64("priority") {
+            let mut in_range = Vec::new();
+            column.get_docids_for_value_range(filter.priority.clone(), 0..max_doc, &mut in_range);
+            for doc in in_range {
+                if set.as_ref().map_or(true, |category: &DocBits| category.contains(doc)) {
+                    docs.insert(doc);
+                }
+            }
+        }
+        set = Some(docs);
+    }
+
+    Ok(set.map_or(SegmentSet::All, SegmentSet::Docs))
+}
+
+/// Recently used filter sets of one service. Browse screens repeat a
+/// handful of filters, so after the first use each is a lookup.
+#[derive(Default)]
+pub(crate) struct FilterCache {
+    entries: Mutex<Vec<Arc<FilterSets>>>,
+}
+
+impl FilterCache {
+    /// The sets of `filter` for `searcher`'s generation, built on a miss.
+    /// None for an unfiltered search or if building fails.
+    pub fn get(&self, searcher: &Searcher, fields: &SearchFields, filter: &Filter) -> Option<Arc<FilterSets>> {
+        if filter.is_none() {
+            return None;
+        }
+        let generation = searcher.generation().generation_id();
+        {
+            let mut entries = self.entries.lock().ok()?;
+            // Sets of older generations are no use once a reload is searched
+            entries.retain(|sets| sets.generation >= generation);
+            if let Some(i) = entries.iter().position(|sets| sets.generation == generation && &sets.filter == filter) {
+                let sets = entries.remove(i);
+                entries.push(sets.clone());
+                return Some(sets);
+            }
+        }
+
+        // Built unlocked; a racing search may build the same sets
+        let sets = Arc::new(FilterSets::build(searcher, fields, filter).ok()?);
+        let mut entries = self.entries.lock().ok()?;
+        if entries.len() >= FILTER_CACHE_ENTRIES {
+            entries.remove(0);
+        }
+        entries.push(sets.clone());
+        Some(sets)
+    }
+
+    /// Heap bytes of the cached sets.
+    pub fn bytes(&self) -> usize {
+        self.entries.lock().map_or(0, |entries| entries.iter().map(|sets| sets.bytes()).sum())
+    }
+}
+
+/// Up to `limit` documents of `searcher` passing `sets` (every document
+/// without them), lowest priority value first, then in index order. No
+/// query runs and nothing is scored.
+pub(crate) fn browse(searcher: &Searcher, sets: Option<&FilterSets>, limit: usize) -> Vec<(u64, DocAddress)> {
+    let mut best: BinaryHeap<(u64, DocAddress)> = BinaryHeap::with_capacity(limit + 1);
+    if limit == 0 {
+        return Vec::new();
+    }
+    for (ord, reader) in searcher.segment_readers().iter().enumerate() {
+        let ord = ord as u32;
+        let set = sets.map_or(&SegmentSet::All, |s| s.segment(ord));
+        if set.is_empty() {
+            continue;
+        }
+        let priority = reader.fast_fields().u64("priority").ok();
+        let alive = reader.alive_bitset();
+        let mut offer = |doc: DocId| {
+            if alive.map_or(false, |bitset| !bitset.is_alive(doc)) {
+                return;
+            }
+            let value = priority.as_ref().and_then(|column| column.first(doc)).unwrap_or(u64::MAX);
+            let candidate = (value, DocAddress::new(ord, doc));
+            if best.len() < limit {
+                best.push(candidate);
+            } else if let Some(mut worst) = best.peek_mut() {
+                if candidate < *worst {
+                    *worst = candidate;
+                }
+            }
+        };
+        match set {
+            SegmentSet::All => (0..reader.max_doc()).for_each(&mut offer),
+            SegmentSet::Docs(bits) => bits.iter().for_each(&mut offer),
+        }
+    }
+    best.into_sorted_vec()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_doc_bits() {
+        let mut bits = DocBits::with_max_doc(130);
+        assert!(bits.is_empty());
+        for doc in [0, 63, 64, 129] {
+            bits.insert(doc);
+        }
+        // Out of range is ignored
+        bits.insert(1_000);
+        assert!(bits.contains(63) && bits.contains(64) && !bits.contains(65));
+        assert!(!bits.contains(1_000));
+        assert_eq!(bits.iter().collect::<Vec<_>>(), vec![0, 63, 64, 129]);
+        assert!(!bits.is_empty());
+    }
+
+    #[test]
+    fn test_filter_from_raw() {
+        assert_eq!(Filter::from_raw(std::ptr::null()), Some(Filter::NONE));
+        let category = std::ffi::CString::new("medical").unwrap();
+        let raw = SearchFilter { category: category.as_ptr(), priority_min: 0, priority_max: 1 };
+        let filter = Filter::from_raw(&raw).unwrap();
+        assert_eq!(filter.category.as_deref(), Some("medical"));
+        assert_eq!(filter.priority, 0..=1);
+        assert!(!filter.is_none());
+        assert_ne!(filter.cache_key(), Filter::NONE.cache_key());
+
+        let unbounded = SearchFilter { category: std::ptr::null(), priority_min: 0, priority_max: u32::MAX };
+        assert!(Filter::from_raw(&unbounded).unwrap().is_none());
+        assert!(Filter::NONE.cache_key().is_empty());
+    }
+
+    #[test]
+    fn test_filtered_browse() {
+        use tantivy::schema::{Schema, FAST, INDEXED, STORED, STRING};
+        use tantivy::{doc, Index};
+
+        let mut builder = Schema::builder();
+        let category = builder.add_text_field("category", STRING | STORED);
+        let priority = builder.add_u64_field("priority", INDEXED | STORED | FAST);
+        let schema = builder.build();
+        let index = Index::create_in_ram(schema.clone());
+        let mut writer: tantivy::IndexWriter = index.writer(15_000_000).unwrap();
+        for (c, p) in [("water", 3u64), ("medical", 2), ("medical", 0), ("water", 0), ("medical", 5)] {
+            writer.add_document(doc!(category => c, priority => p)).unwrap();
+        }
+        writer.commit().unwrap();
+        let searcher = index.reader().unwrap().searcher();
+        let fields = SearchFields::resolve(&schema);
+        let cache = FilterCache::default();
+
+        let medical = Filter { category: Some("medical".into()), priority: 0..=2 };
+        let sets = cache.get(&searcher, &fields, &medical).unwrap();
+        let docs: Vec<_> = browse(&searcher, Some(&sets), 10).into_iter().map(|(p, a)| (p, a.doc_id)).collect();
+        assert_eq!(docs, vec![(0, 2), (2, 1)]);
+        assert!(Arc::ptr_eq(&sets, &cache.get(&searcher, &fields, &medical).unwrap()));
+
+        let all: Vec<_> = browse(&searcher, None, 3).into_iter().map(|(p, a)| (p, a.doc_id)).collect();
+        assert_eq!(all, vec![(0, 2), (0, 3), (2, 1)]);
+        assert!(cache.get(&searcher, &fields, &Filter::NONE).is_none());
+    }
+}
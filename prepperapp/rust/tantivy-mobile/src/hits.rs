@@ -0,0 +1,218 @@
+// hits.rs - Two-phase search: lightweight hits first, stored fields on demand
+//
+// Phase one ranks documents by BM25 blended with priority (priority.rs) and
+// keeps only (segment, doc, score, priority), with priority read from the
+// FAST column rather than the docstore. Phase two hydrates a range of rows
+// into the packed layout from packed.rs, so only the rows a list is about
+// to show pay for docstore block decompression.
+
+use crate::ffi::{SearchFields, SearchService};
+use crate::packed::{buffer_from_raw, PackedRow, PackedWriter};
+use crate::priority::PriorityTopDocs;
+use crate::snippet::summary_or_snippet;
+use std::ffi::{c_char, CStr};
+use std::sync::Arc;
+use std::time::Duration;
+use tantivy::schema::Schema;
+use tantivy::{DocAddress, Score, Searcher, TantivyDocument};
+
+// A ranked hit, laid out for direct access from C (16 bytes)
+#[repr(C)]
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct SearchHit {
+    pub segment_ord: u32,
+    pub doc_id: u32,
+    pub score: f32,
+    pub priority: u32,
+}
+
+// The opaque phase-one result. It owns a Searcher, so hydration reads the
+// same index generation that produced the hits even if a reload happens.
+pub struct SearchHits {
+    searcher: Arc<Searcher>,
+    fields: SearchFields,
+    hits: Vec<SearchHit>,
+    search_time: Duration,
+}
+
+impl SearchHits {
+    pub(crate) fn collect(
+        searcher: Arc<Searcher>,
+        schema: &Schema,
+        top_docs: Vec<(Score, DocAddress)>,
+        search_time: Duration,
+    ) -> Self {
+        // One priority column per segment; missing columns read as 0
+        let priorities: Vec<_> = searcher
+            .segment_readers()
+            .iter()
+            .map(|segment| segment.fast_fields().u64("priority").ok())
+            .collect();
+
+        let hits = top_docs
+            .into_iter()
+            .map(|(score, address)| SearchHit {
+                segment_ord: address.segment_ord,
+                doc_id: address.doc_id,
+                score,
+                priority: priorities
+                    .get(address.segment_ord as usize)
+                    .and_then(|column| column.as_ref())
+                    .and_then(|column| column.first(address.doc_id))
+                    .unwrap_or(0) as u32,
+            })
+            .collect();
+
+        SearchHits {
+            searcher,
+            fields: SearchFields::resolve(schema),
+            hits,
+            search_time,
+        }
+    }
+
+    // Packs rows [start, start + count) into `buf`; returns the packed row
+    // count. The header's total_hits is the clamped range length, so a short
+    // count means the buffer was too small for the whole range.
+    fn hydrate(&self, start: usize, count: usize, buf: &mut [u8]) -> i32 {
+        let start = start.min(self.hits.len());
+        let range = &self.hits[start..start + count.min(self.hits.len() - start)];
+
+        let mut writer = match PackedWriter::new(buf, range.len()) {
+            Some(w) => w,
+            None => return -1,
+        };
+        let mut snippets = self.fields.snippets(&self.searcher);
+        for hit in range {
+            let address = DocAddress::new(hit.segment_ord, hit.doc_id);
+            let doc = match self.searcher.doc::<TantivyDocument>(address) {
+                Ok(d) => d,
+                Err(_) => return -1,
+            };
+            let row = PackedRow {
+                id: SearchFields::text(&doc, self.fields.id),
+                title: SearchFields::text(&doc, self.fields.title),
+                category: SearchFields::text(&doc, self.fields.category),
+                summary: summary_or_snippet(SearchFields::text(&doc, self.fields.summary), &mut snippets, address),
+                module: "",
+                priority: hit.priority,
+                score: hit.score,
+            };
+            if !writer.push(&row) {
+                break;
+            }
+        }
+        writer.finish(range.len(), self.search_time.as_millis() as u64)
+    }
+}
+
+/// Phase one of a two-phase search on a `SearchService`: ranks up to
+/// `limit` documents without touching the docstore.
+///
+/// # Safety
+/// `service_ptr` must be a valid pointer from `init_searcher` and `query_ptr`
+/// a valid, null-terminated C string. The result must be freed with
+/// `tantivy_hits_free`. Returns null on failure.
+#[no_mangle]
+pub extern "C" fn search_hits(
+    service_ptr: *const SearchService,
+    query_ptr: *const c_char,
+    limit: usize,
+) -> *mut SearchHits {
+    if service_ptr.is_null() || query_ptr.is_null() || limit == 0 {
+        return std::ptr::null_mut();
+    }
+
+    let service = unsafe { &*service_ptr };
+    let query_str = match unsafe { CStr::from_ptr(query_ptr) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let query = match service.query_parser.parse_query(query_str) {
+        Ok(q) => q,
+        Err(_) => return std::ptr::null_mut(),
+    };
+
+    let searcher = service.searcher();
+    let start = std::time::Instant::now();
+    let top_docs = match searcher.search(&query, &PriorityTopDocs::with_limit(limit)) {
+        Ok(td) => td,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let elapsed = start.elapsed();
+    service.queries.record(elapsed);
+
+    Box::into_raw(Box::new(SearchHits::collect(searcher, &service.schema, top_docs, elapsed)))
+}
+
+/// Number of hits in a phase-one result.
+#[no_mangle]
+pub extern "C" fn tantivy_hits_count(hits: *const SearchHits) -> usize {
+    if hits.is_null() {
+        return 0;
+    }
+    unsafe { &*hits }.hits.len()
+}
+
+/// The hits array, valid until `tantivy_hits_free`. Null when empty.
+#[no_mangle]
+pub extern "C" fn tantivy_hits_get(hits: *const SearchHits) -> *const SearchHit {
+    if hits.is_null() {
+        return std::ptr::null();
+    }
+    let hits = unsafe { &*hits };
+    if hits.hits.is_empty() {
+        std::ptr::null()
+    } else {
+        hits.hits.as_ptr()
+    }
+}
+
+/// Phase two: loads stored fields for hits [start, start + count) into a
+/// caller-owned buffer using the packed layout.
+/// Returns the number of packed rows, or -1 on failure.
+#[no_mangle]
+pub extern "C" fn tantivy_hits_hydrate(
+    hits: *const SearchHits,
+    start: usize,
+    count: usize,
+    buffer: *mut u8,
+    capacity: usize,
+) -> i32 {
+    if hits.is_null() {
+        return -1;
+    }
+    let buf = match unsafe { buffer_from_raw(buffer, capacity) } {
+        Some(b) => b,
+        None => return -1,
+    };
+    unsafe { &*hits }.hydrate(start, count, buf)
+}
+
+/// Frees a phase-one result.
+#[no_mangle]
+pub extern "C" fn tantivy_hits_free(hits: *mut SearchHits) {
+    if !hits.is_null() {
+        let _ = unsafe { Box::from_raw(hits) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_search_hit_layout() {
+        assert_eq!(std::mem::size_of::<SearchHit>(), 16);
+    }
+
+    #[test]
+    fn test_null_safety() {
+        assert!(search_hits(std::ptr::null(), std::ptr::null(), 10).is_null());
+        assert_eq!(tantivy_hits_count(std::ptr::null()), 0);
+        assert!(tantivy_hits_get(std::ptr::null()).is_null());
+        assert_eq!(tantivy_hits_hydrate(std::ptr::null(), 0, 10, std::ptr::null_mut(), 0), -1);
+
+        tantivy_hits_free(std::ptr::null_mut()); // Should not crash
+    }
+}
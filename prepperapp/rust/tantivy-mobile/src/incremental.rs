@@ -0,0 +1,589 @@
+// incremental.rs - Search-as-you-type sessions
+//
+// A session remembers the constraints of its last query (complete terms plus
+// a trailing prefix) and the per-segment candidate docs that satisfied them.
+// When the next query only extends the last one ("tour" -> "tourn", or
+// "tourn" -> "tourniquet appl"), candidates are narrowed by seeking the new
+// terms' postings instead of searching the index cold. Every call bumps the
+// session generation, so a query overtaken by the next keystroke abandons
+// its work at the next checkpoint. A prefix that expands to more dictionary
+// terms than are read leaves candidates out, so the next query regenerates
+// rather than narrowing that incomplete set.
+
+use crate::abi::TANTIVY_ERROR_CANCELLED;
+use crate::ffi::SearchFields;
+use crate::packed::{buffer_from_raw, PackedRow, PackedWriter};
+use crate::snippet::summary_or_snippet;
+use std::ffi::{c_char, CStr};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, RwLock};
+use tantivy::schema::{Field, FieldType, IndexRecordOption, Schema};
+use tantivy::tokenizer::TokenStream;
+use tantivy::{DocAddress, DocId, DocSet, IndexReader, Searcher, SegmentReader, TantivyDocument, Term, TERMINATED};
+
+// Fields matched by incremental queries and their score contribution
+const MATCH_FIELDS: [(&str, f32); 4] = [("title", 2.0), ("summary", 1.0), ("content", 0.5), ("body", 0.5)];
+
+// Dictionary terms a prefix may expand to, per field and segment
+const MAX_PREFIX_EXPANSIONS: usize = 128;
+
+/// Where a session gets the current searcher from on each query.
+pub trait SearcherSource: Send + Sync {
+    fn searcher(&self) -> Option<Arc<Searcher>>;
+}
+
+impl SearcherSource for RwLock<IndexReader> {
+    fn searcher(&self) -> Option<Arc<Searcher>> {
+        self.read().ok().map(|reader| Arc::new(reader.searcher()))
+    }
+}
+
+#[derive(Clone, Debug, PartialEq)]
+struct Constraint {
+    text: String,
+    prefix: bool,
+}
+
+impl Constraint {
+    // True when every doc matching `next` also matches `self`
+    fn covers(&self, next: &Constraint) -> bool {
+        if self.prefix {
+            next.text.starts_with(&self.text)
+        } else {
+            !next.prefix && next.text == self.text
+        }
+    }
+}
+
+// A candidate doc. `last` is the contribution of a trailing prefix, which is
+// recomputed when the prefix grows; `base` covers the complete terms.
+#[derive(Clone, Copy)]
+struct Candidate {
+    doc: DocId,
+    base: f32,
+    last: f32,
+}
+
+struct SessionState {
+    searcher: Option<Arc<Searcher>>,
+    constraints: Vec<Constraint>,
+    // Per segment, sorted by doc
+    candidates: Vec<Vec<Candidate>>,
+    // A prefix expansion was cut off, so the candidates may be incomplete
+    truncated: bool,
+}
+
+struct Cancelled;
+
+// The opaque session handle
+pub struct SearchSession {
+    source: Arc<dyn SearcherSource>,
+    generation: AtomicU64,
+    state: Mutex<SessionState>,
+}
+
+impl SearchSession {
+    pub fn new(source: Arc<dyn SearcherSource>) -> Self {
+        SearchSession {
+            source,
+            generation: AtomicU64::new(0),
+            state: Mutex::new(SessionState {
+                searcher: None,
+                constraints: Vec::new(),
+                candidates: Vec::new(),
+                truncated: false,
+            }),
+        }
+    }
+
+    fn check(&self, generation: u64) -> Result<(), Cancelled> {
+        if self.generation.load(Ordering::Acquire) == generation {
+            Ok(())
+        } else {
+            Err(Cancelled)
+        }
+    }
+
+    fn search(&self, query: &str, limit: usize, buf: &mut [u8]) -> i32 {
+        let start = std::time::Instant::now();
+        // Claim the newest generation before waiting on the state, so the
+        // query currently holding it sees it is stale and bails out
+        let generation = self.generation.fetch_add(1, Ordering::AcqRel) + 1;
+        let mut state = match self.state.lock() {
+            Ok(s) => s,
+            Err(_) => return -1,
+        };
+        if self.check(generation).is_err() {
+            return TANTIVY_ERROR_CANCELLED;
+        }
+        let searcher = match self.source.searcher() {
+            Some(s) => s,
+            None => return -1,
+        };
+
+        let searchable = searchable_fields(searcher.schema());
+        let constraints = match parse_constraints(&searcher, &searchable, query) {
+            Some(c) => c,
+            None => return -1,
+        };
+
+        match self.update(&mut state, searcher, &searchable, constraints, generation) {
+            Ok(()) => {}
+            Err(Cancelled) => {
+                // Partially narrowed candidates are unusable
+                state.constraints.clear();
+                state.candidates.clear();
+                state.truncated = false;
+                return TANTIVY_ERROR_CANCELLED;
+            }
+        }
+        pack_top(&state, limit, buf, start)
+    }
+
+    fn update(
+        &self,
+        state: &mut SessionState,
+        searcher: Arc<Searcher>,
+        searchable: &[(Field, f32)],
+        constraints: Vec<Constraint>,
+        generation: u64,
+    ) -> Result<(), Cancelled> {
+        let same_generation = state
+            .searcher
+            .as_ref()
+            .map_or(false, |s| s.generation().generation_id() == searcher.generation().generation_id());
+        let old = &state.constraints;
+        let narrowable = same_generation
+            && !state.truncated
+            && !old.is_empty()
+            && constraints.len() >= old.len()
+            && old.iter().zip(&constraints).all(|(a, b)| a.covers(b));
+
+        let mut truncated = false;
+        let first_new = if narrowable {
+            // A trailing prefix is re-applied with the (longer) new text
+            let replace = old.last().map_or(false, |c| c.prefix) && old.last() != constraints.get(old.len() - 1);
+            if replace { old.len() - 1 } else { old.len() }
+        } else {
+            state.candidates = match constraints.first() {
+                Some(first) => searcher
+                    .segment_readers()
+                    .iter()
+                    .map(|segment| {
+                        self.check(generation)?;
+                        generate(segment, searchable, first, &mut truncated)
+                    })
+                    .collect::<Result<_, _>>()?,
+                None => Vec::new(),
+            };
+            1
+        };
+
+        for (position, constraint) in constraints.iter().enumerate().skip(first_new) {
+            let replace_last = narrowable && position + 1 == state.constraints.len();
+            for (segment, candidates) in searcher.segment_readers().iter().zip(state.candidates.iter_mut()) {
+                self.check(generation)?;
+                narrow(segment, searchable, constraint, candidates, replace_last, &mut truncated, || {
+                    self.check(generation)
+                })?;
+            }
+        }
+
+        state.searcher = Some(searcher);
+        state.constraints = constraints;
+        state.truncated = truncated;
+        Ok(())
+    }
+}
+
+// Indexed text fields from MATCH_FIELDS present in this schema
+fn searchable_fields(schema: &Schema) -> Vec<(Field, f32)> {
+    MATCH_FIELDS
+        .iter()
+        .filter_map(|(name, boost)| {
+            let field = schema.get_field(name).ok()?;
+            match schema.get_field_entry(field).field_type() {
+                FieldType::Str(options) if options.get_indexing_options().is_some() => Some((field, *boost)),
+                _ => None,
+            }
+        })
+        .collect()
+}
+
+// Tokenizes with the first searchable field's analyzer. The last token is a
+// prefix unless the query ends on a separator.
+fn parse_constraints(searcher: &Searcher, searchable: &[(Field, f32)], query: &str) -> Option<Vec<Constraint>> {
+    let (field, _) = searchable.first()?;
+    let mut analyzer = searcher.index().tokenizer_for_field(*field).ok()?;
+    let mut tokens = Vec::new();
+    let mut stream = analyzer.token_stream(query);
+    while stream.advance() {
+        tokens.push(stream.token().text.clone());
+    }
+
+    let open_ended = query.chars().last().map_or(false, char::is_alphanumeric);
+    let count = tokens.len();
+    Some(
+        tokens
+            .into_iter()
+            .enumerate()
+            .map(|(i, text)| Constraint { text, prefix: open_ended && i + 1 == count })
+            .collect(),
+    )
+}
+
+// Smallest key greater than every key starting with `prefix`, or None if
+// the prefix is all 0xFF
+fn prefix_upper_bound(prefix: &[u8]) -> Option<Vec<u8>> {
+    let mut upper = prefix.to_vec();
+    while let Some(last) = upper.pop() {
+        if last < 0xFF {
+            upper.push(last + 1);
+            return Some(upper);
+        }
+    }
+    None
+}
+
+// Postings for every dictionary term matching the constraint in one field.
+// Sets `truncated` when a prefix matches more than MAX_PREFIX_EXPANSIONS terms.
+fn for_each_postings(
+    segment: &SegmentReader,
+    field: Field,
+    constraint: &Constraint,
+    truncated: &mut bool,
+    mut visit: impl FnMut(&mut dyn DocSet) -> Result<(), Cancelled>,
+) -> Result<(), Cancelled> {
+    let inverted = match segment.inverted_index(field) {
+        Ok(i) => i,
+        Err(_) => return Ok(()),
+    };
+
+    let mut term_infos = Vec::new();
+    if constraint.prefix {
+        let bytes = constraint.text.as_bytes();
+        let mut range = inverted.terms().range().ge(bytes);
+        if let Some(upper) = prefix_upper_bound(bytes) {
+            range = range.lt(upper);
+        }
+        if let Ok(mut stream) = range.into_stream() {
+            while stream.advance() {
+                if term_infos.len() == MAX_PREFIX_EXPANSIONS {
+                    *truncated = true;
+                    break;
+                }
+                term_infos.push(stream.value().clone());
+            }
+        }
+    } else if let Ok(Some(info)) = inverted.get_term_info(&Term::from_field_text(field, &constraint.text)) {
+        term_infos.push(info);
+    }
+
+    for info in &term_infos {
+        if let Ok(mut postings) = inverted.read_postings_from_terminfo(info, IndexRecordOption::Basic) {
+            visit(&mut postings)?;
+        }
+    }
+    Ok(())
+}
+
+// Cold start: every live doc matching the constraint in any field
+fn generate(
+    segment: &SegmentReader,
+    searchable: &[(Field, f32)],
+    constraint: &Constraint,
+    truncated: &mut bool,
+) -> Result<Vec<Candidate>, Cancelled> {
+    let mut scored: Vec<(DocId, f32)> = Vec::new();
+    for &(field, boost) in searchable {
+        let mut docs = Vec::new();
+        for_each_postings(segment, field, constraint, truncated, |postings| {
+            let mut doc = postings.doc();
+            while doc != TERMINATED {
+                docs.push(doc);
+                doc = postings.advance();
+            }
+            Ok(())
+        })?;
+        docs.sort_unstable();
+        docs.dedup();
+        scored.extend(docs.into_iter().map(|doc| (doc, boost)));
+    }
+    scored.sort_unstable_by_key(|&(doc, _)| doc);
+
+    let alive = segment.alive_bitset();
+    let mut candidates: Vec<Candidate> = Vec::new();
+    for (doc, score) in scored {
+        if alive.map_or(false, |bits| bits.is_deleted(doc)) {
+            continue;
+        }
+        match candidates.last_mut() {
+            Some(last) if last.doc == doc => add(last, score, constraint.prefix),
+            _ => {
+                let mut candidate = Candidate { doc, base: 0.0, last: 0.0 };
+                add(&mut candidate, score, constraint.prefix);
+                candidates.push(candidate);
+            }
+        }
+    }
+    Ok(candidates)
+}
+
+fn add(candidate: &mut Candidate, score: f32, prefix: bool) {
+    if prefix {
+        candidate.last += score;
+    } else {
+        candidate.base += score;
+    }
+}
+
+// Keeps the candidates that also match `constraint`, seeking each term's
+// postings to the candidate docs rather than walking them fully
+fn narrow(
+    segment: &SegmentReader,
+    searchable: &[(Field, f32)],
+    constraint: &Constraint,
+    candidates: &mut Vec<Candidate>,
+    replace_last: bool,
+    truncated: &mut bool,
+    check: impl Fn() -> Result<(), Cancelled>,
+) -> Result<(), Cancelled> {
+    let mut contribution = vec![0.0f32; candidates.len()];
+    let mut matched = vec![false; candidates.len()];
+    for &(field, boost) in searchable {
+        matched.iter_mut().for_each(|m| *m = false);
+        for_each_postings(segment, field, constraint, truncated, |postings| {
+            check()?;
+            let mut doc = postings.doc();
+            for (i, candidate) in candidates.iter().enumerate() {
+                // Seeking backwards is not allowed; an overshoot skips ahead
+                if doc < candidate.doc {
+                    doc = postings.seek(candidate.doc);
+                }
+                if doc == TERMINATED {
+                    break;
+                }
+                if doc == candidate.doc {
+                    matched[i] = true;
+                }
+            }
+            Ok(())
+        })?;
+        for (total, hit) in contribution.iter_mut().zip(&matched) {
+            if *hit {
+                *total += boost;
+            }
+        }
+    }
+
+    let mut scores = contribution.into_iter();
+    candidates.retain_mut(|candidate| {
+        let score = scores.next().unwrap_or(0.0);
+        if score == 0.0 {
+            return false;
+        }
+        // The previous prefix is either replaced or now part of the base
+        if !replace_last {
+            candidate.base += candidate.last;
+        }
+        candidate.last = 0.0;
+        add(candidate, score, constraint.prefix);
+        true
+    });
+    Ok(())
+}
+
+// Ranks candidates by score, then priority (0 first), and packs the top
+// `limit`. A doc without a priority value ranks after every priority.
+fn pack_top(state: &SessionState, limit: usize, buf: &mut [u8], start: std::time::Instant) -> i32 {
+    let searcher = match &state.searcher {
+        Some(s) => s,
+        None => return -1,
+    };
+
+    let mut ranked: Vec<(f32, u64, DocAddress)> = Vec::new();
+    for (ord, (segment, candidates)) in searcher.segment_readers().iter().zip(&state.candidates).enumerate() {
+        let priority = segment.fast_fields().u64("priority").ok();
+        ranked.extend(candidates.iter().map(|c| {
+            let p = priority.as_ref().and_then(|column| column.first(c.doc)).unwrap_or(u64::MAX);
+            (c.base + c.last, p, DocAddress::new(ord as u32, c.doc))
+        }));
+    }
+    let total_hits = ranked.len();
+    let by_rank = |a: &(f32, u64, DocAddress), b: &(f32, u64, DocAddress)| {
+        b.0.total_cmp(&a.0).then(a.1.cmp(&b.1)).then(a.2.cmp(&b.2))
+    };
+    if limit < ranked.len() {
+        if limit > 0 {
+            ranked.select_nth_unstable_by(limit - 1, by_rank);
+        }
+        ranked.truncate(limit);
+    }
+    ranked.sort_unstable_by(by_rank);
+
+    let fields = SearchFields::resolve(searcher.schema());
+    let mut writer = match PackedWriter::new(buf, ranked.len()) {
+        Some(w) => w,
+        None => return -1,
+    };
+    let mut snippets = fields.snippets(searcher);
+    for &(score, priority, address) in &ranked {
+        let doc = match searcher.doc::<TantivyDocument>(address) {
+            Ok(d) => d,
+            Err(_) => continue,
+        };
+        let row = PackedRow {
+            id: SearchFields::text(&doc, fields.id),
+            title: SearchFields::text(&doc, fields.title),
+            category: SearchFields::text(&doc, fields.category),
+            summary: summary_or_snippet(SearchFields::text(&doc, fields.summary), &mut snippets, address),
+            module: "",
+            // Saturates, so a missing priority reads as u32::MAX
+            priority: priority.min(u32::MAX as u64) as u32,
+            score,
+        };
+        if !writer.push(&row) {
+            break;
+        }
+    }
+    writer.finish(total_hits.min(limit), start.elapsed().as_millis() as u64)
+}
+
+/// Runs one keystroke of a search-as-you-type session, writing the top
+/// `limit` hits into a caller-owned buffer using the packed layout.
+/// Returns the number of packed rows, TANTIVY_ERROR_CANCELLED when a newer
+/// call on the same session superseded this one, or -1 on failure.
+#[no_mangle]
+pub extern "C" fn tantivy_search_incremental(
+    session: *const SearchSession,
+    query: *const c_char,
+    limit: usize,
+    buffer: *mut u8,
+    capacity: usize,
+) -> i32 {
+    if session.is_null() || query.is_null() {
+        return -1;
+    }
+    let buf = match unsafe { buffer_from_raw(buffer, capacity) } {
+        Some(b) => b,
+        None => return -1,
+    };
+    let query_str = match unsafe { CStr::from_ptr(query) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -1,
+    };
+    unsafe { &*session }.search(query_str, limit, buf)
+}
+
+/// Abandons the session's in-flight query, if any.
+#[no_mangle]
+pub extern "C" fn tantivy_incremental_cancel(session: *const SearchSession) {
+    if !session.is_null() {
+        unsafe { &*session }.generation.fetch_add(1, Ordering::AcqRel);
+    }
+}
+
+/// Frees a session. No call on it may be in flight.
+#[no_mangle]
+pub extern "C" fn tantivy_incremental_free(session: *mut SearchSession) {
+    if !session.is_null() {
+        let _ = unsafe { Box::from_raw(session) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn constraint(text: &str, prefix: bool) -> Constraint {
+        Constraint { text: text.to_string(), prefix }
+    }
+
+    #[test]
+    fn test_covers() {
+        assert!(constraint("tour", true).covers(&constraint("tourn", true)));
+        assert!(constraint("tour", true).covers(&constraint("tourniquet", false)));
+        assert!(constraint("burn", false).covers(&constraint("burn", false)));
+        assert!(!constraint("burn", false).covers(&constraint("burns", true)));
+        assert!(!constraint("tourn", true).covers(&constraint("tour", true)));
+    }
+
+    #[test]
+    fn test_prefix_upper_bound() {
+        assert_eq!(prefix_upper_bound(b"tour"), Some(b"tous".to_vec()));
+        assert_eq!(prefix_upper_bound(&[b'a', 0xFF]), Some(vec![b'b']));
+        assert_eq!(prefix_upper_bound(&[0xFF]), None);
+    }
+
+    #[test]
+    fn test_narrows_and_regenerates_truncated_prefixes() {
+        use tantivy::schema::{STORED, STRING, TEXT};
+        use tantivy::{doc, Index};
+
+        let mut builder = Schema::builder();
+        let id = builder.add_text_field("id", STRING | STORED);
+        let title = builder.add_text_field("title", TEXT | STORED);
+        let index = Index::create_in_ram(builder.build());
+        let mut writer: tantivy::IndexWriter = index.writer(15_000_000).unwrap();
+        // More "t" terms than one prefix expands to, all before "tourniquet"
+        for i in 0..200 {
+            writer.add_document(doc!(id => format!("filler-{i}"), title => format!("ta{i:03}"))).unwrap();
+        }
+        for (i, text) in ["tourniquet application", "tourniquet wrap", "tourniquet apply"].iter().enumerate() {
+            writer.add_document(doc!(id => format!("med-{i}"), title => *text)).unwrap();
+        }
+        writer.commit().unwrap();
+
+        let reader: Arc<dyn SearcherSource> = Arc::new(RwLock::new(index.reader().unwrap()));
+        let session = SearchSession::new(reader);
+        let mut buf = vec![0u8; 64 * 1024];
+        assert_eq!(session.search("t", 10, &mut buf), 10);
+        assert!(session.state.lock().unwrap().truncated);
+        // Regenerated, since "t" left the tourniquet docs out
+        assert_eq!(session.search("to", 10, &mut buf), 3);
+        assert!(!session.state.lock().unwrap().truncated);
+        assert_eq!(session.search("tourn", 10, &mut buf), 3);
+        // "apply" postings overshoot the "wrap" candidate before matching
+        assert_eq!(session.search("tourniquet appl", 10, &mut buf), 2);
+        assert_eq!(session.search("tourniquet appli", 10, &mut buf), 1);
+    }
+
+    #[test]
+    fn test_ties_rank_critical_first() {
+        use crate::packed::{PACKED_HEADER_SIZE, PACKED_ROW_SIZE};
+        use tantivy::schema::{FAST, STORED, STRING, TEXT};
+        use tantivy::{doc, Index};
+
+        let mut builder = Schema::builder();
+        let id = builder.add_text_field("id", STRING | STORED);
+        let title = builder.add_text_field("title", TEXT | STORED);
+        let priority = builder.add_u64_field("priority", STORED | FAST);
+        let index = Index::create_in_ram(builder.build());
+        let mut writer: tantivy::IndexWriter = index.writer(15_000_000).unwrap();
+        writer.add_document(doc!(id => "routine", title => "burn care", priority => 3u64)).unwrap();
+        writer.add_document(doc!(id => "unranked", title => "burn care")).unwrap();
+        writer.add_document(doc!(id => "critical", title => "burn care", priority => 0u64)).unwrap();
+        writer.commit().unwrap();
+
+        let reader: Arc<dyn SearcherSource> = Arc::new(RwLock::new(index.reader().unwrap()));
+        let session = SearchSession::new(reader);
+        let mut buf = vec![0u8; 4096];
+        assert_eq!(session.search("burn care", 10, &mut buf), 3);
+        let read_u32 = |at: usize| u32::from_le_bytes(buf[at..at + 4].try_into().unwrap()) as usize;
+        let pool = read_u32(12);
+        let ids: Vec<&[u8]> = (0..3)
+            .map(|row| {
+                let at = PACKED_HEADER_SIZE + row * PACKED_ROW_SIZE;
+                &buf[pool + read_u32(at)..pool + read_u32(at) + read_u32(at + 4)]
+            })
+            .collect();
+        assert_eq!(ids, vec![&b"critical"[..], b"routine", b"unranked"]);
+    }
+
+    #[test]
+    fn test_null_safety() {
+        assert_eq!(tantivy_search_incremental(std::ptr::null(), std::ptr::null(), 10, std::ptr::null_mut(), 0), -1);
+        tantivy_incremental_cancel(std::ptr::null());
+        tantivy_incremental_free(std::ptr::null_mut()); // Should not crash
+    }
+}
@@ -0,0 +1,176 @@
+// lazy.rs - Modules registered up front and opened in the background
+//
+// Opening a module reads its meta.json and maps every segment file, so
+// opening all installed content before the first search makes startup
+// grow with the library. A registered module is only a name, a path and a
+// tier until the loader thread opens it, lowest tier first; searches cover
+// whatever is open and report the rest as pending. Under memory pressure
+// registered modules are closed again, least recently searched first, and
+// reopened when a search asks for them by name.
+
+use crate::thread_pool::ThreadHints;
+use std::cmp::Reverse;
+use std::collections::{BinaryHeap, HashMap};
+use std::ffi::CString;
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::JoinHandle;
+
+// States reported by multi_manager_module_state
+pub const TANTIVY_MODULE_PENDING: i32 = 0;
+pub const TANTIVY_MODULE_READY: i32 = 1;
+pub const TANTIVY_MODULE_UNLOADED: i32 = 2;
+pub const TANTIVY_MODULE_FAILED: i32 = 3;
+
+// A module registered for background opening. The slot is assigned at
+// registration and kept while the module is closed and reopened, so option
+// masks built before it opens stay valid.
+pub(crate) struct Registration {
+    pub path: CString,
+    pub tier: u32,
+    pub docstore_cache_bytes: u64,
+    pub slot: usize,
+    pub state: i32,
+    // Distinguishes registrations of the same name, so an open started for
+    // an earlier one is never published over a later one
+    pub generation: u64,
+}
+
+pub(crate) type Registry = HashMap<String, Registration>;
+
+// Opens waiting for the loader: (rank, order queued, name), smallest
+// first. Rank 0 is a reopen a search asked for, tier n ranks n + 1.
+struct LoaderQueue {
+    queued: BinaryHeap<Reverse<(u32, u64, String)>>,
+    next_seq: u64,
+    shutdown: bool,
+}
+
+struct LoaderShared {
+    queue: Mutex<LoaderQueue>,
+    wake: Condvar,
+}
+
+// The thread opening registered modules, one at a time
+pub(crate) struct ModuleLoader {
+    shared: Arc<LoaderShared>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl ModuleLoader {
+    /// Starts the loader thread, which calls `open` with each queued name.
+    /// A name queued twice is opened once; `open` skips modules that are no
+    /// longer pending.
+    pub(crate) fn spawn<F>(hints: ThreadHints, open: F) -> Option<Self>
+    where
+        F: Fn(&str) + Send + 'static,
+    {
+        let shared = Arc::new(LoaderShared {
+            queue: Mutex::new(LoaderQueue { queued: BinaryHeap::new(), next_seq: 0, shutdown: false }),
+            wake: Condvar::new(),
+        });
+
+        let thread = {
+            let shared = shared.clone();
+            std::thread::Builder::new()
+                .name("tantivy-module-open".into())
+                .spawn(move || {
+                    hints.apply();
+                    while let Some(name) = shared.next() {
+                        open(&name);
+                    }
+                })
+                .ok()?
+        };
+
+        Some(ModuleLoader { shared, thread: Some(thread) })
+    }
+
+    /// Queues an open of `name` behind every module of a lower tier.
+    pub(crate) fn enqueue(&self, name: &str, tier: u32) {
+        self.push(tier.saturating_add(1), name);
+    }
+
+    /// Queues an open a search is waiting for, ahead of every tier.
+    pub(crate) fn enqueue_demand(&self, name: &str) {
+        self.push(0, name);
+    }
+
+    fn push(&self, rank: u32, name: &str) {
+        if let Ok(mut queue) = self.shared.queue.lock() {
+            let seq = queue.next_seq;
+            queue.next_seq += 1;
+            queue.queued.push(Reverse((rank, seq, name.to_string())));
+            self.shared.wake.notify_one();
+        }
+    }
+}
+
+impl LoaderShared {
+    // Blocks for the next name to open; None once shut down
+    fn next(&self) -> Option<String> {
+        let mut queue = self.queue.lock().ok()?;
+        loop {
+            if queue.shutdown {
+                return None;
+            }
+            if let Some(Reverse((_, _, name))) = queue.queued.pop() {
+                return Some(name);
+            }
+            queue = self.wake.wait(queue).ok()?;
+        }
+    }
+}
+
+impl Drop for ModuleLoader {
+    fn drop(&mut self) {
+        if let Ok(mut queue) = self.shared.queue.lock() {
+            queue.shutdown = true;
+        }
+        self.shared.wake.notify_all();
+        // Waits for at most the open in flight
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::thread_pool::multi_manager_options_default;
+    use std::sync::mpsc;
+
+    #[test]
+    fn test_opens_lowest_tier_first() {
+        let (tx, rx) = mpsc::channel();
+        let (gate_tx, gate_rx) = mpsc::channel::<()>();
+        let gate = Mutex::new(gate_rx);
+        let loader = ModuleLoader::spawn(multi_manager_options_default().hints(), move |name| {
+            tx.send(name.to_string()).unwrap();
+            // Hold the first open until everything else is queued
+            if name == "first" {
+                let _ = gate.lock().unwrap().recv();
+            }
+        })
+        .unwrap();
+
+        loader.enqueue("first", 1);
+        assert_eq!(rx.recv().unwrap(), "first");
+        loader.enqueue("maps", 3);
+        loader.enqueue("medical", 0);
+        loader.enqueue("survival", 2);
+        loader.enqueue_demand("wikipedia");
+        gate_tx.send(()).unwrap();
+
+        let opened: Vec<String> = (0..4).map(|_| rx.recv().unwrap()).collect();
+        assert_eq!(opened, vec!["wikipedia", "medical", "survival", "maps"]);
+        drop(loader); // Joins
+    }
+
+    #[test]
+    fn test_drop_with_queued_opens() {
+        let loader = ModuleLoader::spawn(multi_manager_options_default().hints(), |_| {}).unwrap();
+        loader.enqueue("a", 1);
+        drop(loader); // Should not hang
+    }
+}
@@ -1,19 +1,35 @@
+// legacy.rs - Single-index API: create, build and search one index
+//
+// The original PrepperApp entry points, behind a `void*` index handle:
+// document ingestion (single and batched) through one shared writer,
+// struct, arena, packed and two-phase searches, incremental sessions and
+// stats. Module search for the app goes through multi_search.rs instead.
+
 use libc::{c_char, c_void};
-use serde::{Deserialize, Serialize};
 use std::ffi::{CStr, CString};
 use std::ptr;
-use std::sync::{Arc, RwLock};
-use tantivy::collector::TopDocs;
+use std::sync::{Arc, Mutex, RwLock};
 use tantivy::query::QueryParser;
 use tantivy::schema::*;
-use tantivy::{doc, Document, Index, IndexReader, IndexWriter, ReloadPolicy};
-
-// Error codes
-const SUCCESS: i32 = 0;
-const ERROR_INVALID_PARAM: i32 = -1;
-const ERROR_INDEX_CREATION: i32 = -2;
-const ERROR_SEARCH_FAILED: i32 = -3;
-const ERROR_INDEXING_FAILED: i32 = -4;
+use tantivy::{doc, DocAddress, Index, IndexReader, IndexWriter, ReloadPolicy, Score, Searcher, TantivyDocument};
+
+use crate::abi::{TANTIVY_ERROR_INDEXING_FAILED, TANTIVY_ERROR_INVALID_PARAM, TANTIVY_ERROR_SEARCH_FAILED, TANTIVY_SUCCESS};
+use crate::batch::{BatchDocument, BatchReader};
+use crate::cache::{CacheKey, ResultCache, DEFAULT_RESULT_CACHE_BYTES};
+use crate::ffi::{index_bytes, searcher_footprint, SearchFields, TANTIVY_OPEN_DEFAULT, TANTIVY_OPEN_MMAP_ADVISED};
+use crate::mmap_advice::{AdvisedDirectory, PageOut};
+use crate::multi_search::{TANTIVY_TRIM_CRITICAL, TANTIVY_TRIM_MODERATE};
+use crate::hits::SearchHits;
+use crate::incremental::SearchSession;
+use crate::packed::{buffer_from_raw, PackedRow, PackedWriter};
+use crate::priority::PriorityTopDocs;
+use crate::stats::{IndexStats, QueryStats};
+
+const WRITER_HEAP_BYTES: usize = 50_000_000;
+
+// Default auto-commit thresholds for batch ingestion (0 disables a threshold)
+const DEFAULT_COMMIT_EVERY_DOCS: usize = 10_000;
+const DEFAULT_COMMIT_EVERY_BYTES: usize = 32 * 1024 * 1024;
 
 // Search result structure
 #[repr(C)]
@@ -33,32 +49,181 @@ pub struct SearchResults {
     pub search_time_ms: u64,
 }
 
+// Reusable result arena. All strings of one result set live in a single
+// NUL-separated slab, and every buffer keeps its capacity across searches,
+// so a steady stream of queries stops hitting malloc/free.
+pub struct SearchResultArena {
+    slab: Vec<u8>,
+    spans: Vec<[usize; 4]>,
+    rows: Vec<SearchResult>,
+    header: SearchResults,
+}
+
+impl SearchResultArena {
+    fn with_capacity(slab_bytes: usize) -> Self {
+        SearchResultArena {
+            slab: Vec::with_capacity(slab_bytes),
+            spans: Vec::new(),
+            rows: Vec::new(),
+            header: SearchResults {
+                results: ptr::null_mut(),
+                count: 0,
+                search_time_ms: 0,
+            },
+        }
+    }
+
+    fn reset(&mut self) {
+        self.slab.clear();
+        self.spans.clear();
+        self.rows.clear();
+        self.header.results = ptr::null_mut();
+        self.header.count = 0;
+        self.header.search_time_ms = 0;
+    }
+
+    fn push_str(&mut self, s: &str) -> usize {
+        let start = self.slab.len();
+        self.slab.extend_from_slice(s.as_bytes());
+        self.slab.push(0);
+        start
+    }
+
+    fn push(&mut self, id: &str, title: &str, category: &str, summary: &str, priority: u64, score: f32) {
+        let spans = [
+            self.push_str(id),
+            self.push_str(title),
+            self.push_str(category),
+            self.push_str(summary),
+        ];
+        self.spans.push(spans);
+        self.rows.push(SearchResult {
+            id: ptr::null_mut(),
+            title: ptr::null_mut(),
+            category: ptr::null_mut(),
+            summary: ptr::null_mut(),
+            priority,
+            score,
+        });
+    }
+
+    // Point rows into the slab once it has stopped growing
+    fn finish(&mut self, search_time_ms: u64) -> *const SearchResults {
+        let base = self.slab.as_mut_ptr() as *mut c_char;
+        for (row, spans) in self.rows.iter_mut().zip(&self.spans) {
+            unsafe {
+                row.id = base.add(spans[0]);
+                row.title = base.add(spans[1]);
+                row.category = base.add(spans[2]);
+                row.summary = base.add(spans[3]);
+            }
+        }
+        self.header.results = self.rows.as_mut_ptr();
+        self.header.count = self.rows.len();
+        self.header.search_time_ms = search_time_ms;
+        &self.header
+    }
+}
+
+// Writer shared by single-document and batch ingestion. It is opened on the
+// first add and kept until the index is freed, so documents accumulate in one
+// writer instead of opening (and locking) a new one per call.
+struct WriterState {
+    writer: Option<IndexWriter>,
+    pending_docs: usize,
+    pending_bytes: usize,
+    commit_every_docs: usize,
+    commit_every_bytes: usize,
+}
+
+impl WriterState {
+    fn new() -> Self {
+        WriterState {
+            writer: None,
+            pending_docs: 0,
+            pending_bytes: 0,
+            commit_every_docs: DEFAULT_COMMIT_EVERY_DOCS,
+            commit_every_bytes: DEFAULT_COMMIT_EVERY_BYTES,
+        }
+    }
+
+    fn writer(&mut self, index: &Index) -> Option<&mut IndexWriter> {
+        if self.writer.is_none() {
+            self.writer = index.writer(WRITER_HEAP_BYTES).ok();
+        }
+        self.writer.as_mut()
+    }
+
+    // Record an added document; returns true once a commit threshold is hit
+    fn record(&mut self, bytes: usize) -> bool {
+        self.pending_docs += 1;
+        self.pending_bytes += bytes;
+        (self.commit_every_docs > 0 && self.pending_docs >= self.commit_every_docs)
+            || (self.commit_every_bytes > 0 && self.pending_bytes >= self.commit_every_bytes)
+    }
+}
+
+// Field handles of the PrepperApp schema, shared with the on-device writer
+pub(crate) struct DocumentFields {
+    pub id: Field,
+    title: Field,
+    category: Field,
+    priority: Field,
+    summary: Field,
+    content: Field,
+}
+
+impl DocumentFields {
+    pub(crate) fn resolve(schema: &Schema) -> Option<Self> {
+        Some(DocumentFields {
+            id: schema.get_field("id").ok()?,
+            title: schema.get_field("title").ok()?,
+            category: schema.get_field("category").ok()?,
+            priority: schema.get_field("priority").ok()?,
+            summary: schema.get_field("summary").ok()?,
+            content: schema.get_field("content").ok()?,
+        })
+    }
+
+    pub(crate) fn build(&self, doc: &BatchDocument) -> TantivyDocument {
+        doc!(
+            self.id => doc.id,
+            self.title => doc.title,
+            self.category => doc.category,
+            self.priority => doc.priority,
+            self.summary => doc.summary,
+            self.content => doc.content
+        )
+    }
+}
+
+// One loaded search result, shared by every result format
+struct ResultRow {
+    id: String,
+    title: String,
+    category: String,
+    summary: String,
+    priority: u64,
+    score: f32,
+}
+
+impl ResultRow {
+    // Approximate heap footprint, charged against the result cache
+    fn cost(&self) -> usize {
+        std::mem::size_of::<Self>() + self.id.len() + self.title.len() + self.category.len() + self.summary.len()
+    }
+}
+
 // Index manager to hold references
 pub struct IndexManager {
     index: Index,
     reader: Arc<RwLock<IndexReader>>,
     schema: Schema,
-}
-
-// Initialize logging for mobile platforms
-#[no_mangle]
-pub extern "C" fn tantivy_init_logging() {
-    #[cfg(target_os = "android")]
-    {
-        android_logger::init_once(
-            android_logger::Config::default()
-                .with_max_level(log::LevelFilter::Info)
-                .with_tag("TantivyMobile"),
-        );
-    }
-    
-    #[cfg(target_os = "ios")]
-    {
-        oslog::OsLogger::new("com.prepperapp.tantivy")
-            .level_filter(log::LevelFilter::Info)
-            .init()
-            .ok();
-    }
+    writer: Mutex<WriterState>,
+    cache: ResultCache<Vec<ResultRow>>,
+    // Set when opened with TANTIVY_OPEN_MMAP_ADVISED
+    directory: Option<AdvisedDirectory>,
+    queries: QueryStats,
 }
 
 // Create a new index with PrepperApp schema
@@ -77,9 +242,10 @@ pub extern "C" fn tantivy_create_index(path: *const c_char) -> *mut c_void {
 
     let schema = create_schema();
     
-    let index = match std::fs::create_dir_all(path_str)
-        .and_then(|_| Index::create_in_dir(path_str, schema.clone()).map_err(|e| e.into()))
-    {
+    if std::fs::create_dir_all(path_str).is_err() {
+        return ptr::null_mut();
+    }
+    let index = match Index::create_in_dir(path_str, schema.clone()) {
         Ok(idx) => idx,
         Err(_) => return ptr::null_mut(),
     };
@@ -96,6 +262,10 @@ pub extern "C" fn tantivy_create_index(path: *const c_char) -> *mut c_void {
         index,
         reader,
         schema,
+        writer: Mutex::new(WriterState::new()),
+        cache: ResultCache::new(DEFAULT_RESULT_CACHE_BYTES),
+        directory: None,
+        queries: QueryStats::default(),
     });
 
     Box::into_raw(manager) as *mut c_void
@@ -104,7 +274,14 @@ pub extern "C" fn tantivy_create_index(path: *const c_char) -> *mut c_void {
 // Open an existing index
 #[no_mangle]
 pub extern "C" fn tantivy_open_index(path: *const c_char) -> *mut c_void {
-    if path.is_null() {
+    tantivy_open_index_with_mode(path, TANTIVY_OPEN_DEFAULT)
+}
+
+// Open an existing index. TANTIVY_OPEN_MMAP_ADVISED adds per-file paging
+// hints and lets tantivy_trim_memory drop resident pages.
+#[no_mangle]
+pub extern "C" fn tantivy_open_index_with_mode(path: *const c_char, mode: u32) -> *mut c_void {
+    if path.is_null() || mode > TANTIVY_OPEN_MMAP_ADVISED {
         return ptr::null_mut();
     }
 
@@ -115,9 +292,16 @@ pub extern "C" fn tantivy_open_index(path: *const c_char) -> *mut c_void {
         }
     };
 
-    let index = match Index::open_in_dir(path_str) {
-        Ok(idx) => idx,
-        Err(_) => return ptr::null_mut(),
+    let opened = if mode == TANTIVY_OPEN_MMAP_ADVISED {
+        AdvisedDirectory::open(path_str)
+            .ok()
+            .and_then(|dir| Index::open(dir.clone()).ok().map(|idx| (idx, Some(dir))))
+    } else {
+        Index::open_in_dir(path_str).ok().map(|idx| (idx, None))
+    };
+    let (index, directory) = match opened {
+        Some(o) => o,
+        None => return ptr::null_mut(),
     };
 
     let schema = index.schema();
@@ -134,6 +318,10 @@ pub extern "C" fn tantivy_open_index(path: *const c_char) -> *mut c_void {
         index,
         reader,
         schema,
+        writer: Mutex::new(WriterState::new()),
+        cache: ResultCache::new(DEFAULT_RESULT_CACHE_BYTES),
+        directory,
+        queries: QueryStats::default(),
     });
 
     Box::into_raw(manager) as *mut c_void
@@ -150,77 +338,203 @@ pub extern "C" fn tantivy_add_document(
     summary: *const c_char,
     content: *const c_char,
 ) -> i32 {
-    if index_ptr.is_null() {
-        return ERROR_INVALID_PARAM;
+    if [id, title, category, summary, content].iter().any(|s| s.is_null()) || index_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
     }
 
     let manager = unsafe { &*(index_ptr as *const IndexManager) };
 
     // Convert C strings to Rust strings
-    let id_str = unsafe { CStr::from_ptr(id).to_string_lossy().to_string() };
-    let title_str = unsafe { CStr::from_ptr(title).to_string_lossy().to_string() };
-    let category_str = unsafe { CStr::from_ptr(category).to_string_lossy().to_string() };
-    let summary_str = unsafe { CStr::from_ptr(summary).to_string_lossy().to_string() };
-    let content_str = unsafe { CStr::from_ptr(content).to_string_lossy().to_string() };
-
-    // Get field handles
-    let id_field = manager.schema.get_field("id").unwrap();
-    let title_field = manager.schema.get_field("title").unwrap();
-    let category_field = manager.schema.get_field("category").unwrap();
-    let priority_field = manager.schema.get_field("priority").unwrap();
-    let summary_field = manager.schema.get_field("summary").unwrap();
-    let content_field = manager.schema.get_field("content").unwrap();
-
-    // Create document
-    let doc = doc!(
-        id_field => id_str,
-        title_field => title_str,
-        category_field => category_str,
-        priority_field => priority,
-        summary_field => summary_str,
-        content_field => content_str
-    );
+    let id_str = unsafe { CStr::from_ptr(id).to_string_lossy() };
+    let title_str = unsafe { CStr::from_ptr(title).to_string_lossy() };
+    let category_str = unsafe { CStr::from_ptr(category).to_string_lossy() };
+    let summary_str = unsafe { CStr::from_ptr(summary).to_string_lossy() };
+    let content_str = unsafe { CStr::from_ptr(content).to_string_lossy() };
+
+    let doc = BatchDocument {
+        id: &id_str,
+        title: &title_str,
+        category: &category_str,
+        summary: &summary_str,
+        content: &content_str,
+        priority,
+    };
 
-    // Add to index
-    match manager.index.writer(50_000_000) {
-        Ok(mut writer) => {
-            if writer.add_document(doc).is_err() {
-                return ERROR_INDEXING_FAILED;
-            }
-            SUCCESS
+    let fields = match DocumentFields::resolve(&manager.schema) {
+        Some(f) => f,
+        None => return TANTIVY_ERROR_INDEXING_FAILED,
+    };
+
+    let mut state = match manager.writer.lock() {
+        Ok(state) => state,
+        Err(_) => return TANTIVY_ERROR_INDEXING_FAILED,
+    };
+    add_to_writer(manager, &mut state, &fields, &doc)
+}
+
+// Add a length-prefixed batch of documents (layout in batch.rs) through the
+// shared writer, committing whenever a commit threshold is reached.
+// Returns the number of documents added, or a negative error code.
+// Documents added after the last automatic commit stay pending until
+// tantivy_commit.
+#[no_mangle]
+pub extern "C" fn tantivy_add_documents_batch(
+    index_ptr: *mut c_void,
+    data: *const u8,
+    len: usize,
+) -> i32 {
+    if index_ptr.is_null() || data.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    let bytes = unsafe { std::slice::from_raw_parts(data, len) };
+
+    let batch = match BatchReader::new(bytes) {
+        Ok(b) => b,
+        Err(_) => return TANTIVY_ERROR_INVALID_PARAM,
+    };
+    let fields = match DocumentFields::resolve(&manager.schema) {
+        Some(f) => f,
+        None => return TANTIVY_ERROR_INDEXING_FAILED,
+    };
+
+    let mut state = match manager.writer.lock() {
+        Ok(state) => state,
+        Err(_) => return TANTIVY_ERROR_INDEXING_FAILED,
+    };
+
+    let mut added = 0;
+    for doc in batch {
+        let doc = match doc {
+            Ok(d) => d,
+            Err(_) => return TANTIVY_ERROR_INVALID_PARAM,
+        };
+        let result = add_to_writer(manager, &mut state, &fields, &doc);
+        if result != TANTIVY_SUCCESS {
+            return result;
+        }
+        added += 1;
+    }
+    added
+}
+
+// Configure the auto-commit thresholds used while adding documents.
+// A threshold of 0 disables it.
+#[no_mangle]
+pub extern "C" fn tantivy_set_commit_thresholds(
+    index_ptr: *mut c_void,
+    max_docs: usize,
+    max_bytes: usize,
+) -> i32 {
+    if index_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    match manager.writer.lock() {
+        Ok(mut state) => {
+            state.commit_every_docs = max_docs;
+            state.commit_every_bytes = max_bytes;
+            TANTIVY_SUCCESS
+        }
+        Err(_) => TANTIVY_ERROR_INDEXING_FAILED,
+    }
+}
+
+// Set the result cache memory cap in bytes. 0 disables caching.
+#[no_mangle]
+pub extern "C" fn tantivy_set_cache_capacity(index_ptr: *mut c_void, bytes: usize) -> i32 {
+    if index_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    manager.cache.set_capacity(bytes);
+    TANTIVY_SUCCESS
+}
+
+// Release memory on an OS memory warning. TANTIVY_TRIM_MODERATE drops the
+// docstore and postings pages, TANTIVY_TRIM_CRITICAL every index page and
+// the result cache. Pages are only tracked for TANTIVY_OPEN_MMAP_ADVISED.
+#[no_mangle]
+pub extern "C" fn tantivy_trim_memory(index_ptr: *mut c_void, level: i32) -> i32 {
+    if index_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    let scope = match level {
+        TANTIVY_TRIM_MODERATE => PageOut::Cold,
+        TANTIVY_TRIM_CRITICAL => {
+            manager.cache.invalidate();
+            PageOut::All
         }
-        Err(_) => ERROR_INDEXING_FAILED,
+        _ => return TANTIVY_ERROR_INVALID_PARAM,
+    };
+    if let Some(directory) = &manager.directory {
+        directory.page_out(scope);
     }
+    TANTIVY_SUCCESS
+}
+
+fn add_to_writer(
+    manager: &IndexManager,
+    state: &mut WriterState,
+    fields: &DocumentFields,
+    doc: &BatchDocument,
+) -> i32 {
+    let writer = match state.writer(&manager.index) {
+        Some(w) => w,
+        None => return TANTIVY_ERROR_INDEXING_FAILED,
+    };
+    if writer.add_document(fields.build(doc)).is_err() {
+        return TANTIVY_ERROR_INDEXING_FAILED;
+    }
+    if state.record(doc.byte_len()) {
+        return commit_pending(manager, state);
+    }
+    TANTIVY_SUCCESS
+}
+
+fn commit_pending(manager: &IndexManager, state: &mut WriterState) -> i32 {
+    let writer = match state.writer.as_mut() {
+        Some(w) => w,
+        None => return TANTIVY_SUCCESS, // Nothing was ever added
+    };
+    if writer.commit().is_err() {
+        return TANTIVY_ERROR_INDEXING_FAILED;
+    }
+    state.pending_docs = 0;
+    state.pending_bytes = 0;
+
+    // Update the reader after commit
+    if let Ok(new_reader) = manager.index.reader_builder()
+        .reload_policy(ReloadPolicy::OnCommit)
+        .try_into()
+    {
+        if let Ok(mut reader_guard) = manager.reader.write() {
+            *reader_guard = new_reader;
+        }
+    }
+    // The commit is visible to readers even if replacing ours failed
+    manager.cache.invalidate();
+
+    TANTIVY_SUCCESS
 }
 
 // Commit changes to the index
 #[no_mangle]
 pub extern "C" fn tantivy_commit(index_ptr: *mut c_void) -> i32 {
     if index_ptr.is_null() {
-        return ERROR_INVALID_PARAM;
+        return TANTIVY_ERROR_INVALID_PARAM;
     }
 
     let manager = unsafe { &*(index_ptr as *const IndexManager) };
 
-    match manager.index.writer(50_000_000) {
-        Ok(mut writer) => {
-            if writer.commit().is_err() {
-                return ERROR_INDEXING_FAILED;
-            }
-            
-            // Update the reader after commit
-            if let Ok(new_reader) = manager.index.reader_builder()
-                .reload_policy(ReloadPolicy::OnCommit)
-                .try_into()
-            {
-                if let Ok(mut reader_guard) = manager.reader.write() {
-                    *reader_guard = new_reader;
-                }
-            }
-            
-            SUCCESS
-        }
-        Err(_) => ERROR_INDEXING_FAILED,
+    match manager.writer.lock() {
+        Ok(mut state) => commit_pending(manager, &mut state),
+        Err(_) => TANTIVY_ERROR_INDEXING_FAILED,
     }
 }
 
@@ -238,79 +552,253 @@ pub extern "C" fn tantivy_search(
     let manager = unsafe { &*(index_ptr as *const IndexManager) };
     let query_str = unsafe { CStr::from_ptr(query).to_string_lossy() };
 
-    let reader_guard = match manager.reader.read() {
-        Ok(guard) => guard,
-        Err(_) => return ptr::null_mut(),
+    let (rows, search_time) = match search_rows(manager, &query_str, limit) {
+        Some(r) => r,
+        None => return ptr::null_mut(),
     };
-    
-    let searcher = reader_guard.searcher();
 
-    // Setup query parser for multiple fields
-    let title_field = manager.schema.get_field("title").unwrap();
-    let summary_field = manager.schema.get_field("summary").unwrap();
-    let content_field = manager.schema.get_field("content").unwrap();
+    // Convert results to C-compatible format
+    let c_string = |s: &str| CString::new(s).unwrap_or_default().into_raw();
+    let mut results: Vec<SearchResult> = rows
+        .iter()
+        .map(|row| SearchResult {
+            id: c_string(&row.id),
+            title: c_string(&row.title),
+            category: c_string(&row.category),
+            summary: c_string(&row.summary),
+            priority: row.priority,
+            score: row.score,
+        })
+        .collect();
+
+    let count = results.len();
+    let results_ptr = results.as_mut_ptr();
+    std::mem::forget(results);
+
+    let search_results = Box::new(SearchResults {
+        results: results_ptr,
+        count,
+        search_time_ms: search_time.as_millis() as u64,
+    });
+
+    Box::into_raw(search_results)
+}
+
+// Ranked and loaded results for a query, answered from the result cache
+// when the same query and limit ran since the last commit. The duration is
+// the search time on a miss and the lookup time on a hit.
+fn search_rows(
+    manager: &IndexManager,
+    query_str: &str,
+    limit: usize,
+) -> Option<(Arc<Vec<ResultRow>>, std::time::Duration)> {
+    let start = std::time::Instant::now();
+    if limit == 0 {
+        return Some((Arc::new(Vec::new()), start.elapsed()));
+    }
+
+    let key = CacheKey::new(query_str, Vec::new(), limit);
+    if let Some(rows) = manager.cache.get(&key) {
+        manager.queries.record(start.elapsed());
+        return Some((rows, start.elapsed()));
+    }
+    // Read before the reader so a commit during the search fences the insert
+    let epoch = manager.cache.epoch();
+
+    let searcher = manager.reader.read().ok()?.searcher();
+    let (top_docs, search_time) = execute_search(manager, &searcher, query_str, limit)?;
+
+    let fields = SearchFields::resolve(&manager.schema);
+    let rows: Vec<ResultRow> = top_docs
+        .into_iter()
+        .filter_map(|(score, doc_address)| {
+            let doc = searcher.doc::<TantivyDocument>(doc_address).ok()?;
+            Some(ResultRow {
+                id: SearchFields::text(&doc, fields.id).to_string(),
+                title: SearchFields::text(&doc, fields.title).to_string(),
+                category: SearchFields::text(&doc, fields.category).to_string(),
+                summary: SearchFields::text(&doc, fields.summary).to_string(),
+                priority: fields.priority(&doc),
+                score,
+            })
+        })
+        .collect();
+
+    let rows = Arc::new(rows);
+    let cost = rows.iter().map(ResultRow::cost).sum();
+    manager.cache.insert(key, rows.clone(), cost, epoch);
+    manager.queries.record(start.elapsed());
+    Some((rows, search_time))
+}
+
+// Parse and run a query against the title/summary/content fields, ranked
+// by BM25 blended with priority like the multi-module searches
+fn execute_search(
+    manager: &IndexManager,
+    searcher: &Searcher,
+    query_str: &str,
+    limit: usize,
+) -> Option<(Vec<(Score, DocAddress)>, std::time::Duration)> {
+    let title_field = manager.schema.get_field("title").ok()?;
+    let summary_field = manager.schema.get_field("summary").ok()?;
+    let content_field = manager.schema.get_field("content").ok()?;
 
     let query_parser = QueryParser::for_index(
         &manager.index,
         vec![title_field, summary_field, content_field],
     );
-
-    let query = match query_parser.parse_query(&query_str) {
-        Ok(q) => q,
-        Err(_) => return ptr::null_mut(),
-    };
+    let query = query_parser.parse_query(query_str).ok()?;
 
     // Perform search with timing
     let start = std::time::Instant::now();
-    let top_docs = match searcher.search(&query, &TopDocs::with_limit(limit)) {
-        Ok(docs) => docs,
+    let top_docs = searcher.search(&query, &PriorityTopDocs::with_limit(limit)).ok()?;
+    Some((top_docs, start.elapsed()))
+}
+
+// Search the index, writing results into a caller-owned buffer using the
+// packed layout from packed.rs. No per-result allocations cross the FFI.
+// Returns the number of packed rows, or a negative error code.
+#[no_mangle]
+pub extern "C" fn tantivy_search_packed(
+    index_ptr: *mut c_void,
+    query: *const c_char,
+    limit: usize,
+    buffer: *mut u8,
+    capacity: usize,
+) -> i32 {
+    if index_ptr.is_null() || query.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    let buf = match unsafe { buffer_from_raw(buffer, capacity) } {
+        Some(b) => b,
+        None => return TANTIVY_ERROR_INVALID_PARAM,
+    };
+
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    let query_str = unsafe { CStr::from_ptr(query).to_string_lossy() };
+
+    let (rows, search_time) = match search_rows(manager, &query_str, limit) {
+        Some(r) => r,
+        None => return TANTIVY_ERROR_SEARCH_FAILED,
+    };
+
+    let mut writer = match PackedWriter::new(buf, rows.len()) {
+        Some(w) => w,
+        None => return TANTIVY_ERROR_INVALID_PARAM,
+    };
+
+    for row in rows.iter() {
+        let packed = PackedRow {
+            id: &row.id,
+            title: &row.title,
+            category: &row.category,
+            summary: &row.summary,
+            module: "",
+            priority: row.priority as u32,
+            score: row.score,
+        };
+        if !writer.push(&packed) {
+            break;
+        }
+    }
+
+    writer.finish(rows.len(), search_time.as_millis() as u64)
+}
+
+// Phase one of a two-phase search: ranks documents and reads priority from
+// its FAST column without loading stored fields. Rows are hydrated later
+// with tantivy_hits_hydrate. Free with tantivy_hits_free.
+#[no_mangle]
+pub extern "C" fn tantivy_search_hits(
+    index_ptr: *mut c_void,
+    query: *const c_char,
+    limit: usize,
+) -> *mut SearchHits {
+    if index_ptr.is_null() || query.is_null() || limit == 0 {
+        return ptr::null_mut();
+    }
+
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    let query_str = unsafe { CStr::from_ptr(query).to_string_lossy() };
+
+    let reader_guard = match manager.reader.read() {
+        Ok(guard) => guard,
         Err(_) => return ptr::null_mut(),
     };
-    let search_time = start.elapsed();
+    let searcher = reader_guard.searcher();
 
-    // Convert results to C-compatible format
-    let mut results = Vec::new();
-    
-    for (score, doc_address) in top_docs {
-        if let Ok(doc) = searcher.doc(doc_address) {
-            let id = doc.get_first(manager.schema.get_field("id").unwrap())
-                .and_then(|v| v.as_text())
-                .unwrap_or("");
-            let title = doc.get_first(manager.schema.get_field("title").unwrap())
-                .and_then(|v| v.as_text())
-                .unwrap_or("");
-            let category = doc.get_first(manager.schema.get_field("category").unwrap())
-                .and_then(|v| v.as_text())
-                .unwrap_or("");
-            let summary = doc.get_first(manager.schema.get_field("summary").unwrap())
-                .and_then(|v| v.as_text())
-                .unwrap_or("");
-            let priority = doc.get_first(manager.schema.get_field("priority").unwrap())
-                .and_then(|v| v.as_u64())
-                .unwrap_or(0);
-
-            results.push(SearchResult {
-                id: CString::new(id).unwrap().into_raw(),
-                title: CString::new(title).unwrap().into_raw(),
-                category: CString::new(category).unwrap().into_raw(),
-                summary: CString::new(summary).unwrap().into_raw(),
-                priority,
-                score,
-            });
+    let (top_docs, search_time) = match execute_search(manager, &searcher, &query_str, limit) {
+        Some(r) => r,
+        None => return ptr::null_mut(),
+    };
+
+    Box::into_raw(Box::new(SearchHits::collect(Arc::new(searcher), &manager.schema, top_docs, search_time)))
+}
+
+// Create a search-as-you-type session over this index. The session picks
+// up reloads on its own; free it with tantivy_incremental_free.
+#[no_mangle]
+pub extern "C" fn tantivy_incremental_create(index_ptr: *mut c_void) -> *mut SearchSession {
+    if index_ptr.is_null() {
+        return ptr::null_mut();
+    }
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    Box::into_raw(Box::new(SearchSession::new(manager.reader.clone())))
+}
+
+// Create a result arena. `initial_capacity` is the starting slab size in bytes.
+#[no_mangle]
+pub extern "C" fn tantivy_arena_create(initial_capacity: usize) -> *mut SearchResultArena {
+    Box::into_raw(Box::new(SearchResultArena::with_capacity(initial_capacity)))
+}
+
+// Drop the contents of an arena while keeping its memory for reuse
+#[no_mangle]
+pub extern "C" fn tantivy_arena_reset(arena: *mut SearchResultArena) {
+    if !arena.is_null() {
+        unsafe { (*arena).reset() };
+    }
+}
+
+// Free an arena and every result set it holds
+#[no_mangle]
+pub extern "C" fn tantivy_arena_free(arena: *mut SearchResultArena) {
+    if !arena.is_null() {
+        unsafe {
+            drop(Box::from_raw(arena));
         }
     }
+}
 
-    let count = results.len();
-    let results_ptr = results.as_mut_ptr();
-    std::mem::forget(results);
+// Search the index into an arena. The arena is reset first, and the returned
+// results stay valid until the next search or reset on the same arena.
+// Must not be freed with tantivy_free_search_results.
+#[no_mangle]
+pub extern "C" fn tantivy_search_arena(
+    index_ptr: *mut c_void,
+    arena: *mut SearchResultArena,
+    query: *const c_char,
+    limit: usize,
+) -> *const SearchResults {
+    if index_ptr.is_null() || arena.is_null() || query.is_null() {
+        return ptr::null();
+    }
 
-    let search_results = Box::new(SearchResults {
-        results: results_ptr,
-        count,
-        search_time_ms: search_time.as_millis() as u64,
-    });
+    let manager = unsafe { &*(index_ptr as *const IndexManager) };
+    let arena = unsafe { &mut *arena };
+    let query_str = unsafe { CStr::from_ptr(query).to_string_lossy() };
+    arena.reset();
 
-    Box::into_raw(search_results)
+    let (rows, search_time) = match search_rows(manager, &query_str, limit) {
+        Some(r) => r,
+        None => return ptr::null(),
+    };
+
+    for row in rows.iter() {
+        arena.push(&row.id, &row.title, &row.category, &row.summary, row.priority, row.score);
+    }
+
+    arena.finish(search_time.as_millis() as u64)
 }
 
 // Free search results
@@ -342,7 +830,7 @@ pub extern "C" fn tantivy_free_search_results(results: *mut SearchResults) {
         
         // Free the results array
         if !results_box.results.is_null() {
-            Vec::from_raw_parts(results_box.results, results_box.count, results_box.count);
+            drop(Vec::from_raw_parts(results_box.results, results_box.count, results_box.count));
         }
     }
 }
@@ -359,9 +847,15 @@ pub extern "C" fn tantivy_free_index(index_ptr: *mut c_void) {
 
 // Helper function to create the schema
 fn create_schema() -> Schema {
+    prepper_schema(STORED | FAST)
+}
+
+// The PrepperApp schema with `id_options` for the id field; the on-device
+// writer also indexes ids so a note can be replaced by id
+pub(crate) fn prepper_schema(id_options: impl Into<TextOptions>) -> Schema {
     let mut schema_builder = Schema::builder();
     
-    schema_builder.add_text_field("id", STORED | FAST);
+    schema_builder.add_text_field("id", id_options);
     schema_builder.add_text_field("title", TEXT | STORED | FAST);
     schema_builder.add_text_field("category", STRING | STORED | FAST);
     schema_builder.add_u64_field("priority", STORED | FAST);
@@ -371,40 +865,87 @@ fn create_schema() -> Schema {
     schema_builder.build()
 }
 
-// Get index statistics
-#[repr(C)]
-pub struct IndexStats {
-    pub num_docs: u64,
-    pub index_size_bytes: u64,
-}
-
+// Footprint and query counters of the index; zeroed apart from the header
+// for a null or poisoned index
 #[no_mangle]
 pub extern "C" fn tantivy_get_index_stats(index_ptr: *mut c_void) -> IndexStats {
+    let mut stats = IndexStats::empty();
     if index_ptr.is_null() {
-        return IndexStats {
-            num_docs: 0,
-            index_size_bytes: 0,
-        };
+        return stats;
     }
 
     let manager = unsafe { &*(index_ptr as *const IndexManager) };
-    
-    let reader_guard = match manager.reader.read() {
-        Ok(guard) => guard,
-        Err(_) => return IndexStats {
-            num_docs: 0,
-            index_size_bytes: 0,
-        },
+    let searcher = match manager.reader.read() {
+        Ok(guard) => guard.searcher(),
+        Err(_) => return stats,
     };
-    
-    let searcher = reader_guard.searcher();
-    let num_docs = searcher.num_docs();
-    
-    // Estimate index size (this is a simplification)
-    let index_size_bytes = num_docs * 1024; // Rough estimate
-    
-    IndexStats {
-        num_docs,
-        index_size_bytes,
+
+    searcher_footprint(&searcher, &mut stats);
+    stats.index_size_bytes = index_bytes(&searcher);
+    stats.mapped_bytes = manager.directory.as_ref().map_or(stats.index_size_bytes, |d| d.mapped_bytes() as u64);
+    stats.resident_bytes = manager.directory.as_ref().map_or(0, |d| d.resident_bytes()) as u64;
+    stats.heap_bytes = stats.docstore_cache_bytes + manager.cache.stats().bytes as u64;
+    manager.queries.fill(&mut stats);
+    stats
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_null_safety() {
+        assert!(tantivy_create_index(ptr::null()).is_null());
+        assert!(tantivy_open_index(ptr::null()).is_null());
+        assert!(tantivy_open_index_with_mode(ptr::null(), TANTIVY_OPEN_MMAP_ADVISED + 1).is_null());
+        assert_eq!(tantivy_add_documents_batch(ptr::null_mut(), ptr::null(), 0), TANTIVY_ERROR_INVALID_PARAM);
+        assert_eq!(tantivy_commit(ptr::null_mut()), TANTIVY_ERROR_INVALID_PARAM);
+        assert_eq!(tantivy_trim_memory(ptr::null_mut(), TANTIVY_TRIM_CRITICAL), TANTIVY_ERROR_INVALID_PARAM);
+        assert!(tantivy_search(ptr::null_mut(), ptr::null(), 10).is_null());
+        assert_eq!(tantivy_search_packed(ptr::null_mut(), ptr::null(), 10, ptr::null_mut(), 0), TANTIVY_ERROR_INVALID_PARAM);
+        assert!(tantivy_search_hits(ptr::null_mut(), ptr::null(), 10).is_null());
+        assert!(tantivy_incremental_create(ptr::null_mut()).is_null());
+        assert!(tantivy_search_arena(ptr::null_mut(), ptr::null_mut(), ptr::null(), 10).is_null());
+        assert_eq!(tantivy_get_index_stats(ptr::null_mut()).num_docs, 0);
+
+        // Should not crash
+        tantivy_arena_reset(ptr::null_mut());
+        tantivy_arena_free(ptr::null_mut());
+        tantivy_free_search_results(ptr::null_mut());
+        tantivy_free_index(ptr::null_mut());
     }
-}
\ No newline at end of file
+
+    #[test]
+    fn test_create_add_search() {
+        let dir = std::env::temp_dir().join(format!("tantivy-legacy-{}", std::process::id()));
+        let path = CString::new(dir.to_str().unwrap()).unwrap();
+        let index = tantivy_create_index(path.as_ptr());
+        assert!(!index.is_null());
+
+        let text = |s: &str| CString::new(s).unwrap();
+        let (id, title, category) = (text("a1"), text("Tourniquet use"), text("medical"));
+        let (summary, content) = (text("Stop bleeding"), text("Apply above the wound"));
+        let added = tantivy_add_document(
+            index,
+            id.as_ptr(),
+            title.as_ptr(),
+            category.as_ptr(),
+            0,
+            summary.as_ptr(),
+            content.as_ptr(),
+        );
+        assert_eq!(added, TANTIVY_SUCCESS);
+        assert_eq!(tantivy_commit(index), TANTIVY_SUCCESS);
+
+        let query = text("bleeding");
+        let arena = tantivy_arena_create(256);
+        let results = unsafe { &*tantivy_search_arena(index, arena, query.as_ptr(), 10) };
+        assert_eq!(results.count, 1);
+        let row = unsafe { &*results.results };
+        assert_eq!(unsafe { CStr::from_ptr(row.category) }.to_str().unwrap(), "medical");
+        tantivy_arena_free(arena);
+
+        tantivy_free_index(index);
+        let _ = std::fs::remove_dir_all(dir);
+    }
+}
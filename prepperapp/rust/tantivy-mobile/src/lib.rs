@@ -1,11 +1,46 @@
+mod abi;
+mod async_search;
+mod batch;
+mod cache;
+mod doc_stream;
+mod doc_table;
 mod ffi;
+mod filter;
+mod hits;
+mod incremental;
+mod lazy;
+mod legacy;
+mod mmap_advice;
 mod multi_search;
+mod packed;
+mod priority;
+mod snippet;
+mod stats;
+mod thread_pool;
+mod timing;
+mod warmup;
+mod writer;
 
-// Re-export FFI functions for mobile bindings
+// Re-export FFI functions for mobile bindings; tantivy_mobile.h declares
+// all of them
+pub use abi::*;
+pub use async_search::{MultiSearchCallback, TieredSearchCallback};
+pub use doc_stream::*;
 pub use ffi::*;
+pub use filter::SearchFilter;
+pub use hits::*;
+pub use incremental::*;
+pub use lazy::{TANTIVY_MODULE_FAILED, TANTIVY_MODULE_PENDING, TANTIVY_MODULE_READY, TANTIVY_MODULE_UNLOADED};
+pub use legacy::*;
 pub use multi_search::*;
+pub use packed::{PackedResultRow, PackedResultsHeader, PackedString};
+pub use stats::{IndexStats, TANTIVY_INDEX_STATS_VERSION, TANTIVY_LATENCY_BUCKETS};
+pub use thread_pool::*;
+pub use timing::SearchTiming;
+pub use warmup::*;
+pub use writer::*;
 
-// Initialize logging for mobile platforms (common to both implementations)
+// Initialize logging for mobile platforms (common to every entry point)
 #[no_mangle]
 pub extern "C" fn tantivy_init_logging() {
     #[cfg(target_os = "android")]
@@ -0,0 +1,257 @@
+// mmap_advice.rs - Memory-mapped index directory with per-file paging hints
+//
+// Wraps MmapDirectory and tells the kernel how each index file is read:
+// term dictionaries and fast fields are touched by every query and are
+// prefetched, the docstore is read in random blocks, and postings/positions
+// are the large files that go first under pressure. Every mapping is kept
+// so a module's resident pages can be measured with mincore and dropped
+// with madvise; dropped pages fault back in from flash on the next access.
+
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Mutex};
+use tantivy::directory::error::{DeleteError, LockError, OpenDirectoryError, OpenReadError, OpenWriteError};
+use tantivy::directory::{
+    Directory, DirectoryLock, FileHandle, Lock, MmapDirectory, OwnedBytes, WatchCallback, WatchHandle, WritePtr,
+};
+use tantivy::HasLen;
+
+/// How an index file is read, from its extension.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub(crate) enum FileClass {
+    /// Term dictionaries, fast fields and fieldnorms
+    Hot,
+    /// Docstore blocks, decompressed only for the rows being shown
+    Random,
+    /// Postings and positions
+    Pageable,
+    Other,
+}
+
+impl FileClass {
+    pub fn of(path: &Path) -> Self {
+        match path.extension().and_then(|e| e.to_str()) {
+            Some("term") | Some("fast") | Some("fieldnorm") => FileClass::Hot,
+            Some("store") => FileClass::Random,
+            Some("pos") | Some("idx") => FileClass::Pageable,
+            _ => FileClass::Other,
+        }
+    }
+}
+
+/// Which mappings `page_out` drops.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub(crate) enum PageOut {
+    /// Docstore, postings and positions; keeps the hot files resident
+    Cold,
+    All,
+}
+
+#[derive(Debug)]
+struct Mapping {
+    bytes: OwnedBytes,
+    class: FileClass,
+}
+
+#[derive(Clone, Debug)]
+pub(crate) struct AdvisedDirectory {
+    inner: MmapDirectory,
+    mappings: Arc<Mutex<HashMap<PathBuf, Mapping>>>,
+}
+
+impl AdvisedDirectory {
+    pub fn open(path: impl AsRef<Path>) -> Result<Self, OpenDirectoryError> {
+        Ok(AdvisedDirectory {
+            inner: MmapDirectory::open(path)?,
+            mappings: Arc::new(Mutex::new(HashMap::new())),
+        })
+    }
+
+    /// Bytes of mapped index files currently in RAM.
+    pub fn resident_bytes(&self) -> usize {
+        self.mappings
+            .lock()
+            .map_or(0, |m| m.values().map(|mapping| os::resident(mapping.bytes.as_slice())).sum())
+    }
+
+    /// Bytes of the index files currently mapped.
+    pub fn mapped_bytes(&self) -> usize {
+        self.mappings.lock().map_or(0, |m| m.values().map(|mapping| mapping.bytes.len()).sum())
+    }
+
+    /// Drops resident pages; the next read faults them back in.
+    pub fn page_out(&self, scope: PageOut) {
+        if let Ok(mappings) = self.mappings.lock() {
+            for mapping in mappings.values() {
+                if scope == PageOut::All || mapping.class != FileClass::Hot {
+                    os::advise(mapping.bytes.as_slice(), os::Advice::DontNeed);
+                }
+            }
+        }
+    }
+
+    /// Unpins mappings of files deleted behind tantivy's back, such as the
+    /// files a delta update replaced. Their blocks are freed once the last
+    /// searcher holding them is dropped.
+    pub fn forget_missing(&self) {
+        if let Ok(mut mappings) = self.mappings.lock() {
+            mappings.retain(|path, _| self.inner.exists(path).unwrap_or(true));
+        }
+    }
+}
+
+impl Directory for AdvisedDirectory {
+    fn get_file_handle(&self, path: &Path) -> Result<Arc<dyn FileHandle>, OpenReadError> {
+        let handle = self.inner.get_file_handle(path)?;
+        // Zero-copy: a view of the whole mapping
+        if let Ok(bytes) = handle.read_bytes(0..handle.len()) {
+            if !bytes.is_empty() {
+                let class = FileClass::of(path);
+                match class {
+                    FileClass::Hot => os::advise(bytes.as_slice(), os::Advice::WillNeed),
+                    FileClass::Random => os::advise(bytes.as_slice(), os::Advice::Random),
+                    FileClass::Pageable | FileClass::Other => {}
+                }
+                if let Ok(mut mappings) = self.mappings.lock() {
+                    mappings.insert(path.to_path_buf(), Mapping { bytes, class });
+                }
+            }
+        }
+        Ok(handle)
+    }
+
+    fn delete(&self, path: &Path) -> Result<(), DeleteError> {
+        // Unpin the mapping so the file's pages can go once tantivy drops it
+        if let Ok(mut mappings) = self.mappings.lock() {
+            mappings.remove(path);
+        }
+        self.inner.delete(path)
+    }
+
+    fn exists(&self, path: &Path) -> Result<bool, OpenReadError> {
+        self.inner.exists(path)
+    }
+
+    fn open_write(&self, path: &Path) -> Result<WritePtr, OpenWriteError> {
+        self.inner.open_write(path)
+    }
+
+    fn atomic_read(&self, path: &Path) -> Result<Vec<u8>, OpenReadError> {
+        self.inner.atomic_read(path)
+    }
+
+    fn atomic_write(&self, path: &Path, data: &[u8]) -> std::io::Result<()> {
+        self.inner.atomic_write(path, data)
+    }
+
+    fn acquire_lock(&self, lock: &Lock) -> Result<DirectoryLock, LockError> {
+        self.inner.acquire_lock(lock)
+    }
+
+    fn watch(&self, watch_callback: WatchCallback) -> tantivy::Result<WatchHandle> {
+        self.inner.watch(watch_callback)
+    }
+
+    fn sync_directory(&self) -> std::io::Result<()> {
+        self.inner.sync_directory()
+    }
+}
+
+// Page-aligned (start, len) covering [addr, addr + len)
+fn page_span(addr: usize, len: usize, page: usize) -> (usize, usize) {
+    let start = addr & !(page - 1);
+    (start, addr + len - start)
+}
+
+#[cfg(unix)]
+mod os {
+    use super::page_span;
+
+    pub enum Advice {
+        WillNeed,
+        Random,
+        DontNeed,
+    }
+
+    fn page_size() -> usize {
+        match unsafe { libc::sysconf(libc::_SC_PAGESIZE) } {
+            n if n > 0 => n as usize,
+            _ => 4096,
+        }
+    }
+
+    // Hints are best effort; failures are ignored
+    pub fn advise(bytes: &[u8], advice: Advice) {
+        if bytes.is_empty() {
+            return;
+        }
+        let advice = match advice {
+            Advice::WillNeed => libc::MADV_WILLNEED,
+            Advice::Random => libc::MADV_RANDOM,
+            Advice::DontNeed => libc::MADV_DONTNEED,
+        };
+        let (start, len) = page_span(bytes.as_ptr() as usize, bytes.len(), page_size());
+        unsafe {
+            libc::madvise(start as *mut libc::c_void, len, advice);
+        }
+    }
+
+    pub fn resident(bytes: &[u8]) -> usize {
+        if bytes.is_empty() {
+            return 0;
+        }
+        let page = page_size();
+        let (start, len) = page_span(bytes.as_ptr() as usize, bytes.len(), page);
+        let mut pages = vec![0u8; (len + page - 1) / page];
+        let rc = unsafe { libc::mincore(start as *mut libc::c_void, len, pages.as_mut_ptr() as *mut _) };
+        if rc != 0 {
+            return 0;
+        }
+        pages.iter().filter(|&&p| p & 1 != 0).count() * page
+    }
+}
+
+#[cfg(not(unix))]
+mod os {
+    pub enum Advice {
+        WillNeed,
+        Random,
+        DontNeed,
+    }
+
+    pub fn advise(_bytes: &[u8], _advice: Advice) {}
+
+    pub fn resident(_bytes: &[u8]) -> usize {
+        0
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_file_class() {
+        assert_eq!(FileClass::of(Path::new("a1b2.term")), FileClass::Hot);
+        assert_eq!(FileClass::of(Path::new("a1b2.fast")), FileClass::Hot);
+        assert_eq!(FileClass::of(Path::new("a1b2.store")), FileClass::Random);
+        assert_eq!(FileClass::of(Path::new("a1b2.pos")), FileClass::Pageable);
+        assert_eq!(FileClass::of(Path::new("meta.json")), FileClass::Other);
+    }
+
+    #[test]
+    fn test_page_span() {
+        assert_eq!(page_span(4096, 10, 4096), (4096, 10));
+        assert_eq!(page_span(4100, 10, 4096), (4096, 14));
+        assert_eq!(page_span(8191, 2, 4096), (4096, 4097));
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_resident_touched_memory() {
+        let buf = vec![1u8; 64 * 1024];
+        assert!(os::resident(&buf) >= 4096);
+        os::advise(&buf, os::Advice::WillNeed); // Must not crash
+        assert_eq!(os::resident(&[]), 0);
+    }
+}
@@ -1,17 +1,274 @@
 // multi_search.rs - Multi-module search functionality
 
-use crate::ffi::SearchService;
+use crate::abi::TANTIVY_ERROR_CANCELLED;
+use crate::async_search::{AsyncSearches, EmitBatch, MultiSearchCallback, TieredSearchCallback};
+use crate::cache::{CacheKey, ResultCache, DEFAULT_RESULT_CACHE_BYTES};
+use crate::ffi::{SearchFields, SearchService, TANTIVY_OPEN_MMAP_ADVISED};
+use crate::filter::{browse, Filter, SearchFilter};
+use crate::lazy::{ModuleLoader, Registration, Registry, TANTIVY_MODULE_FAILED, TANTIVY_MODULE_PENDING, TANTIVY_MODULE_READY, TANTIVY_MODULE_UNLOADED};
+use crate::mmap_advice::PageOut;
+use arc_swap::ArcSwap;
+use crate::packed::{buffer_from_raw, PackedRow, PackedWriter, PACKED_HEADER_SIZE, PACKED_ROW_SIZE};
+use crate::priority::PriorityTopDocs;
+use crate::snippet::summary_or_snippet;
+use crate::stats::{IndexStats, TANTIVY_LATENCY_BUCKETS};
+use crate::thread_pool::{multi_manager_options_default, MultiManagerOptions, SearchPools};
+use crate::timing::{elapsed_ns, nanos, SearchTiming, TraceSection, TRACE_COLLECT, TRACE_MERGE, TRACE_PACK, TRACE_SEARCH};
+use crate::warmup::{warmup_plan, WarmupHandle};
 use rayon::prelude::*;
-use std::collections::{HashMap, HashSet};
-use std::ffi::{c_char, CStr, CString};
-use std::sync::Mutex;
-use tantivy::collector::TopDocs;
-use tantivy::{TantivyDocument, schema::Value};
+use std::cmp::Ordering;
+use std::collections::{BinaryHeap, HashMap, HashSet};
+use std::ffi::{c_char, c_void, CStr, CString};
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering as AtomicOrdering};
+use std::sync::{Arc, Mutex};
+use std::time::Instant;
+use tantivy::schema::Value;
+use tantivy::{DocAddress, Searcher, TantivyDocument};
+
+// Maximum number of modules addressable from MultiSearchOptions
+pub const MULTI_SEARCH_MAX_MODULES: usize = 32;
+
+// A loaded module. `slot` is a small stable number assigned at load time so
+// binary options can address modules without passing names around. `tier`
+// orders tiered searches: 0 for modules loaded directly, the registered
+// tier for modules opened by the loader.
+#[derive(Clone)]
+struct ModuleEntry {
+    slot: usize,
+    tier: u32,
+    service: Arc<SearchService>,
+}
+
+type ModuleMap = HashMap<String, ModuleEntry>;
+
+// The modules of a manager, shared with its loader thread
+struct ModuleTable {
+    // Published module table. Searches load it without locking; load and
+    // unload build a modified copy and swap it in, so a module unloaded
+    // mid-search stays alive until that search drops its snapshot.
+    services: ArcSwap<ModuleMap>,
+    // Serializes writers so concurrent loads don't lose each other's updates
+    write_lock: Mutex<()>,
+    // Merged results of recent searches; cleared whenever a module changes
+    // Shared with background warmups so they can fill it
+    cache: Arc<ResultCache<Vec<MultiSearchResultItem>>>,
+    // Resident index bytes allowed across modules; 0 means unlimited
+    memory_budget: AtomicUsize,
+    // Modules registered for background opening (lazy.rs), open or not.
+    // Locked after write_lock when both are needed.
+    registry: Mutex<Registry>,
+    next_generation: AtomicU64,
+    // Registered modules kept open at once; 0 means unlimited
+    open_limit: AtomicUsize,
+}
 
 // The opaque handle for the FFI layer
 pub struct MultiSearchManager {
-    // Using a Mutex to ensure thread-safe access
-    services: Mutex<HashMap<String, Box<SearchService>>>,
+    table: Arc<ModuleTable>,
+    // Threads searches fan out over, shared with async searches
+    pools: Arc<SearchPools>,
+    // Queue and threads of multi_manager_search_async
+    async_searches: AsyncSearches,
+    // Opens registered modules in the background
+    loader: ModuleLoader,
+}
+
+// Levels for multi_manager_trim_memory
+pub const TANTIVY_TRIM_MODERATE: i32 = 1;
+pub const TANTIVY_TRIM_CRITICAL: i32 = 2;
+
+impl ModuleTable {
+    // Copy-on-write update of the module table
+    fn update<R>(&self, f: impl FnOnce(&mut ModuleMap) -> R) -> Option<R> {
+        let _writer = self.write_lock.lock().ok()?;
+        let mut next = ModuleMap::clone(&self.services.load());
+        let result = f(&mut next);
+        self.services.store(Arc::new(next));
+        // After the store, so nothing searched on the old table is cached
+        self.cache.invalidate();
+        Some(result)
+    }
+
+    // Modules, least recently searched first
+    fn by_recency(services: &ModuleMap) -> Vec<&SearchService> {
+        let mut modules: Vec<&SearchService> = services.values().map(|e| e.service.as_ref()).collect();
+        modules.sort_by_key(|service| service.last_used());
+        modules
+    }
+
+    // Pages out the least recently searched modules until their resident
+    // index pages fit the budget. The most recent module goes last and keeps
+    // its hot files.
+    fn enforce_memory_budget(&self) {
+        let budget = self.memory_budget.load(AtomicOrdering::Relaxed);
+        if budget == 0 {
+            return;
+        }
+
+        let services = self.services.load_full();
+        let modules = Self::by_recency(&services);
+        let resident: Vec<usize> = modules.iter().map(|service| service.resident_bytes()).collect();
+        let mut total: usize = resident.iter().sum();
+
+        for (i, service) in modules.iter().enumerate() {
+            if total <= budget {
+                break;
+            }
+            let scope = if i + 1 == modules.len() { PageOut::Cold } else { PageOut::All };
+            service.page_out(scope);
+            total = total - resident[i] + service.resident_bytes();
+        }
+    }
+
+    // Lowest slot no open or registered module uses
+    fn free_slot(services: &ModuleMap, registry: &Registry) -> usize {
+        (0..)
+            .find(|n| !services.values().any(|e| e.slot == *n) && !registry.values().any(|r| r.slot == *n))
+            .unwrap_or(0)
+    }
+
+    // Loader thread: opens a registered module that is still pending and
+    // publishes it, closing the least recently searched registered modules
+    // beyond the open limit
+    fn open_registered(&self, name: &str) {
+        let (path, docstore_cache_bytes, generation) = match self.registry.lock() {
+            Ok(registry) => match registry.get(name) {
+                Some(r) if r.state == TANTIVY_MODULE_PENDING => (r.path.clone(), r.docstore_cache_bytes, r.generation),
+                _ => return,
+            },
+            Err(_) => return,
+        };
+
+        let service_ptr = crate::ffi::open_searcher(path.as_ptr(), TANTIVY_OPEN_MMAP_ADVISED, docstore_cache_bytes);
+        if service_ptr.is_null() {
+            if let Ok(mut registry) = self.registry.lock() {
+                if let Some(r) = registry.get_mut(name).filter(|r| r.generation == generation) {
+                    r.state = TANTIVY_MODULE_FAILED;
+                }
+            }
+            return;
+        }
+        let service: Arc<SearchService> = unsafe { Box::from_raw(service_ptr) }.into();
+        // Counts as used now, so it is not the first to be closed again
+        service.touch();
+
+        let limit = self.open_limit.load(AtomicOrdering::Relaxed);
+        self.update(|services| {
+            let mut registry = self.registry.lock().ok()?;
+            let registration = registry.get_mut(name).filter(|r| r.generation == generation && r.state == TANTIVY_MODULE_PENDING)?;
+            registration.state = TANTIVY_MODULE_READY;
+            services.insert(name.to_string(), ModuleEntry { slot: registration.slot, tier: registration.tier, service });
+            if limit > 0 {
+                close_least_recent(services, &mut registry, limit);
+            }
+            Some(())
+        });
+        self.enforce_memory_budget();
+    }
+
+    // Slots of the registered modules `select` picks that are not open in
+    // `services`. With `reopen`, those closed under memory pressure are
+    // queued to open again.
+    fn pending_mask(&self, services: &ModuleMap, select: &impl Fn(&str, usize) -> Option<f32>, reopen: Option<&ModuleLoader>) -> u32 {
+        let mut registry = match self.registry.lock() {
+            Ok(r) => r,
+            Err(_) => return 0,
+        };
+        let mut mask = 0;
+        for (name, registration) in registry.iter_mut() {
+            if registration.state == TANTIVY_MODULE_FAILED
+                || services.contains_key(name)
+                || select(name, registration.slot).is_none()
+            {
+                continue;
+            }
+            if registration.state == TANTIVY_MODULE_UNLOADED {
+                match reopen {
+                    Some(loader) => {
+                        registration.state = TANTIVY_MODULE_PENDING;
+                        loader.enqueue_demand(name);
+                    }
+                    None => continue,
+                }
+            }
+            if registration.slot < MULTI_SEARCH_MAX_MODULES {
+                mask |= 1 << registration.slot;
+            }
+        }
+        mask
+    }
+}
+
+// Closes the least recently searched registered modules in `services`
+// until at most `keep` are open. They stay registered and are reopened
+// when a search asks for them by name.
+fn close_least_recent(services: &mut ModuleMap, registry: &mut Registry, keep: usize) {
+    let mut open: Vec<(u64, String)> = registry
+        .iter()
+        .filter(|(_, r)| r.state == TANTIVY_MODULE_READY)
+        .filter_map(|(name, _)| services.get(name).map(|e| (e.service.last_used(), name.clone())))
+        .collect();
+    if open.len() <= keep {
+        return;
+    }
+    open.sort();
+    let excess = open.len() - keep;
+    for (_, name) in open.into_iter().take(excess) {
+        services.remove(&name);
+        if let Some(r) = registry.get_mut(&name) {
+            r.state = TANTIVY_MODULE_UNLOADED;
+        }
+    }
+}
+
+impl MultiSearchManager {
+    // The article with id `doc_id` in `module`, or in the first loaded
+    // module that has it
+    fn find_document(&self, module: Option<&str>, doc_id: &str) -> Option<(Arc<SearchService>, TantivyDocument)> {
+        let services = self.table.services.load();
+        services
+            .iter()
+            .filter(|(name, _)| module.map_or(true, |m| m == name.as_str()))
+            .find_map(|(_, entry)| {
+                let searcher = entry.service.searcher();
+                let doc = entry.service.find_document(&searcher, doc_id)?;
+                Some((entry.service.clone(), doc))
+            })
+    }
+
+    /// Stored body text of an article, for document streams.
+    pub(crate) fn document_body(&self, module: Option<&str>, doc_id: &str) -> Option<String> {
+        let (service, doc) = self.find_document(module, doc_id)?;
+        let body = service.fields.body?;
+        doc.get_first(body).and_then(|v| v.as_str()).map(str::to_string)
+    }
+}
+
+// Binary counterpart of MultiSearchConfig, passed by pointer from native code
+// so a search needs no JSON on either side. Bit n of `module_mask` selects
+// the module in slot n (0 selects every module); `module_weights` is indexed
+// by slot.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct MultiSearchOptions {
+    pub limit: u32,
+    pub module_mask: u32,
+    pub module_weights: [f32; MULTI_SEARCH_MAX_MODULES],
+}
+
+impl MultiSearchOptions {
+    // Weight for a module, or None if the mask excludes it. Modules in slots
+    // beyond the mask width are only searched when every module is selected.
+    fn select(&self, slot: usize) -> Option<f32> {
+        if self.module_mask == 0 {
+            return Some(self.module_weights.get(slot).copied().unwrap_or(1.0));
+        }
+        if slot < MULTI_SEARCH_MAX_MODULES && self.module_mask & (1 << slot) != 0 {
+            Some(self.module_weights[slot])
+        } else {
+            None
+        }
+    }
 }
 
 // Configuration for a multi-search, passed from native code as JSON
@@ -37,23 +294,84 @@ struct MultiSearchResultItem {
     summary: String,
     score: f32,
     module: String,
+    #[serde(skip_serializing_if = "String::is_empty")]
+    category: String,
+    #[serde(skip)]
+    priority: u64,
+}
+
+impl MultiSearchResultItem {
+    // Approximate heap footprint, charged against the result cache
+    fn cost(&self) -> usize {
+        std::mem::size_of::<Self>()
+            + self.doc_id.len()
+            + self.title.len()
+            + self.summary.len()
+            + self.module.len()
+            + self.category.len()
+    }
+}
+
+impl MultiSearchConfig {
+    // Weight for a module, or None if the filter excludes it
+    fn select(&self, module_name: &str) -> Option<f32> {
+        match &self.module_filter {
+            Some(filter) if !filter.iter().any(|m| m == module_name) => None,
+            _ => Some(*self.weights.get(module_name).unwrap_or(&1.0)),
+        }
+    }
+}
+
+// Default binary options: default limit, every module, weight 1.0
+#[no_mangle]
+pub extern "C" fn multi_search_options_default() -> MultiSearchOptions {
+    MultiSearchOptions {
+        limit: default_limit() as u32,
+        module_mask: 0,
+        module_weights: [1.0; MULTI_SEARCH_MAX_MODULES],
+    }
 }
 
-// Initialize multi-search manager with thread pool configuration
+// Initialize multi-search manager with the default thread configuration
 #[no_mangle]
 pub extern "C" fn init_multi_manager() -> *mut MultiSearchManager {
-    // One-time setup for Rayon's thread pool
-    static INIT: std::sync::Once = std::sync::Once::new();
-    INIT.call_once(|| {
-        // Use 4 threads for mobile devices - balances performance and battery
-        let _ = rayon::ThreadPoolBuilder::new()
-            .num_threads(4)
-            .thread_name(|idx| format!("tantivy-search-{}", idx))
-            .build_global();
+    init_multi_manager_with_options(std::ptr::null())
+}
+
+/// Creates a manager whose searches run on its own thread pools, configured
+/// by `options` (null for multi_manager_options_default()) instead of
+/// rayon's one-thread-per-core global pool.
+/// Returns null if the threads cannot be started.
+#[no_mangle]
+pub extern "C" fn init_multi_manager_with_options(options: *const MultiManagerOptions) -> *mut MultiSearchManager {
+    let options = if options.is_null() { multi_manager_options_default() } else { unsafe { *options } };
+    let pools = match SearchPools::new(&options) {
+        Some(p) => Arc::new(p),
+        None => return std::ptr::null_mut(),
+    };
+
+    let table = Arc::new(ModuleTable {
+        services: ArcSwap::from_pointee(HashMap::new()),
+        write_lock: Mutex::new(()),
+        cache: Arc::new(ResultCache::new(DEFAULT_RESULT_CACHE_BYTES)),
+        memory_budget: AtomicUsize::new(0),
+        registry: Mutex::new(HashMap::new()),
+        next_generation: AtomicU64::new(0),
+        open_limit: AtomicUsize::new(0),
     });
+    let loader = {
+        let table = table.clone();
+        match ModuleLoader::spawn(options.hints(), move |name| table.open_registered(name)) {
+            Some(l) => l,
+            None => return std::ptr::null_mut(),
+        }
+    };
 
     let manager = MultiSearchManager {
-        services: Mutex::new(HashMap::new()),
+        table,
+        async_searches: AsyncSearches::new(options.async_threads(), options.hints()),
+        pools,
+        loader,
     };
     Box::into_raw(Box::new(manager))
 }
@@ -74,6 +392,21 @@ pub extern "C" fn multi_manager_load_index(
     manager_ptr: *mut MultiSearchManager,
     module_name_ptr: *const c_char,
     index_path_ptr: *const c_char,
+) -> i32 {
+    multi_manager_load_index_with_cache(manager_ptr, module_name_ptr, index_path_ptr, 0)
+}
+
+/// Like `multi_manager_load_index`, with a docstore block cache of up to
+/// `docstore_cache_bytes` of decompressed blocks for the module (0 keeps
+/// tantivy's default of 100 blocks). A larger cache keeps the blocks of
+/// recently fetched results and articles hot, so paging through results or
+/// re-opening an article does not decompress them again.
+#[no_mangle]
+pub extern "C" fn multi_manager_load_index_with_cache(
+    manager_ptr: *mut MultiSearchManager,
+    module_name_ptr: *const c_char,
+    index_path_ptr: *const c_char,
+    docstore_cache_bytes: u64,
 ) -> i32 {
     if manager_ptr.is_null() || module_name_ptr.is_null() || index_path_ptr.is_null() {
         return -1;
@@ -89,23 +422,34 @@ pub extern "C" fn multi_manager_load_index(
         }
     };
 
-    // Initialize the SearchService for this module
-    let service_ptr = crate::ffi::init_searcher(index_path_ptr);
+    // Initialize the SearchService for this module, with paging hints so
+    // its resident memory can be accounted for and trimmed
+    let service_ptr = crate::ffi::open_searcher(index_path_ptr, TANTIVY_OPEN_MMAP_ADVISED, docstore_cache_bytes);
     if service_ptr.is_null() {
         return -1;
     }
 
     // Convert the raw pointer back to a Box to manage ownership
-    let service = unsafe { Box::from_raw(service_ptr) };
+    let service: Arc<SearchService> = unsafe { Box::from_raw(service_ptr) }.into();
 
-    // Add to the manager
-    match manager.services.lock() {
-        Ok(mut services) => {
-            services.insert(module_name, service);
-            0
-        }
-        Err(_) => -1,
+    // Add to the manager, keeping the slot of a module that is re-loaded or
+    // was registered; a loaded module is no longer opened in the background
+    let table = &manager.table;
+    let added = table.update(|services| {
+        let mut registry = table.registry.lock().ok()?;
+        let slot = match (services.get(&module_name), registry.remove(&module_name)) {
+            (Some(existing), _) => existing.slot,
+            (None, Some(registered)) => registered.slot,
+            (None, None) => ModuleTable::free_slot(services, &registry),
+        };
+        services.insert(module_name, ModuleEntry { slot, tier: 0, service });
+        Some(())
+    });
+    if added.flatten().is_none() {
+        return -1;
     }
+    manager.table.enforce_memory_budget();
+    0
 }
 
 // Unload a specific module
@@ -127,18 +471,133 @@ pub extern "C" fn multi_manager_unload_index(
         }
     };
 
-    match manager.services.lock() {
-        Ok(mut services) => {
-            if services.remove(module_name).is_some() {
-                0
-            } else {
-                -1 // Module not found
-            }
-        }
+    // Also forgets a registration, so a pending open is never published
+    let table = &manager.table;
+    let removed = table.update(|services| {
+        let registered = table.registry.lock().map_or(false, |mut r| r.remove(module_name).is_some());
+        services.remove(module_name).is_some() || registered
+    });
+    match removed {
+        Some(true) => 0,
+        _ => -1, // Module not found
+    }
+}
+
+/// Registers a module to be opened on the manager's loader thread instead
+/// of the calling one. Only the name, path and tier are recorded, so
+/// registering every installed module costs the same however much content
+/// there is. Modules open one at a time, lowest `tier` first and in
+/// registration order within a tier, with a docstore cache as in
+/// `multi_manager_load_index_with_cache`. Until a module is open, searches
+/// skip it and report it in SearchTiming.pending_mask; its slot is assigned
+/// at once, so options can select it before then. Registering a name again
+/// replaces the earlier registration, and an open module keeps serving
+/// searches until its replacement is open.
+/// Returns 0, or -1 on invalid input.
+#[no_mangle]
+pub extern "C" fn multi_manager_register_index(
+    manager_ptr: *const MultiSearchManager,
+    module_name_ptr: *const c_char,
+    index_path_ptr: *const c_char,
+    tier: u32,
+    docstore_cache_bytes: u64,
+) -> i32 {
+    if manager_ptr.is_null() || module_name_ptr.is_null() || index_path_ptr.is_null() {
+        return -1;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let module_name = match unsafe { CStr::from_ptr(module_name_ptr) }.to_str() {
+        Ok(s) => s.to_string(),
+        Err(_) => return -1,
+    };
+    let path = unsafe { CStr::from_ptr(index_path_ptr) }.to_owned();
+
+    let table = &manager.table;
+    {
+        // Held so a concurrent load cannot take the same slot
+        let _writer = match table.write_lock.lock() {
+            Ok(w) => w,
+            Err(_) => return -1,
+        };
+        let services = table.services.load();
+        let mut registry = match table.registry.lock() {
+            Ok(r) => r,
+            Err(_) => return -1,
+        };
+        let slot = match (services.get(&module_name), registry.get(&module_name)) {
+            (Some(existing), _) => existing.slot,
+            (None, Some(registered)) => registered.slot,
+            (None, None) => ModuleTable::free_slot(&services, &registry),
+        };
+        let registration = Registration {
+            path,
+            tier,
+            docstore_cache_bytes,
+            slot,
+            state: TANTIVY_MODULE_PENDING,
+            generation: table.next_generation.fetch_add(1, AtomicOrdering::Relaxed),
+        };
+        registry.insert(module_name.clone(), registration);
+    }
+    manager.loader.enqueue(&module_name, tier);
+    0
+}
+
+/// TANTIVY_MODULE_READY for an open module, whether loaded or registered;
+/// for a registered one that is not open, TANTIVY_MODULE_PENDING while it
+/// waits to open, TANTIVY_MODULE_UNLOADED once closed under memory
+/// pressure, or TANTIVY_MODULE_FAILED if it could not be opened.
+/// Returns -1 for an unknown module.
+#[no_mangle]
+pub extern "C" fn multi_manager_module_state(
+    manager_ptr: *const MultiSearchManager,
+    module_name_ptr: *const c_char,
+) -> i32 {
+    if manager_ptr.is_null() || module_name_ptr.is_null() {
+        return -1;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let module_name = match unsafe { CStr::from_ptr(module_name_ptr) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -1,
+    };
+    if manager.table.services.load().contains_key(module_name) {
+        return TANTIVY_MODULE_READY;
+    }
+    match manager.table.registry.lock() {
+        Ok(registry) => registry.get(module_name).map_or(-1, |r| r.state),
         Err(_) => -1,
     }
 }
 
+/// Keeps at most `count` registered modules open, closing the least
+/// recently searched first when another opens; 0 removes the limit.
+/// Loaded modules are not counted. A closed module stays registered: a
+/// search that selects it by name (module mask or module_filter) reports it
+/// pending and queues it to open ahead of every tier, while searches of
+/// every module skip it.
+/// Returns 0 on success, -1 on a null manager.
+#[no_mangle]
+pub extern "C" fn multi_manager_set_open_module_limit(manager_ptr: *const MultiSearchManager, count: u32) -> i32 {
+    if manager_ptr.is_null() {
+        return -1;
+    }
+
+    let table = &unsafe { &*manager_ptr }.table;
+    let limit = count as usize;
+    table.open_limit.store(limit, AtomicOrdering::Relaxed);
+    if limit > 0 {
+        table.update(|services| {
+            if let Ok(mut registry) = table.registry.lock() {
+                close_least_recent(services, &mut registry, limit);
+            }
+        });
+    }
+    0
+}
+
 // Trigger a reload for a specific module
 #[no_mangle]
 pub extern "C" fn multi_manager_reload_index(
@@ -158,18 +617,320 @@ pub extern "C" fn multi_manager_reload_index(
         }
     };
 
-    match manager.services.lock() {
-        Ok(services) => {
-            if let Some(service) = services.get(module_name) {
-                // Use the trigger_index_reload function from our FFI module
-                let service_ptr = service.as_ref() as *const SearchService as *mut SearchService;
-                crate::ffi::trigger_index_reload(service_ptr)
-            } else {
-                -1 // Module not found
+    // Publishes a new searcher inside the service; the table is unchanged
+    match manager.table.services.load().get(module_name) {
+        Some(entry) => match entry.service.reload() {
+            Ok(_) => {
+                manager.table.cache.invalidate();
+                0
             }
+            Err(_) => -1,
+        },
+        None => -1, // Module not found
+    }
+}
+
+// Parse an optional JSON config (use defaults if not provided)
+fn parse_config(config_json_ptr: *const c_char) -> Option<MultiSearchConfig> {
+    if config_json_ptr.is_null() {
+        return Some(MultiSearchConfig {
+            limit: default_limit(),
+            weights: HashMap::new(),
+            module_filter: None,
+        });
+    }
+    let config_str = unsafe { CStr::from_ptr(config_json_ptr).to_str().ok()? };
+    serde_json::from_str(config_str).ok()
+}
+
+// A searched module. The searcher is kept so stored fields are read from
+// the same generation that produced its hit addresses.
+struct ModuleSource<'a> {
+    name: &'a str,
+    fields: &'a SearchFields,
+    searcher: Arc<Searcher>,
+}
+
+// Head of one sorted list during the k-way merge
+struct MergeCursor {
+    score: f32,
+    list: usize,
+    next: usize,
+}
+
+impl Ord for MergeCursor {
+    fn cmp(&self, other: &Self) -> Ordering {
+        // Max-heap on score; ties go to the lower list index so output is stable
+        self.score
+            .total_cmp(&other.score)
+            .then_with(|| other.list.cmp(&self.list))
+    }
+}
+
+impl PartialOrd for MergeCursor {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl PartialEq for MergeCursor {
+    fn eq(&self, other: &Self) -> bool {
+        self.cmp(other) == Ordering::Equal
+    }
+}
+
+impl Eq for MergeCursor {}
+
+// K-way merge of lists already sorted by descending score. Candidates are
+// offered to `take` best first until it has accepted `limit` of them; the
+// heap holds one cursor per list, so nothing past the final K is visited.
+fn merge_top_k<T>(
+    lists: &[Vec<(f32, T)>],
+    limit: usize,
+    mut take: impl FnMut(usize, f32, &T) -> bool,
+) {
+    let mut heap: BinaryHeap<MergeCursor> = lists
+        .iter()
+        .enumerate()
+        .filter_map(|(list, hits)| hits.first().map(|&(score, _)| MergeCursor { score, list, next: 0 }))
+        .collect();
+
+    let mut taken = 0;
+    while taken < limit {
+        let cursor = match heap.pop() {
+            Some(c) => c,
+            None => break,
+        };
+        let hits = &lists[cursor.list];
+        if let Some(&(score, _)) = hits.get(cursor.next + 1) {
+            heap.push(MergeCursor { score, list: cursor.list, next: cursor.next + 1 });
         }
-        Err(_) => -1,
+        let (score, ref item) = hits[cursor.next];
+        if take(cursor.list, score, item) {
+            taken += 1;
+        }
+    }
+}
+
+// FNV-1a over the id bytes; dedup only needs a cheap, well-spread key
+fn id_hash(id: &str) -> u64 {
+    id.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, byte| {
+        (hash ^ byte as u64).wrapping_mul(0x0000_0100_0000_01b3)
+    })
+}
+
+// Search every selected module and merge the hits, answering repeats from
+// the result cache. `select` maps (module name, slot) to the module's
+// weight, or None to skip it; `by_name` is set when it names modules
+// rather than taking every one, which reopens the selected registered
+// modules closed under memory pressure. `filter` is set for searches
+// through the filtered API. None on failure or once `cancelled` is set.
+// Phase times and the searched and pending modules go to `timing`.
+fn run_multi_search(
+    manager: &MultiSearchManager,
+    query_str: &str,
+    limit: usize,
+    select: impl Fn(&str, usize) -> Option<f32> + Send,
+    by_name: bool,
+    filter: Option<&Filter>,
+    cancelled: Option<&Arc<AtomicBool>>,
+    timing: &mut SearchTiming,
+) -> Option<Arc<Vec<MultiSearchResultItem>>> {
+    if limit == 0 {
+        return Some(Arc::new(Vec::new()));
+    }
+
+    // Read before the table so results from a table replaced mid-search
+    // are not cached
+    let epoch = manager.table.cache.epoch();
+
+    // Snapshot the module table; no lock is held while searching. Modules
+    // still opening are left out and reported instead of waited for.
+    let services = manager.table.services.load_full();
+    timing.pending_mask = manager.table.pending_mask(&services, &select, by_name.then_some(&manager.loader));
+
+    manager
+        .pools
+        .install(|| cached_search(&services, &manager.table.cache, epoch, query_str, limit, select, filter, cancelled, None, timing))
+}
+
+// Looks up or computes and caches the merged results for the modules of
+// `services` that `select` picks. `epoch` must be read before `services`.
+// A search cancelled part way returns None and caches nothing; one cut
+// short by `deadline` returns what it collected, uncached.
+fn cached_search(
+    services: &ModuleMap,
+    cache: &ResultCache<Vec<MultiSearchResultItem>>,
+    epoch: u64,
+    query_str: &str,
+    limit: usize,
+    select: impl Fn(&str, usize) -> Option<f32>,
+    filter: Option<&Filter>,
+    cancelled: Option<&Arc<AtomicBool>>,
+    deadline: Option<Instant>,
+    timing: &mut SearchTiming,
+) -> Option<Arc<Vec<MultiSearchResultItem>>> {
+    // Filter modules and resolve their weights
+    let mut scope = Vec::new();
+    let modules_to_search: Vec<ModuleTarget> = services
+        .iter()
+        .filter_map(|(name, entry)| {
+            let weight = select(name, entry.slot)?;
+            scope.push((entry.slot as u32, weight.to_bits()));
+            if entry.slot < MULTI_SEARCH_MAX_MODULES {
+                timing.searched_mask |= 1 << entry.slot;
+            }
+            Some((name, entry.service.as_ref(), weight, entry.slot))
+        })
+        .collect();
+    timing.module_count = modules_to_search.len() as u32;
+
+    let key = CacheKey::new(query_str, scope, limit).filtered(filter.map(Filter::cache_key));
+    if let Some(cached) = cache.get(&key) {
+        timing.cache_hit = 1;
+        return Some(cached);
+    }
+
+    let results = Arc::new(search_modules(&modules_to_search, query_str, limit, filter, cancelled, deadline, timing));
+    if cancelled.map_or(false, |flag| flag.load(AtomicOrdering::Relaxed)) {
+        return None;
     }
+    if deadline.map_or(false, |deadline| Instant::now() >= deadline) {
+        return Some(results);
+    }
+    let cost = results.iter().map(MultiSearchResultItem::cost).sum();
+    cache.insert(key, results.clone(), cost, epoch);
+    Some(results)
+}
+
+// Search modules in parallel and merge the hits.
+//
+// Each module contributes only scores and addresses; stored documents are
+// loaded during the merge, in final order, so a document is read only when
+// it is about to be returned or is a duplicate of a better-scoring hit.
+// With a filter, each module only collects documents passing it, and a
+// blank query lists them by priority instead (see filter.rs), unscored and
+// unweighted. Once `cancelled` is set, collection stops and the result is
+// empty; once `deadline` passes, collection stops and the hits so far are
+// merged.
+fn search_modules(
+    modules_to_search: &[ModuleTarget],
+    query_str: &str,
+    limit: usize,
+    filter: Option<&Filter>,
+    cancelled: Option<&Arc<AtomicBool>>,
+    deadline: Option<Instant>,
+    timing: &mut SearchTiming,
+) -> Vec<MultiSearchResultItem> {
+    // Perform parallel search, collecting only (score, address) per module,
+    // best first with the weight applied, along with each module's parse and
+    // collect times
+    let collect_start = Instant::now();
+    let browsing = filter.is_some() && query_str.trim().is_empty();
+    let searched: Vec<(ModuleSource, Vec<(f32, DocAddress)>, ModulePhases)> = modules_to_search
+        .par_iter()
+        .filter_map(|(module_name, service, weight, slot)| {
+            let _section = TraceSection::begin(TRACE_COLLECT);
+            let parse_start = Instant::now();
+            service.touch();
+            let searcher = service.searcher();
+            let query = if browsing { None } else { Some(service.query_parser.parse_query(query_str).ok()?) };
+            let parse_ns = elapsed_ns(parse_start);
+            let search_start = Instant::now();
+            let sets = filter.and_then(|f| service.filters.get(&searcher, &service.fields, f));
+            let hits = match query {
+                // BM25 x priority boost, pruning postings that cannot make the top K
+                Some(query) => {
+                    let collector = PriorityTopDocs::with_limit(limit).cancellable(cancelled).until(deadline).filtered(sets);
+                    let top_docs = searcher.search(&query, &collector).ok()?;
+                    top_docs.into_iter().map(|(score, address)| (score * weight, address)).collect()
+                }
+                // Negated so the merge, which takes the highest first, lists
+                // the lowest priority values first
+                None => browse(&searcher, sets.as_deref(), limit)
+                    .into_iter()
+                    .map(|(priority, address)| (-(priority as f32), address))
+                    .collect(),
+            };
+            let phases = ModulePhases { slot: *slot, parse_ns, collect_ns: elapsed_ns(search_start) };
+            service.queries.record(parse_start.elapsed());
+
+            let source = ModuleSource {
+                name: module_name.as_str(),
+                fields: &service.fields,
+                searcher,
+            };
+            Some((source, hits, phases))
+        })
+        .collect();
+    timing.collect_ns = elapsed_ns(collect_start);
+
+    let mut modules = Vec::with_capacity(searched.len());
+    let mut hit_lists = Vec::with_capacity(searched.len());
+    for (source, hits, phases) in searched {
+        timing.parse_ns += phases.parse_ns;
+        timing.record_module(phases.slot, phases.collect_ns);
+        modules.push(source);
+        hit_lists.push(hits);
+    }
+    // Skips loading stored documents for a superseded query
+    if cancelled.map_or(false, |flag| flag.load(AtomicOrdering::Relaxed)) {
+        return Vec::new();
+    }
+
+    // Merge best first, deduplicating by doc_id (keeping the highest scoring
+    // version). Stored field and snippet loads count as fetch, not merge.
+    let _section = TraceSection::begin(TRACE_MERGE);
+    let merge_start = Instant::now();
+    let mut fetch = std::time::Duration::ZERO;
+    let expected = limit.min(hit_lists.iter().map(Vec::len).sum());
+    let mut seen_ids = HashSet::with_capacity(expected);
+    let mut final_results = Vec::with_capacity(expected);
+    let mut snippets: Vec<_> = modules.iter().map(|m| m.fields.snippets(&m.searcher)).collect();
+
+    merge_top_k(&hit_lists, limit, |list, score, &address| {
+        let module = &modules[list];
+        let fetch_start = Instant::now();
+        let doc = module.searcher.doc::<TantivyDocument>(address);
+        fetch += fetch_start.elapsed();
+        let doc = match doc {
+            Ok(d) => d,
+            Err(_) => return false,
+        };
+        let doc_id = SearchFields::text(&doc, module.fields.id);
+        if !seen_ids.insert(id_hash(doc_id)) {
+            return false;
+        }
+
+        let fetch_start = Instant::now();
+        let summary = summary_or_snippet(SearchFields::text(&doc, module.fields.summary), &mut snippets[list], address)
+            .to_string();
+        fetch += fetch_start.elapsed();
+        final_results.push(MultiSearchResultItem {
+            doc_id: doc_id.to_string(),
+            title: SearchFields::text(&doc, module.fields.title).to_string(),
+            summary,
+            score: if browsing { 0.0 } else { score },
+            module: module.name.to_string(),
+            category: SearchFields::text(&doc, module.fields.category).to_string(),
+            priority: module.fields.priority(&doc),
+        });
+        true
+    });
+    timing.fetch_ns = nanos(fetch);
+    timing.merge_ns = elapsed_ns(merge_start).saturating_sub(timing.fetch_ns);
+
+    final_results
+}
+
+// A module to search: name, service, weight and slot
+type ModuleTarget<'a> = (&'a String, &'a SearchService, f32, usize);
+
+// One module's share of a search's time
+struct ModulePhases {
+    slot: usize,
+    parse_ns: u64,
+    collect_ns: u64,
 }
 
 // The core multi-search function
@@ -193,126 +954,470 @@ pub extern "C" fn multi_manager_search(
         }
     };
 
-    // Parse config (use defaults if not provided)
-    let config: MultiSearchConfig = if config_json_ptr.is_null() {
-        MultiSearchConfig {
-            limit: default_limit(),
-            weights: HashMap::new(),
-            module_filter: None,
-        }
-    } else {
-        let config_str = unsafe {
-            match CStr::from_ptr(config_json_ptr).to_str() {
-                Ok(s) => s,
-                Err(_) => return std::ptr::null(),
-            }
-        };
-        match serde_json::from_str(config_str) {
-            Ok(c) => c,
-            Err(_) => return std::ptr::null(),
-        }
-    };
-
-    // Get services to search
-    let services = match manager.services.lock() {
-        Ok(s) => s,
-        Err(_) => return std::ptr::null(),
+    let config = match parse_config(config_json_ptr) {
+        Some(c) => c,
+        None => return std::ptr::null(),
     };
 
-    // Filter modules if specified
-    let modules_to_search: Vec<(&String, &Box<SearchService>)> = if let Some(filter) = &config.module_filter {
-        services
-            .iter()
-            .filter(|(name, _)| filter.contains(name))
-            .collect()
-    } else {
-        services.iter().collect()
+    let mut timing = SearchTiming::default();
+    let final_results = match run_multi_search(manager, query_str, config.limit, |name, _| config.select(name), config.module_filter.is_some(), None, None, &mut timing) {
+        Some(results) => results,
+        None => return std::ptr::null(),
     };
 
-    // Perform parallel search
-    let all_results: Vec<Vec<MultiSearchResultItem>> = modules_to_search
-        .par_iter()
-        .map(|(module_name, service)| {
-            // Get weight for this module (default to 1.0)
-            let weight = config.weights.get(*module_name).unwrap_or(&1.0);
-            
-            // Perform search using the service
-            let searcher = service.reader.searcher();
-            let query = match service.query_parser.parse_query(query_str) {
-                Ok(q) => q,
-                Err(_) => return Vec::new(),
-            };
-
-            let top_docs = match searcher.search(&query, &TopDocs::with_limit(config.limit)) {
-                Ok(td) => td,
-                Err(_) => return Vec::new(),
-            };
-
-            // Convert results
-            let mut module_results = Vec::new();
-            for (score, doc_address) in top_docs {
-                if let Ok(doc) = searcher.doc::<TantivyDocument>(doc_address) {
-                    let doc_id = doc.get_first(service.schema.get_field("id").unwrap())
-                        .and_then(|v| v.as_str())
-                        .unwrap_or("")
-                        .to_string();
-                    let title = doc.get_first(service.schema.get_field("title").unwrap())
-                        .and_then(|v| v.as_str())
-                        .unwrap_or("")
-                        .to_string();
-                    let summary = doc.get_first(service.schema.get_field("summary").unwrap())
-                        .and_then(|v| v.as_str())
-                        .unwrap_or("")
-                        .to_string();
-
-                    module_results.push(MultiSearchResultItem {
-                        doc_id,
-                        title,
-                        summary,
-                        score: score * weight,
-                        module: module_name.to_string(),
-                    });
-                }
-            }
-            module_results
-        })
-        .collect();
-
-    // Flatten and merge results
-    let mut merged_results: Vec<MultiSearchResultItem> = all_results
-        .into_iter()
-        .flatten()
-        .collect();
-
-    // Sort by score (descending)
-    merged_results.sort_by(|a, b| b.score.partial_cmp(&a.score).unwrap());
-
-    // Deduplicate by doc_id (keeping highest scoring version)
-    let mut seen_ids = HashSet::new();
-    let mut final_results = Vec::new();
-    
-    for result in merged_results {
-        if seen_ids.insert(result.doc_id.clone()) {
-            final_results.push(result);
-            if final_results.len() >= config.limit {
-                break;
-            }
-        }
-    }
-
     // Serialize to JSON
-    match serde_json::to_string(&final_results) {
+    match serde_json::to_string(&*final_results) {
         Ok(json) => CString::new(json).map_or(std::ptr::null(), |s| s.into_raw()),
         Err(_) => std::ptr::null(),
     }
 }
 
-// Free a string allocated by Rust (for consistency with ffi.rs)
+// Multi-search writing into a caller-owned buffer with the packed layout
+// from packed.rs instead of a JSON string.
+// Returns the number of packed rows, or -1 on failure.
 #[no_mangle]
-pub extern "C" fn free_rust_string(s: *mut c_char) {
-    if !s.is_null() {
-        unsafe {
-            let _ = CString::from_raw(s);
+pub extern "C" fn multi_manager_search_packed(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    config_json_ptr: *const c_char,
+    buffer: *mut u8,
+    capacity: usize,
+) -> i32 {
+    if manager_ptr.is_null() || query_ptr.is_null() {
+        return -1;
+    }
+    let buf = match unsafe { buffer_from_raw(buffer, capacity) } {
+        Some(b) => b,
+        None => return -1,
+    };
+
+    let manager = unsafe { &*manager_ptr };
+    let query_str = unsafe {
+        match CStr::from_ptr(query_ptr).to_str() {
+            Ok(s) => s,
+            Err(_) => return -1,
+        }
+    };
+    let config = match parse_config(config_json_ptr) {
+        Some(c) => c,
+        None => return -1,
+    };
+
+    let start = Instant::now();
+    let mut timing = SearchTiming::default();
+    let results = match run_multi_search(manager, query_str, config.limit, |name, _| config.select(name), config.module_filter.is_some(), None, None, &mut timing) {
+        Some(r) => r,
+        None => return -1,
+    };
+    pack_results(&results, buf, start)
+}
+
+// Multi-search driven by binary options, writing the packed layout into a
+// caller-owned buffer. Neither the config nor the results touch JSON.
+// `options` may be null for multi_search_options_default().
+// Returns the number of packed rows, or -1 on failure.
+#[no_mangle]
+pub extern "C" fn multi_manager_search_binary(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    options: *const MultiSearchOptions,
+    buffer: *mut u8,
+    capacity: usize,
+) -> i32 {
+    multi_manager_search_binary_timed(manager_ptr, query_ptr, options, buffer, capacity, std::ptr::null_mut())
+}
+
+/// multi_manager_search_binary that also fills `timing`, when not null,
+/// with the search's phases in nanoseconds. Every field is written, with
+/// zeros for phases that did not run, e.g. parse and collect on a cache
+/// hit; `marshal_ns` is left for the caller. The phases are also trace
+/// sections on Android: tantivy.search, tantivy.collect per module,
+/// tantivy.merge and tantivy.pack.
+#[no_mangle]
+pub extern "C" fn multi_manager_search_binary_timed(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    options: *const MultiSearchOptions,
+    buffer: *mut u8,
+    capacity: usize,
+    timing_ptr: *mut SearchTiming,
+) -> i32 {
+    search_binary(manager_ptr, query_ptr, options, None, buffer, capacity, timing_ptr)
+}
+
+/// Multi-search with binary options that only returns documents passing
+/// `filter`: its category, when set, and priority range. The filter is
+/// applied per segment while collecting, so it narrows the documents that
+/// are scored rather than the top K afterwards. A blank query lists the
+/// passing documents by ascending priority with a score of 0, without
+/// scoring anything; module weights do not apply to such a listing. Module
+/// filters are the options' module_mask. `options` may be null for the
+/// defaults, `filter` null to filter nothing, which makes a blank query
+/// list every article.
+/// Returns the number of packed rows, or -1 on failure.
+#[no_mangle]
+pub extern "C" fn multi_manager_search_filtered(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    options: *const MultiSearchOptions,
+    filter: *const SearchFilter,
+    buffer: *mut u8,
+    capacity: usize,
+) -> i32 {
+    let filter = match Filter::from_raw(filter) {
+        Some(f) => f,
+        None => return -1,
+    };
+    search_binary(manager_ptr, query_ptr, options, Some(&filter), buffer, capacity, std::ptr::null_mut())
+}
+
+// Binary options and packed results, with the filter of the filtered API
+fn search_binary(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    options: *const MultiSearchOptions,
+    filter: Option<&Filter>,
+    buffer: *mut u8,
+    capacity: usize,
+    timing_ptr: *mut SearchTiming,
+) -> i32 {
+    if manager_ptr.is_null() || query_ptr.is_null() {
+        return -1;
+    }
+    let buf = match unsafe { buffer_from_raw(buffer, capacity) } {
+        Some(b) => b,
+        None => return -1,
+    };
+
+    let manager = unsafe { &*manager_ptr };
+    let query_str = unsafe {
+        match CStr::from_ptr(query_ptr).to_str() {
+            Ok(s) => s,
+            Err(_) => return -1,
+        }
+    };
+    let defaults;
+    let options = if options.is_null() {
+        defaults = multi_search_options_default();
+        &defaults
+    } else {
+        unsafe { &*options }
+    };
+
+    let _section = TraceSection::begin(TRACE_SEARCH);
+    let start = Instant::now();
+    let mut timing = SearchTiming::default();
+    let results = run_multi_search(manager, query_str, options.limit as usize, |_, slot| options.select(slot), options.module_mask != 0, filter, None, &mut timing);
+    let count = match results {
+        Some(r) => {
+            let pack_start = Instant::now();
+            let count = pack_results(&r, buf, start);
+            timing.serialize_ns = elapsed_ns(pack_start);
+            count
+        }
+        None => -1,
+    };
+    timing.total_ns = elapsed_ns(start);
+    if !timing_ptr.is_null() {
+        unsafe { *timing_ptr = timing };
+    }
+    count
+}
+
+/// Queues a multi-search with binary options on the manager's search
+/// threads and returns at once. `callback` runs exactly once per returned
+/// id, on a search thread, with the packed row count (or a negative error
+/// code) and the packed results, which are only valid during the call.
+/// A cancelled search reports TANTIVY_ERROR_CANCELLED.
+///
+/// # Safety
+/// `query_ptr` must be a valid, null-terminated C string; it and `options`
+/// (null for the defaults) are copied before returning. `user_data` is
+/// passed to `callback` as is. `destroy_multi_manager` cancels pending
+/// searches and waits for their callbacks, so it must not be called from
+/// inside one. Returns the request id, or 0 on invalid input.
+#[no_mangle]
+pub extern "C" fn multi_manager_search_async(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    options: *const MultiSearchOptions,
+    callback: Option<MultiSearchCallback>,
+    user_data: *mut c_void,
+) -> u64 {
+    let callback = match callback {
+        Some(c) if !manager_ptr.is_null() && !query_ptr.is_null() => c,
+        _ => return 0,
+    };
+
+    let manager = unsafe { &*manager_ptr };
+    let query = match unsafe { CStr::from_ptr(query_ptr) }.to_str() {
+        Ok(s) => s.to_string(),
+        Err(_) => return 0,
+    };
+    let options = if options.is_null() { multi_search_options_default() } else { unsafe { *options } };
+
+    // Snapshot now, as a warmup does: the manager may change while queued
+    let epoch = manager.table.cache.epoch();
+    let services = manager.table.services.load_full();
+    let cache = manager.table.cache.clone();
+    let pools = manager.pools.clone();
+
+    let search = move |cancelled: &Arc<AtomicBool>| {
+        let start = Instant::now();
+        let limit = options.limit as usize;
+        let results = if limit == 0 {
+            Some(Arc::new(Vec::new()))
+        } else {
+            let mut timing = SearchTiming::default();
+            pools.install(|| {
+                let select = |_: &str, slot| options.select(slot);
+                cached_search(&services, &cache, epoch, &query, limit, select, None, Some(cancelled), None, &mut timing)
+            })
+        };
+        match results {
+            Some(r) => pack_owned(&r, start),
+            None => (TANTIVY_ERROR_CANCELLED, Vec::new()),
+        }
+    };
+    manager.async_searches.submit(search, callback, user_data)
+}
+
+/// Queues a multi-search like multi_manager_search_async, but searches the
+/// selected modules one tier at a time, lowest first, so the core modules
+/// answer without waiting on large reference modules. After every tier but
+/// the last, `callback` gets a batch with `is_final` 0: the top K merged
+/// over the tiers searched so far, so each batch replaces the previous
+/// one. The final call, `is_final` 1, runs exactly once per returned id.
+/// Modules loaded directly are tier 0; registered modules keep the tier
+/// they were registered with, and only those already open are searched.
+///
+/// `tier_deadlines_ms` holds `deadline_count` budgets in milliseconds, one
+/// per tier in search order, the last repeating for further tiers; 0 (or
+/// no budgets) means none. A tier that runs out stops collecting and
+/// contributes the hits it found so far.
+///
+/// # Safety
+/// As for multi_manager_search_async; `tier_deadlines_ms` is copied before
+/// returning. Batches stop soon after a cancel (one being delivered may
+/// still arrive) and the final call reports TANTIVY_ERROR_CANCELLED.
+/// Returns the request id, or 0 on invalid input.
+#[no_mangle]
+pub extern "C" fn multi_manager_search_tiered(
+    manager_ptr: *const MultiSearchManager,
+    query_ptr: *const c_char,
+    options: *const MultiSearchOptions,
+    tier_deadlines_ms: *const u32,
+    deadline_count: usize,
+    callback: Option<TieredSearchCallback>,
+    user_data: *mut c_void,
+) -> u64 {
+    let callback = match callback {
+        Some(c) if !manager_ptr.is_null() && !query_ptr.is_null() => c,
+        _ => return 0,
+    };
+    if tier_deadlines_ms.is_null() && deadline_count > 0 {
+        return 0;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let query = match unsafe { CStr::from_ptr(query_ptr) }.to_str() {
+        Ok(s) => s.to_string(),
+        Err(_) => return 0,
+    };
+    let options = if options.is_null() { multi_search_options_default() } else { unsafe { *options } };
+    let deadlines = if deadline_count == 0 {
+        Vec::new()
+    } else {
+        unsafe { std::slice::from_raw_parts(tier_deadlines_ms, deadline_count) }.to_vec()
+    };
+
+    let epoch = manager.table.cache.epoch();
+    let services = manager.table.services.load_full();
+    let cache = manager.table.cache.clone();
+    let pools = manager.pools.clone();
+
+    let search = move |cancelled: &Arc<AtomicBool>, emit: EmitBatch| {
+        let start = Instant::now();
+        let limit = options.limit as usize;
+        let mut tiers: Vec<u32> =
+            services.values().filter(|e| options.select(e.slot).is_some()).map(|e| e.tier).collect();
+        tiers.sort_unstable();
+        tiers.dedup();
+        if limit == 0 {
+            tiers.clear();
+        }
+
+        let mut searched = Vec::with_capacity(tiers.len());
+        let mut merged = Vec::new();
+        for (n, &tier) in tiers.iter().enumerate() {
+            let budget_ms = deadlines.get(n).or(deadlines.last()).copied().unwrap_or(0);
+            let deadline = (budget_ms > 0).then(|| Instant::now() + std::time::Duration::from_millis(budget_ms as u64));
+            let select = |name: &str, slot| services.get(name).filter(|e| e.tier == tier).and_then(|_| options.select(slot));
+            let mut timing = SearchTiming::default();
+            let results = pools.install(|| {
+                cached_search(&services, &cache, epoch, &query, limit, select, None, Some(cancelled), deadline, &mut timing)
+            });
+            match results {
+                Some(r) => searched.push(r),
+                None => return (TANTIVY_ERROR_CANCELLED, Vec::new()),
+            }
+            merged = merge_tiers(&searched, limit);
+            if n + 1 < tiers.len() {
+                let (count, buf) = pack_owned(&merged, start);
+                emit(count, &buf);
+            }
+        }
+        pack_owned(&merged, start)
+    };
+    manager.async_searches.submit_tiered(search, callback, user_data)
+}
+
+// Top `limit` of the merged results of several tiers, each sorted best
+// first, keeping the best scoring copy of a doc_id as search_modules does
+fn merge_tiers(tiers: &[Arc<Vec<MultiSearchResultItem>>], limit: usize) -> Vec<MultiSearchResultItem> {
+    let lists: Vec<Vec<(f32, &MultiSearchResultItem)>> =
+        tiers.iter().map(|items| items.iter().map(|item| (item.score, item)).collect()).collect();
+    let expected = limit.min(lists.iter().map(Vec::len).sum());
+    let mut seen_ids = HashSet::with_capacity(expected);
+    let mut merged = Vec::with_capacity(expected);
+    merge_top_k(&lists, limit, |_, _, item| {
+        if !seen_ids.insert(id_hash(&item.doc_id)) {
+            return false;
+        }
+        merged.push((*item).clone());
+        true
+    });
+    merged
+}
+
+/// Cancels an async search. Collection stops at the next document visited,
+/// loading documents is skipped and the callback reports
+/// TANTIVY_ERROR_CANCELLED.
+/// Returns 0 if the search was cancelled, -1 if its callback has already
+/// started, the id is unknown or the manager is null.
+#[no_mangle]
+pub extern "C" fn multi_manager_cancel_search(manager_ptr: *const MultiSearchManager, request_id: u64) -> i32 {
+    if manager_ptr.is_null() {
+        return -1;
+    }
+
+    if unsafe { &*manager_ptr }.async_searches.cancel(request_id) {
+        0
+    } else {
+        -1
+    }
+}
+
+// Slot of a loaded or registered module for MultiSearchOptions, or -1 if
+// the manager has no such module
+#[no_mangle]
+pub extern "C" fn multi_manager_module_slot(
+    manager_ptr: *const MultiSearchManager,
+    module_name_ptr: *const c_char,
+) -> i32 {
+    if manager_ptr.is_null() || module_name_ptr.is_null() {
+        return -1;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let module_name = unsafe {
+        match CStr::from_ptr(module_name_ptr).to_str() {
+            Ok(s) => s,
+            Err(_) => return -1,
+        }
+    };
+
+    if let Some(entry) = manager.table.services.load().get(module_name) {
+        return entry.slot as i32;
+    }
+    match manager.table.registry.lock() {
+        Ok(registry) => registry.get(module_name).map_or(-1, |r| r.slot as i32),
+        Err(_) => -1,
+    }
+}
+
+// Bytes pack_results needs to hold every row
+fn packed_size(results: &[MultiSearchResultItem]) -> usize {
+    let strings: usize = results.iter().map(|r| r.doc_id.len() + r.title.len() + r.summary.len() + r.module.len() + r.category.len())
+        .sum();
+    PACKED_HEADER_SIZE + results.len() * PACKED_ROW_SIZE + strings
+}
+
+// Packs into a buffer of its own, for searches that outlive the caller's
+fn pack_owned(results: &[MultiSearchResultItem], start: Instant) -> (i32, Vec<u8>) {
+    let mut buf = vec![0u8; packed_size(results)];
+    let count = pack_results(results, &mut buf, start);
+    (count, buf)
+}
+
+fn pack_results(results: &[MultiSearchResultItem], buf: &mut [u8], start: Instant) -> i32 {
+    let _section = TraceSection::begin(TRACE_PACK);
+    let mut writer = match PackedWriter::new(buf, results.len()) {
+        Some(w) => w,
+        None => return -1,
+    };
+    for item in results {
+        let row = PackedRow {
+            id: &item.doc_id,
+            title: &item.title,
+            category: &item.category,
+            summary: &item.summary,
+            module: &item.module,
+            priority: item.priority as u32,
+            score: item.score,
+        };
+        if !writer.push(&row) {
+            break;
+        }
+    }
+    writer.finish(results.len(), start.elapsed().as_millis() as u64)
+}
+
+/// Stored fields of the article with id `doc_id` as a JSON object, from
+/// module `module_name`, or from the first loaded module that has it when
+/// `module_name` is null. Resolved through the module's id table when it
+/// has one, so opening an article parses no query.
+///
+/// # Safety
+/// `doc_id_ptr` and a non-null `module_name_ptr` must be valid,
+/// null-terminated C strings. The result must be freed with
+/// `free_rust_string`. Returns null when no module has the article.
+#[no_mangle]
+pub extern "C" fn multi_manager_get_document(
+    manager_ptr: *const MultiSearchManager,
+    module_name_ptr: *const c_char,
+    doc_id_ptr: *const c_char,
+) -> *const c_char {
+    if manager_ptr.is_null() || doc_id_ptr.is_null() {
+        return std::ptr::null();
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let doc_id = match unsafe { CStr::from_ptr(doc_id_ptr) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return std::ptr::null(),
+    };
+    let module_name = if module_name_ptr.is_null() {
+        None
+    } else {
+        match unsafe { CStr::from_ptr(module_name_ptr) }.to_str() {
+            Ok(s) => Some(s),
+            Err(_) => return std::ptr::null(),
+        }
+    };
+
+    match manager.find_document(module_name, doc_id) {
+        Some((service, doc)) => crate::ffi::document_json(&service.schema, &doc),
+        None => std::ptr::null(),
+    }
+}
+
+// Free a string allocated by Rust (for consistency with ffi.rs)
+#[no_mangle]
+pub extern "C" fn free_rust_string(s: *mut c_char) {
+    if !s.is_null() {
+        unsafe {
+            let _ = CString::from_raw(s);
         }
     }
 }
@@ -322,7 +1427,43 @@ pub extern "C" fn free_rust_string(s: *mut c_char) {
 struct ModuleStats {
     name: String,
     num_docs: u64,
+    // Segment file bytes; the name predates measuring them
     estimated_size_bytes: u64,
+    mapped_bytes: u64,
+    resident_bytes: u64,
+    heap_bytes: u64,
+    docstore_cache_bytes: u64,
+    segment_count: u32,
+    query_count: u64,
+    query_time_ns: u64,
+    latency_histogram: [u64; TANTIVY_LATENCY_BUCKETS],
+}
+
+/// Fills `out` with one module's footprint and query counters: the binary
+/// counterpart of its multi_manager_get_stats entry, cheap enough to sample
+/// periodically. Returns 0, or -1 if the module is not loaded.
+#[no_mangle]
+pub extern "C" fn multi_manager_module_stats(
+    manager_ptr: *const MultiSearchManager,
+    module_name_ptr: *const c_char,
+    out: *mut IndexStats,
+) -> i32 {
+    if manager_ptr.is_null() || module_name_ptr.is_null() || out.is_null() {
+        return -1;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let module_name = match unsafe { CStr::from_ptr(module_name_ptr) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return -1,
+    };
+    match manager.table.services.load().get(module_name) {
+        Some(entry) => {
+            unsafe { *out = entry.service.stats() };
+            0
+        }
+        None => -1,
+    }
 }
 
 #[no_mangle]
@@ -333,21 +1474,24 @@ pub extern "C" fn multi_manager_get_stats(manager_ptr: *const MultiSearchManager
 
     let manager = unsafe { &*manager_ptr };
     
-    let services = match manager.services.lock() {
-        Ok(s) => s,
-        Err(_) => return std::ptr::null(),
-    };
+    let services = manager.table.services.load();
 
     let stats: Vec<ModuleStats> = services
         .iter()
-        .map(|(name, service)| {
-            let searcher = service.reader.searcher();
-            let num_docs = searcher.num_docs();
-            
+        .map(|(name, entry)| {
+            let stats = entry.service.stats();
             ModuleStats {
                 name: name.clone(),
-                num_docs,
-                estimated_size_bytes: num_docs * 1024, // Rough estimate
+                num_docs: stats.num_docs,
+                estimated_size_bytes: stats.index_size_bytes,
+                mapped_bytes: stats.mapped_bytes,
+                resident_bytes: stats.resident_bytes,
+                heap_bytes: stats.heap_bytes,
+                docstore_cache_bytes: stats.docstore_cache_bytes,
+                segment_count: stats.segment_count,
+                query_count: stats.query_count,
+                query_time_ns: stats.query_time_ns,
+                latency_histogram: stats.latency_histogram,
             }
         })
         .collect();
@@ -358,6 +1502,164 @@ pub extern "C" fn multi_manager_get_stats(manager_ptr: *const MultiSearchManager
     }
 }
 
+/// Starts warming every loaded module with the queries listed in a content
+/// manifest (`search_config.warmup_queries`, or the home screen shortcut
+/// queries). Runs on its own thread with a single search worker, so user
+/// searches keep the shared pool; results land in the result cache under
+/// the default options, matching an unfiltered search at the manifest's
+/// `default_limit`.
+///
+/// # Safety
+/// `manifest_json_ptr` must be a valid, null-terminated C string. The result
+/// must be freed with `warmup_free`, which also cancels it. Returns null on
+/// invalid input or when there is nothing to warm.
+#[no_mangle]
+pub extern "C" fn multi_manager_start_warmup(
+    manager_ptr: *const MultiSearchManager,
+    manifest_json_ptr: *const c_char,
+) -> *mut WarmupHandle {
+    if manager_ptr.is_null() || manifest_json_ptr.is_null() {
+        return std::ptr::null_mut();
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let manifest_json = match unsafe { CStr::from_ptr(manifest_json_ptr) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let (queries, limit) = match warmup_plan(manifest_json) {
+        Some(plan) => plan,
+        None => return std::ptr::null_mut(),
+    };
+    let limit = limit.unwrap_or_else(default_limit);
+    if queries.is_empty() || limit == 0 {
+        return std::ptr::null_mut();
+    }
+
+    // Fixed at start: a module change bumps the epoch, after which the
+    // remaining queries still fault pages in but no longer fill the cache
+    let epoch = manager.table.cache.epoch();
+    let services = manager.table.services.load_full();
+    let cache = manager.table.cache.clone();
+    let hints = manager.pools.hints();
+    let pool = match rayon::ThreadPoolBuilder::new()
+        .num_threads(1)
+        .thread_name(|_| "tantivy-warmup-search".into())
+        .start_handler(move |_| hints.apply())
+        .build()
+    {
+        Ok(p) => p,
+        Err(_) => return std::ptr::null_mut(),
+    };
+
+    let handle = WarmupHandle::spawn(queries, move |query| {
+        pool.install(|| {
+            cached_search(&services, &cache, epoch, query, limit, |_, _| Some(1.0), None, None, None, &mut SearchTiming::default());
+        });
+    });
+    handle.map_or(std::ptr::null_mut(), |h| Box::into_raw(Box::new(h)))
+}
+
+/// Caps the index pages kept resident across all modules, in bytes; 0
+/// removes the cap. Checked now, after each load and on every trim: the
+/// least recently searched modules are paged out first.
+/// Returns 0 on success, -1 on a null manager.
+#[no_mangle]
+pub extern "C" fn multi_manager_set_memory_budget(manager_ptr: *const MultiSearchManager, bytes: usize) -> i32 {
+    if manager_ptr.is_null() {
+        return -1;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    manager.table.memory_budget.store(bytes, AtomicOrdering::Relaxed);
+    manager.table.enforce_memory_budget();
+    0
+}
+
+/// Releases memory in response to an OS memory warning (Android
+/// onTrimMemory, iOS didReceiveMemoryWarning). `TANTIVY_TRIM_MODERATE`
+/// drops the docstore and postings pages of every module but the most
+/// recently searched one; `TANTIVY_TRIM_CRITICAL` also closes every
+/// registered module but the most recently searched one, drops every
+/// remaining module's pages and clears the result cache. Searches keep
+/// working and fault pages back in as needed; closed modules reopen when a
+/// search selects them by name.
+/// Returns 0 on success, -1 on a null manager or unknown level.
+#[no_mangle]
+pub extern "C" fn multi_manager_trim_memory(manager_ptr: *const MultiSearchManager, level: i32) -> i32 {
+    if manager_ptr.is_null() {
+        return -1;
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    let services = manager.table.services.load_full();
+    let modules = ModuleTable::by_recency(&services);
+    match level {
+        TANTIVY_TRIM_MODERATE => {
+            if let Some((_, cold)) = modules.split_last() {
+                cold.iter().for_each(|service| service.page_out(PageOut::Cold));
+            }
+            manager.table.enforce_memory_budget();
+        }
+        TANTIVY_TRIM_CRITICAL => {
+            let table = &manager.table;
+            table.update(|services| {
+                if let Ok(mut registry) = table.registry.lock() {
+                    close_least_recent(services, &mut registry, 1);
+                }
+            });
+            modules.iter().for_each(|service| service.page_out(PageOut::All));
+            table.cache.invalidate();
+        }
+        _ => return -1,
+    }
+    0
+}
+
+/// Starts (`active` = 1) or ends (0) one background indexing job. While any
+/// is active, searches run on the `background_search_threads` pool so that
+/// indexing and search together stay off the remaining cores.
+/// Returns 0 on success, -1 on a null manager.
+#[no_mangle]
+pub extern "C" fn multi_manager_set_background_indexing(manager_ptr: *const MultiSearchManager, active: i32) -> i32 {
+    if manager_ptr.is_null() {
+        return -1;
+    }
+
+    unsafe { &*manager_ptr }.pools.set_indexing(active != 0);
+    0
+}
+
+/// Result cache counters as JSON:
+/// {"hits":..,"misses":..,"entries":..,"bytes":..,"capacity_bytes":..}
+///
+/// # Safety
+/// The returned string must be freed with `free_rust_string`.
+#[no_mangle]
+pub extern "C" fn multi_manager_cache_stats(manager_ptr: *const MultiSearchManager) -> *const c_char {
+    if manager_ptr.is_null() {
+        return std::ptr::null();
+    }
+
+    let manager = unsafe { &*manager_ptr };
+    match serde_json::to_string(&manager.table.cache.stats()) {
+        Ok(json) => CString::new(json).map_or(std::ptr::null(), |s| s.into_raw()),
+        Err(_) => std::ptr::null(),
+    }
+}
+
+/// Sets the result cache memory cap in bytes; 0 disables caching.
+/// Returns 0 on success, -1 on a null manager.
+#[no_mangle]
+pub extern "C" fn multi_manager_set_cache_capacity(manager_ptr: *const MultiSearchManager, bytes: usize) -> i32 {
+    if manager_ptr.is_null() {
+        return -1;
+    }
+
+    unsafe { &*manager_ptr }.table.cache.set_capacity(bytes);
+    0
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -366,15 +1668,226 @@ mod tests {
     fn test_multi_manager_lifecycle() {
         let manager_ptr = init_multi_manager();
         assert!(!manager_ptr.is_null());
+
+        let mut stats = IndexStats::empty();
+        let name = CString::new("missing").unwrap();
+        assert_eq!(multi_manager_module_stats(manager_ptr, name.as_ptr(), &mut stats), -1);
+        let doc_id = CString::new("article-1").unwrap();
+        assert!(multi_manager_get_document(manager_ptr, std::ptr::null(), doc_id.as_ptr()).is_null());
         
         destroy_multi_manager(manager_ptr);
     }
 
+    #[test]
+    fn test_register_without_opening() {
+        let manager_ptr = init_multi_manager();
+        let missing = CString::new("missing").unwrap();
+        let maps = CString::new("maps").unwrap();
+        let path = CString::new("/nonexistent/tantivy-index").unwrap();
+
+        assert_eq!(multi_manager_module_state(manager_ptr, missing.as_ptr()), -1);
+        // Slots are assigned before anything opens
+        assert_eq!(multi_manager_register_index(manager_ptr, missing.as_ptr(), path.as_ptr(), 1, 0), 0);
+        assert_eq!(multi_manager_register_index(manager_ptr, maps.as_ptr(), path.as_ptr(), 3, 0), 0);
+        assert_eq!(multi_manager_module_slot(manager_ptr, missing.as_ptr()), 0);
+        assert_eq!(multi_manager_module_slot(manager_ptr, maps.as_ptr()), 1);
+
+        // The loader thread fails to open both; they are never searchable
+        let settled = || {
+            [&missing, &maps]
+                .iter()
+                .all(|name| multi_manager_module_state(manager_ptr, name.as_ptr()) == TANTIVY_MODULE_FAILED)
+        };
+        let deadline = Instant::now() + std::time::Duration::from_secs(10);
+        while !settled() && Instant::now() < deadline {
+            std::thread::sleep(std::time::Duration::from_millis(5));
+        }
+        assert!(settled());
+
+        let query = CString::new("water").unwrap();
+        let mut buffer = vec![0u8; 4096];
+        let mut timing = SearchTiming::default();
+        let count = multi_manager_search_binary_timed(
+            manager_ptr,
+            query.as_ptr(),
+            std::ptr::null(),
+            buffer.as_mut_ptr(),
+            buffer.len(),
+            &mut timing,
+        );
+        assert_eq!(count, 0);
+        assert_eq!(timing.searched_mask, 0);
+        assert_eq!(timing.pending_mask, 0);
+
+        assert_eq!(multi_manager_unload_index(manager_ptr, maps.as_ptr()), 0);
+        assert_eq!(multi_manager_module_state(manager_ptr, maps.as_ptr()), -1);
+        assert_eq!(multi_manager_set_open_module_limit(manager_ptr, 1), 0);
+
+        destroy_multi_manager(manager_ptr);
+    }
+
+    extern "C" fn count_rows(_: u64, status: i32, _: *const u8, _: usize, user_data: *mut c_void) {
+        let sender = unsafe { &*(user_data as *const Mutex<std::sync::mpsc::Sender<i32>>) };
+        let _ = sender.lock().unwrap().send(status);
+    }
+
+    #[test]
+    fn test_search_async_without_modules() {
+        let manager_ptr = init_multi_manager();
+        let (tx, rx) = std::sync::mpsc::channel();
+        let sender = Mutex::new(tx);
+        let query = CString::new("water").unwrap();
+
+        let id = multi_manager_search_async(
+            manager_ptr,
+            query.as_ptr(),
+            std::ptr::null(),
+            Some(count_rows),
+            &sender as *const _ as *mut c_void,
+        );
+        assert_ne!(id, 0);
+        assert_eq!(rx.recv().unwrap(), 0);
+        assert_eq!(multi_manager_cancel_search(manager_ptr, id), -1);
+
+        destroy_multi_manager(manager_ptr);
+    }
+
+    extern "C" fn record_tier(_: u64, status: i32, _: *const u8, _: usize, is_final: i32, user_data: *mut c_void) {
+        let sender = unsafe { &*(user_data as *const Mutex<std::sync::mpsc::Sender<(i32, i32)>>) };
+        let _ = sender.lock().unwrap().send((status, is_final));
+    }
+
+    #[test]
+    fn test_search_tiered_without_modules() {
+        let manager_ptr = init_multi_manager();
+        let (tx, rx) = std::sync::mpsc::channel();
+        let sender = Mutex::new(tx);
+        let query = CString::new("water").unwrap();
+        let deadlines = [50u32, 0];
+
+        // Budgets without a pointer to them
+        let rejected = multi_manager_search_tiered(
+            manager_ptr,
+            query.as_ptr(),
+            std::ptr::null(),
+            std::ptr::null(),
+            2,
+            Some(record_tier),
+            &sender as *const _ as *mut c_void,
+        );
+        assert_eq!(rejected, 0);
+
+        let id = multi_manager_search_tiered(
+            manager_ptr,
+            query.as_ptr(),
+            std::ptr::null(),
+            deadlines.as_ptr(),
+            deadlines.len(),
+            Some(record_tier),
+            &sender as *const _ as *mut c_void,
+        );
+        assert_ne!(id, 0);
+        // No tiers to batch: only the final call
+        assert_eq!(rx.recv().unwrap(), (0, 1));
+
+        destroy_multi_manager(manager_ptr);
+        assert!(rx.try_recv().is_err());
+    }
+
+    fn item(doc_id: &str, score: f32, module: &str) -> MultiSearchResultItem {
+        MultiSearchResultItem {
+            doc_id: doc_id.to_string(),
+            title: String::new(),
+            summary: String::new(),
+            score,
+            module: module.to_string(),
+            category: String::new(),
+            priority: 0,
+        }
+    }
+
+    #[test]
+    fn test_merge_tiers() {
+        let core = Arc::new(vec![item("tourniquet", 6.0, "medical"), item("splint", 2.0, "medical")]);
+        let reference = Arc::new(vec![item("hemorrhage", 9.0, "wikipedia"), item("tourniquet", 5.0, "wikipedia")]);
+
+        let merged = merge_tiers(&[core.clone(), reference], 3);
+        let ids: Vec<(&str, &str)> = merged.iter().map(|r| (r.doc_id.as_str(), r.module.as_str())).collect();
+        assert_eq!(ids, vec![("hemorrhage", "wikipedia"), ("tourniquet", "medical"), ("splint", "medical")]);
+        assert_eq!(merge_tiers(&[core], 1).len(), 1);
+        assert!(merge_tiers(&[], 5).is_empty());
+    }
+
+    #[test]
+    fn test_options_select() {
+        let mut options = multi_search_options_default();
+        assert_eq!(options.select(3), Some(1.0));
+
+        options.module_mask = 1 << 2;
+        options.module_weights[2] = 2.5;
+        assert_eq!(options.select(2), Some(2.5));
+        assert_eq!(options.select(0), None);
+        assert_eq!(options.select(MULTI_SEARCH_MAX_MODULES + 1), None);
+    }
+
+    #[test]
+    fn test_merge_top_k() {
+        let lists = vec![
+            vec![(9.0, "a"), (4.0, "b"), (1.0, "c")],
+            vec![(7.0, "a"), (5.0, "d")],
+            vec![],
+            vec![(8.0, "e")],
+        ];
+
+        let mut seen = HashSet::new();
+        let mut merged = Vec::new();
+        merge_top_k(&lists, 4, |list, score, id| {
+            if !seen.insert(id_hash(id)) {
+                return false;
+            }
+            merged.push((list, score, *id));
+            true
+        });
+
+        assert_eq!(merged, vec![(0, 9.0, "a"), (3, 8.0, "e"), (1, 5.0, "d"), (0, 4.0, "b")]);
+    }
+
     #[test]
     fn test_null_safety() {
         assert_eq!(multi_manager_load_index(std::ptr::null_mut(), std::ptr::null(), std::ptr::null()), -1);
+        assert_eq!(multi_manager_load_index_with_cache(std::ptr::null_mut(), std::ptr::null(), std::ptr::null(), 1 << 20), -1);
         assert_eq!(multi_manager_reload_index(std::ptr::null_mut(), std::ptr::null()), -1);
         assert!(multi_manager_search(std::ptr::null(), std::ptr::null(), std::ptr::null()).is_null());
+        assert_eq!(multi_manager_search_packed(std::ptr::null(), std::ptr::null(), std::ptr::null(), std::ptr::null_mut(), 0), -1);
+        assert_eq!(multi_manager_search_binary(std::ptr::null(), std::ptr::null(), std::ptr::null(), std::ptr::null_mut(), 0), -1);
+        let mut timing = SearchTiming::default();
+        assert_eq!(
+            multi_manager_search_binary_timed(std::ptr::null(), std::ptr::null(), std::ptr::null(), std::ptr::null_mut(), 0, &mut timing),
+            -1
+        );
+        assert_eq!(
+            multi_manager_search_filtered(std::ptr::null(), std::ptr::null(), std::ptr::null(), std::ptr::null(), std::ptr::null_mut(), 0),
+            -1
+        );
+        assert_eq!(multi_manager_module_slot(std::ptr::null(), std::ptr::null()), -1);
+        assert!(multi_manager_get_document(std::ptr::null(), std::ptr::null(), std::ptr::null()).is_null());
+        let mut stats = IndexStats::empty();
+        assert_eq!(multi_manager_module_stats(std::ptr::null(), std::ptr::null(), &mut stats), -1);
+        assert_eq!(multi_manager_search_async(std::ptr::null(), std::ptr::null(), std::ptr::null(), None, std::ptr::null_mut()), 0);
+        assert_eq!(multi_manager_cancel_search(std::ptr::null(), 1), -1);
+        assert_eq!(
+            multi_manager_search_tiered(std::ptr::null(), std::ptr::null(), std::ptr::null(), std::ptr::null(), 0, None, std::ptr::null_mut()),
+            0
+        );
+        assert!(multi_manager_cache_stats(std::ptr::null()).is_null());
+        assert!(multi_manager_start_warmup(std::ptr::null(), std::ptr::null()).is_null());
+        assert_eq!(multi_manager_set_memory_budget(std::ptr::null(), 0), -1);
+        assert_eq!(multi_manager_set_background_indexing(std::ptr::null(), 1), -1);
+        assert_eq!(multi_manager_trim_memory(std::ptr::null(), TANTIVY_TRIM_CRITICAL), -1);
+        assert_eq!(multi_manager_set_cache_capacity(std::ptr::null(), 0), -1);
+        assert_eq!(multi_manager_register_index(std::ptr::null(), std::ptr::null(), std::ptr::null(), 0, 0), -1);
+        assert_eq!(multi_manager_module_state(std::ptr::null(), std::ptr::null()), -1);
+        assert_eq!(multi_manager_set_open_module_limit(std::ptr::null(), 1), -1);
         
         destroy_multi_manager(std::ptr::null_mut()); // Should not crash
     }
@@ -0,0 +1,187 @@
+// packed.rs - Compact binary result encoding written into caller-owned buffers
+//
+// Layout (little-endian, see tantivy_mobile.h):
+//   header  [magic u32][count u32][total_hits u32][pool_offset u32][search_time_ms u64]
+//   rows    count x [5 x (offset u32, len u32)][priority u32][score f32]
+//   pool    UTF-8 bytes, string offsets are relative to pool_offset
+//
+// String slots per row are id, title, category, summary, module. Rows are
+// written in rank order; if the buffer fills up the tail is dropped and
+// `count < total_hits` tells the caller to grow its buffer.
+
+pub const PACKED_MAGIC: u32 = 0x3152_5054; // "TPR1"
+pub const PACKED_HEADER_SIZE: usize = 24;
+pub const PACKED_ROW_SIZE: usize = 48;
+
+// The layout as C structs, for tantivy_mobile.h; the writer below encodes
+// the same bytes explicitly so it never depends on host endianness
+#[repr(C)]
+pub struct PackedResultsHeader {
+    pub magic: u32,
+    pub count: u32,
+    pub total_hits: u32,
+    pub pool_offset: u32,
+    pub search_time_ms: u64,
+}
+
+#[repr(C)]
+pub struct PackedString {
+    pub offset: u32,
+    pub length: u32,
+}
+
+#[repr(C)]
+pub struct PackedResultRow {
+    pub id: PackedString,
+    pub title: PackedString,
+    pub category: PackedString,
+    pub summary: PackedString,
+    pub module: PackedString,
+    pub priority: u32,
+    pub score: f32,
+}
+
+pub(crate) struct PackedRow<'a> {
+    pub id: &'a str,
+    pub title: &'a str,
+    pub category: &'a str,
+    pub summary: &'a str,
+    pub module: &'a str,
+    pub priority: u32,
+    pub score: f32,
+}
+
+pub(crate) struct PackedWriter<'a> {
+    buf: &'a mut [u8],
+    row_capacity: usize,
+    count: usize,
+    pool_start: usize,
+    pool_end: usize,
+}
+
+impl<'a> PackedWriter<'a> {
+    /// Reserves a row table for up to `expected_rows` rows.
+    /// Returns `None` when the buffer cannot hold the header.
+    pub fn new(buf: &'a mut [u8], expected_rows: usize) -> Option<Self> {
+        if buf.len() < PACKED_HEADER_SIZE {
+            return None;
+        }
+        let row_capacity = expected_rows.min((buf.len() - PACKED_HEADER_SIZE) / PACKED_ROW_SIZE);
+        let pool_start = PACKED_HEADER_SIZE + row_capacity * PACKED_ROW_SIZE;
+        Some(PackedWriter {
+            buf,
+            row_capacity,
+            count: 0,
+            pool_start,
+            pool_end: pool_start,
+        })
+    }
+
+    /// Appends a row. Returns false, writing nothing, once the buffer is full.
+    pub fn push(&mut self, row: &PackedRow) -> bool {
+        if self.count >= self.row_capacity {
+            return false;
+        }
+
+        let strings = [row.id, row.title, row.category, row.summary, row.module];
+        let needed: usize = strings.iter().map(|s| s.len()).sum();
+        if needed > self.buf.len() - self.pool_end {
+            return false;
+        }
+
+        let mut at = PACKED_HEADER_SIZE + self.count * PACKED_ROW_SIZE;
+        for s in strings {
+            let offset = self.pool_end - self.pool_start;
+            self.buf[self.pool_end..self.pool_end + s.len()].copy_from_slice(s.as_bytes());
+            self.pool_end += s.len();
+            put_u32(self.buf, at, offset as u32);
+            put_u32(self.buf, at + 4, s.len() as u32);
+            at += 8;
+        }
+        put_u32(self.buf, at, row.priority);
+        put_u32(self.buf, at + 4, row.score.to_bits());
+
+        self.count += 1;
+        true
+    }
+
+    /// Writes the header and returns the number of packed rows.
+    pub fn finish(self, total_hits: usize, search_time_ms: u64) -> i32 {
+        put_u32(self.buf, 0, PACKED_MAGIC);
+        put_u32(self.buf, 4, self.count as u32);
+        put_u32(self.buf, 8, total_hits as u32);
+        put_u32(self.buf, 12, self.pool_start as u32);
+        self.buf[16..24].copy_from_slice(&search_time_ms.to_le_bytes());
+        self.count as i32
+    }
+}
+
+fn put_u32(buf: &mut [u8], at: usize, value: u32) {
+    buf[at..at + 4].copy_from_slice(&value.to_le_bytes());
+}
+
+/// Wraps a caller-provided buffer (e.g. a direct ByteBuffer address).
+///
+/// # Safety
+/// `ptr` must be valid for writes of `capacity` bytes for the returned lifetime.
+pub(crate) unsafe fn buffer_from_raw<'a>(ptr: *mut u8, capacity: usize) -> Option<&'a mut [u8]> {
+    if ptr.is_null() || capacity == 0 {
+        None
+    } else {
+        Some(std::slice::from_raw_parts_mut(ptr, capacity))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn row<'a>(id: &'a str, title: &'a str) -> PackedRow<'a> {
+        PackedRow { id, title, category: "medical", summary: "", module: "", priority: 0, score: 1.5 }
+    }
+
+    #[test]
+    fn test_c_layout_sizes() {
+        assert_eq!(std::mem::size_of::<PackedResultsHeader>(), PACKED_HEADER_SIZE);
+        assert_eq!(std::mem::size_of::<PackedResultRow>(), PACKED_ROW_SIZE);
+    }
+
+    fn read_u32(buf: &[u8], at: usize) -> u32 {
+        u32::from_le_bytes(buf[at..at + 4].try_into().unwrap())
+    }
+
+    #[test]
+    fn test_round_trip() {
+        let mut buf = vec![0u8; 512];
+        let mut writer = PackedWriter::new(&mut buf, 2).unwrap();
+        assert!(writer.push(&row("med-001", "Tourniquet")));
+        assert!(writer.push(&row("med-002", "Hypothermia")));
+        assert_eq!(writer.finish(2, 7), 2);
+
+        assert_eq!(read_u32(&buf, 0), PACKED_MAGIC);
+        assert_eq!(read_u32(&buf, 4), 2);
+        let pool = read_u32(&buf, 12) as usize;
+        let second_title = PACKED_HEADER_SIZE + PACKED_ROW_SIZE + 8;
+        let offset = pool + read_u32(&buf, second_title) as usize;
+        let len = read_u32(&buf, second_title + 4) as usize;
+        assert_eq!(&buf[offset..offset + len], b"Hypothermia");
+        assert_eq!(f32::from_bits(read_u32(&buf, PACKED_HEADER_SIZE + 44)), 1.5);
+    }
+
+    #[test]
+    fn test_truncates_when_full() {
+        let mut buf = vec![0u8; PACKED_HEADER_SIZE + 2 * PACKED_ROW_SIZE + 20];
+        let mut writer = PackedWriter::new(&mut buf, 3).unwrap();
+        assert!(writer.push(&row("a", "b")));
+        assert!(!writer.push(&row("a-much-longer-id", "that does not fit")));
+        assert_eq!(writer.finish(3, 0), 1);
+        assert_eq!(read_u32(&buf, 8), 3);
+    }
+
+    #[test]
+    fn test_rejects_tiny_buffer() {
+        let mut buf = vec![0u8; PACKED_HEADER_SIZE - 1];
+        assert!(PackedWriter::new(&mut buf, 1).is_none());
+        assert!(unsafe { buffer_from_raw(std::ptr::null_mut(), 16) }.is_none());
+    }
+}
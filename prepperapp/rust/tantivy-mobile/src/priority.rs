@@ -0,0 +1,345 @@
+// priority.rs - Top-K collector blending BM25 with the priority FAST column
+//
+// Ranking multiplies each document's BM25 score by a boost for its content
+// priority (0 is critical), read from the FAST column while collecting, so a
+// life-critical article outranks a slightly better textual match. The blend
+// keeps block-max WAND usable: a document can only enter the top K if its
+// BM25 score times the segment's largest boost beats the current K-th
+// blended score, so that quotient is handed to the scorer as its pruning
+// threshold. Once K critical hits are in, blocks of postings that cannot
+// beat them are skipped instead of scored.
+//
+// Pruning hands the loop to tantivy, which cannot be stopped part way: a
+// conjunction, phrase or other non-WAND scorer walks every posting and only
+// calls back for documents beating the threshold. A cancellable collector,
+// or one with a deadline, therefore drives the scorer itself and gives up
+// block-max WAND. It checks the flag per document visited and the clock
+// every few thousand, and stops the segment when either fires. A cancelled
+// search's partial results are meant to be discarded; a deadline keeps the
+// best of the documents scored before it passed.
+//
+// A filtered collector only collects documents in its filter's set for the
+// segment (see filter.rs) and does not score segments where it is empty.
+
+use crate::filter::FilterSets;
+use std::cmp::Ordering;
+use std::collections::BinaryHeap;
+use std::sync::atomic::{AtomicBool, Ordering as AtomicOrdering};
+use std::sync::Arc;
+use std::time::Instant;
+use tantivy::collector::{Collector, SegmentCollector};
+use tantivy::columnar::Column;
+use tantivy::query::{Scorer, Weight};
+use tantivy::{DocAddress, DocId, DocSet, Score, SegmentOrdinal, SegmentReader, TERMINATED};
+
+// Boost by priority 0, 1, 2; lower priorities are not boosted
+const PRIORITY_BOOSTS: [Score; 3] = [2.0, 1.5, 1.2];
+
+// Documents visited between reads of the clock for a deadline
+const DEADLINE_CHECK_INTERVAL: u32 = 4096;
+
+pub(crate) fn priority_boost(priority: u64) -> Score {
+    PRIORITY_BOOSTS.get(priority as usize).copied().unwrap_or(1.0)
+}
+
+/// Like `TopDocs::with_limit`, ranked by BM25 x priority boost. Segments
+/// without a priority column rank by BM25 alone.
+pub(crate) struct PriorityTopDocs {
+    limit: usize,
+    cancelled: Option<Arc<AtomicBool>>,
+    deadline: Option<Instant>,
+    filter: Option<Arc<FilterSets>>,
+}
+
+impl PriorityTopDocs {
+    pub fn with_limit(limit: usize) -> Self {
+        PriorityTopDocs { limit, cancelled: None, deadline: None, filter: None }
+    }
+
+    /// Collects only documents in `filter`'s sets.
+    pub fn filtered(mut self, filter: Option<Arc<FilterSets>>) -> Self {
+        self.filter = filter;
+        self
+    }
+
+    /// Stops collecting once `cancelled` is set.
+    pub fn cancellable(mut self, cancelled: Option<&Arc<AtomicBool>>) -> Self {
+        self.cancelled = cancelled.cloned();
+        self
+    }
+
+    /// Stops collecting once `deadline` passes, keeping the hits so far.
+    pub fn until(mut self, deadline: Option<Instant>) -> Self {
+        self.deadline = deadline;
+        self
+    }
+
+    fn is_cancelled(&self) -> bool {
+        self.cancelled.as_ref().map_or(false, |flag| flag.load(AtomicOrdering::Relaxed))
+    }
+
+    fn is_past_deadline(&self) -> bool {
+        self.deadline.map_or(false, |deadline| Instant::now() >= deadline)
+    }
+
+    fn is_stoppable(&self) -> bool {
+        self.cancelled.is_some() || self.deadline.is_some()
+    }
+}
+
+// Min-heap entry: the lowest blended score on top, later docs first on ties
+struct Candidate {
+    score: Score,
+    doc: DocId,
+}
+
+impl PartialEq for Candidate {
+    fn eq(&self, other: &Self) -> bool {
+        self.cmp(other) == Ordering::Equal
+    }
+}
+
+impl Eq for Candidate {}
+
+impl PartialOrd for Candidate {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Candidate {
+    fn cmp(&self, other: &Self) -> Ordering {
+        other.score.total_cmp(&self.score).then(self.doc.cmp(&other.doc))
+    }
+}
+
+pub(crate) struct PrioritySegmentCollector {
+    segment_ord: SegmentOrdinal,
+    limit: usize,
+    priority: Option<Column<u64>>,
+    // Largest boost any document of this segment can get
+    max_boost: Score,
+    heap: BinaryHeap<Candidate>,
+}
+
+impl PrioritySegmentCollector {
+    /// BM25 score a document must exceed to still make the top K.
+    fn threshold(&self) -> Score {
+        match self.heap.peek() {
+            Some(kth) if self.heap.len() >= self.limit => kth.score / self.max_boost,
+            _ => Score::MIN,
+        }
+    }
+}
+
+impl SegmentCollector for PrioritySegmentCollector {
+    type Fruit = Vec<(Score, DocAddress)>;
+
+    fn collect(&mut self, doc: DocId, score: Score) {
+        if self.limit == 0 {
+            return;
+        }
+        let boost = self
+            .priority
+            .as_ref()
+            .map_or(1.0, |column| priority_boost(column.first(doc).unwrap_or(u64::MAX)));
+        let candidate = Candidate { score: score * boost, doc };
+        if self.heap.len() < self.limit {
+            self.heap.push(candidate);
+        } else if let Some(mut kth) = self.heap.peek_mut() {
+            // Heap order puts the candidate below the K-th when it ranks higher
+            if candidate < *kth {
+                *kth = candidate;
+            }
+        }
+    }
+
+    fn harvest(self) -> Self::Fruit {
+        let segment_ord = self.segment_ord;
+        self.heap
+            .into_sorted_vec()
+            .into_iter()
+            .map(|c| (c.score, DocAddress::new(segment_ord, c.doc)))
+            .collect()
+    }
+}
+
+impl Collector for PriorityTopDocs {
+    type Fruit = Vec<(Score, DocAddress)>;
+    type Child = PrioritySegmentCollector;
+
+    fn for_segment(&self, segment_ord: SegmentOrdinal, reader: &SegmentReader) -> tantivy::Result<Self::Child> {
+        let priority = reader.fast_fields().u64("priority").ok();
+        // The smallest priority value present gets the largest boost
+        let max_boost = priority.as_ref().map_or(1.0, |column| priority_boost(column.min_value()));
+        Ok(PrioritySegmentCollector {
+            segment_ord,
+            limit: self.limit,
+            priority,
+            max_boost,
+            heap: BinaryHeap::with_capacity(self.limit),
+        })
+    }
+
+    fn requires_scoring(&self) -> bool {
+        true
+    }
+
+    fn merge_fruits(&self, segment_fruits: Vec<Self::Fruit>) -> tantivy::Result<Self::Fruit> {
+        let mut merged: Vec<(Score, DocAddress)> = segment_fruits.into_iter().flatten().collect();
+        merged.sort_unstable_by(|a, b| b.0.total_cmp(&a.0).then(a.1.cmp(&b.1)));
+        merged.truncate(self.limit);
+        Ok(merged)
+    }
+
+    fn collect_segment(
+        &self,
+        weight: &dyn Weight,
+        segment_ord: SegmentOrdinal,
+        reader: &SegmentReader,
+    ) -> tantivy::Result<Self::Fruit> {
+        let mut child = self.for_segment(segment_ord, reader)?;
+        if self.limit == 0 || self.is_cancelled() || self.is_past_deadline() {
+            return Ok(Vec::new());
+        }
+        let filter = self.filter.as_ref().map(|sets| sets.segment(segment_ord));
+        if filter.map_or(false, |set| set.is_empty()) {
+            return Ok(Vec::new());
+        }
+        let alive = reader.alive_bitset();
+        let accept = |doc: DocId| {
+            alive.map_or(true, |bitset| bitset.is_alive(doc)) && filter.map_or(true, |set| set.contains(doc))
+        };
+        if self.is_stoppable() {
+            let mut scorer = weight.scorer(reader, 1.0)?;
+            collect_until(&mut *scorer, &mut child, accept, |visited| {
+                self.is_cancelled() || (visited % DEADLINE_CHECK_INTERVAL == 0 && self.is_past_deadline())
+            });
+        } else {
+            weight.for_each_pruning(Score::MIN, reader, &mut |doc, score| {
+                if accept(doc) {
+                    child.collect(doc, score);
+                }
+                child.threshold()
+            })?;
+        }
+        Ok(child.harvest())
+    }
+}
+
+// Collects every accepted document of `scorer` into `child`, asking `stop`
+// with the count visited so far before each one
+fn collect_until(
+    scorer: &mut dyn Scorer,
+    child: &mut PrioritySegmentCollector,
+    accept: impl Fn(DocId) -> bool,
+    mut stop: impl FnMut(u32) -> bool,
+) {
+    let mut visited: u32 = 0;
+    let mut doc = scorer.doc();
+    while doc != TERMINATED {
+        visited = visited.wrapping_add(1);
+        if stop(visited) {
+            return;
+        }
+        if accept(doc) {
+            // Only a score above the threshold can enter the top K
+            let score = scorer.score();
+            if score > child.threshold() {
+                child.collect(doc, score);
+            }
+        }
+        doc = scorer.advance();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn collector(limit: usize, max_boost: Score) -> PrioritySegmentCollector {
+        PrioritySegmentCollector { segment_ord: 0, limit, priority: None, max_boost, heap: BinaryHeap::new() }
+    }
+
+    #[test]
+    fn test_priority_boost() {
+        assert!(priority_boost(0) > priority_boost(1));
+        assert!(priority_boost(1) > priority_boost(2));
+        assert_eq!(priority_boost(3), 1.0);
+        assert_eq!(priority_boost(u64::MAX), 1.0);
+    }
+
+    #[test]
+    fn test_keeps_best_k_in_order() {
+        let mut child = collector(2, 1.0);
+        for (doc, score) in [(0, 1.0), (1, 3.0), (2, 2.0), (3, 0.5)] {
+            child.collect(doc, score);
+        }
+        let docs: Vec<_> = child.harvest().into_iter().map(|(s, a)| (s, a.doc_id)).collect();
+        assert_eq!(docs, vec![(3.0, 1), (2.0, 2)]);
+    }
+
+    #[test]
+    fn test_threshold_accounts_for_max_boost() {
+        let mut child = collector(1, 2.0);
+        assert_eq!(child.threshold(), Score::MIN);
+        child.collect(0, 4.0);
+        // A BM25 score of 2.0 could still tie once boosted
+        assert_eq!(child.threshold(), 2.0);
+        assert!(collector(0, 1.0).harvest().is_empty());
+    }
+
+    #[test]
+    fn test_cancellable() {
+        let flag = Arc::new(AtomicBool::new(false));
+        let top_docs = PriorityTopDocs::with_limit(5).cancellable(Some(&flag));
+        assert!(!top_docs.is_cancelled());
+        flag.store(true, AtomicOrdering::Relaxed);
+        assert!(top_docs.is_cancelled());
+        assert!(!PriorityTopDocs::with_limit(5).cancellable(None).is_cancelled());
+    }
+
+    #[test]
+    fn test_cancels_conjunction_part_way() {
+        use tantivy::query::{BooleanQuery, EnableScoring, Query, TermQuery};
+        use tantivy::schema::{IndexRecordOption, Schema, TEXT};
+        use tantivy::{doc, Index, Term};
+
+        let mut builder = Schema::builder();
+        let body = builder.add_text_field("body", TEXT);
+        let index = Index::create_in_ram(builder.build());
+        let mut writer: tantivy::IndexWriter = index.writer(15_000_000).unwrap();
+        for _ in 0..20_000 {
+            writer.add_document(doc!(body => "stop bleeding")).unwrap();
+        }
+        writer.commit().unwrap();
+        let searcher = index.reader().unwrap().searcher();
+        let term = |text: &str| -> Box<dyn Query> {
+            Box::new(TermQuery::new(Term::from_field_text(body, text), IndexRecordOption::WithFreqs))
+        };
+        let query = BooleanQuery::intersection(vec![term("stop"), term("bleeding")]);
+
+        // The conjunction's scorer stops where the check fires
+        let weight = query.weight(EnableScoring::enabled_from_searcher(&searcher)).unwrap();
+        let reader = searcher.segment_reader(0);
+        let mut scorer = weight.scorer(reader, 1.0).unwrap();
+        let mut child = PriorityTopDocs::with_limit(5).for_segment(0, reader).unwrap();
+        collect_until(&mut *scorer, &mut child, |_| true, |visited| visited > 100);
+        assert_eq!(scorer.doc(), 100);
+        assert_eq!(child.harvest().len(), 5);
+
+        let flag = Arc::new(AtomicBool::new(true));
+        assert!(searcher.search(&query, &PriorityTopDocs::with_limit(5).cancellable(Some(&flag))).unwrap().is_empty());
+        flag.store(false, AtomicOrdering::Relaxed);
+        assert_eq!(searcher.search(&query, &PriorityTopDocs::with_limit(5).cancellable(Some(&flag))).unwrap().len(), 5);
+    }
+
+    #[test]
+    fn test_until() {
+        let passed = Instant::now();
+        assert!(PriorityTopDocs::with_limit(5).until(Some(passed)).is_past_deadline());
+        let later = passed + std::time::Duration::from_secs(60);
+        assert!(!PriorityTopDocs::with_limit(5).until(Some(later)).is_past_deadline());
+        assert!(!PriorityTopDocs::with_limit(5).until(None).is_past_deadline());
+    }
+}
@@ -0,0 +1,93 @@
+// snippet.rs - Result snippets from the indexer's fast bytes column
+//
+// Mobile indexes store no article text. tantivy-indexer-mobile writes a short
+// excerpt per document to the `snippet` fast field instead, so a results list
+// is filled in from the columnar files without decompressing docstore blocks
+// of article bodies. Each value is (must match tantivy-indexer's snippet.rs):
+//   [u8 version][u16 text_len][text][u16 token_count][token_count x (u16 start, u16 end)]
+// little-endian. The token spans are the byte ranges the index's default
+// tokenizer found in the text, for highlighting query terms natively.
+
+use tantivy::columnar::BytesColumn;
+use tantivy::{DocAddress, Searcher};
+
+pub(crate) const SNIPPET_FIELD: &str = "snippet";
+const SNIPPET_FORMAT_VERSION: u8 = 1;
+
+/// The text of an encoded snippet; None if malformed or a newer version.
+pub(crate) fn snippet_text(bytes: &[u8]) -> Option<&str> {
+    if *bytes.first()? != SNIPPET_FORMAT_VERSION {
+        return None;
+    }
+    let len = u16::from_le_bytes([*bytes.get(1)?, *bytes.get(2)?]) as usize;
+    std::str::from_utf8(bytes.get(3..3 + len)?).ok()
+}
+
+/// Reads snippets for one results list. Each segment's column is opened on
+/// first use; an index without the field reads as having no snippets.
+pub(crate) struct SnippetReader<'a> {
+    searcher: &'a Searcher,
+    enabled: bool,
+    // Outer None: not opened yet
+    columns: Vec<Option<Option<BytesColumn>>>,
+    buf: Vec<u8>,
+}
+
+impl<'a> SnippetReader<'a> {
+    pub fn new(searcher: &'a Searcher, enabled: bool) -> Self {
+        SnippetReader { searcher, enabled, columns: Vec::new(), buf: Vec::new() }
+    }
+
+    pub fn get(&mut self, address: DocAddress) -> Option<&str> {
+        if !self.enabled {
+            return None;
+        }
+        let segment = address.segment_ord as usize;
+        if self.columns.len() <= segment {
+            self.columns.resize_with(segment + 1, || None);
+        }
+        let searcher = self.searcher;
+        let column = self.columns[segment]
+            .get_or_insert_with(|| {
+                searcher.segment_readers().get(segment)?.fast_fields().bytes(SNIPPET_FIELD).ok()?
+            })
+            .as_ref()?;
+
+        let ord = column.term_ords(address.doc_id).next()?;
+        self.buf.clear();
+        if !column.ord_to_bytes(ord, &mut self.buf).ok()? {
+            return None;
+        }
+        snippet_text(&self.buf)
+    }
+}
+
+/// `stored` if non-empty, else the document's snippet.
+pub(crate) fn summary_or_snippet<'s>(
+    stored: &'s str,
+    snippets: &'s mut SnippetReader<'_>,
+    address: DocAddress,
+) -> &'s str {
+    if !stored.is_empty() {
+        return stored;
+    }
+    snippets.get(address).unwrap_or("")
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_snippet_text() {
+        let mut encoded = vec![SNIPPET_FORMAT_VERSION, 5, 0];
+        encoded.extend_from_slice(b"Burns");
+        encoded.extend_from_slice(&[1, 0, 0, 0, 5, 0]);
+        assert_eq!(snippet_text(&encoded), Some("Burns"));
+
+        assert_eq!(snippet_text(&[]), None);
+        assert_eq!(snippet_text(&[SNIPPET_FORMAT_VERSION + 1, 0, 0]), None);
+        // Length past the end
+        assert_eq!(snippet_text(&[SNIPPET_FORMAT_VERSION, 9, 0, b'a']), None);
+    }
+}
@@ -0,0 +1,130 @@
+// stats.rs - Per-index memory footprint and query latency counters
+//
+// Deciding which modules stay loaded on a 2 GB phone needs more than a
+// document count: how much of the index is mapped and how much of that is
+// resident, what the heap holds for it, and how often and how fast it is
+// searched. IndexStats carries all of it in one versioned struct, filled
+// for a single index by tantivy_get_index_stats and for a module by
+// multi_manager_module_stats. Query counters are relaxed atomics bumped
+// once per search, so sampling them costs nothing on the search path.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::Duration;
+
+// Bump when IndexStats gains fields; callers check `version` before reading
+// fields added after the one they were built against
+pub const TANTIVY_INDEX_STATS_VERSION: u32 = 2;
+
+pub const TANTIVY_LATENCY_BUCKETS: usize = 12;
+
+// Upper bounds in microseconds of every bucket but the last, which counts
+// everything slower
+const LATENCY_BOUNDS_US: [u64; TANTIVY_LATENCY_BUCKETS - 1] =
+    [100, 250, 500, 1_000, 2_500, 5_000, 10_000, 25_000, 50_000, 100_000, 250_000];
+
+/// Footprint and query counters of one index. Byte counts the library
+/// cannot measure for an index are 0: resident bytes need an index opened
+/// with TANTIVY_OPEN_MMAP_ADVISED.
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct IndexStats {
+    // size_of::<IndexStats>() and TANTIVY_INDEX_STATS_VERSION of the library
+    pub struct_size: u32,
+    pub version: u32,
+    pub num_docs: u64,
+    // Bytes of the current generation's segment files
+    pub index_size_bytes: u64,
+    // Of those, bytes memory-mapped, and bytes of the mappings in RAM
+    pub mapped_bytes: u64,
+    pub resident_bytes: u64,
+    // Heap held for the index: the docstore cache and filter sets, plus the
+    // result cache of a single index (a manager's cache is in
+    // multi_manager_cache_stats)
+    pub heap_bytes: u64,
+    // Decompressed docstore blocks cached across segments
+    pub docstore_cache_bytes: u64,
+    pub segment_count: u32,
+    pub _reserved: u32,
+    // Searches since the index was opened and their summed latency
+    pub query_count: u64,
+    pub query_time_ns: u64,
+    // Search counts by latency: < 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50,
+    // 100, 250 ms, and slower
+    pub latency_histogram: [u64; TANTIVY_LATENCY_BUCKETS],
+}
+
+impl IndexStats {
+    /// Zeroed stats with the header filled in.
+    pub fn empty() -> Self {
+        IndexStats {
+            struct_size: std::mem::size_of::<IndexStats>() as u32,
+            version: TANTIVY_INDEX_STATS_VERSION,
+            ..Default::default()
+        }
+    }
+}
+
+/// Search count and latency histogram of one index.
+#[derive(Default)]
+pub(crate) struct QueryStats {
+    count: AtomicU64,
+    total_ns: AtomicU64,
+    buckets: [AtomicU64; TANTIVY_LATENCY_BUCKETS],
+}
+
+impl QueryStats {
+    pub fn record(&self, elapsed: Duration) {
+        let ns = elapsed.as_nanos().min(u64::MAX as u128) as u64;
+        self.count.fetch_add(1, Ordering::Relaxed);
+        self.total_ns.fetch_add(ns, Ordering::Relaxed);
+        self.buckets[latency_bucket(ns / 1_000)].fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Copies the counters into `stats`. Each counter is read on its own, so
+    /// a sample racing searches can be off by those searches.
+    pub fn fill(&self, stats: &mut IndexStats) {
+        stats.query_count = self.count.load(Ordering::Relaxed);
+        stats.query_time_ns = self.total_ns.load(Ordering::Relaxed);
+        for (out, bucket) in stats.latency_histogram.iter_mut().zip(&self.buckets) {
+            *out = bucket.load(Ordering::Relaxed);
+        }
+    }
+}
+
+fn latency_bucket(micros: u64) -> usize {
+    LATENCY_BOUNDS_US.iter().position(|&bound| micros < bound).unwrap_or(TANTIVY_LATENCY_BUCKETS - 1)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_latency_bucket() {
+        assert_eq!(latency_bucket(0), 0);
+        assert_eq!(latency_bucket(99), 0);
+        assert_eq!(latency_bucket(100), 1);
+        assert_eq!(latency_bucket(999), 3);
+        assert_eq!(latency_bucket(1_000), 4);
+        assert_eq!(latency_bucket(249_999), TANTIVY_LATENCY_BUCKETS - 2);
+        assert_eq!(latency_bucket(u64::MAX / 1_000), TANTIVY_LATENCY_BUCKETS - 1);
+    }
+
+    #[test]
+    fn test_record_and_fill() {
+        let queries = QueryStats::default();
+        queries.record(Duration::from_micros(50));
+        queries.record(Duration::from_millis(3));
+        queries.record(Duration::from_secs(1));
+
+        let mut stats = IndexStats::empty();
+        queries.fill(&mut stats);
+        assert_eq!(stats.version, TANTIVY_INDEX_STATS_VERSION);
+        assert_eq!(stats.struct_size as usize, std::mem::size_of::<IndexStats>());
+        assert_eq!(stats.query_count, 3);
+        assert_eq!(stats.query_time_ns, 1_003_050_000);
+        assert_eq!(stats.latency_histogram[0], 1);
+        assert_eq!(stats.latency_histogram[5], 1);
+        assert_eq!(stats.latency_histogram[TANTIVY_LATENCY_BUCKETS - 1], 1);
+    }
+}
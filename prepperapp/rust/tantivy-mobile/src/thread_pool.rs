@@ -0,0 +1,254 @@
+// thread_pool.rs - Search threads sized and placed for phones
+//
+// rayon's global pool takes one thread per core, so a multi-module search
+// fans out over every core the UI thread and RenderThread also need, and on
+// big.LITTLE parts it wakes the big cores for work the little ones can do.
+// Each MultiSearchManager owns its pools instead, sized from
+// MultiManagerOptions, with every thread pinned to a core class and given a
+// scheduling priority as it starts. While background indexing runs,
+// searches move to a smaller pool so the two together stay within budget.
+
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+// Core classes for MultiManagerOptions.core_class
+pub const TANTIVY_CORES_ANY: i32 = 0;
+pub const TANTIVY_CORES_EFFICIENCY: i32 = 1;
+pub const TANTIVY_CORES_PERFORMANCE: i32 = 2;
+
+const DEFAULT_SEARCH_THREADS: usize = 4;
+const DEFAULT_ASYNC_THREADS: usize = 2;
+const DEFAULT_BACKGROUND_SEARCH_THREADS: usize = 1;
+
+/// Thread configuration for init_multi_manager_with_options. A count of 0
+/// takes the default.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct MultiManagerOptions {
+    // Threads one search fans out over; at most the number of cores
+    pub search_threads: u32,
+    // Threads running multi_manager_search_async requests
+    pub async_threads: u32,
+    // Search threads while background indexing is active
+    pub background_search_threads: u32,
+    // TANTIVY_CORES_*: the cores every thread is pinned to (Android, Linux)
+    // or the QoS class it runs at (iOS)
+    pub core_class: i32,
+    // Nice value for every thread on Android and Linux, 0 to inherit.
+    // Positive values yield to the UI thread.
+    pub thread_priority: i32,
+}
+
+// Defaults: 4 search threads, 2 async, 1 while indexing, any core
+#[no_mangle]
+pub extern "C" fn multi_manager_options_default() -> MultiManagerOptions {
+    MultiManagerOptions {
+        search_threads: DEFAULT_SEARCH_THREADS as u32,
+        async_threads: DEFAULT_ASYNC_THREADS as u32,
+        background_search_threads: DEFAULT_BACKGROUND_SEARCH_THREADS as u32,
+        core_class: TANTIVY_CORES_ANY,
+        thread_priority: 0,
+    }
+}
+
+impl MultiManagerOptions {
+    pub(crate) fn async_threads(&self) -> usize {
+        count_or(self.async_threads, DEFAULT_ASYNC_THREADS)
+    }
+
+    pub(crate) fn hints(&self) -> ThreadHints {
+        ThreadHints { core_class: self.core_class, nice: self.thread_priority }
+    }
+}
+
+fn count_or(count: u32, default: usize) -> usize {
+    if count == 0 {
+        default
+    } else {
+        count as usize
+    }
+}
+
+/// Placement applied by each pool thread to itself when it starts. The
+/// default leaves threads where the OS puts them.
+#[derive(Clone, Copy, Default)]
+pub(crate) struct ThreadHints {
+    core_class: i32,
+    nice: i32,
+}
+
+impl ThreadHints {
+    #[cfg(any(target_os = "android", target_os = "linux"))]
+    pub fn apply(&self) {
+        if let Some(cores) = cores_of_class(self.core_class) {
+            unsafe {
+                let mut set: libc::cpu_set_t = std::mem::zeroed();
+                for cpu in cores {
+                    libc::CPU_SET(cpu, &mut set);
+                }
+                libc::sched_setaffinity(0, std::mem::size_of::<libc::cpu_set_t>(), &set);
+            }
+        }
+        if self.nice != 0 {
+            // With a thread id, setpriority affects only the calling thread
+            unsafe {
+                let tid = libc::syscall(libc::SYS_gettid) as libc::id_t;
+                libc::setpriority(libc::PRIO_PROCESS, tid, self.nice);
+            }
+        }
+    }
+
+    #[cfg(any(target_os = "ios", target_os = "macos"))]
+    pub fn apply(&self) {
+        // Darwin schedules by QoS class, not affinity: utility work is
+        // steered to the efficiency cores
+        const QOS_CLASS_USER_INITIATED: u32 = 0x19;
+        const QOS_CLASS_UTILITY: u32 = 0x11;
+        extern "C" {
+            fn pthread_set_qos_class_self_np(qos_class: u32, relative_priority: i32) -> i32;
+        }
+        let qos = match self.core_class {
+            TANTIVY_CORES_PERFORMANCE => QOS_CLASS_USER_INITIATED,
+            TANTIVY_CORES_EFFICIENCY => QOS_CLASS_UTILITY,
+            _ => return,
+        };
+        unsafe {
+            pthread_set_qos_class_self_np(qos, 0);
+        }
+    }
+
+    #[cfg(not(any(target_os = "android", target_os = "linux", target_os = "ios", target_os = "macos")))]
+    pub fn apply(&self) {}
+}
+
+/// CPUs grouped by their maximum frequency: the slowest cluster is the
+/// efficiency class and everything faster the performance class. None when
+/// all cores are alike, or for TANTIVY_CORES_ANY.
+pub(crate) fn split_cores(core_class: i32, max_freqs: &[(usize, u64)]) -> Option<Vec<usize>> {
+    let slowest = max_freqs.iter().map(|&(_, freq)| freq).min()?;
+    let (efficiency, performance): (Vec<_>, Vec<_>) = max_freqs.iter().partition(|&&(_, freq)| freq == slowest);
+    if performance.is_empty() {
+        return None;
+    }
+    let class = match core_class {
+        TANTIVY_CORES_EFFICIENCY => efficiency,
+        TANTIVY_CORES_PERFORMANCE => performance,
+        _ => return None,
+    };
+    Some(class.into_iter().map(|&(cpu, _)| cpu).collect())
+}
+
+#[cfg(any(target_os = "android", target_os = "linux"))]
+fn cores_of_class(core_class: i32) -> Option<Vec<usize>> {
+    if core_class == TANTIVY_CORES_ANY {
+        return None;
+    }
+    let cpus = unsafe { libc::sysconf(libc::_SC_NPROCESSORS_CONF) }.max(0) as usize;
+    let max_freqs: Vec<(usize, u64)> = (0..cpus)
+        .filter_map(|cpu| {
+            let path = format!("/sys/devices/system/cpu/cpu{}/cpufreq/cpuinfo_max_freq", cpu);
+            let freq = std::fs::read_to_string(path).ok()?.trim().parse().ok()?;
+            Some((cpu, freq))
+        })
+        .collect();
+    split_cores(core_class, &max_freqs)
+}
+
+/// The manager's search pools.
+pub(crate) struct SearchPools {
+    full: rayon::ThreadPool,
+    background: rayon::ThreadPool,
+    // Background indexing jobs in progress
+    indexing: AtomicUsize,
+    hints: ThreadHints,
+}
+
+impl SearchPools {
+    pub fn new(options: &MultiManagerOptions) -> Option<Self> {
+        let cores = std::thread::available_parallelism().map_or(1, |n| n.get());
+        let search_threads = count_or(options.search_threads, DEFAULT_SEARCH_THREADS).min(cores);
+        let background_threads =
+            count_or(options.background_search_threads, DEFAULT_BACKGROUND_SEARCH_THREADS).min(search_threads);
+        let hints = options.hints();
+
+        let build = |threads: usize, name: &'static str| {
+            rayon::ThreadPoolBuilder::new()
+                .num_threads(threads)
+                .thread_name(move |idx| format!("{}-{}", name, idx))
+                .start_handler(move |_| hints.apply())
+                .build()
+                .ok()
+        };
+        Some(SearchPools {
+            full: build(search_threads, "tantivy-search")?,
+            background: build(background_threads, "tantivy-search-bg")?,
+            indexing: AtomicUsize::new(0),
+            hints,
+        })
+    }
+
+    /// Runs `f` on the search pool, or on the background pool while
+    /// indexing is active.
+    pub fn install<R: Send>(&self, f: impl FnOnce() -> R + Send) -> R {
+        if self.indexing.load(Ordering::Relaxed) > 0 {
+            self.background.install(f)
+        } else {
+            self.full.install(f)
+        }
+    }
+
+    /// Starts or ends one background indexing job.
+    pub fn set_indexing(&self, active: bool) {
+        if active {
+            self.indexing.fetch_add(1, Ordering::Relaxed);
+        } else {
+            let _ = self.indexing.fetch_update(Ordering::Relaxed, Ordering::Relaxed, |n| n.checked_sub(1));
+        }
+    }
+
+    pub fn is_indexing(&self) -> bool {
+        self.indexing.load(Ordering::Relaxed) > 0
+    }
+
+    /// Placement for other threads doing search work, e.g. warmups.
+    pub fn hints(&self) -> ThreadHints {
+        self.hints
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_split_cores() {
+        // 4 little cores at 1.8 GHz, 3 big at 2.4 GHz, 1 prime at 3.0 GHz
+        let freqs: Vec<(usize, u64)> = (0..8)
+            .map(|cpu| (cpu, [1_800_000, 2_400_000, 3_000_000][(cpu >= 4) as usize + (cpu == 7) as usize]))
+            .collect();
+        assert_eq!(split_cores(TANTIVY_CORES_EFFICIENCY, &freqs), Some(vec![0, 1, 2, 3]));
+        assert_eq!(split_cores(TANTIVY_CORES_PERFORMANCE, &freqs), Some(vec![4, 5, 6, 7]));
+        assert_eq!(split_cores(TANTIVY_CORES_ANY, &freqs), None);
+
+        // Homogeneous or unreadable: no pinning
+        assert_eq!(split_cores(TANTIVY_CORES_EFFICIENCY, &[(0, 2_000_000), (1, 2_000_000)]), None);
+        assert_eq!(split_cores(TANTIVY_CORES_PERFORMANCE, &[]), None);
+    }
+
+    #[test]
+    fn test_indexing_caps_pool() {
+        let mut options = multi_manager_options_default();
+        options.search_threads = 2;
+        options.background_search_threads = 1;
+        let pools = SearchPools::new(&options).unwrap();
+        assert!(pools.full.current_num_threads() <= 2);
+
+        pools.set_indexing(true);
+        pools.set_indexing(true);
+        pools.set_indexing(false);
+        assert!(pools.is_indexing());
+        assert_eq!(pools.install(rayon::current_num_threads), 1);
+        pools.set_indexing(false);
+        pools.set_indexing(false); // Unbalanced end is ignored
+        assert!(!pools.is_indexing());
+    }
+}
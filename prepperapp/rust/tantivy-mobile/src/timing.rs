@@ -0,0 +1,115 @@
+// timing.rs - Per-query latency breakdown and platform trace sections
+//
+// A single search_time_ms cannot say whether a slow query spent its time
+// parsing, in the postings, loading stored fields or packing results. A
+// timed search fills a SearchTiming with nanosecond phases instead, and
+// each phase is also a trace section, so Perfetto/systrace captures on
+// Android show them per thread. iOS signposts are emitted by the Swift
+// side from the record, since os_signpost is a C macro API.
+
+use crate::multi_search::MULTI_SEARCH_MAX_MODULES;
+use std::time::{Duration, Instant};
+
+/// Phases of one search in nanoseconds. Collect is the wall time of the
+/// parallel per-module phase; parse sums every module's query parse, and
+/// module_collect_ns is each module's own collect time, by slot. Fetch
+/// (stored fields and snippets) is not part of merge. `marshal_ns` is left
+/// for the platform bridge to fill in, e.g. JNI string and array access.
+#[repr(C)]
+#[derive(Clone, Copy, Default)]
+pub struct SearchTiming {
+    pub total_ns: u64,
+    pub parse_ns: u64,
+    pub collect_ns: u64,
+    pub merge_ns: u64,
+    pub fetch_ns: u64,
+    pub serialize_ns: u64,
+    pub marshal_ns: u64,
+    // 1 when the results came from the result cache, with no parse or collect
+    pub cache_hit: u32,
+    pub module_count: u32,
+    pub module_collect_ns: [u64; MULTI_SEARCH_MAX_MODULES],
+    // Slots searched, and slots selected but skipped because their
+    // registered module is not open yet (see lazy.rs)
+    pub searched_mask: u32,
+    pub pending_mask: u32,
+}
+
+impl SearchTiming {
+    /// Ignores slots past MULTI_SEARCH_MAX_MODULES.
+    pub(crate) fn record_module(&mut self, slot: usize, collect_ns: u64) {
+        if let Some(ns) = self.module_collect_ns.get_mut(slot) {
+            *ns = collect_ns;
+        }
+    }
+}
+
+pub(crate) fn nanos(duration: Duration) -> u64 {
+    duration.as_nanos().min(u64::MAX as u128) as u64
+}
+
+/// Nanoseconds since `start`.
+pub(crate) fn elapsed_ns(start: Instant) -> u64 {
+    nanos(start.elapsed())
+}
+
+#[cfg(target_os = "android")]
+mod atrace {
+    use std::ffi::c_char;
+
+    #[link(name = "android")]
+    extern "C" {
+        pub fn ATrace_beginSection(section_name: *const c_char);
+        pub fn ATrace_endSection();
+    }
+}
+
+// Trace section names, null-terminated for the C API
+pub(crate) const TRACE_SEARCH: &[u8] = b"tantivy.search\0";
+pub(crate) const TRACE_COLLECT: &[u8] = b"tantivy.collect\0";
+pub(crate) const TRACE_MERGE: &[u8] = b"tantivy.merge\0";
+pub(crate) const TRACE_PACK: &[u8] = b"tantivy.pack\0";
+
+/// A trace section on the calling thread, ended on drop. Costs a check of
+/// the tracing flag when no trace is being captured; a no-op off Android.
+pub(crate) struct TraceSection(());
+
+impl TraceSection {
+    /// `name` is one of the TRACE_* constants.
+    pub fn begin(name: &'static [u8]) -> Self {
+        debug_assert_eq!(name.last(), Some(&0));
+        #[cfg(target_os = "android")]
+        unsafe {
+            atrace::ATrace_beginSection(name.as_ptr() as *const std::ffi::c_char);
+        }
+        let _ = name;
+        TraceSection(())
+    }
+}
+
+impl Drop for TraceSection {
+    fn drop(&mut self) {
+        #[cfg(target_os = "android")]
+        unsafe {
+            atrace::ATrace_endSection();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_record_module() {
+        let mut timing = SearchTiming::default();
+        timing.record_module(1, nanos(Duration::from_micros(3)));
+        timing.record_module(MULTI_SEARCH_MAX_MODULES, 3_000); // Ignored
+        assert_eq!(timing.module_collect_ns[1], 3_000);
+        assert_eq!(timing.module_collect_ns.iter().sum::<u64>(), 3_000);
+
+        for name in [TRACE_SEARCH, TRACE_COLLECT, TRACE_MERGE, TRACE_PACK] {
+            drop(TraceSection::begin(name));
+        }
+    }
+}
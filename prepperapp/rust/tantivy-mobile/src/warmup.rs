@@ -0,0 +1,198 @@
+// warmup.rs - Background warmup with a module's emergency query set
+//
+// The first search after a cold start pays for page faults in the term,
+// postings and store files. A module's content_manifest.json lists the
+// Tier-1 queries a panicked user is most likely to type; running them on a
+// background thread right after load faults those pages in and fills the
+// result cache, so the first real query finds both warm.
+
+use serde::Deserialize;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::thread::JoinHandle;
+
+#[derive(Deserialize, Default)]
+struct WarmupManifest {
+    #[serde(default)]
+    search_config: ManifestSearchConfig,
+    #[serde(default)]
+    ui_config: ManifestUiConfig,
+}
+
+#[derive(Deserialize, Default)]
+struct ManifestSearchConfig {
+    default_limit: Option<usize>,
+    #[serde(default)]
+    warmup_queries: Vec<String>,
+}
+
+#[derive(Deserialize, Default)]
+struct ManifestUiConfig {
+    #[serde(default)]
+    home_screen_modules: Vec<ManifestHomeModule>,
+}
+
+#[derive(Deserialize)]
+struct ManifestHomeModule {
+    #[serde(default)]
+    queries: Vec<String>,
+}
+
+/// Queries and limit to warm up with, read from a content manifest.
+/// Uses `search_config.warmup_queries`, falling back to the home screen
+/// shortcut queries, deduplicated in order. None if the JSON is invalid.
+pub(crate) fn warmup_plan(manifest_json: &str) -> Option<(Vec<String>, Option<usize>)> {
+    let manifest: WarmupManifest = serde_json::from_str(manifest_json).ok()?;
+
+    let listed = if manifest.search_config.warmup_queries.is_empty() {
+        manifest
+            .ui_config
+            .home_screen_modules
+            .into_iter()
+            .flat_map(|module| module.queries)
+            .collect()
+    } else {
+        manifest.search_config.warmup_queries
+    };
+
+    let mut queries: Vec<String> = Vec::with_capacity(listed.len());
+    for query in listed {
+        let query = query.trim();
+        if !query.is_empty() && !queries.iter().any(|q| q == query) {
+            queries.push(query.to_string());
+        }
+    }
+    Some((queries, manifest.search_config.default_limit))
+}
+
+// The opaque handle for a running warmup
+pub struct WarmupHandle {
+    cancelled: Arc<AtomicBool>,
+    completed: Arc<AtomicUsize>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl WarmupHandle {
+    /// Runs `search` for each query on a background thread, checking for
+    /// cancellation between queries.
+    pub(crate) fn spawn<F>(queries: Vec<String>, search: F) -> Option<Self>
+    where
+        F: Fn(&str) + Send + 'static,
+    {
+        let cancelled = Arc::new(AtomicBool::new(false));
+        let completed = Arc::new(AtomicUsize::new(0));
+
+        let thread = {
+            let cancelled = cancelled.clone();
+            let completed = completed.clone();
+            std::thread::Builder::new()
+                .name("tantivy-warmup".into())
+                .spawn(move || {
+                    for query in &queries {
+                        if cancelled.load(Ordering::Relaxed) {
+                            break;
+                        }
+                        search(query);
+                        completed.fetch_add(1, Ordering::Release);
+                    }
+                })
+                .ok()?
+        };
+
+        Some(WarmupHandle { cancelled, completed, thread: Some(thread) })
+    }
+
+    fn is_finished(&self) -> bool {
+        self.thread.as_ref().map_or(true, |t| t.is_finished())
+    }
+}
+
+impl Drop for WarmupHandle {
+    fn drop(&mut self) {
+        self.cancelled.store(true, Ordering::Relaxed);
+        // Waits for at most the query in flight
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+/// Stops a warmup after the query in flight. Safe to call more than once.
+#[no_mangle]
+pub extern "C" fn warmup_cancel(handle: *const WarmupHandle) {
+    if !handle.is_null() {
+        unsafe { &*handle }.cancelled.store(true, Ordering::Relaxed);
+    }
+}
+
+/// Number of warmup queries run so far, or -1 on a null handle.
+#[no_mangle]
+pub extern "C" fn warmup_progress(handle: *const WarmupHandle) -> i32 {
+    if handle.is_null() {
+        return -1;
+    }
+    unsafe { &*handle }.completed.load(Ordering::Acquire) as i32
+}
+
+/// 1 once the warmup has finished or stopped after a cancel, 0 while it is
+/// running, -1 on a null handle.
+#[no_mangle]
+pub extern "C" fn warmup_is_done(handle: *const WarmupHandle) -> i32 {
+    if handle.is_null() {
+        return -1;
+    }
+    unsafe { &*handle }.is_finished() as i32
+}
+
+/// Cancels the warmup, waits for the query in flight and frees the handle.
+#[no_mangle]
+pub extern "C" fn warmup_free(handle: *mut WarmupHandle) {
+    if !handle.is_null() {
+        let _ = unsafe { Box::from_raw(handle) };
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_warmup_plan() {
+        let manifest = r#"{
+            "ui_config": {"home_screen_modules": [
+                {"queries": ["bleeding", "cpr"]},
+                {"queries": [" cpr ", "water"]}
+            ]},
+            "search_config": {"default_limit": 20}
+        }"#;
+        let (queries, limit) = warmup_plan(manifest).unwrap();
+        assert_eq!(queries, vec!["bleeding", "cpr", "water"]);
+        assert_eq!(limit, Some(20));
+
+        let explicit = r#"{"search_config": {"warmup_queries": ["tourniquet"]},
+            "ui_config": {"home_screen_modules": [{"queries": ["cpr"]}]}}"#;
+        assert_eq!(warmup_plan(explicit).unwrap().0, vec!["tourniquet"]);
+        assert_eq!(warmup_plan("{}").unwrap().0, Vec::<String>::new());
+        assert!(warmup_plan("not json").is_none());
+    }
+
+    #[test]
+    fn test_cancel_stops_between_queries() {
+        let ran = Arc::new(AtomicUsize::new(0));
+        let counter = ran.clone();
+        let handle = WarmupHandle::spawn(vec!["a".into(), "b".into()], move |_| {
+            counter.fetch_add(1, Ordering::SeqCst);
+        })
+        .unwrap();
+        drop(handle); // Joins
+        assert!(ran.load(Ordering::SeqCst) <= 2);
+    }
+
+    #[test]
+    fn test_null_safety() {
+        warmup_cancel(std::ptr::null());
+        assert_eq!(warmup_progress(std::ptr::null()), -1);
+        assert_eq!(warmup_is_done(std::ptr::null()), -1);
+        warmup_free(std::ptr::null_mut()); // Should not crash
+    }
+}
@@ -0,0 +1,576 @@
+// writer.rs - On-device writer for user notes and downloaded content
+//
+// The legacy writer (legacy.rs) commits on the caller's thread with a 50 MB
+// heap and tantivy's default merge policy, so notes added one at a time
+// leave a small segment per commit and every later query pays a postings
+// lookup in each. An on-device writer owns its IndexWriter on a thread of
+// its own: adds are queued and return at once, and commits run there once
+// no document was added for a while, or every N documents. Indexing uses
+// one tantivy thread and a bounded heap.
+//
+// Segments are merged by a log-merge policy tuned for small indexes, but
+// only while the platform reports the device charging or idle. tantivy's
+// own merging is disabled; the writer thread runs one merge at a time
+// between queued commands instead. A merge cannot be interrupted, so one
+// started before merging is turned off still finishes.
+//
+// After each commit or merge the writer's callback runs on its thread. That
+// is where the search side calls trigger_index_reload or
+// multi_manager_reload_index; both publish the new segments as a new
+// searcher without blocking queries on the old one.
+
+use crate::abi::{TANTIVY_ERROR_INDEXING_FAILED, TANTIVY_ERROR_INVALID_PARAM, TANTIVY_SUCCESS};
+use crate::batch::{BatchDocument, BatchReader};
+use crate::legacy::{prepper_schema, DocumentFields};
+use std::ffi::{c_char, c_void, CStr};
+use std::sync::atomic::{AtomicBool, AtomicU32, Ordering};
+use std::sync::mpsc::{self, Receiver, RecvTimeoutError, SyncSender};
+use std::sync::Arc;
+use std::thread::JoinHandle;
+use std::time::{Duration, Instant};
+use tantivy::merge_policy::{LogMergePolicy, MergePolicy, NoMergePolicy};
+use tantivy::schema::{FAST, STORED, STRING};
+use tantivy::{Index, IndexWriter, TantivyDocument, Term};
+
+// tantivy refuses smaller heaps for an indexing thread
+const MIN_HEAP_BYTES: u64 = 15_000_000;
+const DEFAULT_HEAP_BYTES: u64 = 16 * 1024 * 1024;
+const DEFAULT_COMMIT_DELAY_MS: u32 = 2_000;
+const DEFAULT_COMMIT_EVERY_DOCS: u32 = 1_000;
+// tantivy's default is 8 segments per level; on a phone fewer, larger
+// segments are worth the extra merging
+const DEFAULT_MERGE_MIN_SEGMENTS: u32 = 4;
+// Bounds the work of one merge; larger segments are left as they are
+const DEFAULT_MERGE_MAX_DOCS: u32 = 500_000;
+
+// Commands queued for the writer thread before adds block
+const QUEUE_COMMANDS: usize = 1024;
+
+/// Options of tantivy_writer_open. A value of 0 takes the default.
+#[repr(C)]
+#[derive(Clone, Copy)]
+pub struct WriterOptions {
+    // Indexing memory budget; at least 15 MB. A full heap flushes a segment.
+    pub heap_bytes: u64,
+    // Commit once no document was added for this long
+    pub commit_delay_ms: u32,
+    // Commit once this many documents are pending, whatever the delay
+    pub commit_every_docs: u32,
+    // Segments of a similar size merged together
+    pub merge_min_segments: u32,
+    // Segments with more documents are not merged further
+    pub merge_max_docs: u32,
+}
+
+// Defaults: 16 MB heap, commit after 2 s idle or 1000 documents, merge 4
+// segments at a time up to 500k documents
+#[no_mangle]
+pub extern "C" fn tantivy_writer_options_default() -> WriterOptions {
+    WriterOptions {
+        heap_bytes: DEFAULT_HEAP_BYTES,
+        commit_delay_ms: DEFAULT_COMMIT_DELAY_MS,
+        commit_every_docs: DEFAULT_COMMIT_EVERY_DOCS,
+        merge_min_segments: DEFAULT_MERGE_MIN_SEGMENTS,
+        merge_max_docs: DEFAULT_MERGE_MAX_DOCS,
+    }
+}
+
+fn or_default(value: u32, default: u32) -> u32 {
+    if value == 0 {
+        default
+    } else {
+        value
+    }
+}
+
+impl WriterOptions {
+    fn heap_bytes(&self) -> usize {
+        let bytes = if self.heap_bytes == 0 { DEFAULT_HEAP_BYTES } else { self.heap_bytes };
+        bytes.max(MIN_HEAP_BYTES) as usize
+    }
+
+    fn merge_policy(&self) -> LogMergePolicy {
+        let mut policy = LogMergePolicy::default();
+        policy.set_min_num_segments(or_default(self.merge_min_segments, DEFAULT_MERGE_MIN_SEGMENTS) as usize);
+        policy.set_max_docs_before_merge(or_default(self.merge_max_docs, DEFAULT_MERGE_MAX_DOCS) as usize);
+        policy
+    }
+}
+
+/// Runs on the writer thread after every commit and merge: `status` is
+/// TANTIVY_SUCCESS or a negative error code, `segment_count` the committed
+/// segments now on disk.
+pub type WriterCallback = extern "C" fn(status: i32, segment_count: u32, user_data: *mut c_void);
+
+// The caller's callback and context, handed back untouched on the writer thread
+struct Notify {
+    callback: Option<WriterCallback>,
+    user_data: *mut c_void,
+}
+
+unsafe impl Send for Notify {}
+
+enum Command {
+    // A document and, when ids are indexed, the term of the one it replaces
+    Add(TantivyDocument, Option<Term>),
+    Delete(Term),
+    Commit,
+    // Merging was turned on; wakes the thread to look for merges
+    Merge,
+}
+
+// The opaque handle for the FFI layer
+pub struct OnDeviceWriter {
+    // Dropped to stop the writer thread
+    commands: Option<SyncSender<Command>>,
+    fields: DocumentFields,
+    // Whether the schema indexes ids, so adds can replace and ids can be deleted
+    ids_indexed: bool,
+    merging: Arc<AtomicBool>,
+    segments: Arc<AtomicU32>,
+    thread: Option<JoinHandle<()>>,
+}
+
+impl OnDeviceWriter {
+    fn send(&self, command: Command) -> i32 {
+        match self.commands.as_ref().map(|commands| commands.send(command)) {
+            Some(Ok(())) => TANTIVY_SUCCESS,
+            _ => TANTIVY_ERROR_INDEXING_FAILED,
+        }
+    }
+
+    fn id_term(&self, id: &str) -> Option<Term> {
+        self.ids_indexed.then(|| Term::from_field_text(self.fields.id, id))
+    }
+
+    fn add(&self, doc: &BatchDocument) -> i32 {
+        self.send(Command::Add(self.fields.build(doc), self.id_term(doc.id)))
+    }
+}
+
+impl Drop for OnDeviceWriter {
+    /// Commits what is pending and waits for the writer thread, including
+    /// a merge in progress.
+    fn drop(&mut self) {
+        self.commands.take();
+        if let Some(thread) = self.thread.take() {
+            let _ = thread.join();
+        }
+    }
+}
+
+// State owned by the writer thread
+struct WriterThread {
+    index: Index,
+    writer: IndexWriter,
+    policy: LogMergePolicy,
+    commit_delay: Duration,
+    commit_every_docs: usize,
+    pending_docs: usize,
+    // An add or delete failed since the last commit
+    failed: bool,
+    last_add: Instant,
+    // Another merge may be due right after the last one
+    merge_more: bool,
+    merging: Arc<AtomicBool>,
+    segments: Arc<AtomicU32>,
+    notify: Notify,
+}
+
+impl WriterThread {
+    fn run(mut self, commands: Receiver<Command>) {
+        loop {
+            let command = match self.next_wait() {
+                Some(wait) => commands.recv_timeout(wait),
+                None => commands.recv().map_err(|_| RecvTimeoutError::Disconnected),
+            };
+            match command {
+                Ok(Command::Add(doc, replaces)) => self.add(doc, replaces),
+                Ok(Command::Delete(term)) => {
+                    self.writer.delete_term(term);
+                    self.record();
+                }
+                Ok(Command::Commit) => self.commit(),
+                Ok(Command::Merge) => self.merge_more = true,
+                // Only waits with documents pending or a merge due
+                Err(RecvTimeoutError::Timeout) => self.commit(),
+                Err(RecvTimeoutError::Disconnected) => {
+                    self.commit();
+                    return;
+                }
+            }
+            if self.merge_more && self.pending_docs == 0 {
+                self.merge_more = self.merging.load(Ordering::Relaxed) && self.merge_once();
+            }
+        }
+    }
+
+    // How long to wait for the next command before committing or merging;
+    // None blocks until one arrives
+    fn next_wait(&self) -> Option<Duration> {
+        if self.pending_docs > 0 {
+            Some(self.commit_delay.saturating_sub(self.last_add.elapsed()))
+        } else if self.merge_more {
+            // Queued commands still go first
+            Some(Duration::ZERO)
+        } else {
+            None
+        }
+    }
+
+    fn add(&mut self, doc: TantivyDocument, replaces: Option<Term>) {
+        if let Some(term) = replaces {
+            self.writer.delete_term(term);
+        }
+        if self.writer.add_document(doc).is_err() {
+            self.failed = true;
+        }
+        self.record();
+    }
+
+    fn record(&mut self) {
+        self.pending_docs += 1;
+        self.last_add = Instant::now();
+        if self.pending_docs >= self.commit_every_docs {
+            self.commit();
+        }
+    }
+
+    fn commit(&mut self) {
+        if self.pending_docs == 0 && !self.failed {
+            return;
+        }
+        let status = match self.writer.commit() {
+            Ok(_) if !self.failed => TANTIVY_SUCCESS,
+            Ok(_) => TANTIVY_ERROR_INDEXING_FAILED,
+            Err(_) => {
+                // Drops what was pending so the next commit can succeed
+                let _ = self.writer.rollback();
+                TANTIVY_ERROR_INDEXING_FAILED
+            }
+        };
+        self.pending_docs = 0;
+        self.failed = false;
+        // The new segment may complete a merge level
+        self.merge_more = true;
+        self.changed(status);
+    }
+
+    // Runs the first merge the policy picks; false if there was none
+    fn merge_once(&mut self) -> bool {
+        let metas = match self.index.searchable_segment_metas() {
+            Ok(m) => m,
+            Err(_) => return false,
+        };
+        let candidate = match self.policy.compute_merge_candidates(&metas).into_iter().next() {
+            Some(c) => c,
+            None => return false,
+        };
+        let status = match self.writer.merge(&candidate.0).wait() {
+            Ok(_) => TANTIVY_SUCCESS,
+            Err(_) => TANTIVY_ERROR_INDEXING_FAILED,
+        };
+        // Deletes the merged segments' files; searchers still using them
+        // keep their mappings
+        let _ = self.writer.garbage_collect_files().wait();
+        self.changed(status);
+        status == TANTIVY_SUCCESS
+    }
+
+    fn changed(&self, status: i32) {
+        let count = self.index.searchable_segment_metas().map_or(0, |metas| metas.len() as u32);
+        self.segments.store(count, Ordering::Relaxed);
+        if let Some(callback) = self.notify.callback {
+            callback(status, count, self.notify.user_data);
+        }
+    }
+}
+
+/// Opens the index at `path` for on-device writing, creating it with the
+/// PrepperApp schema if there is none; created indexes also index ids, so
+/// adds replace the document with the same id. `options` may be null for
+/// tantivy_writer_options_default(). `callback`, if set, runs on the
+/// writer thread after every commit and merge with `user_data`.
+///
+/// The writer holds the index's writer lock until tantivy_writer_close.
+/// Returns null if the index cannot be opened or created, lacks the
+/// PrepperApp fields or the writer thread cannot be started.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_open(
+    path: *const c_char,
+    options: *const WriterOptions,
+    callback: Option<WriterCallback>,
+    user_data: *mut c_void,
+) -> *mut OnDeviceWriter {
+    if path.is_null() {
+        return std::ptr::null_mut();
+    }
+    let path_str = match unsafe { CStr::from_ptr(path) }.to_str() {
+        Ok(s) => s,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let options = if options.is_null() { tantivy_writer_options_default() } else { unsafe { *options } };
+
+    if std::fs::create_dir_all(path_str).is_err() {
+        return std::ptr::null_mut();
+    }
+    let index = match Index::open_in_dir(path_str)
+        .or_else(|_| Index::create_in_dir(path_str, prepper_schema(STRING | STORED | FAST)))
+    {
+        Ok(i) => i,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    let schema = index.schema();
+    let fields = match DocumentFields::resolve(&schema) {
+        Some(f) => f,
+        None => return std::ptr::null_mut(),
+    };
+    let ids_indexed = schema.get_field_entry(fields.id).is_indexed();
+
+    let writer: IndexWriter = match index.writer_with_num_threads(1, options.heap_bytes()) {
+        Ok(w) => w,
+        Err(_) => return std::ptr::null_mut(),
+    };
+    writer.set_merge_policy(Box::new(NoMergePolicy));
+
+    let merging = Arc::new(AtomicBool::new(false));
+    let segments = Arc::new(AtomicU32::new(index.searchable_segment_metas().map_or(0, |m| m.len() as u32)));
+    let state = WriterThread {
+        index,
+        writer,
+        policy: options.merge_policy(),
+        commit_delay: Duration::from_millis(or_default(options.commit_delay_ms, DEFAULT_COMMIT_DELAY_MS) as u64),
+        commit_every_docs: or_default(options.commit_every_docs, DEFAULT_COMMIT_EVERY_DOCS) as usize,
+        pending_docs: 0,
+        failed: false,
+        last_add: Instant::now(),
+        merge_more: false,
+        merging: merging.clone(),
+        segments: segments.clone(),
+        notify: Notify { callback, user_data },
+    };
+
+    let (commands, receiver) = mpsc::sync_channel(QUEUE_COMMANDS);
+    let thread = match std::thread::Builder::new()
+        .name("tantivy-writer".into())
+        .spawn(move || state.run(receiver))
+    {
+        Ok(t) => t,
+        Err(_) => return std::ptr::null_mut(),
+    };
+
+    Box::into_raw(Box::new(OnDeviceWriter {
+        commands: Some(commands),
+        fields,
+        ids_indexed,
+        merging,
+        segments,
+        thread: Some(thread),
+    }))
+}
+
+/// Queues a document and returns without indexing it; it becomes visible
+/// after the next commit and a reload. Blocks only while the writer thread
+/// has 1024 commands queued, e.g. during a merge.
+/// Returns TANTIVY_SUCCESS or a negative error code.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_add_document(
+    writer_ptr: *const OnDeviceWriter,
+    id: *const c_char,
+    title: *const c_char,
+    category: *const c_char,
+    priority: u64,
+    summary: *const c_char,
+    content: *const c_char,
+) -> i32 {
+    if [id, title, category, summary, content].iter().any(|s| s.is_null()) || writer_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let writer = unsafe { &*writer_ptr };
+    let text = |s: *const c_char| unsafe { CStr::from_ptr(s) }.to_string_lossy();
+    let (id, title, category, summary, content) = (text(id), text(title), text(category), text(summary), text(content));
+    writer.add(&BatchDocument {
+        id: &id,
+        title: &title,
+        category: &category,
+        summary: &summary,
+        content: &content,
+        priority,
+    })
+}
+
+/// Queues a length-prefixed batch of documents (layout in batch.rs). The
+/// whole batch is decoded first, so a malformed one queues nothing.
+/// Returns the number of documents queued, or a negative error code.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_add_documents_batch(writer_ptr: *const OnDeviceWriter, data: *const u8, len: usize) -> i32 {
+    if writer_ptr.is_null() || data.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let writer = unsafe { &*writer_ptr };
+    let bytes = unsafe { std::slice::from_raw_parts(data, len) };
+    let docs = match BatchReader::new(bytes).and_then(|batch| batch.collect::<Result<Vec<_>, _>>()) {
+        Ok(d) => d,
+        Err(_) => return TANTIVY_ERROR_INVALID_PARAM,
+    };
+
+    for doc in &docs {
+        let result = writer.add(doc);
+        if result != TANTIVY_SUCCESS {
+            return result;
+        }
+    }
+    docs.len() as i32
+}
+
+/// Queues the deletion of the document with article id `id`. Only indexes
+/// created by the writer index ids; others return
+/// TANTIVY_ERROR_INVALID_PARAM.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_delete_document(writer_ptr: *const OnDeviceWriter, id: *const c_char) -> i32 {
+    if writer_ptr.is_null() || id.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let writer = unsafe { &*writer_ptr };
+    match writer.id_term(&unsafe { CStr::from_ptr(id) }.to_string_lossy()) {
+        Some(term) => writer.send(Command::Delete(term)),
+        None => TANTIVY_ERROR_INVALID_PARAM,
+    }
+}
+
+/// Asks for a commit of everything queued so far without waiting for it;
+/// the callback reports it.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_commit(writer_ptr: *const OnDeviceWriter) -> i32 {
+    if writer_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+    unsafe { &*writer_ptr }.send(Command::Commit)
+}
+
+/// Allows (nonzero) or stops (0) segment merges, e.g. while the device
+/// is charging or idle. Off when opened. A merge in progress finishes.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_set_merging(writer_ptr: *const OnDeviceWriter, allowed: i32) -> i32 {
+    if writer_ptr.is_null() {
+        return TANTIVY_ERROR_INVALID_PARAM;
+    }
+
+    let writer = unsafe { &*writer_ptr };
+    writer.merging.store(allowed != 0, Ordering::Relaxed);
+    if allowed != 0 {
+        return writer.send(Command::Merge);
+    }
+    TANTIVY_SUCCESS
+}
+
+/// Committed segments after the last commit or merge, or -1 for a null writer.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_segment_count(writer_ptr: *const OnDeviceWriter) -> i32 {
+    if writer_ptr.is_null() {
+        return -1;
+    }
+    unsafe { &*writer_ptr }.segments.load(Ordering::Relaxed) as i32
+}
+
+/// Commits what is pending, waits for a merge in progress and frees the
+/// writer. Must not be called from inside its callback.
+#[no_mangle]
+pub extern "C" fn tantivy_writer_close(writer_ptr: *mut OnDeviceWriter) {
+    if !writer_ptr.is_null() {
+        drop(unsafe { Box::from_raw(writer_ptr) });
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::ffi::CString;
+    use std::sync::Mutex;
+
+    // The callback's user_data: (status, segment_count) per change
+    type Changes = Mutex<mpsc::Sender<(i32, u32)>>;
+
+    extern "C" fn record(status: i32, segment_count: u32, user_data: *mut c_void) {
+        let sender = unsafe { &*(user_data as *const Changes) };
+        let _ = sender.lock().unwrap().send((status, segment_count));
+    }
+
+    fn num_docs(path: &std::path::Path) -> u64 {
+        Index::open_in_dir(path).unwrap().reader().unwrap().searcher().num_docs()
+    }
+
+    #[test]
+    fn test_null_safety() {
+        assert!(tantivy_writer_open(std::ptr::null(), std::ptr::null(), None, std::ptr::null_mut()).is_null());
+        assert_eq!(tantivy_writer_add_documents_batch(std::ptr::null(), std::ptr::null(), 0), TANTIVY_ERROR_INVALID_PARAM);
+        assert_eq!(tantivy_writer_delete_document(std::ptr::null(), std::ptr::null()), TANTIVY_ERROR_INVALID_PARAM);
+        assert_eq!(tantivy_writer_commit(std::ptr::null()), TANTIVY_ERROR_INVALID_PARAM);
+        assert_eq!(tantivy_writer_set_merging(std::ptr::null(), 1), TANTIVY_ERROR_INVALID_PARAM);
+        assert_eq!(tantivy_writer_segment_count(std::ptr::null()), -1);
+
+        // Should not crash
+        tantivy_writer_close(std::ptr::null_mut());
+    }
+
+    #[test]
+    fn test_commits_replaces_and_merges() {
+        let dir = std::env::temp_dir().join(format!("tantivy-writer-{}", std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        let path = CString::new(dir.to_str().unwrap()).unwrap();
+        let (tx, rx) = mpsc::channel();
+        let changes = Mutex::new(tx);
+
+        let mut options = tantivy_writer_options_default();
+        // Only explicit commits, and any two segments merge
+        options.commit_delay_ms = 60_000;
+        options.merge_min_segments = 2;
+        let writer = tantivy_writer_open(path.as_ptr(), &options, Some(record), &changes as *const _ as *mut c_void);
+        assert!(!writer.is_null());
+
+        let text = |s: &str| CString::new(s).unwrap();
+        let (title, category, summary, content) = (text("Water"), text("notes"), text("Boil first"), text("Ten minutes"));
+        let add = |id: &str| {
+            let id = text(id);
+            tantivy_writer_add_document(
+                writer,
+                id.as_ptr(),
+                title.as_ptr(),
+                category.as_ptr(),
+                1,
+                summary.as_ptr(),
+                content.as_ptr(),
+            )
+        };
+
+        for (n, id) in ["n1", "n2", "n3"].iter().enumerate() {
+            assert_eq!(add(id), TANTIVY_SUCCESS);
+            assert_eq!(tantivy_writer_commit(writer), TANTIVY_SUCCESS);
+            assert_eq!(rx.recv().unwrap(), (TANTIVY_SUCCESS, n as u32 + 1));
+        }
+        assert_eq!(tantivy_writer_segment_count(writer), 3);
+        assert_eq!(num_docs(&dir), 3);
+
+        // Same id: replaced, not duplicated
+        assert_eq!(add("n1"), TANTIVY_SUCCESS);
+        assert_eq!(tantivy_writer_commit(writer), TANTIVY_SUCCESS);
+        assert_eq!(rx.recv().unwrap().0, TANTIVY_SUCCESS);
+        assert_eq!(num_docs(&dir), 3);
+
+        assert_eq!(tantivy_writer_set_merging(writer, 1), TANTIVY_SUCCESS);
+        while rx.recv().unwrap().1 > 1 {}
+        assert_eq!(tantivy_writer_segment_count(writer), 1);
+        assert_eq!(num_docs(&dir), 3);
+
+        // Pending documents are committed on close
+        let id = text("n2");
+        assert_eq!(tantivy_writer_delete_document(writer, id.as_ptr()), TANTIVY_SUCCESS);
+        tantivy_writer_close(writer);
+        assert_eq!(num_docs(&dir), 2);
+
+        let _ = std::fs::remove_dir_all(dir);
+    }
+}
@@ -1,4 +1,5 @@
-/* Generated by cbindgen - DO NOT EDIT */
+/* Maintained by hand to match the Rust exports until the first run of
+ * scripts/generate-header.sh, which replaces it with cbindgen's output */
 
 #ifndef TANTIVY_MOBILE_H
 #define TANTIVY_MOBILE_H
@@ -10,6 +11,13 @@
 extern "C" {
 #endif
 
+/* Version of this ABI, bumped on any incompatible change to a signature or
+ * layout below. Bridges compare tantivy_abi_version() with the header's
+ * TANTIVY_ABI_VERSION when the library loads and refuse a mismatch. */
+#define TANTIVY_ABI_VERSION 2
+
+uint32_t tantivy_abi_version(void);
+
 /* Search result structure */
 typedef struct {
     char* id;
@@ -27,12 +35,99 @@ typedef struct {
     uint64_t search_time_ms;
 } SearchResults;
 
-/* Index statistics */
+/* Reusable slab for search results, see tantivy_search_arena */
+typedef struct SearchResultArena SearchResultArena;
+
+/* IndexStats layout version; check `version` before reading fields added
+ * after the version you were built against */
+#define TANTIVY_INDEX_STATS_VERSION 2
+#define TANTIVY_LATENCY_BUCKETS 12
+
+/* Footprint and query counters of one index. Byte counts the library
+ * cannot measure are 0; resident bytes need TANTIVY_OPEN_MMAP_ADVISED. */
 typedef struct {
+    uint32_t struct_size;           /* sizeof(IndexStats) in the library */
+    uint32_t version;               /* TANTIVY_INDEX_STATS_VERSION */
     uint64_t num_docs;
-    uint64_t index_size_bytes;
+    uint64_t index_size_bytes;      /* segment files of the current generation */
+    uint64_t mapped_bytes;          /* of those, memory-mapped */
+    uint64_t resident_bytes;        /* of the mappings, in RAM */
+    uint64_t heap_bytes;            /* docstore cache and filter sets, plus a single index's result cache */
+    uint64_t docstore_cache_bytes;  /* decompressed docstore blocks cached */
+    uint32_t segment_count;
+    uint32_t _reserved;
+    uint64_t query_count;           /* searches since opened */
+    uint64_t query_time_ns;         /* their summed latency */
+    /* Search counts by latency: < 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50,
+     * 100, 250 ms, and slower */
+    uint64_t latency_histogram[TANTIVY_LATENCY_BUCKETS];
 } IndexStats;
 
+/*
+ * Packed search results, written into a caller-owned buffer (little-endian).
+ *
+ *   PackedResultsHeader
+ *   PackedResultRow[count]
+ *   string pool: UTF-8 bytes, PackedString offsets are relative to pool_offset
+ *
+ * Rows are in rank order. If the buffer fills up the tail is dropped and
+ * count < total_hits; grow the buffer for the next query.
+ */
+#define TANTIVY_PACKED_MAGIC 0x31525054u /* "TPR1" */
+#define TANTIVY_PACKED_HEADER_SIZE 24
+#define TANTIVY_PACKED_ROW_SIZE 48
+
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t total_hits;
+    uint32_t pool_offset;
+    uint64_t search_time_ms;
+} PackedResultsHeader;
+
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+} PackedString;
+
+typedef struct {
+    PackedString id;
+    PackedString title;
+    PackedString category;
+    PackedString summary;
+    PackedString module;
+    uint32_t priority;
+    float score;
+} PackedResultRow;
+
+/*
+ * Two-phase search. tantivy_search_hits ranks documents without loading
+ * stored fields; tantivy_hits_hydrate then packs only the rows about to be
+ * shown. A SearchHits handle pins the index generation it was searched on.
+ */
+typedef struct {
+    uint32_t segment_ord;
+    uint32_t doc_id;
+    float score;
+    uint32_t priority;
+} SearchHit;
+
+typedef struct SearchHits SearchHits;
+
+/* Search-as-you-type session (incremental.rs) */
+typedef struct SearchSession SearchSession;
+
+/*
+ * Document batch for tantivy_add_documents_batch (little-endian).
+ *
+ *   [magic uint32 TANTIVY_BATCH_MAGIC][doc_count uint32]
+ *   doc_count x [priority uint32][id][title][category][summary][content]
+ *
+ * Every string is [length uint32][UTF-8 bytes], not NUL-terminated.
+ */
+#define TANTIVY_BATCH_MAGIC 0x31424454u /* "TDB1" */
+#define TANTIVY_BATCH_HEADER_SIZE 8
+
 /* Initialize logging for mobile platforms */
 void tantivy_init_logging(void);
 
@@ -42,6 +137,23 @@ void* tantivy_create_index(const char* path);
 /* Open an existing index */
 void* tantivy_open_index(const char* path);
 
+/* Index open modes */
+#define TANTIVY_OPEN_DEFAULT 0
+/* Memory-mapped with per-file madvise hints: term dictionaries and fast
+ * fields WILLNEED, docstore RANDOM; resident pages can be trimmed */
+#define TANTIVY_OPEN_MMAP_ADVISED 1
+
+/* Open an existing index with an open mode; NULL on failure */
+void* tantivy_open_index_with_mode(const char* path, uint32_t mode);
+
+/* Levels for the trim_memory entry points */
+#define TANTIVY_TRIM_MODERATE 1 /* drop docstore and postings pages */
+#define TANTIVY_TRIM_CRITICAL 2 /* drop all index pages and the result cache */
+
+/* Release memory on an OS memory warning. Only indexes opened with
+ * TANTIVY_OPEN_MMAP_ADVISED have pages to drop. */
+int32_t tantivy_trim_memory(void* index_ptr, int32_t level);
+
 /* Add a document to the index */
 int32_t tantivy_add_document(
     void* index_ptr,
@@ -53,6 +165,26 @@ int32_t tantivy_add_document(
     const char* content
 );
 
+/* Add a batch of documents in one call, auto-committing at the configured
+ * thresholds. Returns the number of documents added, or a negative error
+ * code. Documents after the last automatic commit need tantivy_commit. */
+int32_t tantivy_add_documents_batch(
+    void* index_ptr,
+    const uint8_t* data,
+    size_t len
+);
+
+/* Set auto-commit thresholds for document ingestion (0 disables one) */
+int32_t tantivy_set_commit_thresholds(
+    void* index_ptr,
+    size_t max_docs,
+    size_t max_bytes
+);
+
+/* Set the result cache memory cap in bytes (0 disables caching). Repeated
+ * searches are answered from the cache until the next commit. */
+int32_t tantivy_set_cache_capacity(void* index_ptr, size_t bytes);
+
 /* Commit changes to the index */
 int32_t tantivy_commit(void* index_ptr);
 
@@ -63,21 +195,530 @@ SearchResults* tantivy_search(
     size_t limit
 );
 
+/* Search the index into a caller-owned buffer using the packed layout.
+ * Returns the number of packed rows, or a negative error code. */
+int32_t tantivy_search_packed(
+    void* index_ptr,
+    const char* query,
+    size_t limit,
+    uint8_t* buffer,
+    size_t capacity
+);
+
+/* Create a result arena with an initial string slab of `initial_capacity` bytes */
+SearchResultArena* tantivy_arena_create(size_t initial_capacity);
+
+/* Drop an arena's results while keeping its memory for reuse */
+void tantivy_arena_reset(SearchResultArena* arena);
+
+/* Free an arena */
+void tantivy_arena_free(SearchResultArena* arena);
+
+/* Search the index into an arena. The arena is reset first; the results
+ * stay valid until the next search or reset on the same arena and must
+ * NOT be passed to tantivy_free_search_results. */
+const SearchResults* tantivy_search_arena(
+    void* index_ptr,
+    SearchResultArena* arena,
+    const char* query,
+    size_t limit
+);
+
+/* Phase one: rank up to `limit` documents by BM25 times a priority boost
+ * (priority 0 highest), reading priority from its FAST column. Returns NULL
+ * on failure; free with tantivy_hits_free. */
+SearchHits* tantivy_search_hits(
+    void* index_ptr,
+    const char* query,
+    size_t limit
+);
+
+/* Number of hits, and the hits array (NULL when empty) */
+size_t tantivy_hits_count(const SearchHits* hits);
+const SearchHit* tantivy_hits_get(const SearchHits* hits);
+
+/* Phase two: pack hits [start, start + count) with their stored fields into
+ * a caller-owned buffer. total_hits in the header is the range length.
+ * Returns the number of packed rows, or -1 on failure. */
+int32_t tantivy_hits_hydrate(
+    const SearchHits* hits,
+    size_t start,
+    size_t count,
+    uint8_t* buffer,
+    size_t capacity
+);
+
+void tantivy_hits_free(SearchHits* hits);
+
+/* Create a search-as-you-type session over an index. Free it with
+ * tantivy_incremental_free before freeing the index. */
+SearchSession* tantivy_incremental_create(void* index_ptr);
+
+/* Search one keystroke of a session into a caller-owned buffer using the
+ * packed layout. A query extending the previous one narrows its candidates
+ * instead of searching cold; the last token is matched as a prefix unless
+ * the query ends on a separator. Returns the number of packed rows,
+ * TANTIVY_ERROR_CANCELLED if a newer call on the session superseded this
+ * one, or a negative error code. */
+int32_t tantivy_search_incremental(
+    const SearchSession* session,
+    const char* query,
+    size_t limit,
+    uint8_t* buffer,
+    size_t capacity
+);
+
+/* Abandon the session's in-flight query, if any */
+void tantivy_incremental_cancel(const SearchSession* session);
+
+/* Free a session; no call on it may be in flight */
+void tantivy_incremental_free(SearchSession* session);
+
 /* Free search results */
 void tantivy_free_search_results(SearchResults* results);
 
 /* Free an index manager */
 void tantivy_free_index(void* index_ptr);
 
-/* Get index statistics */
+/* Get index footprint and query counters. Cheap enough to sample
+ * periodically; the counters are not reset. */
 IndexStats tantivy_get_index_stats(void* index_ptr);
 
+/* ---- On-device writer for notes and downloads (writer.rs) ---- */
+
+typedef struct OnDeviceWriter OnDeviceWriter;
+
+/* Options of tantivy_writer_open. A value of 0 takes the default. */
+typedef struct {
+    uint64_t heap_bytes;          /* indexing memory budget, at least 15 MB; a full heap flushes a segment */
+    uint32_t commit_delay_ms;     /* commit once no document was added for this long */
+    uint32_t commit_every_docs;   /* commit once this many documents are pending */
+    uint32_t merge_min_segments;  /* segments of a similar size merged together */
+    uint32_t merge_max_docs;      /* segments with more documents are not merged further */
+} WriterOptions;
+
+/* Defaults: 16 MB heap, commit after 2 s idle or 1000 documents, merge 4
+ * segments at a time up to 500k documents */
+WriterOptions tantivy_writer_options_default(void);
+
+/* Called on the writer thread after every commit and merge with
+ * TANTIVY_SUCCESS or a negative error code and the committed segment
+ * count. Reload the searchers of the index here (trigger_index_reload,
+ * multi_manager_reload_index); queries keep running on the old segments
+ * until the new searcher is published. */
+typedef void (*WriterCallback)(int32_t status, uint32_t segment_count, void* user_data);
+
+/* Open the index at `path` for writing on a background thread, creating it
+ * with the PrepperApp schema (ids indexed, so adds replace the document
+ * with the same id) if there is none. `options` may be NULL for defaults;
+ * `callback` may be NULL. Holds the index's writer lock until
+ * tantivy_writer_close. Returns NULL on failure. */
+OnDeviceWriter* tantivy_writer_open(
+    const char* path,
+    const WriterOptions* options,
+    WriterCallback callback,
+    void* user_data
+);
+
+/* Queue a document and return without indexing it. Blocks only while 1024
+ * commands are queued, e.g. during a merge. Returns 0 or a negative error
+ * code. */
+int32_t tantivy_writer_add_document(
+    const OnDeviceWriter* writer,
+    const char* id,
+    const char* title,
+    const char* category,
+    uint64_t priority,
+    const char* summary,
+    const char* content
+);
+
+/* Queue a batch (see tantivy_add_documents_batch); a malformed batch queues
+ * nothing. Returns the number of documents queued, or a negative error code. */
+int32_t tantivy_writer_add_documents_batch(const OnDeviceWriter* writer, const uint8_t* data, size_t len);
+
+/* Queue the deletion of article `id`. TANTIVY_ERROR_INVALID_PARAM for
+ * indexes not created by the writer, which do not index ids. */
+int32_t tantivy_writer_delete_document(const OnDeviceWriter* writer, const char* id);
+
+/* Ask for a commit of everything queued without waiting; the callback
+ * reports it */
+int32_t tantivy_writer_commit(const OnDeviceWriter* writer);
+
+/* Allow (nonzero) or stop (0) segment merges, e.g. while charging or idle.
+ * Off when opened; a merge in progress finishes. */
+int32_t tantivy_writer_set_merging(const OnDeviceWriter* writer, int32_t allowed);
+
+/* Committed segments after the last commit or merge; -1 for NULL */
+int32_t tantivy_writer_segment_count(const OnDeviceWriter* writer);
+
+/* Commit what is pending, wait for a merge in progress and free the writer.
+ * Never call it from inside the writer's callback. */
+void tantivy_writer_close(OnDeviceWriter* writer);
+
+/* ---- Single module index, JSON results (ffi.rs) ---- */
+
+typedef struct SearchService SearchService;
+
+/* Open a module index read-only; NULL on failure. Free with destroy_searcher. */
+SearchService* init_searcher(const char* index_path);
+
+/* Same with a TANTIVY_OPEN_* mode */
+SearchService* init_searcher_with_mode(const char* index_path, uint32_t mode);
+
+void destroy_searcher(SearchService* service);
+
+/* Top 20 results as a JSON array of {"doc_id","title","summary","score"},
+ * or NULL on failure. Free with free_string. */
+const char* search(const SearchService* service, const char* query);
+
+/* `search` returning `limit` results after the best `offset`, for paging */
+const char* search_with_offset(const SearchService* service, const char* query, uint32_t limit, uint32_t offset);
+
+/* Stored fields of article `doc_id` as a JSON object, NULL if absent.
+ * Free with free_string. */
+const char* get_document(const SearchService* service, const char* doc_id);
+
+/* Pick up a new generation from disk. Returns 0, or -1 on failure. */
+int32_t trigger_index_reload(SearchService* service);
+
+/* Phase one of a two-phase search over a SearchService; see
+ * tantivy_search_hits */
+SearchHits* search_hits(const SearchService* service, const char* query, size_t limit);
+
+/* Free a string returned by the functions above */
+void free_string(char* s);
+
+/* ---- Multi-module search (multi_search.rs) ---- */
+
+typedef struct MultiSearchManager MultiSearchManager;
+
+/* Modules addressable from MultiSearchOptions (bits of module_mask) */
+#define MULTI_SEARCH_MAX_MODULES 32
+
+/* Binary search options, the JSON-free counterpart of the config string.
+ * Modules are addressed by the slot from multi_manager_module_slot:
+ * bit n of module_mask selects slot n (0 selects every module) and
+ * module_weights[n] is that module's score weight. */
+typedef struct {
+    uint32_t limit;
+    uint32_t module_mask;
+    float module_weights[MULTI_SEARCH_MAX_MODULES];
+} MultiSearchOptions;
+
+/* Default options: limit 20, every module, all weights 1.0 */
+MultiSearchOptions multi_search_options_default(void);
+
+/* Core classes for MultiManagerOptions.core_class */
+#define TANTIVY_CORES_ANY 0
+#define TANTIVY_CORES_EFFICIENCY 1  /* slowest cluster; iOS: utility QoS */
+#define TANTIVY_CORES_PERFORMANCE 2 /* faster clusters; iOS: user-initiated QoS */
+
+/* Threads of a manager, which owns its pools instead of using rayon's
+ * one-thread-per-core global pool. A count of 0 takes the default. */
+typedef struct {
+    uint32_t search_threads;            /* one search fans out over these; capped at the core count */
+    uint32_t async_threads;             /* run multi_manager_search_async requests */
+    uint32_t background_search_threads; /* search threads while background indexing is active */
+    int32_t core_class;                 /* TANTIVY_CORES_*: affinity on Android, QoS on iOS */
+    int32_t thread_priority;            /* nice value on Android, 0 to inherit */
+} MultiManagerOptions;
+
+/* Default threads: 4 search, 2 async, 1 while indexing, any core */
+MultiManagerOptions multi_manager_options_default(void);
+
+/* Create a manager that searches several named index modules in parallel */
+MultiSearchManager* init_multi_manager(void);
+
+/* Same with explicit thread options (NULL for defaults). Returns NULL if the
+ * threads cannot be started. */
+MultiSearchManager* init_multi_manager_with_options(const MultiManagerOptions* options);
+
+/* Destroy a manager and every module it holds */
+void destroy_multi_manager(MultiSearchManager* manager);
+
+/* Load, unload or reload a named module. Return 0 on success, -1 on failure */
+int32_t multi_manager_load_index(MultiSearchManager* manager, const char* module_name, const char* index_path);
+int32_t multi_manager_unload_index(MultiSearchManager* manager, const char* module_name);
+int32_t multi_manager_reload_index(MultiSearchManager* manager, const char* module_name);
+
+/* Load a module whose docstore block cache holds up to docstore_cache_bytes
+ * of decompressed blocks (0: tantivy's default of 100 blocks). Size it up
+ * for modules whose results and articles are re-read often. Returns 0 on
+ * success, -1 on failure */
+int32_t multi_manager_load_index_with_cache(MultiSearchManager* manager, const char* module_name,
+                                            const char* index_path, uint64_t docstore_cache_bytes);
+
+/* States of multi_manager_module_state */
+#define TANTIVY_MODULE_PENDING  0 /* registered, waiting to open */
+#define TANTIVY_MODULE_READY    1 /* open and searched */
+#define TANTIVY_MODULE_UNLOADED 2 /* registered, closed under memory pressure */
+#define TANTIVY_MODULE_FAILED   3 /* registered, could not be opened */
+
+/* Register a module to be opened on the manager's loader thread: records
+ * only the name, path and tier and returns at once, so startup does not
+ * grow with installed content. Modules open one at a time, lowest tier
+ * first, then in registration order. Searches skip modules not open yet
+ * and report them in SearchTiming.pending_mask; the slot is assigned at
+ * once. Registering a name again replaces the registration; unload
+ * forgets it. Returns 0, or -1 on invalid input. */
+int32_t multi_manager_register_index(const MultiSearchManager* manager, const char* module_name,
+                                     const char* index_path, uint32_t tier, uint64_t docstore_cache_bytes);
+
+/* TANTIVY_MODULE_* of a loaded or registered module, -1 if unknown.
+ * Loaded modules are always READY. */
+int32_t multi_manager_module_state(const MultiSearchManager* manager, const char* module_name);
+
+/* Keep at most `count` registered modules open (0 = unlimited), closing the
+ * least recently searched when another opens. A closed module is skipped
+ * by searches of every module; one that selects it by mask or
+ * module_filter reports it pending and reopens it ahead of every tier. */
+int32_t multi_manager_set_open_module_limit(const MultiSearchManager* manager, uint32_t count);
+
+/* Search all modules, ranking by BM25 times a priority boost times the
+ * module weight. `config_json` may be NULL for defaults.
+ * Returns a JSON array to be freed with free_rust_string, or NULL.
+ * Kept for debugging; prefer multi_manager_search_binary. */
+const char* multi_manager_search(const MultiSearchManager* manager, const char* query, const char* config_json);
+
+/* Search all modules into a caller-owned buffer using the packed layout.
+ * Returns the number of packed rows, or -1 on failure. */
+int32_t multi_manager_search_packed(
+    const MultiSearchManager* manager,
+    const char* query,
+    const char* config_json,
+    uint8_t* buffer,
+    size_t capacity
+);
+
+/* Search all modules with binary options (NULL for defaults) into a
+ * caller-owned buffer using the packed layout. No JSON on either side.
+ * Returns the number of packed rows, or -1 on failure. */
+int32_t multi_manager_search_binary(
+    const MultiSearchManager* manager,
+    const char* query,
+    const MultiSearchOptions* options,
+    uint8_t* buffer,
+    size_t capacity
+);
+
+/* Phases of one search in nanoseconds. collect_ns is the wall time of the
+ * parallel per-module phase and module_collect_ns each module's own share,
+ * by slot; parse_ns sums the modules' query parses. fetch_ns (stored
+ * fields and snippets) is not part of merge_ns. On a cache hit cache_hit
+ * is 1 and parse, collect, merge and fetch are 0. marshal_ns is not set by
+ * the library: bridges fill in their own string and array copying. */
+typedef struct {
+    uint64_t total_ns;
+    uint64_t parse_ns;
+    uint64_t collect_ns;
+    uint64_t merge_ns;
+    uint64_t fetch_ns;
+    uint64_t serialize_ns;
+    uint64_t marshal_ns;
+    uint32_t cache_hit;
+    uint32_t module_count;
+    uint64_t module_collect_ns[MULTI_SEARCH_MAX_MODULES];
+    uint32_t searched_mask; /* slots searched */
+    uint32_t pending_mask;  /* slots selected but not open yet (results are partial) */
+} SearchTiming;
+
+/* multi_manager_search_binary that also fills `timing` (NULL to skip).
+ * On Android each phase is an ATrace section (tantivy.search,
+ * tantivy.collect per module, tantivy.merge, tantivy.pack), visible in
+ * Perfetto and systrace captures. */
+int32_t multi_manager_search_binary_timed(
+    const MultiSearchManager* manager,
+    const char* query,
+    const MultiSearchOptions* options,
+    uint8_t* buffer,
+    size_t capacity,
+    SearchTiming* timing
+);
+
+/* Filter of multi_manager_search_filtered. `category` is an exact match
+ * (NULL for any) against the index's indexed `category` field; the
+ * priority range is inclusive, 0..UINT32_MAX leaving it unbounded. */
+typedef struct {
+    const char* category;
+    uint32_t priority_min;
+    uint32_t priority_max;
+} SearchFilter;
+
+/* Like multi_manager_search_binary, returning only documents that pass
+ * `filter` (NULL for none), checked per segment while collecting. A blank
+ * query lists the passing documents by ascending priority, unscored (score
+ * 0) and unweighted: a browse listing, filtered or not. Modules are chosen
+ * by the options' module_mask. Returns packed rows or -1. */
+int32_t multi_manager_search_filtered(
+    const MultiSearchManager* manager,
+    const char* query,
+    const MultiSearchOptions* options,
+    const SearchFilter* filter,
+    uint8_t* buffer,
+    size_t capacity
+);
+
+/* Completion of multi_manager_search_async, called once per request on a
+ * native search thread. `status` is the number of packed rows, or a
+ * negative error code (TANTIVY_ERROR_CANCELLED once cancelled) with a NULL
+ * buffer. `packed` uses the packed layout and is only valid during the
+ * call; copy what outlives it. */
+typedef void (*MultiSearchCallback)(
+    uint64_t request_id,
+    int32_t status,
+    const uint8_t* packed,
+    size_t packed_len,
+    void* user_data
+);
+
+/* Queue a search with binary options (NULL for defaults) on the manager's
+ * search threads and return at once. The query and options are copied.
+ * Returns the request id passed to `callback`, or 0 on invalid input.
+ * destroy_multi_manager cancels pending searches and waits for their
+ * callbacks, so never call it from inside one. */
+uint64_t multi_manager_search_async(
+    const MultiSearchManager* manager,
+    const char* query,
+    const MultiSearchOptions* options,
+    MultiSearchCallback callback,
+    void* user_data
+);
+
+/* Batch or final result of multi_manager_search_tiered: called with
+ * is_final 0 once per tier but the last, then exactly once with is_final 1.
+ * `status` and `packed` are as for MultiSearchCallback; each batch holds
+ * the top K over every tier searched so far and replaces the previous one. */
+typedef void (*TieredSearchCallback)(
+    uint64_t request_id,
+    int32_t status,
+    const uint8_t* packed,
+    size_t packed_len,
+    int32_t is_final,
+    void* user_data
+);
+
+/* Queue a search like multi_manager_search_async that searches the
+ * selected modules one tier at a time, lowest first (tier 0 for modules
+ * loaded directly, the registered tier otherwise; only open modules are
+ * searched), delivering a batch after each. `tier_deadlines_ms` holds
+ * `deadline_count` budgets in ms, one per tier in search order, the last
+ * repeating; 0 means none. A tier out of budget contributes the hits it
+ * found so far. Batches stop soon after a cancel (one being delivered may
+ * still arrive) and the final call reports TANTIVY_ERROR_CANCELLED.
+ * Returns the request id, or 0 on invalid input. */
+uint64_t multi_manager_search_tiered(
+    const MultiSearchManager* manager,
+    const char* query,
+    const MultiSearchOptions* options,
+    const uint32_t* tier_deadlines_ms,
+    size_t deadline_count,
+    TieredSearchCallback callback,
+    void* user_data
+);
+
+/* Cancel an async or tiered search: collection stops at the next document
+ * visited and the callback reports TANTIVY_ERROR_CANCELLED. Returns 0 if
+ * cancelled, -1 if the callback has already started or the id is unknown. */
+int32_t multi_manager_cancel_search(const MultiSearchManager* manager, uint64_t request_id);
+
+/* Slot of a loaded or registered module for MultiSearchOptions, or -1 if
+ * unknown. A module keeps its slot until it is unloaded. */
+int32_t multi_manager_module_slot(const MultiSearchManager* manager, const char* module_name);
+
+/* Stored fields of article `doc_id` as a JSON object, from `module_name`
+ * or, when it is NULL, from the first loaded module that has it. Uses the
+ * module's id table (doc_addresses.bin) when present, otherwise a term
+ * query. Free with free_rust_string; NULL if no module has the article. */
+const char* multi_manager_get_document(const MultiSearchManager* manager, const char* module_name, const char* doc_id);
+
+/* Chunked article bodies. A DocumentStream holds the stored body of one
+ * article (its `body` field, or `content` where the schema stores that)
+ * and copies it out in caller-sized chunks, so the first screen can be
+ * shown before a long manual has been copied in full. Chunks end on UTF-8
+ * character boundaries. Streams outlive reloads and unloads of their module
+ * but are not for concurrent use. */
+typedef struct DocumentStream DocumentStream;
+
+/* NULL if no module (or `module_name`, when non-NULL) has the article or
+ * its index stores no body; free with document_stream_free */
+DocumentStream* multi_manager_open_document_stream(const MultiSearchManager* manager, const char* module_name,
+                                                   const char* doc_id);
+
+/* Body length in bytes, or -1 for a NULL stream */
+int64_t document_stream_length(const DocumentStream* stream);
+
+/* Bytes written to buf, 0 at the end, or TANTIVY_ERROR_INVALID_PARAM if
+ * the next character does not fit (capacity under 4) */
+int32_t document_stream_read(DocumentStream* stream, uint8_t* buf, size_t capacity);
+
+void document_stream_free(DocumentStream* stream);
+
+/* Per-module statistics as JSON, to be freed with free_rust_string */
+const char* multi_manager_get_stats(const MultiSearchManager* manager);
+
+/* Fill `out` with one module's footprint and query counters, the binary
+ * counterpart of its multi_manager_get_stats entry. A module's query time
+ * is its own parse and collect time within each multi-module search.
+ * Returns 0, or -1 if the module is not loaded. */
+int32_t multi_manager_module_stats(const MultiSearchManager* manager, const char* module_name, IndexStats* out);
+
+/* Cap the index pages resident across modules (0 = unlimited). Enforced
+ * now, after each load and on trim, paging out the least recently searched
+ * modules first. Modules are opened with TANTIVY_OPEN_MMAP_ADVISED. */
+int32_t multi_manager_set_memory_budget(const MultiSearchManager* manager, size_t bytes);
+
+/* Respond to Android onTrimMemory / iOS memory warnings. MODERATE pages out
+ * cold modules' docstore and postings. CRITICAL closes every registered
+ * module but the most recently searched, then pages out every module and
+ * clears the result cache. Searches keep working and fault pages back in. */
+int32_t multi_manager_trim_memory(const MultiSearchManager* manager, int32_t level);
+
+/* Start (active = 1) or end (0) one background indexing job. While any is
+ * active, searches use background_search_threads only. */
+int32_t multi_manager_set_background_indexing(const MultiSearchManager* manager, int32_t active);
+
+/* Result cache counters as JSON, to be freed with free_rust_string:
+ * {"hits","misses","entries","bytes","capacity_bytes"} */
+const char* multi_manager_cache_stats(const MultiSearchManager* manager);
+
+/* Set the result cache memory cap in bytes (0 disables caching).
+ * Loading, unloading or reloading a module clears the cache. */
+int32_t multi_manager_set_cache_capacity(const MultiSearchManager* manager, size_t bytes);
+
+/* ---- Startup warmup (warmup.rs) ---- */
+
+typedef struct WarmupHandle WarmupHandle;
+
+/* Run a content manifest's warmup queries (search_config.warmup_queries,
+ * or the home screen shortcut queries) against every loaded module on a
+ * background thread. Faults index pages in and fills the result cache;
+ * never blocks searches. Returns NULL on invalid input or nothing to warm.
+ * Free with warmup_free. */
+WarmupHandle* multi_manager_start_warmup(const MultiSearchManager* manager, const char* manifest_json);
+
+/* Stop after the query in flight */
+void warmup_cancel(const WarmupHandle* handle);
+
+/* Queries run so far, or -1 on NULL */
+int32_t warmup_progress(const WarmupHandle* handle);
+
+/* 1 when finished or stopped, 0 while running, -1 on NULL */
+int32_t warmup_is_done(const WarmupHandle* handle);
+
+/* Cancel, wait for the query in flight and free the handle */
+void warmup_free(WarmupHandle* handle);
+
+/* Free a string returned by the multi-search functions */
+void free_rust_string(char* s);
+
 /* Error codes */
 #define TANTIVY_SUCCESS 0
 #define TANTIVY_ERROR_INVALID_PARAM -1
 #define TANTIVY_ERROR_INDEX_CREATION -2
 #define TANTIVY_ERROR_SEARCH_FAILED -3
 #define TANTIVY_ERROR_INDEXING_FAILED -4
+#define TANTIVY_ERROR_CANCELLED -5
 
 #ifdef __cplusplus
 }
@@ -1,7 +1,8 @@
 #!/bin/bash
 
 # Build Tantivy library for iOS
-# This creates a universal library for iOS devices and simulator
+# This creates one static library for iOS devices and one universal library
+# for the simulator; create-xcframework.sh bundles them
 
 set -e
 
@@ -9,32 +10,35 @@ echo "Building Tantivy library for iOS..."
 
 cd ../rust/tantivy-mobile
 
-# Install cargo-lipo if not already installed
-if ! command -v cargo-lipo &> /dev/null; then
-    echo "Installing cargo-lipo..."
-    cargo install cargo-lipo
-fi
-
 # Add iOS targets if not already added
 rustup target add aarch64-apple-ios x86_64-apple-ios aarch64-apple-ios-sim
 
-# Build for iOS
+# Build for iOS devices and both simulator architectures
 echo "Building for iOS devices and simulator..."
-cargo lipo --release
+for TARGET in aarch64-apple-ios aarch64-apple-ios-sim x86_64-apple-ios; do
+    cargo build --release --target $TARGET
+done
 
 # Create output directory
 OUTPUT_DIR="../../ios/Libraries"
 mkdir -p $OUTPUT_DIR
 
-# Copy the universal library
-cp target/universal/release/libtantivy_mobile.a $OUTPUT_DIR/
+# Device and arm64 simulator slices share an architecture and cannot live in
+# one fat library, so only the two simulator architectures are merged
+cp target/aarch64-apple-ios/release/libtantivy_mobile.a $OUTPUT_DIR/
+lipo -create \
+    target/aarch64-apple-ios-sim/release/libtantivy_mobile.a \
+    target/x86_64-apple-ios/release/libtantivy_mobile.a \
+    -output $OUTPUT_DIR/libtantivy_mobile-sim.a
 cp tantivy_mobile.h $OUTPUT_DIR/
 
 echo "iOS library built successfully!"
 echo "Output files:"
 echo "  - $OUTPUT_DIR/libtantivy_mobile.a"
+echo "  - $OUTPUT_DIR/libtantivy_mobile-sim.a"
 echo "  - $OUTPUT_DIR/tantivy_mobile.h"
 
 # Show library info
 echo -e "\nLibrary info:"
-lipo -info $OUTPUT_DIR/libtantivy_mobile.a
\ No newline at end of file
+lipo -info $OUTPUT_DIR/libtantivy_mobile.a
+lipo -info $OUTPUT_DIR/libtantivy_mobile-sim.a
@@ -1,7 +1,8 @@
 #!/bin/bash
 
 # Create XCFramework for Tantivy Mobile
-# This bundles the static library for distribution
+# This bundles the device and simulator libraries with tantivy_mobile.h, the
+# same C ABI the Android JNI bridge compiles against
 
 set -e
 
@@ -9,37 +10,42 @@ echo "Creating XCFramework for Tantivy Mobile..."
 
 cd ../rust/tantivy-mobile
 
+LIB_DIR="../../ios/Libraries"
+
 # Build if not already built
-if [ ! -f "../../ios/Libraries/libtantivy_mobile.a" ]; then
+if [ ! -f "$LIB_DIR/libtantivy_mobile.a" ] || [ ! -f "$LIB_DIR/libtantivy_mobile-sim.a" ]; then
     echo "Building iOS library first..."
     cd ../../scripts
     ./build-ios-lib.sh
     cd ../rust/tantivy-mobile
 fi
 
+# Only the header and its module map go into the framework, so Swift can
+# `import TantivyMobile` without a bridging header
+HEADERS_DIR="target/xcframework-headers"
+rm -rf $HEADERS_DIR
+mkdir -p $HEADERS_DIR
+cp tantivy_mobile.h $HEADERS_DIR/
+
+cat > $HEADERS_DIR/module.modulemap << EOF
+module TantivyMobile {
+    header "tantivy_mobile.h"
+    
+    export *
+}
+EOF
+
 # Create XCFramework
 OUTPUT_DIR="../../ios/Frameworks"
 mkdir -p $OUTPUT_DIR
+rm -rf $OUTPUT_DIR/TantivyMobile.xcframework
 
 echo "Creating XCFramework..."
 xcodebuild -create-xcframework \
-    -library ../../ios/Libraries/libtantivy_mobile.a \
-    -headers . \
+    -library $LIB_DIR/libtantivy_mobile.a \
+    -headers $HEADERS_DIR \
+    -library $LIB_DIR/libtantivy_mobile-sim.a \
+    -headers $HEADERS_DIR \
     -output $OUTPUT_DIR/TantivyMobile.xcframework
 
 echo "XCFramework created at: $OUTPUT_DIR/TantivyMobile.xcframework"
-
-# Create module map for Swift integration
-MODULE_DIR="$OUTPUT_DIR/TantivyMobile.xcframework/ios-arm64/TantivyMobile.framework/Modules"
-mkdir -p $MODULE_DIR
-
-cat > $MODULE_DIR/module.modulemap << EOF
-framework module TantivyMobile {
-    umbrella header "tantivy_mobile.h"
-    
-    export *
-    module * { export * }
-}
-EOF
-
-echo "Module map created for Swift integration"
\ No newline at end of file
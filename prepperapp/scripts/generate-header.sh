@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# Regenerate tantivy_mobile.h from the Rust exports with cbindgen
+# Run after changing an exported function or #[repr(C)] layout and commit the
+# header together with that change; builds never rewrite it
+
+set -e
+
+echo "Generating tantivy_mobile.h..."
+
+cd ../rust/tantivy-mobile
+
+# Install cbindgen if not already installed
+if ! command -v cbindgen &> /dev/null; then
+    echo "Installing cbindgen..."
+    cargo install cbindgen --version "^0.26"
+fi
+
+cbindgen --config cbindgen.toml --crate tantivy-mobile --output tantivy_mobile.h
+
+echo "Header generated: rust/tantivy-mobile/tantivy_mobile.h"